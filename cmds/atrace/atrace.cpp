@@ -28,10 +28,12 @@
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
-#include <zlib.h>
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include <binder/IBinder.h>
 #include <binder/IServiceManager.h>
@@ -50,6 +52,9 @@
 #include <android-base/properties.h>
 #include <android-base/strings.h>
 #include <android-base/stringprintf.h>
+#include <android-base/unique_fd.h>
+
+#include "trace_compression.h"
 
 using namespace android;
 using hardware::hidl_vec;
@@ -59,6 +64,8 @@ using hardware::atrace::V1_0::IAtraceDevice;
 using hardware::atrace::V1_0::Status;
 using hardware::atrace::V1_0::toString;
 
+using android::base::StringPrintf;
+using android::base::unique_fd;
 using std::string;
 
 #define MAX_SYS_FILES 13
@@ -286,13 +293,14 @@ struct TracingVendorHalCategory {
 static int g_traceDurationSeconds = 5;
 static bool g_traceOverwrite = false;
 static int g_traceBufferSizeKB = 2048;
-static bool g_compress = false;
+static TraceCompressor::Algorithm g_compression = TraceCompressor::Algorithm::NONE;
 static bool g_nohup = false;
 static int g_initialSleepSecs = 0;
 static const char* g_categoriesFile = nullptr;
 static const char* g_kernelTraceFuncs = nullptr;
 static const char* g_debugAppCmdLine = "";
 static const char* g_outputFile = nullptr;
+static const char* g_rawTraceDir = nullptr;
 
 /* Global state */
 static bool g_traceAborted = false;
@@ -345,6 +353,19 @@ static const char* k_traceStreamPath =
 static const char* k_traceMarkerPath =
     "trace_marker";
 
+static const char* k_rawTracePathTemplate =
+    "per_cpu/cpu%d/trace_pipe_raw";
+
+// Size of the reads of the trace dump. Large reads cut the number of syscalls and
+// feed the compressor enough data to work with.
+static const size_t k_traceReadSize = 1024 * 1024;
+
+// Size of the pipes the raw per-cpu buffers are spliced through.
+static const int k_rawTracePipeSize = 1024 * 1024;
+
+// Maximum number of threads compressing the trace dump with zstd.
+static const int k_maxCompressionThreads = 4;
+
 // Check whether a file exists.
 static bool fileExists(const char* filename) {
     return access((g_traceFolder + filename).c_str(), F_OK) != -1;
@@ -945,6 +966,12 @@ static void streamTrace()
     }
 }
 
+static int getCompressionThreads()
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 1 ? std::min<int>(cpus, k_maxCompressionThreads) : 0;
+}
+
 // Read the current kernel trace and write it to stdout.
 static void dumpTrace(int outFd)
 {
@@ -956,97 +983,137 @@ static void dumpTrace(int outFd)
         return;
     }
 
-    if (g_compress) {
-        z_stream zs;
-        memset(&zs, 0, sizeof(zs));
-
-        int result = deflateInit(&zs, Z_DEFAULT_COMPRESSION);
-        if (result != Z_OK) {
-            fprintf(stderr, "error initializing zlib: %d\n", result);
-            close(traceFD);
-            return;
-        }
-
-        constexpr size_t bufSize = 64*1024;
-        std::unique_ptr<uint8_t> in(new uint8_t[bufSize]);
-        std::unique_ptr<uint8_t> out(new uint8_t[bufSize]);
-        if (!in || !out) {
-            fprintf(stderr, "couldn't allocate buffers\n");
-            close(traceFD);
-            return;
-        }
-
-        int flush = Z_NO_FLUSH;
+    std::unique_ptr<TraceCompressor> compressor =
+            TraceCompressor::create(g_compression, outFd, getCompressionThreads());
+    if (compressor && copyTrace(traceFD, compressor.get(), k_traceReadSize)) {
+        compressor->finish();
+    }
 
-        zs.next_out = reinterpret_cast<Bytef*>(out.get());
-        zs.avail_out = bufSize;
+    close(traceFD);
+}
 
-        do {
+// Moves the ring buffer of a cpu to |dir|/cpuN.raw, compressed if requested. The
+// pages are spliced out of trace_pipe_raw, which takes many pages at once off the
+// ring buffer, where read() returns a single page per call.
+static bool dumpRawCpuTrace(int cpu, const string& dir)
+{
+    string tracePath = g_traceFolder + StringPrintf(k_rawTracePathTemplate, cpu);
+    unique_fd traceFd(open(tracePath.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC));
+    if (traceFd == -1) {
+        fprintf(stderr, "error opening %s: %s (%d)\n", tracePath.c_str(), strerror(errno),
+                errno);
+        return false;
+    }
+    string outPath = StringPrintf("%s/cpu%d.raw%s", dir.c_str(), cpu,
+                                  TraceCompressor::fileSuffix(g_compression));
+    unique_fd outFd(open(outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (outFd == -1) {
+        fprintf(stderr, "error opening %s: %s (%d)\n", outPath.c_str(), strerror(errno), errno);
+        return false;
+    }
+    int pipeFds[2];
+    if (pipe2(pipeFds, O_CLOEXEC) == -1) {
+        fprintf(stderr, "error creating pipe: %s (%d)\n", strerror(errno), errno);
+        return false;
+    }
+    unique_fd pipeIn(pipeFds[0]);
+    unique_fd pipeOut(pipeFds[1]);
+    // Best effort, the default pipe only holds 16 pages.
+    fcntl(pipeOut, F_SETPIPE_SZ, k_rawTracePipeSize);
 
-            if (zs.avail_in == 0) {
-                // More input is needed.
-                result = read(traceFD, in.get(), bufSize);
-                if (result < 0) {
-                    fprintf(stderr, "error reading trace: %s (%d)\n",
-                            strerror(errno), errno);
-                    result = Z_STREAM_END;
-                    break;
-                } else if (result == 0) {
-                    flush = Z_FINISH;
-                } else {
-                    zs.next_in = reinterpret_cast<Bytef*>(in.get());
-                    zs.avail_in = result;
-                }
-            }
+    // Without compression, the pages go from the ring buffer to the file without a copy.
+    std::unique_ptr<TraceCompressor> compressor;
+    if (g_compression != TraceCompressor::Algorithm::NONE) {
+        compressor = TraceCompressor::create(g_compression, outFd);
+        if (!compressor) {
+            return false;
+        }
+    }
+    std::vector<uint8_t> buf(k_rawTracePipeSize);
 
-            if (zs.avail_out == 0) {
-                // Need to write the output.
-                result = write(outFd, out.get(), bufSize);
-                if ((size_t)result < bufSize) {
-                    fprintf(stderr, "error writing deflated trace: %s (%d)\n",
-                            strerror(errno), errno);
-                    result = Z_STREAM_END; // skip deflate error message
-                    zs.avail_out = bufSize; // skip the final write
-                    break;
+    while (true) {
+        ssize_t spliced = splice(traceFd, nullptr, pipeOut, nullptr, k_rawTracePipeSize,
+                                 SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (spliced == -1 && errno == EINTR) {
+            continue;
+        }
+        if (spliced == 0 || (spliced == -1 && errno == EAGAIN)) {
+            break;
+        }
+        if (spliced == -1) {
+            fprintf(stderr, "error splicing %s: %s (%d)\n", tracePath.c_str(), strerror(errno),
+                    errno);
+            return false;
+        }
+        while (spliced > 0) {
+            ssize_t moved;
+            if (compressor) {
+                moved = TEMP_FAILURE_RETRY(read(pipeIn, buf.data(), spliced));
+                if (moved > 0 && !compressor->write(buf.data(), moved)) {
+                    return false;
                 }
-                zs.next_out = reinterpret_cast<Bytef*>(out.get());
-                zs.avail_out = bufSize;
+            } else {
+                moved = TEMP_FAILURE_RETRY(
+                        splice(pipeIn, nullptr, outFd, nullptr, spliced, SPLICE_F_MOVE));
             }
-
-        } while ((result = deflate(&zs, flush)) == Z_OK);
-
-        if (result != Z_STREAM_END) {
-            fprintf(stderr, "error deflating trace: %s\n", zs.msg);
-        }
-
-        if (zs.avail_out < bufSize) {
-            size_t bytes = bufSize - zs.avail_out;
-            result = write(outFd, out.get(), bytes);
-            if ((size_t)result < bytes) {
-                fprintf(stderr, "error writing deflated trace: %s (%d)\n",
-                        strerror(errno), errno);
+            if (moved <= 0) {
+                fprintf(stderr, "error writing %s: %s (%d)\n", outPath.c_str(), strerror(errno),
+                        errno);
+                return false;
             }
+            spliced -= moved;
         }
+    }
 
-        result = deflateEnd(&zs);
-        if (result != Z_OK) {
-            fprintf(stderr, "error cleaning up zlib: %d\n", result);
-        }
-    } else {
-        char buf[4096];
-        ssize_t rc;
-        while ((rc = TEMP_FAILURE_RETRY(read(traceFD, buf, sizeof(buf)))) > 0) {
-            if (!android::base::WriteFully(outFd, buf, rc)) {
-                fprintf(stderr, "error writing trace: %s\n", strerror(errno));
-                break;
-            }
+    // splice() only takes full pages, the page being written to is left to read().
+    std::unique_ptr<TraceCompressor> plainWriter;
+    if (!compressor) {
+        plainWriter = TraceCompressor::create(TraceCompressor::Algorithm::NONE, outFd);
+    }
+    TraceCompressor* writer = compressor ? compressor.get() : plainWriter.get();
+    while (true) {
+        ssize_t rc = TEMP_FAILURE_RETRY(read(traceFd, buf.data(), buf.size()));
+        if (rc == 0 || (rc == -1 && errno == EAGAIN)) {
+            break;
         }
         if (rc == -1) {
-            fprintf(stderr, "error dumping trace: %s\n", strerror(errno));
+            fprintf(stderr, "error reading %s: %s (%d)\n", tracePath.c_str(), strerror(errno),
+                    errno);
+            return false;
+        }
+        if (!writer->write(buf.data(), rc)) {
+            return false;
         }
     }
+    return writer->finish();
+}
 
-    close(traceFD);
+// Dump the raw ring buffers of every cpu to |dir|, on one thread per cpu.
+static bool dumpRawTrace(const char* dir)
+{
+    ALOGI("Dumping raw trace to %s", dir);
+    int cpus = 0;
+    while (fileExists(StringPrintf(k_rawTracePathTemplate, cpus).c_str())) {
+        cpus++;
+    }
+    if (cpus == 0) {
+        fprintf(stderr, "error dumping raw trace: no per-cpu buffer found\n");
+        return false;
+    }
+
+    std::vector<std::thread> threads;
+    std::unique_ptr<bool[]> results(new bool[cpus]);
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        threads.emplace_back([cpu, dir, &results]() {
+            results[cpu] = dumpRawCpuTrace(cpu, dir);
+        });
+    }
+    bool ok = true;
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        threads[cpu].join();
+        ok &= results[cpu];
+    }
+    return ok;
 }
 
 static void handleSignal(int /*signo*/)
@@ -1100,6 +1167,12 @@ static void showHelp(const char *cmd)
                     "  -s N            sleep for N seconds before tracing [default 0]\n"
                     "  -t N            trace for N seconds [default 5]\n"
                     "  -z              compress the trace dump\n"
+                    "  --zstd          compress the trace dump with zstd, on several\n"
+                    "                    threads, rather than zlib\n"
+                    "  --raw_dir dir   dump the raw per-cpu buffers to dir/cpuN.raw instead,\n"
+                    "                    one thread per cpu, compressed with -z or --zstd.\n"
+                    "                    The files can be turned into a trace.dat with\n"
+                    "                    trace-cmd restore.\n"
                     "  --async_start   start circular trace and return immediately\n"
                     "  --async_dump    dump the current contents of circular trace buffer\n"
                     "  --async_stop    stop tracing and dump the current contents of circular\n"
@@ -1283,6 +1356,8 @@ int main(int argc, char **argv)
             {"list_categories",   no_argument, nullptr,  0 },
             {"stream",            no_argument, nullptr,  0 },
             {"prefer_sdk",        no_argument, nullptr,  0 },
+            {"zstd",              no_argument, nullptr,  0 },
+            {"raw_dir",     required_argument, nullptr,  0 },
             {nullptr,                       0, nullptr,  0 }
         };
 
@@ -1330,7 +1405,9 @@ int main(int argc, char **argv)
             break;
 
             case 'z':
-                g_compress = true;
+                if (g_compression == TraceCompressor::Algorithm::NONE) {
+                    g_compression = TraceCompressor::Algorithm::ZLIB;
+                }
             break;
 
             case 'o':
@@ -1357,6 +1434,10 @@ int main(int argc, char **argv)
                     traceDump = false;
                 } else if (!strcmp(long_options[option_index].name, "prefer_sdk")) {
                     preferSdk = true;
+                } else if (!strcmp(long_options[option_index].name, "zstd")) {
+                    g_compression = TraceCompressor::Algorithm::ZSTD;
+                } else if (!strcmp(long_options[option_index].name, "raw_dir")) {
+                    g_rawTraceDir = optarg;
                 } else if (!strcmp(long_options[option_index].name, "list_categories")) {
                     listSupportedCategories();
                     exit(0);
@@ -1443,17 +1524,23 @@ int main(int argc, char **argv)
         if (!g_traceAborted) {
             printf(" done\n");
             fflush(stdout);
-            int outFd = STDOUT_FILENO;
-            if (g_outputFile) {
-                outFd = open(g_outputFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-            }
-            if (outFd == -1) {
-                printf("Failed to open '%s', err=%d", g_outputFile, errno);
+            if (g_rawTraceDir) {
+                if (!dumpRawTrace(g_rawTraceDir)) {
+                    fprintf(stderr, "error dumping raw trace to %s\n", g_rawTraceDir);
+                }
             } else {
-                dprintf(outFd, "TRACE:\n");
-                dumpTrace(outFd);
+                int outFd = STDOUT_FILENO;
                 if (g_outputFile) {
-                    close(outFd);
+                    outFd = open(g_outputFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                }
+                if (outFd == -1) {
+                    printf("Failed to open '%s', err=%d", g_outputFile, errno);
+                } else {
+                    dprintf(outFd, "TRACE:\n");
+                    dumpTrace(outFd);
+                    if (g_outputFile) {
+                        close(outFd);
+                    }
                 }
             }
         } else {
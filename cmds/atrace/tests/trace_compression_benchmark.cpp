@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the compression of recorded trace buffers, see README.md for how to
+// record them.
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <android-base/file.h>
+#include <android-base/strings.h>
+#include <android-base/unique_fd.h>
+#include <benchmark/benchmark.h>
+
+#include "../trace_compression.h"
+
+namespace android {
+
+using Algorithm = TraceCompressor::Algorithm;
+
+static const char* kDefaultTraceDir = "/data/local/tmp/atrace_benchmark";
+static const char* kOutputPath = "/data/local/tmp/atrace_benchmark.out";
+
+static std::string getTraceDir() {
+    const char* dir = getenv("ATRACE_BENCHMARK_DIR");
+    return dir != nullptr ? dir : kDefaultTraceDir;
+}
+
+// The text dump of "atrace --async_dump -o <dir>/trace".
+static const std::string& getTextTrace() {
+    static const std::string trace = [] {
+        std::string content;
+        android::base::ReadFileToString(getTraceDir() + "/trace", &content);
+        return content;
+    }();
+    return trace;
+}
+
+// The per-cpu buffers of "atrace --async_dump --raw_dir <dir>".
+static const std::vector<std::string>& getRawTraces() {
+    static const std::vector<std::string> traces = [] {
+        std::vector<std::string> names;
+        std::unique_ptr<DIR, int (*)(DIR*)> dir(opendir(getTraceDir().c_str()), closedir);
+        if (dir) {
+            while (dirent* entry = readdir(dir.get())) {
+                if (android::base::EndsWith(entry->d_name, ".raw")) {
+                    names.push_back(entry->d_name);
+                }
+            }
+        }
+        std::sort(names.begin(), names.end());
+        std::vector<std::string> contents;
+        for (const auto& name : names) {
+            std::string content;
+            android::base::ReadFileToString(getTraceDir() + "/" + name, &content);
+            contents.push_back(std::move(content));
+        }
+        return contents;
+    }();
+    return traces;
+}
+
+// Compresses |trace| as atrace does, in chunks of the size it reads.
+static bool compress(const std::string& trace, Algorithm algorithm, int fd, int threads,
+                     size_t* compressedSize) {
+    static const size_t kChunkSize = 1024 * 1024;
+    std::unique_ptr<TraceCompressor> compressor = TraceCompressor::create(algorithm, fd, threads);
+    if (!compressor) {
+        return false;
+    }
+    for (size_t offset = 0; offset < trace.size(); offset += kChunkSize) {
+        size_t size = std::min(kChunkSize, trace.size() - offset);
+        if (!compressor->write(trace.data() + offset, size)) {
+            return false;
+        }
+    }
+    if (!compressor->finish()) {
+        return false;
+    }
+    *compressedSize = compressor->bytesWritten();
+    return true;
+}
+
+static void setCounters(benchmark::State& state, size_t size, size_t compressedSize) {
+    state.SetBytesProcessed(state.iterations() * size);
+    state.counters["ratio"] = compressedSize > 0 ? static_cast<double>(size) / compressedSize : 0;
+}
+
+// The text dump, as with "atrace -z" or "atrace --zstd". Args: algorithm, zstd threads.
+static void BM_CompressTextTrace(benchmark::State& state) {
+    const std::string& trace = getTextTrace();
+    if (trace.empty()) {
+        state.SkipWithError("No recorded text trace");
+        return;
+    }
+    Algorithm algorithm = static_cast<Algorithm>(state.range(0));
+    size_t compressedSize = 0;
+    for (auto _ : state) {
+        android::base::unique_fd fd(
+                open(kOutputPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+        if (!compress(trace, algorithm, fd, state.range(1), &compressedSize)) {
+            state.SkipWithError("Compression failed");
+            break;
+        }
+    }
+    setCounters(state, trace.size(), compressedSize);
+    unlink(kOutputPath);
+}
+BENCHMARK(BM_CompressTextTrace)
+        ->Args({static_cast<int>(Algorithm::ZLIB), 0})
+        ->Args({static_cast<int>(Algorithm::ZSTD), 0})
+        ->Args({static_cast<int>(Algorithm::ZSTD), 2})
+        ->Args({static_cast<int>(Algorithm::ZSTD), 4})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+// The per-cpu buffers, as with "atrace --raw_dir", one thread per cpu. Args: algorithm.
+static void BM_CompressRawTrace(benchmark::State& state) {
+    const std::vector<std::string>& traces = getRawTraces();
+    if (traces.empty()) {
+        state.SkipWithError("No recorded raw trace");
+        return;
+    }
+    Algorithm algorithm = static_cast<Algorithm>(state.range(0));
+    size_t size = 0;
+    for (const auto& trace : traces) {
+        size += trace.size();
+    }
+    std::vector<size_t> compressedSizes(traces.size());
+    for (auto _ : state) {
+        std::vector<std::thread> threads;
+        std::unique_ptr<bool[]> results(new bool[traces.size()]);
+        for (size_t cpu = 0; cpu < traces.size(); cpu++) {
+            threads.emplace_back([&, cpu]() {
+                std::string path = kOutputPath + std::to_string(cpu);
+                android::base::unique_fd fd(
+                        open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+                results[cpu] = compress(traces[cpu], algorithm, fd, 0, &compressedSizes[cpu]);
+                unlink(path.c_str());
+            });
+        }
+        bool ok = true;
+        for (size_t cpu = 0; cpu < traces.size(); cpu++) {
+            threads[cpu].join();
+            ok &= results[cpu];
+        }
+        if (!ok) {
+            state.SkipWithError("Compression failed");
+            break;
+        }
+    }
+    size_t compressedSize = 0;
+    for (size_t s : compressedSizes) {
+        compressedSize += s;
+    }
+    setCounters(state, size, compressedSize);
+}
+BENCHMARK(BM_CompressRawTrace)
+        ->Arg(static_cast<int>(Algorithm::ZLIB))
+        ->Arg(static_cast<int>(Algorithm::ZSTD))
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+}  // namespace android
+
+BENCHMARK_MAIN();
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace_compression.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <zstd.h>
+
+#include <vector>
+
+#include <android-base/file.h>
+#include <android-base/macros.h>
+
+namespace android {
+
+namespace {
+
+class PlainWriter : public TraceCompressor {
+public:
+    explicit PlainWriter(int fd) : TraceCompressor(fd) {}
+
+    bool write(const void* data, size_t size) override { return writeOut(data, size); }
+
+    bool finish() override { return true; }
+};
+
+class ZlibCompressor : public TraceCompressor {
+public:
+    explicit ZlibCompressor(int fd) : TraceCompressor(fd), mOut(kBufSize) {}
+
+    ~ZlibCompressor() override {
+        if (mInitialized) {
+            deflateEnd(&mStream);
+        }
+    }
+
+    bool init() {
+        memset(&mStream, 0, sizeof(mStream));
+        int result = deflateInit(&mStream, Z_DEFAULT_COMPRESSION);
+        if (result != Z_OK) {
+            fprintf(stderr, "error initializing zlib: %d\n", result);
+            return false;
+        }
+        mInitialized = true;
+        return true;
+    }
+
+    bool write(const void* data, size_t size) override {
+        mStream.next_in = reinterpret_cast<Bytef*>(const_cast<void*>(data));
+        mStream.avail_in = size;
+        return deflateAll(Z_NO_FLUSH);
+    }
+
+    bool finish() override {
+        mStream.next_in = nullptr;
+        mStream.avail_in = 0;
+        return deflateAll(Z_FINISH);
+    }
+
+private:
+    static constexpr size_t kBufSize = 64 * 1024;
+
+    bool deflateAll(int flush) {
+        int result;
+        do {
+            mStream.next_out = mOut.data();
+            mStream.avail_out = mOut.size();
+            result = deflate(&mStream, flush);
+            if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+                fprintf(stderr, "error deflating trace: %s\n", mStream.msg);
+                return false;
+            }
+            if (!writeOut(mOut.data(), mOut.size() - mStream.avail_out)) {
+                return false;
+            }
+        } while (mStream.avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+        return true;
+    }
+
+    z_stream mStream;
+    bool mInitialized = false;
+    std::vector<Bytef> mOut;
+};
+
+class ZstdCompressor : public TraceCompressor {
+public:
+    explicit ZstdCompressor(int fd)
+          : TraceCompressor(fd), mContext(ZSTD_createCCtx()), mOut(ZSTD_CStreamOutSize()) {}
+
+    ~ZstdCompressor() override { ZSTD_freeCCtx(mContext); }
+
+    bool init(int threads) {
+        if (mContext == nullptr) {
+            fprintf(stderr, "error initializing zstd\n");
+            return false;
+        }
+        size_t result =
+                ZSTD_CCtx_setParameter(mContext, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+        if (ZSTD_isError(result)) {
+            fprintf(stderr, "error initializing zstd: %s\n", ZSTD_getErrorName(result));
+            return false;
+        }
+        // Fails if the library is built without threads, which only makes compressing slower.
+        if (threads > 0) {
+            ZSTD_CCtx_setParameter(mContext, ZSTD_c_nbWorkers, threads);
+        }
+        return true;
+    }
+
+    bool write(const void* data, size_t size) override {
+        ZSTD_inBuffer in = {data, size, 0};
+        while (in.pos < in.size) {
+            if (compress(&in, ZSTD_e_continue) == kError) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool finish() override {
+        ZSTD_inBuffer in = {nullptr, 0, 0};
+        size_t remaining;
+        do {
+            remaining = compress(&in, ZSTD_e_end);
+            if (remaining == kError) {
+                return false;
+            }
+        } while (remaining != 0);
+        return true;
+    }
+
+private:
+    static constexpr size_t kError = static_cast<size_t>(-1);
+
+    // Returns what's left to flush, or kError.
+    size_t compress(ZSTD_inBuffer* in, ZSTD_EndDirective directive) {
+        ZSTD_outBuffer out = {mOut.data(), mOut.size(), 0};
+        size_t result = ZSTD_compressStream2(mContext, &out, in, directive);
+        if (ZSTD_isError(result)) {
+            fprintf(stderr, "error compressing trace: %s\n", ZSTD_getErrorName(result));
+            return kError;
+        }
+        if (!writeOut(mOut.data(), out.pos)) {
+            return kError;
+        }
+        return result;
+    }
+
+    ZSTD_CCtx* mContext;
+    std::vector<uint8_t> mOut;
+};
+
+}  // namespace
+
+std::unique_ptr<TraceCompressor> TraceCompressor::create(Algorithm algorithm, int fd,
+                                                         int threads) {
+    switch (algorithm) {
+        case Algorithm::NONE:
+            return std::make_unique<PlainWriter>(fd);
+        case Algorithm::ZLIB: {
+            auto compressor = std::make_unique<ZlibCompressor>(fd);
+            return compressor->init() ? std::move(compressor) : nullptr;
+        }
+        case Algorithm::ZSTD: {
+            auto compressor = std::make_unique<ZstdCompressor>(fd);
+            return compressor->init(threads) ? std::move(compressor) : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+const char* TraceCompressor::fileSuffix(Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::NONE:
+            return "";
+        case Algorithm::ZLIB:
+            return ".z";
+        case Algorithm::ZSTD:
+            return ".zst";
+    }
+    return "";
+}
+
+bool TraceCompressor::writeOut(const void* data, size_t size) {
+    if (size == 0) {
+        return true;
+    }
+    if (!android::base::WriteFully(mFd, data, size)) {
+        fprintf(stderr, "error writing trace: %s (%d)\n", strerror(errno), errno);
+        return false;
+    }
+    mBytesWritten += size;
+    return true;
+}
+
+bool copyTrace(int fd, TraceCompressor* compressor, size_t bufSize) {
+    std::vector<uint8_t> buf(bufSize);
+    while (true) {
+        ssize_t rc = TEMP_FAILURE_RETRY(read(fd, buf.data(), buf.size()));
+        if (rc < 0) {
+            fprintf(stderr, "error reading trace: %s (%d)\n", strerror(errno), errno);
+            return false;
+        }
+        if (rc == 0) {
+            return true;
+        }
+        if (!compressor->write(buf.data(), rc)) {
+            return false;
+        }
+    }
+}
+
+}  // namespace android
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAMEWORK_NATIVE_CMDS_ATRACE_TRACE_COMPRESSION_H_
+#define FRAMEWORK_NATIVE_CMDS_ATRACE_TRACE_COMPRESSION_H_
+
+#include <stddef.h>
+
+#include <memory>
+
+namespace android {
+
+// Writes trace data to a file descriptor as it comes, optionally compressed.
+// Errors are reported on stderr.
+class TraceCompressor {
+public:
+    enum class Algorithm {
+        NONE,
+        // A zlib stream, as written by "atrace -z".
+        ZLIB,
+        // A zstd frame, compressed on several threads if the library supports it.
+        ZSTD,
+    };
+
+    // Returns a compressor writing to |fd|, or nullptr if it couldn't be set up.
+    // |threads| is the number of threads zstd compresses on, 0 compressing on
+    // the calling thread. It is ignored by the other algorithms.
+    static std::unique_ptr<TraceCompressor> create(Algorithm algorithm, int fd, int threads = 0);
+
+    // Returns the suffix of a file holding data compressed with |algorithm|,
+    // e.g. ".zst".
+    static const char* fileSuffix(Algorithm algorithm);
+
+    virtual ~TraceCompressor() = default;
+
+    // Compresses |size| bytes and writes out what is ready.
+    virtual bool write(const void* data, size_t size) = 0;
+
+    // Writes out the end of the data. Nothing can be written afterwards.
+    virtual bool finish() = 0;
+
+    // Returns the number of bytes written to the file descriptor so far.
+    size_t bytesWritten() const { return mBytesWritten; }
+
+protected:
+    explicit TraceCompressor(int fd) : mFd(fd) {}
+
+    bool writeOut(const void* data, size_t size);
+
+private:
+    const int mFd;
+    size_t mBytesWritten = 0;
+};
+
+// Reads |fd| until the end, in chunks of |bufSize| bytes, and hands the data
+// to |compressor|. Doesn't finish the compressor.
+bool copyTrace(int fd, TraceCompressor* compressor, size_t bufSize);
+
+}  // namespace android
+
+#endif  // FRAMEWORK_NATIVE_CMDS_ATRACE_TRACE_COMPRESSION_H_
@@ -0,0 +1,413 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "dumpstate"
+
+#include "DumpScheduler.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <android-base/stringprintf.h>
+#include <android-base/unique_fd.h>
+#include <log/log.h>
+
+#include "DumpPool.h"
+#include "dumpstate.h"
+#include "DumpstateInternal.h"
+#include "DumpstateUtil.h"
+
+namespace android {
+namespace os {
+namespace dumpstate {
+
+using android::base::StringPrintf;
+
+static const char* ResourceName(DumpScheduler::Resource resource) {
+    switch (resource) {
+        case DumpScheduler::IO:
+            return "io";
+        case DumpScheduler::BINDER:
+            return "binder";
+        case DumpScheduler::CPU:
+            return "cpu";
+        default:
+            return "unknown";
+    }
+}
+
+template <class Duration>
+static long long ToMillis(Duration duration) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
+DumpScheduler::DumpScheduler(const std::string& tmp_root) : tmp_root_(tmp_root), shutdown_(false),
+        log_duration_(true), created_(Clock::now()), liveness_(std::make_shared<Liveness>()) {
+    // Reading files barely competes with the rest, while cpu bound sections would skew each
+    // other's measurements.
+    limits_[IO] = 2;
+    limits_[BINDER] = 2;
+    limits_[CPU] = 1;
+    running_.fill(0);
+}
+
+DumpScheduler::~DumpScheduler() {
+    std::vector<std::thread> threads;
+    {
+        std::unique_lock alive_lock(liveness_->lock);
+        std::unique_lock lock(lock_);
+        shutdown_ = true;
+        liveness_->destroyed = true;
+        // Nobody checks the timeouts anymore, so the sections which have one are given up on
+        // right away. Their threads drop the results and exit once the sections return, without
+        // touching the scheduler.
+        for (const auto& section : sections_) {
+            if (section->state == RUNNING &&
+                (section->timed_out || section->timeout.count() > 0)) {
+                section->timed_out = true;
+                threads_[section->worker].detach();
+            }
+        }
+        threads = std::move(threads_);
+        threads_.clear();
+        condition_variable_.notify_all();
+    }
+
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    for (const auto& section : sections_) {
+        if (!section->result_path.empty()) {
+            unlink(section->result_path.c_str());
+        }
+    }
+}
+
+void DumpScheduler::setLimit(Resource resource, int limit) {
+    std::unique_lock lock(lock_);
+    limits_[resource] = std::max(limit, 1);
+}
+
+void DumpScheduler::addSection(const std::string& title, Resource resource,
+                               const std::vector<std::string>& dependencies,
+                               std::chrono::milliseconds timeout, Task task) {
+    std::unique_lock lock(lock_);
+    if (findSectionLocked(title) != nullptr) {
+        MYLOGE("Section %s added twice\n", title.c_str());
+        return;
+    }
+    auto section = std::make_unique<Section>();
+    section->title = title;
+    section->resource = resource;
+    section->timeout = timeout;
+    section->task = std::move(task);
+    // Only sections added earlier can be depended on, which keeps the graph acyclic.
+    for (const auto& dependency : dependencies) {
+        Section* other = findSectionLocked(dependency);
+        if (other == nullptr) {
+            MYLOGE("Section %s depends on unknown section %s\n", title.c_str(),
+                   dependency.c_str());
+            continue;
+        }
+        section->dependencies.push_back(other);
+    }
+    sections_.push_back(std::move(section));
+}
+
+void DumpScheduler::start(int thread_counts) {
+    assert(thread_counts > 0);
+    assert(threads_.empty());
+    if (thread_counts > MAX_THREAD_COUNT) {
+        thread_counts = MAX_THREAD_COUNT;
+    }
+    MYLOGI("Start section scheduler:%d\n", thread_counts);
+    std::unique_lock lock(lock_);
+    for (int i = 0; i < thread_counts; i++) {
+        startThreadLocked();
+    }
+}
+
+void DumpScheduler::startThreadLocked() {
+    size_t worker = threads_.size();
+    threads_.emplace_back(std::thread([this, worker]() {
+        std::string name = StringPrintf("dumpsched_%zu", worker + 1);
+        pthread_setname_np(pthread_self(), name.c_str());
+        loop(worker);
+    }));
+}
+
+void DumpScheduler::waitForSection(const std::string& title, int out_fd) {
+    DurationReporter duration_reporter("Wait for " + title, true);
+
+    std::unique_lock lock(lock_);
+    Section* section = findSectionLocked(title);
+    if (section == nullptr) {
+        MYLOGE("Waiting for unknown section %s\n", title.c_str());
+        return;
+    }
+    auto wait_started = Clock::now();
+    if (threads_.empty()) {
+        lock.unlock();
+        runSerially(section, out_fd);
+        lock.lock();
+    }
+    while (section->state != DONE) {
+        auto next_timeout = checkTimeoutsLocked();
+        if (section->state == PENDING && !section->timed_out && section->timeout.count() > 0) {
+            auto deadline = wait_started + section->timeout;
+            if (deadline <= Clock::now()) {
+                MYLOGE("Section %s didn't start within %lldms\n", title.c_str(),
+                       ToMillis(section->timeout));
+                section->timed_out = true;
+                // Sections depending on this one don't need to wait for it anymore.
+                condition_variable_.notify_all();
+            } else {
+                next_timeout = std::min(next_timeout, deadline);
+            }
+        }
+        if (section->timed_out) {
+            break;
+        }
+        waitLocked(lock, next_timeout);
+    }
+    section->waited = Clock::now() - wait_started;
+
+    if (section->timed_out) {
+        bool started = section->state != PENDING;
+        lock.unlock();
+        if (started) {
+            dprintf(out_fd, "*** %s: timed out after %lldms, results dropped\n", title.c_str(),
+                    ToMillis(section->timeout));
+        } else {
+            dprintf(out_fd, "*** %s: didn't start within %lldms, skipped\n", title.c_str(),
+                    ToMillis(section->timeout));
+        }
+        return;
+    }
+    std::string result_path = std::move(section->result_path);
+    section->result_path.clear();
+    lock.unlock();
+
+    if (!result_path.empty()) {
+        DumpFileToFd(out_fd, "", result_path);
+        if (unlink(result_path.c_str())) {
+            MYLOGE("Failed to unlink (%s): %s\n", result_path.c_str(), strerror(errno));
+        }
+    }
+}
+
+std::string DumpScheduler::getTimingReport() {
+    std::unique_lock lock(lock_);
+    std::string report = StringPrintf("%-40s %-7s %10s %10s %10s  %s\n", "SECTION", "CLASS",
+                                      "START_MS", "RUN_MS", "WAITED_MS", "STATUS");
+    for (const auto& section : sections_) {
+        std::string status;
+        long long start_ms = -1, run_ms = -1;
+        if (section->state == PENDING) {
+            status = section->timed_out ? "timed out" : "not run";
+        } else {
+            start_ms = ToMillis(section->started - created_);
+            if (section->state == DONE) {
+                run_ms = ToMillis(section->finished - section->started);
+            }
+            status = section->timed_out ? "timed out" : section->state == DONE ? "done" : "running";
+        }
+        report += StringPrintf("%-40s %-7s %10lld %10lld %10lld  %s\n", section->title.c_str(),
+                               ResourceName(section->resource), start_ms, run_ms,
+                               ToMillis(section->waited), status.c_str());
+    }
+    return report;
+}
+
+DumpScheduler::Section* DumpScheduler::findSectionLocked(const std::string& title) {
+    for (const auto& section : sections_) {
+        if (section->title == title) {
+            return section.get();
+        }
+    }
+    return nullptr;
+}
+
+DumpScheduler::Clock::time_point DumpScheduler::checkTimeoutsLocked() {
+    auto now = Clock::now();
+    auto next_timeout = Clock::time_point::max();
+    for (const auto& section : sections_) {
+        if (section->state != RUNNING || section->timed_out || section->timeout.count() == 0) {
+            continue;
+        }
+        auto deadline = section->started + section->timeout;
+        if (deadline <= now) {
+            MYLOGE("Section %s timed out after %lldms\n", section->title.c_str(),
+                   ToMillis(section->timeout));
+            section->timed_out = true;
+            // Its thread may be stuck for good, so the section no longer counts against the
+            // limit of its class, and another thread takes over.
+            running_[section->resource]--;
+            if (!shutdown_) {
+                startThreadLocked();
+            }
+            // Sections depending on this one don't need to wait for it anymore.
+            condition_variable_.notify_all();
+        } else {
+            next_timeout = std::min(next_timeout, deadline);
+        }
+    }
+    return next_timeout;
+}
+
+void DumpScheduler::waitLocked(std::unique_lock<std::mutex>& lock, Clock::time_point until) {
+    if (until == Clock::time_point::max()) {
+        condition_variable_.wait(lock);
+    } else {
+        condition_variable_.wait_until(lock, until);
+    }
+}
+
+bool DumpScheduler::isReadyLocked(const Section& section) {
+    if (section.state != PENDING || section.timed_out ||
+        running_[section.resource] >= limits_[section.resource]) {
+        return false;
+    }
+    for (const Section* dependency : section.dependencies) {
+        if (dependency->state != DONE && !dependency->timed_out) {
+            return false;
+        }
+    }
+    return true;
+}
+
+DumpScheduler::Section* DumpScheduler::nextSectionLocked() {
+    // Sections are picked in the order they were added, which is about the order the bugreport
+    // waits for them.
+    for (const auto& section : sections_) {
+        if (isReadyLocked(*section)) {
+            return section.get();
+        }
+    }
+    return nullptr;
+}
+
+bool DumpScheduler::runSection(Section* section, int out_fd) {
+    // The section goes away with the scheduler, which may happen while the task runs.
+    std::shared_ptr<Liveness> liveness = liveness_;
+    std::string title = section->title;
+    Task task = section->task;
+    android::base::unique_fd result_fd;
+    std::string result_path;
+    if (out_fd < 0) {
+        std::string path_template = tmp_root_ + "/" + DumpPool::PREFIX_TMPFILE_NAME + "XXXXXX";
+        result_fd.reset(TEMP_FAILURE_RETRY(mkostemp(path_template.data(), O_CLOEXEC)));
+        if (result_fd.get() == -1) {
+            MYLOGE("open(%s, %s)\n", path_template.c_str(), strerror(errno));
+        } else {
+            result_path = path_template;
+        }
+        out_fd = result_fd.get();
+    }
+
+    if (out_fd >= 0) {
+        DurationReporter duration_reporter(title, /*logcat_only =*/!log_duration_,
+                /*verbose =*/false, out_fd);
+        std::invoke(task, out_fd);
+    }
+    result_fd.reset();
+
+    std::unique_lock alive_lock(liveness->lock);
+    if (liveness->destroyed) {
+        if (!result_path.empty()) {
+            unlink(result_path.c_str());
+        }
+        return false;
+    }
+    std::unique_lock lock(lock_);
+    section->finished = Clock::now();
+    section->state = DONE;
+    if (section->timed_out) {
+        // Nobody is going to dump the results anymore.
+        if (!result_path.empty()) {
+            unlink(result_path.c_str());
+        }
+    } else {
+        section->result_path = std::move(result_path);
+    }
+    condition_variable_.notify_all();
+    return true;
+}
+
+void DumpScheduler::runSerially(Section* section, int out_fd) {
+    for (Section* dependency : section->dependencies) {
+        if (dependency->state == PENDING) {
+            runSerially(dependency, -1);
+        }
+    }
+    if (section->state == PENDING) {
+        {
+            std::unique_lock lock(lock_);
+            section->state = RUNNING;
+            section->started = Clock::now();
+        }
+        runSection(section, out_fd);
+    }
+}
+
+void DumpScheduler::setLogDuration(bool log_duration) {
+    log_duration_ = log_duration;
+}
+
+void DumpScheduler::loop(size_t worker) {
+    std::unique_lock lock(lock_);
+    while (!shutdown_) {
+        auto next_timeout = checkTimeoutsLocked();
+        Section* section = nextSectionLocked();
+        if (section == nullptr) {
+            waitLocked(lock, next_timeout);
+            continue;
+        }
+        section->state = RUNNING;
+        section->started = Clock::now();
+        section->worker = worker;
+        running_[section->resource]++;
+        if (section->timeout.count() > 0) {
+            // So that the waiting threads check its timeout.
+            condition_variable_.notify_all();
+        }
+        lock.unlock();
+        if (!runSection(section, -1)) {
+            return;
+        }
+        lock.lock();
+        if (section->timed_out) {
+            // Another thread took over already.
+            return;
+        }
+        running_[section->resource]--;
+        condition_variable_.notify_all();
+    }
+}
+
+}  // namespace dumpstate
+}  // namespace os
+}  // namespace android
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAMEWORK_NATIVE_CMD_DUMPSCHEDULER_H_
+#define FRAMEWORK_NATIVE_CMD_DUMPSCHEDULER_H_
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace os {
+namespace dumpstate {
+
+class DumpSchedulerTest;
+
+/*
+ * Runs the sections of a bugreport on a few threads, following the
+ * dependencies declared between them. Each section belongs to a resource
+ * class, which limits how many sections of the same kind run at the same time,
+ * so that, e.g., two commands burning cpu don't skew each other's
+ * measurements. A section writes its results to the fd it's given, which is
+ * a temporary file copied to the bugreport when the section is waited for, so
+ * that the bugreport reads the same whatever order the sections ran in.
+ * Takes an example below for the usage of the DumpScheduler:
+ *
+ * DumpScheduler scheduler(tmp_root);
+ * scheduler.addSection("CPU INFO", DumpScheduler::CPU, {}, 10s, &DumpCpuInfo);
+ * scheduler.addSection("PROCDUMP", DumpScheduler::CPU, {"CPU INFO"}, 0s, &DumpProcs);
+ * scheduler.start();
+ * ...
+ * scheduler.waitForSection("CPU INFO", STDOUT_FILENO);
+ * ...
+ * scheduler.waitForSection("PROCDUMP", STDOUT_FILENO);
+ *
+ * If the scheduler isn't started, each section runs on the calling thread
+ * when it's waited for, right after any of its dependencies that didn't run
+ * yet, and timeouts are left to the sections themselves.
+ *
+ * A section running past its timeout is given up on: its thread is replaced
+ * by a new one, and it no longer counts against the limit of its class. The
+ * thread is left behind for good if the section is still stuck when the
+ * scheduler goes away.
+ */
+class DumpScheduler {
+  friend class android::os::dumpstate::DumpSchedulerTest;
+
+  public:
+    enum Resource {
+        IO,      // Mostly reads files, e.g. from procfs or sysfs.
+        BINDER,  // Mostly waits for other processes to dump, e.g. dumpsys.
+        CPU,     // Mostly computes, e.g. walks every process.
+        RESOURCE_COUNT
+    };
+
+    using Task = std::function<void(int out_fd)>;
+
+    /*
+     * |tmp_root| A path to a temporary folder for the results of the sections.
+     */
+    explicit DumpScheduler(const std::string& tmp_root);
+
+    /*
+     * Drops the sections that haven't started, and the results of the
+     * running ones with a timeout, without waiting for them. Waits until the
+     * running sections without a timeout finish.
+     */
+    ~DumpScheduler();
+
+    /*
+     * Sets how many sections of the given class may run at the same time.
+     * Only effective before start().
+     */
+    void setLimit(Resource resource, int limit);
+
+    /*
+     * Adds a section, which must happen before start().
+     *
+     * |title| The name of the section, used to wait for it and as the title of
+     * its DurationReporter log.
+     * |resource| The resource class of the section.
+     * |dependencies| The titles of sections, already added, which must be done
+     * or timed out before this one starts.
+     * |timeout| How long the section may run before it's given up on, or 0 for
+     * no limit. The results of a section given up on are dropped, and the
+     * sections depending on it may start.
+     * |task| Callable function dumping the section to the fd it's passed.
+     */
+    void addSection(const std::string& title, Resource resource,
+                    const std::vector<std::string>& dependencies,
+                    std::chrono::milliseconds timeout, Task task);
+
+    /*
+     * Starts running the sections on the given number of threads.
+     */
+    void start(int thread_counts = MAX_THREAD_COUNT);
+
+    /*
+     * Waits until the section is done, or timed out, and dumps its results
+     * to |out_fd|. A section with a timeout which didn't start within that
+     * time once waited for, e.g. because the sections of its class are slow,
+     * is given up on as well.
+     */
+    void waitForSection(const std::string& title, int out_fd);
+
+    /*
+     * Returns when each section started, how long it ran and how long the
+     * bugreport waited for it, as a table.
+     */
+    std::string getTimingReport();
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    enum State { PENDING, RUNNING, DONE };
+
+    struct Section {
+        std::string title;
+        Resource resource;
+        std::vector<Section*> dependencies;
+        std::chrono::milliseconds timeout;
+        Task task;
+        State state = PENDING;
+        bool timed_out = false;
+        // The index of the thread running the section, in threads_.
+        size_t worker = 0;
+        // A temporary file with the results, until they're dumped.
+        std::string result_path;
+        Clock::time_point started;
+        Clock::time_point finished;
+        Clock::duration waited = Clock::duration::zero();
+    };
+
+    // Shared with the threads, which may outlive the scheduler when stuck in a section that
+    // timed out.
+    struct Liveness {
+        std::mutex lock;  // Held while a thread hands over the results of a section.
+        bool destroyed = false;
+    };
+
+    Section* findSectionLocked(const std::string& title);
+    // Gives up on the sections running past their timeout, and returns when the next one will.
+    Clock::time_point checkTimeoutsLocked();
+    void waitLocked(std::unique_lock<std::mutex>& lock, Clock::time_point until);
+    Section* nextSectionLocked();
+    bool isReadyLocked(const Section& section);
+    void startThreadLocked();
+    // Returns false if the scheduler was destroyed while the section ran, in which case neither
+    // may be touched anymore.
+    bool runSection(Section* section, int out_fd);
+    void runSerially(Section* section, int out_fd);
+    void loop(size_t worker);
+
+    /*
+     * For test purpose only. Enables or disables logging duration of the
+     * sections.
+     */
+    void setLogDuration(bool log_duration);
+
+  private:
+    static const int MAX_THREAD_COUNT = 4;
+
+    /* A path to a temporary folder for the results of the sections. */
+    std::string tmp_root_;
+    bool shutdown_;
+    bool log_duration_;  // For test purpose only, the default value is true.
+    Clock::time_point created_;
+    std::shared_ptr<Liveness> liveness_;
+    std::mutex lock_;  // A lock for the sections_, running_ and threads_.
+    std::condition_variable condition_variable_;
+    std::vector<std::unique_ptr<Section>> sections_;
+    std::array<int, RESOURCE_COUNT> limits_;
+    std::array<int, RESOURCE_COUNT> running_;
+
+    std::vector<std::thread> threads_;
+
+    DISALLOW_COPY_AND_ASSIGN(DumpScheduler);
+};
+
+}  // namespace dumpstate
+}  // namespace os
+}  // namespace android
+
+#endif //FRAMEWORK_NATIVE_CMD_DUMPSCHEDULER_H_
@@ -0,0 +1,427 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "dumpstate"
+
+#include "ParallelZipWriter.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+
+#include <zlib.h>
+
+namespace android {
+namespace os {
+namespace dumpstate {
+
+static const uint32_t kLocalFileHeaderSignature = 0x04034b50;
+static const uint32_t kDataDescriptorSignature = 0x08074b50;
+static const uint32_t kCentralDirectorySignature = 0x02014b50;
+static const uint32_t kEndOfCentralDirectorySignature = 0x06054b50;
+
+static const uint16_t kVersion = 20;
+// The sizes and crc of an entry follow its data, as they're only known once it's written.
+static const uint16_t kDataDescriptorFlag = 0x0008;
+static const uint16_t kMethodStored = 0;
+static const uint16_t kMethodDeflated = 8;
+
+// Deflate looks back this far at most, so it's all a block needs from the previous one.
+static const size_t kDictionarySize = 32 * 1024;
+
+static void PutU16(std::vector<uint8_t>* out, uint16_t value) {
+    out->push_back(value & 0xff);
+    out->push_back(value >> 8);
+}
+
+static void PutU32(std::vector<uint8_t>* out, uint32_t value) {
+    PutU16(out, value & 0xffff);
+    PutU16(out, value >> 16);
+}
+
+static void PutString(std::vector<uint8_t>* out, const std::string& value) {
+    out->insert(out->end(), value.begin(), value.end());
+}
+
+// Converts to the MS-DOS date and time used by zip, which start in 1980.
+static void ToDosTime(time_t time, uint16_t* dos_time, uint16_t* dos_date) {
+    struct tm tm;
+    if (localtime_r(&time, &tm) == nullptr || tm.tm_year < 80) {
+        *dos_time = 0;
+        *dos_date = (1 << 5) | 1;
+        return;
+    }
+    *dos_time = (tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec >> 1);
+    *dos_date = ((tm.tm_year - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday;
+}
+
+const char* ParallelZipWriter::ErrorCodeString(int32_t error_code) {
+    switch (error_code) {
+        case kNoError:
+            return "No error";
+        case kIoError:
+            return "I/O error";
+        case kInvalidState:
+            return "Invalid state";
+        case kInvalidEntryName:
+            return "Invalid entry name";
+        case kZlibError:
+            return "Zlib error";
+        case kFileTooLarge:
+            return "File too large";
+        default:
+            return "Unknown error";
+    }
+}
+
+ParallelZipWriter::ParallelZipWriter(FILE* file, int thread_count)
+    : file_(file),
+      state_(State::kWritingZip),
+      error_(kNoError),
+      offset_(0),
+      current_entry_started_(false),
+      shutdown_(false) {
+    thread_count = std::clamp(thread_count, 0, MAX_THREAD_COUNT);
+    // Enough blocks in flight to keep every thread busy while the oldest one is written.
+    max_pending_ = 2 * thread_count + 1;
+    for (int i = 0; i < thread_count; i++) {
+        threads_.emplace_back([this, i]() {
+            std::string name = "dumpstate_zip" + std::to_string(i + 1);
+            pthread_setname_np(pthread_self(), name.c_str());
+            loop();
+        });
+    }
+}
+
+ParallelZipWriter::~ParallelZipWriter() {
+    {
+        std::unique_lock lock(lock_);
+        shutdown_ = true;
+        block_submitted_.notify_all();
+    }
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+int32_t ParallelZipWriter::StartEntryWithTime(const char* path, size_t flags, time_t time) {
+    if (state_ == State::kError) {
+        return error_;
+    }
+    if (state_ != State::kWritingZip) {
+        return kInvalidState;
+    }
+    std::string name(path);
+    if (name.empty() || name.size() > UINT16_MAX) {
+        return kInvalidEntryName;
+    }
+
+    current_entry_ = std::make_shared<Entry>();
+    current_entry_->path = std::move(name);
+    current_entry_->method = (flags & kCompress) ? kMethodDeflated : kMethodStored;
+    current_entry_->level =
+            (flags & kDefaultCompression) ? Z_DEFAULT_COMPRESSION : Z_BEST_COMPRESSION;
+    ToDosTime(time, &current_entry_->mod_time, &current_entry_->mod_date);
+    current_input_.clear();
+    current_input_.reserve(BLOCK_SIZE);
+    previous_input_ = nullptr;
+    current_entry_started_ = false;
+    state_ = State::kWritingEntry;
+    return kNoError;
+}
+
+int32_t ParallelZipWriter::WriteBytes(const void* data, size_t len) {
+    if (state_ == State::kError) {
+        return error_;
+    }
+    if (state_ != State::kWritingEntry) {
+        return kInvalidState;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (len > 0) {
+        size_t count = std::min(len, BLOCK_SIZE - current_input_.size());
+        current_input_.insert(current_input_.end(), bytes, bytes + count);
+        bytes += count;
+        len -= count;
+        if (current_input_.size() == BLOCK_SIZE) {
+            int32_t err = SubmitBlock(/* last = */false);
+            if (err != kNoError) {
+                return err;
+            }
+        }
+    }
+    return kNoError;
+}
+
+int32_t ParallelZipWriter::FinishEntry() {
+    if (state_ == State::kError) {
+        return error_;
+    }
+    if (state_ != State::kWritingEntry) {
+        return kInvalidState;
+    }
+    state_ = State::kWritingZip;
+    int32_t err = SubmitBlock(/* last = */true);
+    current_entry_ = nullptr;
+    return err;
+}
+
+int32_t ParallelZipWriter::Finish() {
+    if (state_ == State::kError) {
+        return error_;
+    }
+    if (state_ != State::kWritingZip) {
+        return kInvalidState;
+    }
+    int32_t err = WriteBlocks(/* max_pending = */0);
+    if (err != kNoError) {
+        return err;
+    }
+
+    const uint64_t central_directory_offset = offset_;
+    std::vector<uint8_t> record;
+    for (const auto& entry : entries_) {
+        record.clear();
+        PutU32(&record, kCentralDirectorySignature);
+        PutU16(&record, kVersion);  // Version made by.
+        PutU16(&record, kVersion);  // Version needed to extract.
+        PutU16(&record, kDataDescriptorFlag);
+        PutU16(&record, entry->method);
+        PutU16(&record, entry->mod_time);
+        PutU16(&record, entry->mod_date);
+        PutU32(&record, entry->crc);
+        PutU32(&record, entry->compressed_size);
+        PutU32(&record, entry->uncompressed_size);
+        PutU16(&record, entry->path.size());
+        PutU16(&record, 0);  // Extra field length.
+        PutU16(&record, 0);  // Comment length.
+        PutU16(&record, 0);  // Disk number.
+        PutU16(&record, 0);  // Internal attributes.
+        PutU32(&record, 0);  // External attributes.
+        PutU32(&record, entry->local_header_offset);
+        PutString(&record, entry->path);
+        if ((err = Write(record)) != kNoError) {
+            return SetError(err);
+        }
+    }
+    const uint64_t central_directory_size = offset_ - central_directory_offset;
+    if (entries_.size() > UINT16_MAX || offset_ > UINT32_MAX) {
+        return SetError(kFileTooLarge);
+    }
+
+    record.clear();
+    PutU32(&record, kEndOfCentralDirectorySignature);
+    PutU16(&record, 0);  // Disk number.
+    PutU16(&record, 0);  // Disk with the central directory.
+    PutU16(&record, entries_.size());
+    PutU16(&record, entries_.size());
+    PutU32(&record, central_directory_size);
+    PutU32(&record, central_directory_offset);
+    PutU16(&record, 0);  // Comment length.
+    if ((err = Write(record)) != kNoError) {
+        return SetError(err);
+    }
+    if (fflush(file_) != 0) {
+        return SetError(kIoError);
+    }
+    state_ = State::kDone;
+    return kNoError;
+}
+
+int32_t ParallelZipWriter::SubmitBlock(bool last) {
+    auto input = std::make_shared<const std::vector<uint8_t>>(std::move(current_input_));
+    current_input_ = std::vector<uint8_t>();
+    if (!last) {
+        current_input_.reserve(BLOCK_SIZE);
+    }
+
+    auto block = std::make_shared<Block>();
+    block->entry = current_entry_;
+    block->first = !current_entry_started_;
+    block->last = last;
+    block->input = input;
+    block->previous_input = std::move(previous_input_);
+    previous_input_ = last ? nullptr : input;
+    current_entry_started_ = true;
+
+    if (threads_.empty()) {
+        CompressBlock(block.get());
+        block->compressed = true;
+    } else {
+        std::unique_lock lock(lock_);
+        blocks_to_compress_.push(block);
+        block_submitted_.notify_one();
+    }
+    pending_.push_back(std::move(block));
+    return WriteBlocks(max_pending_);
+}
+
+int32_t ParallelZipWriter::WriteBlocks(size_t max_pending) {
+    while (!pending_.empty()) {
+        {
+            std::unique_lock lock(lock_);
+            if (!pending_.front()->compressed) {
+                if (pending_.size() <= max_pending) {
+                    break;
+                }
+                block_compressed_.wait(lock, [this] { return pending_.front()->compressed; });
+            }
+        }
+        std::shared_ptr<Block> block = std::move(pending_.front());
+        pending_.pop_front();
+        int32_t err = WriteBlock(*block);
+        if (err != kNoError) {
+            return SetError(err);
+        }
+    }
+    return kNoError;
+}
+
+int32_t ParallelZipWriter::WriteBlock(const Block& block) {
+    if (block.failed) {
+        return kZlibError;
+    }
+    Entry* entry = block.entry.get();
+    int32_t err;
+    if (block.first) {
+        entry->local_header_offset = offset_;
+        std::vector<uint8_t> header;
+        PutU32(&header, kLocalFileHeaderSignature);
+        PutU16(&header, kVersion);
+        PutU16(&header, kDataDescriptorFlag);
+        PutU16(&header, entry->method);
+        PutU16(&header, entry->mod_time);
+        PutU16(&header, entry->mod_date);
+        PutU32(&header, 0);  // Crc, in the data descriptor.
+        PutU32(&header, 0);  // Compressed size, in the data descriptor.
+        PutU32(&header, 0);  // Uncompressed size, in the data descriptor.
+        PutU16(&header, entry->path.size());
+        PutU16(&header, 0);  // Extra field length.
+        PutString(&header, entry->path);
+        if ((err = Write(header)) != kNoError) {
+            return err;
+        }
+    }
+
+    if ((err = Write(block.output)) != kNoError) {
+        return err;
+    }
+    entry->crc = crc32_combine(entry->crc, block.crc, block.input->size());
+    entry->compressed_size += block.output.size();
+    entry->uncompressed_size += block.input->size();
+
+    if (block.last) {
+        if (entry->compressed_size > UINT32_MAX || entry->uncompressed_size > UINT32_MAX ||
+            entry->local_header_offset > UINT32_MAX) {
+            return kFileTooLarge;
+        }
+        std::vector<uint8_t> descriptor;
+        PutU32(&descriptor, kDataDescriptorSignature);
+        PutU32(&descriptor, entry->crc);
+        PutU32(&descriptor, entry->compressed_size);
+        PutU32(&descriptor, entry->uncompressed_size);
+        if ((err = Write(descriptor)) != kNoError) {
+            return err;
+        }
+        entries_.push_back(block.entry);
+    }
+    return kNoError;
+}
+
+int32_t ParallelZipWriter::Write(const std::vector<uint8_t>& data) {
+    if (!data.empty() && fwrite(data.data(), 1, data.size(), file_) != data.size()) {
+        return kIoError;
+    }
+    offset_ += data.size();
+    return kNoError;
+}
+
+int32_t ParallelZipWriter::SetError(int32_t error) {
+    if (state_ != State::kError) {
+        state_ = State::kError;
+        error_ = error;
+    }
+    return error_;
+}
+
+void ParallelZipWriter::CompressBlock(Block* block) {
+    const std::vector<uint8_t>& input = *block->input;
+    block->crc = crc32(0, input.data(), input.size());
+    if (block->entry->method == kMethodStored) {
+        block->output = input;
+        return;
+    }
+
+    z_stream stream = {};
+    if (deflateInit2(&stream, block->entry->level, Z_DEFLATED, -MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        block->failed = true;
+        return;
+    }
+    if (block->previous_input) {
+        const std::vector<uint8_t>& previous = *block->previous_input;
+        size_t size = std::min(previous.size(), kDictionarySize);
+        if (deflateSetDictionary(&stream, previous.data() + previous.size() - size, size) !=
+            Z_OK) {
+            block->failed = true;
+            deflateEnd(&stream);
+            return;
+        }
+    }
+
+    // A sync flush ends all but the last block on a byte boundary, so that the blocks can be
+    // concatenated into a single deflate stream.
+    const int flush = block->last ? Z_FINISH : Z_SYNC_FLUSH;
+    block->output.resize(deflateBound(&stream, input.size()) + 16);
+    stream.next_in = const_cast<Bytef*>(input.data());
+    stream.avail_in = input.size();
+    while (true) {
+        stream.next_out = block->output.data() + stream.total_out;
+        stream.avail_out = block->output.size() - stream.total_out;
+        int ret = deflate(&stream, flush);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            block->failed = true;
+            break;
+        }
+        if (block->last ? ret == Z_STREAM_END : stream.avail_out != 0) {
+            break;
+        }
+        block->output.resize(block->output.size() * 2);
+    }
+    block->output.resize(stream.total_out);
+    deflateEnd(&stream);
+}
+
+void ParallelZipWriter::loop() {
+    std::unique_lock lock(lock_);
+    while (!shutdown_) {
+        if (blocks_to_compress_.empty()) {
+            block_submitted_.wait(lock);
+            continue;
+        }
+        std::shared_ptr<Block> block = std::move(blocks_to_compress_.front());
+        blocks_to_compress_.pop();
+        lock.unlock();
+        CompressBlock(block.get());
+        lock.lock();
+        block->compressed = true;
+        block_compressed_.notify_all();
+    }
+}
+
+}  // namespace dumpstate
+}  // namespace os
+}  // namespace android
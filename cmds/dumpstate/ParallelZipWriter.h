@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAMEWORK_NATIVE_CMD_PARALLELZIPWRITER_H_
+#define FRAMEWORK_NATIVE_CMD_PARALLELZIPWRITER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace os {
+namespace dumpstate {
+
+/*
+ * Writes a zip file like ZipWriter from libziparchive does, but deflates the
+ * entries on a few threads. The data written to an entry is cut into blocks of
+ * BLOCK_SIZE bytes, which are compressed independently, each one primed with
+ * the end of the previous block, and stitched back in order into the single
+ * deflate stream of the entry. Blocks are compressed while the caller keeps
+ * writing, including the blocks of the next entries, so the caller only waits
+ * for the compression when too many blocks are in flight.
+ *
+ * As with ZipWriter, only one entry can be written at a time, and the writer
+ * must be used from one thread at a time. Once an error happened, every
+ * following call returns it.
+ */
+class ParallelZipWriter {
+  public:
+    enum {
+        // Deflates the data of the entry. Otherwise, the data is stored as is.
+        kCompress = 0x01,
+        // Uses the default compression level of zlib rather than the best one.
+        kDefaultCompression = 0x08,
+    };
+
+    enum : int32_t {
+        kNoError = 0,
+        kIoError = -1,
+        kInvalidState = -2,
+        kInvalidEntryName = -3,
+        kZlibError = -4,
+        kFileTooLarge = -5,
+    };
+
+    static constexpr size_t BLOCK_SIZE = 128 * 1024;
+    static constexpr int MAX_THREAD_COUNT = 4;
+
+    /*
+     * Returns a readable description of an error returned by the writer.
+     */
+    static const char* ErrorCodeString(int32_t error_code);
+
+    /*
+     * Creates a writer appending the zip file to |file|.
+     *
+     * |thread_count| the number of threads compressing blocks, or 0 to
+     * compress them on the calling thread.
+     */
+    explicit ParallelZipWriter(FILE* file, int thread_count = MAX_THREAD_COUNT);
+
+    /*
+     * Stops the threads. Blocks that aren't written yet are dropped, unless
+     * Finish() was called.
+     */
+    ~ParallelZipWriter();
+
+    /*
+     * Starts a new entry, finishing with FinishEntry() before the next one.
+     *
+     * |flags| a combination of kCompress and kDefaultCompression.
+     * |time| the modification time of the entry.
+     */
+    int32_t StartEntryWithTime(const char* path, size_t flags, time_t time);
+
+    /*
+     * Appends data to the current entry.
+     */
+    int32_t WriteBytes(const void* data, size_t len);
+
+    /*
+     * Ends the current entry. Its data may still be compressed and written
+     * afterwards.
+     */
+    int32_t FinishEntry();
+
+    /*
+     * Waits for all the entries to be written and writes the central
+     * directory. The writer can't be used afterwards.
+     */
+    int32_t Finish();
+
+  private:
+    enum class State { kWritingZip, kWritingEntry, kDone, kError };
+
+    struct Entry {
+        std::string path;
+        uint16_t method;
+        int level;
+        uint16_t mod_time;
+        uint16_t mod_date;
+        uint32_t crc = 0;
+        uint64_t compressed_size = 0;
+        uint64_t uncompressed_size = 0;
+        uint64_t local_header_offset = 0;
+    };
+
+    struct Block {
+        std::shared_ptr<Entry> entry;
+        bool first;
+        bool last;
+        std::shared_ptr<const std::vector<uint8_t>> input;
+        // Input of the previous block of the entry, used as dictionary.
+        std::shared_ptr<const std::vector<uint8_t>> previous_input;
+        std::vector<uint8_t> output;
+        uint32_t crc = 0;
+        bool compressed = false;  // Guarded by lock_.
+        bool failed = false;
+    };
+
+    int32_t SubmitBlock(bool last);
+    int32_t WriteBlocks(size_t max_pending);
+    int32_t WriteBlock(const Block& block);
+    int32_t Write(const std::vector<uint8_t>& data);
+    int32_t SetError(int32_t error);
+    static void CompressBlock(Block* block);
+    void loop();
+
+    FILE* file_;
+    State state_;
+    int32_t error_;
+    uint64_t offset_;
+    // Entries already written, for the central directory.
+    std::vector<std::shared_ptr<Entry>> entries_;
+    // Entry being written by the caller, and its pending data.
+    std::shared_ptr<Entry> current_entry_;
+    std::vector<uint8_t> current_input_;
+    std::shared_ptr<const std::vector<uint8_t>> previous_input_;
+    bool current_entry_started_;
+    // Blocks not written to the file yet, in order.
+    std::deque<std::shared_ptr<Block>> pending_;
+    size_t max_pending_;
+
+    std::vector<std::thread> threads_;
+    bool shutdown_;
+    std::mutex lock_;  // A lock for the blocks_to_compress_ and Block::compressed.
+    std::condition_variable block_submitted_;
+    std::condition_variable block_compressed_;
+    std::queue<std::shared_ptr<Block>> blocks_to_compress_;
+
+    DISALLOW_COPY_AND_ASSIGN(ParallelZipWriter);
+};
+
+}  // namespace dumpstate
+}  // namespace os
+}  // namespace android
+
+#endif //FRAMEWORK_NATIVE_CMD_PARALLELZIPWRITER_H_
@@ -124,6 +124,8 @@ using android::os::IDumpstateListener;
 using android::os::dumpstate::CommandOptions;
 using android::os::dumpstate::DumpFileToFd;
 using android::os::dumpstate::DumpPool;
+using android::os::dumpstate::DumpScheduler;
+using android::os::dumpstate::ParallelZipWriter;
 using android::os::dumpstate::PropertiesHelper;
 using android::os::dumpstate::TaskQueue;
 using android::os::dumpstate::WaitForTask;
@@ -240,10 +242,15 @@ static const std::string SHUTDOWN_CHECKPOINTS_FILE_PREFIX = "checkpoints-";
     WaitForTask(future);                     \
     RETURN_IF_USER_DENIED_CONSENT();
 
+#define WAIT_SECTION_WITH_CONSENT_CHECK(scheduler, title) \
+    RETURN_IF_USER_DENIED_CONSENT();                      \
+    scheduler.waitForSection(title, STDOUT_FILENO);       \
+    RETURN_IF_USER_DENIED_CONSENT();
+
 static const char* WAKE_LOCK_NAME = "dumpstate_wakelock";
 
-// Names of parallel tasks, they are used for the DumpPool to identify the dump
-// task and the log title of the duration report.
+// Names of parallel tasks, they are used for the DumpPool or the DumpScheduler to
+// identify the dump task and the log title of the duration report.
 static const std::string DUMP_TRACES_TASK = "DUMP TRACES";
 static const std::string DUMP_INCIDENT_REPORT_TASK = "INCIDENT REPORT";
 static const std::string DUMP_NETSTATS_PROTO_TASK = "DUMP NETSTATS PROTO";
@@ -251,6 +258,12 @@ static const std::string DUMP_HALS_TASK = "DUMP HALS";
 static const std::string DUMP_BOARD_TASK = "dumpstate_board()";
 static const std::string DUMP_CHECKINS_TASK = "DUMP CHECKINS";
 static const std::string SERIALIZE_PERFETTO_TRACE_TASK = "SERIALIZE PERFETTO TRACE";
+static const std::string DUMP_PROCESSES_TASK = "DUMP PROCESSES";
+static const std::string DUMP_PROCDUMP_TASK = "DUMP PROCDUMP";
+static const std::string DUMP_KERNEL_MODULES_TASK = "DUMP KERNEL MODULES";
+static const std::string DUMP_BINDER_LOGS_TASK = "DUMP BINDER LOGS";
+static const std::string DUMP_APP_INFOS_TASK = "DUMP APP INFOS";
+static const std::string DUMP_DROPBOX_CRASHES_TASK = "DUMP DROPBOX CRASHES";
 
 namespace android {
 namespace os {
@@ -367,8 +380,9 @@ static void RunDumpsys(const std::string& title, const std::vector<std::string>&
                        int out_fd) {
     return ds.RunDumpsys(title, dumpsysArgs, Dumpstate::DEFAULT_DUMPSYS, 0, out_fd);
 }
-static int DumpFile(const std::string& title, const std::string& path) {
-    return ds.DumpFile(title, path);
+static int DumpFile(const std::string& title, const std::string& path,
+                    int out_fd = STDOUT_FILENO) {
+    return ds.DumpFile(title, path, out_fd);
 }
 
 // Relative directory (inside the zip) for all files copied as-is into the bugreport.
@@ -863,12 +877,12 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
 
     // Logging statement  below is useful to time how long each entry takes, but it's too verbose.
     // MYLOGD("Adding zip entry %s\n", entry_name.c_str());
-    size_t flags = ZipWriter::kCompress | ZipWriter::kDefaultCompression;
+    size_t flags = ParallelZipWriter::kCompress | ParallelZipWriter::kDefaultCompression;
     int32_t err = zip_writer_->StartEntryWithTime(valid_name.c_str(), flags,
                                                   get_mtime(fd, ds.now_));
     if (err != 0) {
         MYLOGE("zip_writer_->StartEntryWithTime(%s): %s\n", valid_name.c_str(),
-               ZipWriter::ErrorCodeString(err));
+               ParallelZipWriter::ErrorCodeString(err));
         return UNKNOWN_ERROR;
     }
     bool finished_entry = false;
@@ -917,7 +931,7 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
         }
         err = zip_writer_->WriteBytes(buffer.data(), bytes_read);
         if (err) {
-            MYLOGE("zip_writer_->WriteBytes(): %s\n", ZipWriter::ErrorCodeString(err));
+            MYLOGE("zip_writer_->WriteBytes(): %s\n", ParallelZipWriter::ErrorCodeString(err));
             return UNKNOWN_ERROR;
         }
     }
@@ -925,7 +939,7 @@ status_t Dumpstate::AddZipEntryFromFd(const std::string& entry_name, int fd,
     err = zip_writer_->FinishEntry();
     finished_entry = true;
     if (err != 0) {
-        MYLOGE("zip_writer_->FinishEntry(): %s\n", ZipWriter::ErrorCodeString(err));
+        MYLOGE("zip_writer_->FinishEntry(): %s\n", ParallelZipWriter::ErrorCodeString(err));
         return UNKNOWN_ERROR;
     }
 
@@ -956,24 +970,24 @@ void Dumpstate::AddDir(const std::string& dir, bool recursive) {
 
 bool Dumpstate::AddTextZipEntry(const std::string& entry_name, const std::string& content) {
     MYLOGD("Adding zip text entry %s\n", entry_name.c_str());
-    size_t flags = ZipWriter::kCompress | ZipWriter::kDefaultCompression;
+    size_t flags = ParallelZipWriter::kCompress | ParallelZipWriter::kDefaultCompression;
     int32_t err = zip_writer_->StartEntryWithTime(entry_name.c_str(), flags, ds.now_);
     if (err != 0) {
         MYLOGE("zip_writer_->StartEntryWithTime(%s): %s\n", entry_name.c_str(),
-               ZipWriter::ErrorCodeString(err));
+               ParallelZipWriter::ErrorCodeString(err));
         return false;
     }
 
     err = zip_writer_->WriteBytes(content.c_str(), content.length());
     if (err != 0) {
         MYLOGE("zip_writer_->WriteBytes(%s): %s\n", entry_name.c_str(),
-               ZipWriter::ErrorCodeString(err));
+               ParallelZipWriter::ErrorCodeString(err));
         return false;
     }
 
     err = zip_writer_->FinishEntry();
     if (err != 0) {
-        MYLOGE("zip_writer_->FinishEntry(): %s\n", ZipWriter::ErrorCodeString(err));
+        MYLOGE("zip_writer_->FinishEntry(): %s\n", ParallelZipWriter::ErrorCodeString(err));
         return false;
     }
 
@@ -1364,8 +1378,6 @@ static Dumpstate::RunStatus RunDumpsysProto(const std::string& title, int priori
             bool dumpTerminated = (status == OK);
             dumpsys.stopDumpThread(dumpTerminated);
         }
-        ZipWriter::FileEntry file_entry;
-        ds.zip_writer_->GetLastEntry(&file_entry);
 
         auto elapsed_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::steady_clock::now() - start);
@@ -1655,6 +1667,101 @@ static void DumpAppInfos(int out_fd = STDOUT_FILENO) {
             DUMPSYS_COMPONENTS_OPTIONS, 0, out_fd);
 }
 
+/*
+ * Dumps the cpu usage, the threads and the open files of every process.
+ *
+ * |out_fd| A fd to support the DumpScheduler to output results to a temporary file.
+ * Using STDOUT_FILENO if it's not running in the parallel task.
+ */
+static void DumpProcesses(int out_fd = STDOUT_FILENO) {
+    RunCommand("CPU INFO", {"top", "-b", "-n", "1", "-H", "-s", "6", "-o",
+                            "pid,tid,user,pr,ni,%cpu,s,virt,res,pcy,cmd,name"},
+               CommandOptions::DEFAULT, false, out_fd);
+    RunCommand("PROCESSES AND THREADS",
+               {"ps", "-A", "-T", "-Z", "-O", "pri,nice,rtprio,sched,pcy,time"},
+               CommandOptions::DEFAULT, false, out_fd);
+    RunCommand("LIST OF OPEN FILES", {"lsof"}, CommandOptions::AS_ROOT, false, out_fd);
+}
+
+/*
+ * Dumps the loaded kernel modules.
+ *
+ * |out_fd| A fd to support the DumpScheduler to output results to a temporary file.
+ * Using STDOUT_FILENO if it's not running in the parallel task.
+ */
+static void DumpKernelModules(int out_fd = STDOUT_FILENO) {
+    struct stat s;
+    if (stat("/proc/modules", &s) != 0) {
+        MYLOGD("Skipping 'lsmod' because /proc/modules does not exist\n");
+        return;
+    }
+    RunCommand("LSMOD", {"lsmod"}, CommandOptions::DEFAULT, false, out_fd);
+    RunCommand("MODULES INFO",
+               {"sh", "-c", "cat /proc/modules | cut -d' ' -f1 | "
+                "    while read MOD ; do echo modinfo:$MOD ; modinfo $MOD ; "
+                "done"}, CommandOptions::AS_ROOT, false, out_fd);
+}
+
+/*
+ * Dumps the binder logs. Binder state is expensive to look at as it uses a lot of memory.
+ *
+ * |out_fd| A fd to support the DumpScheduler to output results to a temporary file.
+ * Using STDOUT_FILENO if it's not running in the parallel task.
+ */
+static void DumpBinderLogs(int out_fd = STDOUT_FILENO) {
+    std::string binder_logs_dir = access("/dev/binderfs/binder_logs", R_OK) ?
+            "/sys/kernel/debug/binder" : "/dev/binderfs/binder_logs";
+
+    DumpFile("BINDER FAILED TRANSACTION LOG", binder_logs_dir + "/failed_transaction_log", out_fd);
+    DumpFile("BINDER TRANSACTION LOG", binder_logs_dir + "/transaction_log", out_fd);
+    DumpFile("BINDER TRANSACTIONS", binder_logs_dir + "/transactions", out_fd);
+    DumpFile("BINDER STATS", binder_logs_dir + "/stats", out_fd);
+    DumpFile("BINDER STATE", binder_logs_dir + "/state", out_fd);
+}
+
+/*
+ * Dumps the crashes of system_server and system apps kept by dropbox.
+ *
+ * |out_fd| A fd to support the DumpScheduler to output results to a temporary file.
+ * Using STDOUT_FILENO if it's not running in the parallel task.
+ */
+static void DumpDropboxCrashes(int out_fd = STDOUT_FILENO) {
+    dprintf(out_fd, "========================================================\n");
+    dprintf(out_fd, "== Dropbox crashes\n");
+    dprintf(out_fd, "========================================================\n");
+
+    RunDumpsys("DROPBOX SYSTEM SERVER CRASHES", {"dropbox", "-p", "system_server_crash"}, out_fd);
+    RunDumpsys("DROPBOX SYSTEM APP CRASHES", {"dropbox", "-p", "system_app_crash"}, out_fd);
+}
+
+/*
+ * Adds the sections of dumpstate() that can run concurrently to the scheduler,
+ * with their resource class and timeout.
+ */
+static void AddDumpstateSections(DumpScheduler* scheduler) {
+    scheduler->addSection(DUMP_PROCESSES_TASK, DumpScheduler::CPU, {}, 60s, &DumpProcesses);
+    // Dumping every process would skew the cpu usage measured by top.
+    scheduler->addSection(DUMP_PROCDUMP_TASK, DumpScheduler::CPU, {DUMP_PROCESSES_TASK}, 60s,
+                          [](int out_fd) {
+        RunCommand("BUGREPORT_PROCDUMP", {"bugreport_procdump"}, CommandOptions::AS_ROOT, false,
+                   out_fd);
+    });
+    scheduler->addSection(DUMP_HALS_TASK, DumpScheduler::BINDER, {}, 0s, &DumpHals);
+    scheduler->addSection(DUMP_KERNEL_MODULES_TASK, DumpScheduler::IO, {}, 30s,
+                          &DumpKernelModules);
+    scheduler->addSection(DUMP_BINDER_LOGS_TASK, DumpScheduler::IO, {}, 30s, &DumpBinderLogs);
+    scheduler->addSection(DUMP_BOARD_TASK, DumpScheduler::BINDER, {}, 0s,
+                          std::bind(&Dumpstate::DumpstateBoard, &ds, _1));
+    scheduler->addSection(DUMP_CHECKINS_TASK, DumpScheduler::BINDER, {}, 0s, &DumpCheckins);
+    scheduler->addSection(DUMP_APP_INFOS_TASK, DumpScheduler::BINDER, {}, 300s, &DumpAppInfos);
+    scheduler->addSection(DUMP_DROPBOX_CRASHES_TASK, DumpScheduler::BINDER, {}, 30s,
+                          &DumpDropboxCrashes);
+    scheduler->addSection(DUMP_NETSTATS_PROTO_TASK, DumpScheduler::BINDER, {}, 0s,
+                          [](int) { DumpNetstatsProto(); });
+    scheduler->addSection(DUMP_INCIDENT_REPORT_TASK, DumpScheduler::BINDER, {}, 0s,
+                          [](int) { DumpIncidentReport(); });
+}
+
 // Dumps various things. Returns early with status USER_CONSENT_DENIED if user denies consent
 // via the consent they are shown. Ignores other errors that occur while running various
 // commands. The consent checking is currently done around long running tasks, which happen to
@@ -1662,22 +1769,13 @@ static void DumpAppInfos(int out_fd = STDOUT_FILENO) {
 Dumpstate::RunStatus Dumpstate::dumpstate() {
     DurationReporter duration_reporter("DUMPSTATE");
 
-    // Enqueue slow functions into the thread pool, if the parallel run is enabled.
-    std::future<std::string> dump_hals, dump_incident_report, dump_board, dump_checkins,
-        dump_netstats_report;
+    // Runs slow sections on the scheduler, if the parallel run is enabled. Otherwise, each
+    // section runs in place when it's waited for.
+    DumpScheduler scheduler(ds.bugreport_internal_dir_);
+    AddDumpstateSections(&scheduler);
     if (ds.dump_pool_) {
-        // Pool was shutdown in DumpstateDefaultAfterCritical method in order to
-        // drop root user. Restarts it.
-        ds.dump_pool_->start(/* thread_counts = */3);
-
-        dump_hals = ds.dump_pool_->enqueueTaskWithFd(DUMP_HALS_TASK, &DumpHals, _1);
-        dump_incident_report = ds.dump_pool_->enqueueTask(
-            DUMP_INCIDENT_REPORT_TASK, &DumpIncidentReport);
-        dump_netstats_report = ds.dump_pool_->enqueueTask(
-            DUMP_NETSTATS_PROTO_TASK, &DumpNetstatsProto);
-        dump_board = ds.dump_pool_->enqueueTaskWithFd(
-            DUMP_BOARD_TASK, &Dumpstate::DumpstateBoard, &ds, _1);
-        dump_checkins = ds.dump_pool_->enqueueTaskWithFd(DUMP_CHECKINS_TASK, &DumpCheckins, _1);
+        // The threads are started after DumpstateDefaultAfterCritical dropped the root user.
+        scheduler.start();
     }
 
     // Dump various things. Note that anything that takes "long" (i.e. several seconds) should
@@ -1687,11 +1785,9 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
     RunCommand("UPTIME", {"uptime"});
     DumpBlockStatFiles();
     DumpFile("MEMORY INFO", "/proc/meminfo");
-    RunCommand("CPU INFO", {"top", "-b", "-n", "1", "-H", "-s", "6", "-o",
-                            "pid,tid,user,pr,ni,%cpu,s,virt,res,pcy,cmd,name"});
+    WAIT_SECTION_WITH_CONSENT_CHECK(scheduler, DUMP_PROCESSES_TASK);
 
-    RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK(RunCommand, "BUGREPORT_PROCDUMP", {"bugreport_procdump"},
-                                         CommandOptions::AS_ROOT);
+    WAIT_SECTION_WITH_CONSENT_CHECK(scheduler, DUMP_PROCDUMP_TASK);
 
     RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK(DumpVisibleWindowViews);
 
@@ -1705,27 +1801,11 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
 
     DumpFile("KERNEL CPUFREQ", "/sys/devices/system/cpu/cpu0/cpufreq/stats/time_in_state");
 
-    RunCommand("PROCESSES AND THREADS",
-               {"ps", "-A", "-T", "-Z", "-O", "pri,nice,rtprio,sched,pcy,time"});
-
-    if (ds.dump_pool_) {
-        WAIT_TASK_WITH_CONSENT_CHECK(std::move(dump_hals));
-    } else {
-        RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK_AND_LOG(DUMP_HALS_TASK, DumpHals);
-    }
+    WAIT_SECTION_WITH_CONSENT_CHECK(scheduler, DUMP_HALS_TASK);
 
     RunCommand("PRINTENV", {"printenv"});
     RunCommand("NETSTAT", {"netstat", "-nW"});
-    struct stat s;
-    if (stat("/proc/modules", &s) != 0) {
-        MYLOGD("Skipping 'lsmod' because /proc/modules does not exist\n");
-    } else {
-        RunCommand("LSMOD", {"lsmod"});
-        RunCommand("MODULES INFO",
-                   {"sh", "-c", "cat /proc/modules | cut -d' ' -f1 | "
-                    "    while read MOD ; do echo modinfo:$MOD ; modinfo $MOD ; "
-                    "done"}, CommandOptions::AS_ROOT);
-    }
+    WAIT_SECTION_WITH_CONSENT_CHECK(scheduler, DUMP_KERNEL_MODULES_TASK);
 
     if (android::base::GetBoolProperty("ro.logd.kernel", false)) {
         DoKernelLogcat();
@@ -1735,8 +1815,6 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
 
     DumpVintf();
 
-    RunCommand("LIST OF OPEN FILES", {"lsof"}, CommandOptions::AS_ROOT);
-
     for_each_tid(show_wchan, "BLOCKED PROCESS WAIT-CHANNELS");
     for_each_pid(show_showtime, "PROCESS TIMES (pid cmd user system iowait+percentage)");
 
@@ -1802,23 +1880,11 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
 
     RunCommand("FILESYSTEMS & FREE SPACE", {"df"});
 
-    /* Binder state is expensive to look at as it uses a lot of memory. */
-    std::string binder_logs_dir = access("/dev/binderfs/binder_logs", R_OK) ?
-            "/sys/kernel/debug/binder" : "/dev/binderfs/binder_logs";
-
-    DumpFile("BINDER FAILED TRANSACTION LOG", binder_logs_dir + "/failed_transaction_log");
-    DumpFile("BINDER TRANSACTION LOG", binder_logs_dir + "/transaction_log");
-    DumpFile("BINDER TRANSACTIONS", binder_logs_dir + "/transactions");
-    DumpFile("BINDER STATS", binder_logs_dir + "/stats");
-    DumpFile("BINDER STATE", binder_logs_dir + "/state");
+    WAIT_SECTION_WITH_CONSENT_CHECK(scheduler, DUMP_BINDER_LOGS_TASK);
 
     ds.AddDir(SNAPSHOTCTL_LOG_DIR, false);
 
-    if (ds.dump_pool_) {
-        WAIT_TASK_WITH_CONSENT_CHECK(std::move(dump_board));
-    } else {
-        RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK_AND_LOG(DUMP_BOARD_TASK, ds.DumpstateBoard);
-    }
+    WAIT_SECTION_WITH_CONSENT_CHECK(scheduler, DUMP_BOARD_TASK);
 
     /* Migrate the ril_dumpstate to a device specific dumpstate? */
     int rilDumpstateTimeout = android::base::GetIntProperty("ril.dumpstate.timeout", 0);
@@ -1843,20 +1909,11 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
     /* Dump Bluetooth HCI logs after getting bluetooth_manager dumpsys */
     ds.AddDir("/data/misc/bluetooth/logs", true);
 
-    if (ds.dump_pool_) {
-        WAIT_TASK_WITH_CONSENT_CHECK(std::move(dump_checkins));
-    } else {
-        RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK_AND_LOG(DUMP_CHECKINS_TASK, DumpCheckins);
-    }
+    WAIT_SECTION_WITH_CONSENT_CHECK(scheduler, DUMP_CHECKINS_TASK);
 
-    RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK(DumpAppInfos);
+    WAIT_SECTION_WITH_CONSENT_CHECK(scheduler, DUMP_APP_INFOS_TASK);
 
-    printf("========================================================\n");
-    printf("== Dropbox crashes\n");
-    printf("========================================================\n");
-
-    RunDumpsys("DROPBOX SYSTEM SERVER CRASHES", {"dropbox", "-p", "system_server_crash"});
-    RunDumpsys("DROPBOX SYSTEM APP CRASHES", {"dropbox", "-p", "system_app_crash"});
+    WAIT_SECTION_WITH_CONSENT_CHECK(scheduler, DUMP_DROPBOX_CRASHES_TASK);
 
     printf("========================================================\n");
     printf("== Final progress (pid %d): %d/%d (estimated %d)\n", ds.pid_, ds.progress_->Get(),
@@ -1877,22 +1934,14 @@ Dumpstate::RunStatus Dumpstate::dumpstate() {
     /* Dump frozen cgroupfs */
     dump_frozen_cgroupfs();
 
-    if (ds.dump_pool_) {
-        WAIT_TASK_WITH_CONSENT_CHECK(std::move(dump_netstats_report));
-    } else {
-        RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK_AND_LOG(DUMP_NETSTATS_PROTO_TASK,
-                DumpNetstatsProto);
-    }
+    WAIT_SECTION_WITH_CONSENT_CHECK(scheduler, DUMP_NETSTATS_PROTO_TASK);
 
-    if (ds.dump_pool_) {
-        WAIT_TASK_WITH_CONSENT_CHECK(std::move(dump_incident_report));
-    } else {
-        RUN_SLOW_FUNCTION_WITH_CONSENT_CHECK_AND_LOG(DUMP_INCIDENT_REPORT_TASK,
-                DumpIncidentReport);
-    }
+    WAIT_SECTION_WITH_CONSENT_CHECK(scheduler, DUMP_INCIDENT_REPORT_TASK);
 
     MaybeAddUiTracesToZip();
 
+    ds.AddTextZipEntry("dumpstate_sections.txt", scheduler.getTimingReport());
+
     return Dumpstate::RunStatus::OK;
 }
 
@@ -2769,7 +2818,7 @@ bool Dumpstate::FinishZipFile() {
 
     int32_t err = zip_writer_->Finish();
     if (err != 0) {
-        MYLOGE("zip_writer_->Finish(): %s\n", ZipWriter::ErrorCodeString(err));
+        MYLOGE("zip_writer_->Finish(): %s\n", ParallelZipWriter::ErrorCodeString(err));
         return false;
     }
 
@@ -2822,7 +2871,7 @@ static void MaybeResolveSymlink(std::string* path) {
 }
 
 /*
- * Prepares state like filename, screenshot path, etc in Dumpstate. Also initializes ZipWriter
+ * Prepares state like filename, screenshot path, etc in Dumpstate. Also initializes the zip writer
  * and adds the version file. Return false if zip_file could not be open to write.
  */
 static bool PrepareToWriteToFile() {
@@ -2868,7 +2917,7 @@ static bool PrepareToWriteToFile() {
         MYLOGE("fopen(%s, 'wb'): %s\n", ds.path_.c_str(), strerror(errno));
         return false;
     }
-    ds.zip_writer_.reset(new ZipWriter(ds.zip_file.get()));
+    ds.zip_writer_.reset(new ParallelZipWriter(ds.zip_file.get()));
     ds.AddTextZipEntry("version.txt", ds.version_);
     return true;
 }
@@ -4287,10 +4336,11 @@ void do_dmesg() {
     return;
 }
 
-int Dumpstate::DumpFile(const std::string& title, const std::string& path) {
-    DurationReporter duration_reporter(title);
+int Dumpstate::DumpFile(const std::string& title, const std::string& path, int out_fd) {
+    DurationReporter duration_reporter(title, false /* logcat_only */, false /* verbose */,
+                                       out_fd);
 
-    int status = DumpFileToFd(STDOUT_FILENO, title, path);
+    int status = DumpFileToFd(out_fd, title, path);
 
     UpdateProgress(WEIGHT_FILE);
 
@@ -33,10 +33,11 @@
 #include <android/os/IDumpstate.h>
 #include <android/os/IDumpstateListener.h>
 #include <utils/StrongPointer.h>
-#include <ziparchive/zip_writer.h>
 
 #include "DumpstateUtil.h"
 #include "DumpPool.h"
+#include "DumpScheduler.h"
+#include "ParallelZipWriter.h"
 #include "TaskQueue.h"
 
 // TODO: move everything under this namespace
@@ -56,8 +57,6 @@ class ZippedBugReportStreamTest;
 }  // namespace os
 }  // namespace android
 
-class ZipWriter;
-
 // TODO: remove once moved to HAL
 #ifdef __cplusplus
 extern "C" {
@@ -262,8 +261,10 @@ class Dumpstate {
      * |title| description of the command printed on `stdout` (or empty to skip
      * description).
      * |path| location of the file to be dumped.
+     * |out_fd| A fd to support the DumpScheduler to output results to a temporary
+     * file. Using STDOUT_FILENO if it's not running in the parallel task.
      */
-    int DumpFile(const std::string& title, const std::string& path);
+    int DumpFile(const std::string& title, const std::string& path, int out_fd = STDOUT_FILENO);
 
     /*
      * Adds a new entry to the existing zip file.
@@ -517,7 +518,7 @@ class Dumpstate {
     std::unique_ptr<FILE, int (*)(FILE*)> zip_file{nullptr, fclose};
 
     // Pointer to the zip structure.
-    std::unique_ptr<ZipWriter> zip_writer_;
+    std::unique_ptr<android::os::dumpstate::ParallelZipWriter> zip_writer_;
 
     // Binder object listening to progress.
     android::sp<android::os::IDumpstateListener> listener_;
@@ -38,12 +38,15 @@
 #include <unistd.h>
 #include <ziparchive/zip_archive.h>
 
+#include <atomic>
 #include <filesystem>
 #include <thread>
 
 #include "DumpPool.h"
+#include "DumpScheduler.h"
 #include "DumpstateInternal.h"
 #include "DumpstateService.h"
+#include "ParallelZipWriter.h"
 #include "android/os/BnDumpstate.h"
 
 namespace android {
@@ -51,6 +54,7 @@ namespace os {
 namespace dumpstate {
 
 using DumpstateDeviceAidl = ::aidl::android::hardware::dumpstate::IDumpstateDevice;
+using ::std::literals::chrono_literals::operator""ms;
 using ::android::hardware::dumpstate::V1_1::DumpstateMode;
 using ::testing::EndsWith;
 using ::testing::Eq;
@@ -1833,6 +1837,279 @@ TEST_F(TaskQueueTest, runTask_withCancelled) {
     EXPECT_TRUE(is_task2_cancelled);
 }
 
+class DumpSchedulerTest : public DumpstateBaseTest {
+  public:
+    void SetUp() {
+        scheduler_ = std::make_unique<DumpScheduler>(kTestDataPath);
+        scheduler_->setLogDuration(/* log_duration = */false);
+        DumpstateBaseTest::SetUp();
+        out_path_ = kTestDataPath + "out.txt";
+        out_fd_.reset(TEMP_FAILURE_RETRY(open(out_path_.c_str(),
+                O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW,
+                S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)));
+        ASSERT_GE(out_fd_.get(), 0) << "could not create FD for path " << out_path_;
+    }
+
+    std::string getOutput() {
+        std::string result;
+        ReadFileToString(out_path_, &result);
+        return result;
+    }
+
+    std::unique_ptr<DumpScheduler> scheduler_;
+    android::base::unique_fd out_fd_;
+    std::string out_path_;
+};
+
+TEST_F(DumpSchedulerTest, WaitForSection_inWaitOrder) {
+    scheduler_->addSection("A", DumpScheduler::IO, {}, 0ms, [](int out_fd) {
+        usleep(100000);
+        dprintf(out_fd, "A");
+    });
+    scheduler_->addSection("B", DumpScheduler::IO, {}, 0ms, [](int out_fd) {
+        dprintf(out_fd, "B");
+    });
+    scheduler_->start();
+
+    scheduler_->waitForSection("B", out_fd_.get());
+    scheduler_->waitForSection("A", out_fd_.get());
+
+    EXPECT_THAT(getOutput(), StrEq("BA"));
+}
+
+TEST_F(DumpSchedulerTest, Dependencies) {
+    std::atomic<bool> a_done = false;
+    bool a_done_before_b = false;
+    scheduler_->addSection("A", DumpScheduler::IO, {}, 0ms, [&](int) {
+        usleep(100000);
+        a_done = true;
+    });
+    scheduler_->addSection("B", DumpScheduler::IO, {"A"}, 0ms, [&](int) {
+        a_done_before_b = a_done;
+    });
+    scheduler_->start();
+
+    scheduler_->waitForSection("B", out_fd_.get());
+    scheduler_->waitForSection("A", out_fd_.get());
+
+    EXPECT_TRUE(a_done_before_b);
+}
+
+TEST_F(DumpSchedulerTest, ResourceLimit) {
+    std::atomic<int> running = 0;
+    std::atomic<int> max_running = 0;
+    auto dump_func = [&](int) {
+        int now_running = ++running;
+        int max = max_running;
+        while (now_running > max && !max_running.compare_exchange_weak(max, now_running)) {
+        }
+        usleep(50000);
+        running--;
+    };
+    scheduler_->setLimit(DumpScheduler::CPU, 2);
+    for (const auto& title : {"1", "2", "3", "4"}) {
+        scheduler_->addSection(title, DumpScheduler::CPU, {}, 0ms, dump_func);
+    }
+    scheduler_->start(/* thread_counts = */4);
+
+    for (const auto& title : {"1", "2", "3", "4"}) {
+        scheduler_->waitForSection(title, out_fd_.get());
+    }
+
+    EXPECT_THAT(max_running.load(), Eq(2));
+}
+
+TEST_F(DumpSchedulerTest, Timeout) {
+    // A may outlive the test, since nobody waits for a section that timed out.
+    auto a_done = std::make_shared<std::atomic<bool>>(false);
+    bool a_done_before_b = true;
+    scheduler_->addSection("A", DumpScheduler::BINDER, {}, 100ms, [a_done](int out_fd) {
+        dprintf(out_fd, "A");
+        sleep(1);
+        *a_done = true;
+    });
+    scheduler_->addSection("B", DumpScheduler::IO, {"A"}, 0ms, [&](int out_fd) {
+        a_done_before_b = *a_done;
+        dprintf(out_fd, "B");
+    });
+    scheduler_->start();
+
+    scheduler_->waitForSection("B", out_fd_.get());
+    scheduler_->waitForSection("A", out_fd_.get());
+
+    EXPECT_FALSE(a_done_before_b);
+    EXPECT_THAT(getOutput(), StartsWith("B*** A: timed out after 100ms"));
+    EXPECT_THAT(scheduler_->getTimingReport(), HasSubstr("timed out"));
+}
+
+TEST_F(DumpSchedulerTest, Timeout_releasesResource) {
+    scheduler_->addSection("A", DumpScheduler::CPU, {}, 100ms, [](int) {
+        sleep(1);
+    });
+    scheduler_->addSection("B", DumpScheduler::CPU, {"A"}, 0ms, [](int out_fd) {
+        dprintf(out_fd, "B");
+    });
+    scheduler_->start(/* thread_counts = */1);
+
+    scheduler_->waitForSection("B", out_fd_.get());
+
+    EXPECT_THAT(getOutput(), StrEq("B"));
+}
+
+TEST_F(DumpSchedulerTest, WaitForSection_pendingTimesOut) {
+    std::atomic<bool> release_a = false;
+    scheduler_->setLimit(DumpScheduler::BINDER, 1);
+    scheduler_->addSection("A", DumpScheduler::BINDER, {}, 0ms, [&](int) {
+        while (!release_a) {
+            usleep(10000);
+        }
+    });
+    scheduler_->addSection("B", DumpScheduler::BINDER, {}, 100ms, [](int out_fd) {
+        dprintf(out_fd, "B");
+    });
+    scheduler_->start();
+
+    scheduler_->waitForSection("B", out_fd_.get());
+    release_a = true;
+    scheduler_->waitForSection("A", out_fd_.get());
+
+    EXPECT_THAT(getOutput(), StrEq("*** B: didn't start within 100ms, skipped\n"));
+    EXPECT_THAT(scheduler_->getTimingReport(), HasSubstr("timed out"));
+}
+
+TEST_F(DumpSchedulerTest, Destructor_doesNotWaitForTimedOutSections) {
+    scheduler_->addSection("A", DumpScheduler::IO, {}, 100ms, [](int) {
+        sleep(2);
+    });
+    scheduler_->addSection("B", DumpScheduler::IO, {}, 60000ms, [](int) {
+        sleep(2);
+    });
+    scheduler_->start();
+
+    scheduler_->waitForSection("A", out_fd_.get());
+    auto destroying = std::chrono::steady_clock::now();
+    scheduler_.reset();
+
+    EXPECT_LT(std::chrono::steady_clock::now() - destroying, 1000ms);
+}
+
+TEST_F(DumpSchedulerTest, WaitForSection_withoutStart) {
+    std::thread::id main_thread = std::this_thread::get_id();
+    bool on_main_thread = false;
+    scheduler_->addSection("A", DumpScheduler::IO, {}, 0ms, [&](int out_fd) {
+        on_main_thread = std::this_thread::get_id() == main_thread;
+        dprintf(out_fd, "A");
+    });
+    scheduler_->addSection("B", DumpScheduler::IO, {"A"}, 0ms, [](int out_fd) {
+        dprintf(out_fd, "B");
+    });
+
+    scheduler_->waitForSection("B", out_fd_.get());
+    scheduler_->waitForSection("A", out_fd_.get());
+
+    EXPECT_TRUE(on_main_thread);
+    EXPECT_THAT(getOutput(), StrEq("BA"));
+}
+
+class ParallelZipWriterTest : public DumpstateBaseTest {
+  public:
+    void SetUp() {
+        DumpstateBaseTest::SetUp();
+        zip_path_ = kTestDataPath + "ParallelZipWriterOut.zip";
+        zip_file_.reset(fopen(zip_path_.c_str(), "wb"));
+        ASSERT_NE(zip_file_, nullptr) << "could not create " << zip_path_;
+    }
+
+    void TearDown() {
+        zip_file_.reset();
+        unlink(zip_path_.c_str());
+    }
+
+    // Text spanning several blocks, with some repetition across blocks like logs have.
+    std::string LongText() {
+        std::string text;
+        for (int i = 0; text.size() < 3 * ParallelZipWriter::BLOCK_SIZE + 1234; i++) {
+            text += android::base::StringPrintf("%05d: line %d of the section\n", i % 4096, i);
+        }
+        return text;
+    }
+
+    void AddEntry(ParallelZipWriter* writer, const std::string& name, const std::string& content,
+                  size_t flags) {
+        ASSERT_EQ(0, writer->StartEntryWithTime(name.c_str(), flags, time(nullptr)));
+        // Written in uneven chunks, to cross block boundaries in the middle of a write.
+        for (size_t offset = 0; offset < content.size(); offset += 10000) {
+            ASSERT_EQ(0, writer->WriteBytes(content.data() + offset,
+                                            std::min<size_t>(10000, content.size() - offset)));
+        }
+        ASSERT_EQ(0, writer->FinishEntry());
+    }
+
+    std::string ReadEntry(ZipArchiveHandle archive, const std::string& name) {
+        ZipEntry entry;
+        int32_t err = FindEntry(archive, name, &entry);
+        EXPECT_EQ(0, err) << ErrorCodeString(err) << " entry name: " << name;
+        if (err != 0) {
+            return "";
+        }
+        std::string content(entry.uncompressed_length, '\0');
+        err = ExtractToMemory(archive, &entry, reinterpret_cast<uint8_t*>(content.data()),
+                              content.size());
+        EXPECT_EQ(0, err) << ErrorCodeString(err) << " entry name: " << name;
+        return content;
+    }
+
+    void WriteAndVerify(int thread_count) {
+        const size_t compress =
+                ParallelZipWriter::kCompress | ParallelZipWriter::kDefaultCompression;
+        const std::string long_text = LongText();
+        {
+            ParallelZipWriter writer(zip_file_.get(), thread_count);
+            AddEntry(&writer, "version.txt", "2.0", compress);
+            AddEntry(&writer, "bugreport.txt", long_text, compress);
+            AddEntry(&writer, "empty.txt", "", compress);
+            AddEntry(&writer, "stored.txt", long_text, /* flags = */0);
+            AddEntry(&writer, "exact.txt", long_text.substr(0, ParallelZipWriter::BLOCK_SIZE),
+                     compress);
+            ASSERT_EQ(0, writer.Finish());
+        }
+        zip_file_.reset();
+
+        ZipArchiveHandle archive;
+        ASSERT_EQ(0, OpenArchive(zip_path_.c_str(), &archive));
+        EXPECT_THAT(ReadEntry(archive, "version.txt"), StrEq("2.0"));
+        EXPECT_EQ(ReadEntry(archive, "bugreport.txt"), long_text);
+        EXPECT_THAT(ReadEntry(archive, "empty.txt"), IsEmpty());
+        EXPECT_EQ(ReadEntry(archive, "stored.txt"), long_text);
+        EXPECT_EQ(ReadEntry(archive, "exact.txt"),
+                  long_text.substr(0, ParallelZipWriter::BLOCK_SIZE));
+        CloseArchive(archive);
+    }
+
+    std::string zip_path_;
+    std::unique_ptr<FILE, int (*)(FILE*)> zip_file_{nullptr, fclose};
+};
+
+TEST_F(ParallelZipWriterTest, WriteEntries) {
+    WriteAndVerify(/* thread_count = */ParallelZipWriter::MAX_THREAD_COUNT);
+}
+
+TEST_F(ParallelZipWriterTest, WriteEntries_withoutThreads) {
+    WriteAndVerify(/* thread_count = */0);
+}
+
+TEST_F(ParallelZipWriterTest, InvalidState) {
+    ParallelZipWriter writer(zip_file_.get());
+    EXPECT_EQ(ParallelZipWriter::kInvalidState, writer.WriteBytes("A", 1));
+    EXPECT_EQ(ParallelZipWriter::kInvalidState, writer.FinishEntry());
+    ASSERT_EQ(0, writer.StartEntryWithTime("a.txt", ParallelZipWriter::kCompress, time(nullptr)));
+    EXPECT_EQ(ParallelZipWriter::kInvalidState,
+              writer.StartEntryWithTime("b.txt", ParallelZipWriter::kCompress, time(nullptr)));
+    EXPECT_EQ(ParallelZipWriter::kInvalidState, writer.Finish());
+    EXPECT_EQ(0, writer.FinishEntry());
+    EXPECT_EQ(0, writer.Finish());
+}
+
 
 }  // namespace dumpstate
 }  // namespace os
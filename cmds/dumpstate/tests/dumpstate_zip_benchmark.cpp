@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <android-base/stringprintf.h>
+#include <benchmark/benchmark.h>
+#include <ziparchive/zip_writer.h>
+
+#include "ParallelZipWriter.h"
+
+namespace android {
+namespace os {
+namespace dumpstate {
+
+static const char* kZipPath = "/data/local/tmp/dumpstate_zip_benchmark.zip";
+
+// Size of the reads AddZipEntryFromFd() does.
+static const size_t kChunkSize = 64 * 1024;
+
+struct Section {
+    std::string name;
+    std::string content;
+};
+
+// Roughly the shape of a bugreport: a large main text entry, dumpsys protos and many small files
+// such as the ones of AddDir().
+static const std::vector<Section>& GetSections() {
+    static const std::vector<Section> sections = [] {
+        std::vector<Section> sections;
+        std::mt19937 random(42);
+        const char* kTags[] = {"ActivityManager", "PackageManager", "WindowManager", "Binder",
+                               "Zygote", "SurfaceFlinger", "InputDispatcher", "vold"};
+        auto log_lines = [&](size_t size) {
+            std::string text;
+            while (text.size() < size) {
+                text += android::base::StringPrintf(
+                        "01-01 12:%02u:%02u.%03u %5u %5u I %s: event %u for uid %u\n",
+                        random() % 60, random() % 60, random() % 1000, random() % 30000,
+                        random() % 30000, kTags[random() % 8], random() % 100, random() % 20000);
+            }
+            return text;
+        };
+
+        sections.push_back({"bugreport.txt", log_lines(24 * 1024 * 1024)});
+        for (int i = 0; i < 64; i++) {
+            // Protos compress less than text.
+            std::string proto(256 * 1024, '\0');
+            for (size_t j = 0; j < proto.size(); j++) {
+                proto[j] = (j % 4 == 0) ? random() % 256 : proto[j / 2];
+            }
+            sections.push_back({android::base::StringPrintf("proto/service%d.proto", i), proto});
+        }
+        for (int i = 0; i < 300; i++) {
+            sections.push_back({android::base::StringPrintf("FS/data/misc/file%d", i),
+                                log_lines(4 * 1024)});
+        }
+        return sections;
+    }();
+    return sections;
+}
+
+template <class Writer>
+static void WriteSections(Writer* writer, benchmark::State& state) {
+    const size_t flags = Writer::kCompress | Writer::kDefaultCompression;
+    for (const Section& section : GetSections()) {
+        if (writer->StartEntryWithTime(section.name.c_str(), flags, time(nullptr)) != 0) {
+            state.SkipWithError("StartEntryWithTime failed");
+            return;
+        }
+        // Streamed in chunks, as sections are read from their producers.
+        for (size_t offset = 0; offset < section.content.size(); offset += kChunkSize) {
+            size_t size = std::min(kChunkSize, section.content.size() - offset);
+            if (writer->WriteBytes(section.content.data() + offset, size) != 0) {
+                state.SkipWithError("WriteBytes failed");
+                return;
+            }
+        }
+        if (writer->FinishEntry() != 0) {
+            state.SkipWithError("FinishEntry failed");
+            return;
+        }
+    }
+    if (writer->Finish() != 0) {
+        state.SkipWithError("Finish failed");
+    }
+}
+
+static void SetCounters(benchmark::State& state) {
+    size_t bytes = 0;
+    for (const Section& section : GetSections()) {
+        bytes += section.content.size();
+    }
+    state.SetBytesProcessed(state.iterations() * bytes);
+}
+
+// Baseline: the sections deflated on the calling thread by libziparchive.
+static void BM_ZipWriter(benchmark::State& state) {
+    GetSections();
+    for (auto _ : state) {
+        std::unique_ptr<FILE, int (*)(FILE*)> file(fopen(kZipPath, "wb"), fclose);
+        ZipWriter writer(file.get());
+        WriteSections(&writer, state);
+    }
+    SetCounters(state);
+    unlink(kZipPath);
+}
+BENCHMARK(BM_ZipWriter)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ParallelZipWriter(benchmark::State& state) {
+    GetSections();
+    for (auto _ : state) {
+        std::unique_ptr<FILE, int (*)(FILE*)> file(fopen(kZipPath, "wb"), fclose);
+        ParallelZipWriter writer(file.get(), state.range(0));
+        WriteSections(&writer, state);
+    }
+    SetCounters(state);
+    unlink(kZipPath);
+}
+BENCHMARK(BM_ParallelZipWriter)
+        ->Arg(0)
+        ->Arg(1)
+        ->Arg(2)
+        ->Arg(ParallelZipWriter::MAX_THREAD_COUNT)
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+}  // namespace dumpstate
+}  // namespace os
+}  // namespace android
+
+BENCHMARK_MAIN();
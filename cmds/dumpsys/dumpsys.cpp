@@ -16,8 +16,11 @@
 
 #include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <iomanip>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include <android-base/file.h>
 #include <android-base/stringprintf.h>
@@ -54,6 +57,10 @@ using ::android::base::unique_fd;
 using ::android::base::WriteFully;
 using ::android::base::WriteStringToFd;
 
+// Upper bound of --parallel, services mostly wait on binder calls but still compete for the
+// cpu and for the binder threads of system_server.
+static constexpr int kMaxParallelDumps = 8;
+
 static int sort_func(const String16* lhs, const String16* rhs)
 {
     return lhs->compare(*rhs);
@@ -65,16 +72,22 @@ static void usage() {
         "usage: dumpsys\n"
         "         To dump all services.\n"
         "or:\n"
-        "       dumpsys [-t TIMEOUT] [--priority LEVEL] [--clients] [--dump] [--pid] [--thread] "
-        "[--help | "
+        "       dumpsys [-t TIMEOUT] [--priority LEVEL] [--parallel N] [--clients] [--dump] "
+        "[--pid] [--thread] [--binder-profile ACTION] [--help | "
         "-l | --skip SERVICES "
         "| SERVICE [ARGS]]\n"
+        "         --binder-profile ACTION: instead of usual dump, ACTION the profiling of binder\n"
+        "               transactions of the service process, one of start | stop | dump.\n"
+        "               Starting drops the previous profile and requires root\n"
         "         --help: shows this help\n"
         "         -l: only list services, do not dump them\n"
         "         -t TIMEOUT_SEC: TIMEOUT to use in seconds instead of default 10 seconds\n"
         "         -T TIMEOUT_MS: TIMEOUT to use in milliseconds instead of default 10 seconds\n"
         "         --clients: dump client PIDs instead of usual dump\n"
         "         --dump: ask the service to dump itself (this is the default)\n"
+        "         --parallel N: dump up to N services at once (max 8), their dumps are still\n"
+        "               written one after the other in the usual order, followed by a timing\n"
+        "               table\n"
         "         --pid: dump PID instead of usual dump\n"
         "         --proto: filter services that support dumping data in proto format. Dumps\n"
         "               will be in proto format.\n"
@@ -82,7 +95,7 @@ static void usage() {
         "               LEVEL must be one of CRITICAL | HIGH | NORMAL\n"
         "         --skip SERVICES: dumps all services but SERVICES (comma-separated list)\n"
         "         --stability: dump binder stability information instead of usual dump\n"
-        "         --thread: dump thread usage instead of usual dump\n"
+        "         --thread: dump thread usage and thread pool stats instead of usual dump\n"
         "         SERVICE [ARGS]: dumps only service SERVICE, optionally passing ARGS to it\n");
 }
 
@@ -135,13 +148,16 @@ int Dumpsys::main(int argc, char* const argv[]) {
     bool asProto = false;
     int dumpTypeFlags = 0;
     int timeoutArgMs = 10000;
+    int parallelism = 1;
     int priorityFlags = IServiceManager::DUMP_FLAG_PRIORITY_ALL;
     static struct option longOptions[] = {
         {"help", no_argument, 0, 0},           {"clients", no_argument, 0, 0},
         {"dump", no_argument, 0, 0},           {"pid", no_argument, 0, 0},
         {"priority", required_argument, 0, 0}, {"proto", no_argument, 0, 0},
         {"skip", no_argument, 0, 0},           {"stability", no_argument, 0, 0},
-        {"thread", no_argument, 0, 0},         {0, 0, 0, 0}};
+        {"thread", no_argument, 0, 0},         {"parallel", required_argument, 0, 0},
+        {"binder-profile", required_argument, 0, 0},
+        {0, 0, 0, 0}};
 
     // Must reset optind, otherwise subsequent calls will fail (wouldn't happen on main.cpp, but
     // happens on test cases).
@@ -182,6 +198,25 @@ int Dumpsys::main(int argc, char* const argv[]) {
                 dumpTypeFlags |= TYPE_THREAD;
             } else if (!strcmp(longOptions[optionIndex].name, "clients")) {
                 dumpTypeFlags |= TYPE_CLIENTS;
+            } else if (!strcmp(longOptions[optionIndex].name, "binder-profile")) {
+                if (!strcmp(optarg, "start")) {
+                    dumpTypeFlags |= TYPE_BINDER_PROFILE_START;
+                } else if (!strcmp(optarg, "stop")) {
+                    dumpTypeFlags |= TYPE_BINDER_PROFILE_STOP;
+                } else if (!strcmp(optarg, "dump")) {
+                    dumpTypeFlags |= TYPE_BINDER_PROFILE;
+                } else {
+                    fprintf(stderr, "Error: invalid binder profile action: %s\n\n", optarg);
+                    usage();
+                    return -1;
+                }
+            } else if (!strcmp(longOptions[optionIndex].name, "parallel")) {
+                char* endptr;
+                parallelism = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || parallelism <= 0 || parallelism > kMaxParallelDumps) {
+                    fprintf(stderr, "Error: invalid parallel dump number: '%s'\n", optarg);
+                    return -1;
+                }
             }
             break;
 
@@ -271,6 +306,18 @@ int Dumpsys::main(int argc, char* const argv[]) {
         return 0;
     }
 
+    if (parallelism > 1 && N > 1) {
+        Vector<String16> dumpedServices;
+        for (const auto& serviceName : services) {
+            if (!IsSkipped(skippedServices, serviceName)) {
+                dumpedServices.add(serviceName);
+            }
+        }
+        dumpServicesInParallel(STDOUT_FILENO, dumpedServices, dumpTypeFlags, args, priorityFlags,
+                               std::chrono::milliseconds(timeoutArgMs), asProto, parallelism);
+        return 0;
+    }
+
     for (size_t i = 0; i < N; i++) {
         const String16& serviceName = services[i];
         if (IsSkipped(skippedServices, serviceName)) continue;
@@ -374,6 +421,21 @@ static status_t dumpThreadsToFd(const sp<IBinder>& service, const unique_fd& fd)
     WriteStringToFd("Threads in use: " + std::to_string(pidInfo.threadUsage) + "/" +
                         std::to_string(pidInfo.threadCount) + "\n",
                     fd.get());
+    // Not every process reports the utilization of its thread pool.
+    std::string poolStats;
+    if (service->getDebugThreadPoolStats(&poolStats) == OK) {
+        WriteStringToFd("Thread pool: " + poolStats + "\n", fd.get());
+    }
+    return OK;
+}
+
+static status_t dumpBinderProfileToFd(const sp<IBinder>& service, const unique_fd& fd) {
+    std::string profile;
+    status_t status = service->getDebugTransactionProfile(&profile);
+    if (status != OK) {
+        return status;
+    }
+    WriteStringToFd(profile, fd.get());
     return OK;
 }
 
@@ -450,6 +512,18 @@ status_t Dumpsys::startDumpThread(int dumpTypeFlags, const String16& serviceName
             status_t err = dumpClientsToFd(service, remote_end);
             reportDumpError(serviceName, err, "dumping clients info");
         }
+        if (dumpTypeFlags & TYPE_BINDER_PROFILE_START) {
+            status_t err = service->setDebugTransactionProfiling(true);
+            reportDumpError(serviceName, err, "starting binder profiling");
+        }
+        if (dumpTypeFlags & TYPE_BINDER_PROFILE_STOP) {
+            status_t err = service->setDebugTransactionProfiling(false);
+            reportDumpError(serviceName, err, "stopping binder profiling");
+        }
+        if (dumpTypeFlags & TYPE_BINDER_PROFILE) {
+            status_t err = dumpBinderProfileToFd(service, remote_end);
+            reportDumpError(serviceName, err, "dumping binder profile");
+        }
 
         // other types always act as a header, this is usually longer
         if (dumpTypeFlags & TYPE_DUMP) {
@@ -489,6 +563,14 @@ void Dumpsys::writeDumpHeader(int fd, const String16& serviceName, int priorityF
 status_t Dumpsys::writeDump(int fd, const String16& serviceName, std::chrono::milliseconds timeout,
                             bool asProto, std::chrono::duration<double>& elapsedDuration,
                             size_t& bytesWritten) const {
+    return readDump(serviceName, timeout, asProto, elapsedDuration, bytesWritten,
+                    [fd](const char* data, size_t size) { return WriteFully(fd, data, size); });
+}
+
+status_t Dumpsys::readDump(const String16& serviceName, std::chrono::milliseconds timeout,
+                           bool asProto, std::chrono::duration<double>& elapsedDuration,
+                           size_t& bytesWritten,
+                           const std::function<bool(const char*, size_t)>& write) const {
     status_t status = OK;
     size_t totalBytes = 0;
     auto start = std::chrono::steady_clock::now();
@@ -532,7 +614,7 @@ status_t Dumpsys::writeDump(int fd, const String16& serviceName, std::chrono::mi
             break;
         }
 
-        if (!WriteFully(fd, buf, rc)) {
+        if (!write(buf, rc)) {
             std::cerr << "Failed to write while dumping service " << serviceName << ": "
                  << strerror(errno) << std::endl;
             status = -errno;
@@ -544,7 +626,7 @@ status_t Dumpsys::writeDump(int fd, const String16& serviceName, std::chrono::mi
     if ((status == TIMED_OUT) && (!asProto)) {
         std::string msg = StringPrintf("\n*** SERVICE '%s' DUMP TIMEOUT (%llums) EXPIRED ***\n\n",
                                        String8(serviceName).c_str(), timeout.count());
-        WriteStringToFd(msg, fd);
+        write(msg.data(), msg.size());
     }
 
     elapsedDuration = std::chrono::steady_clock::now() - start;
@@ -565,3 +647,122 @@ void Dumpsys::writeDumpFooter(int fd, const String16& serviceName,
                      elapsedDuration.count(), String8(serviceName).c_str(), oss.str().c_str());
     WriteStringToFd(msg, fd);
 }
+
+void Dumpsys::dumpServicesInParallel(int fd, const Vector<String16>& services, int dumpTypeFlags,
+                                     const Vector<String16>& args, int priorityFlags,
+                                     std::chrono::milliseconds timeout, bool asProto,
+                                     int parallelism) const {
+    struct ServiceDump {
+        std::string output;
+        status_t status = OK;
+        bool done = false;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::duration<double> elapsedDuration = std::chrono::duration<double>::zero();
+        size_t bytesWritten = 0;
+    };
+
+    const size_t N = services.size();
+    std::vector<ServiceDump> dumps(N);
+    std::mutex lock;
+    std::condition_variable dumpDone;
+    size_t nextService = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    auto dumpServices = [&]() {
+        while (true) {
+            size_t i;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                if (nextService == N) {
+                    return;
+                }
+                i = nextService++;
+            }
+            ServiceDump& dump = dumps[i];
+            dump.start = std::chrono::steady_clock::now();
+            // Each dump has its own pipe and thread, the thread is left behind if the dump
+            // times out, as in the sequential mode.
+            Dumpsys dumpsys(sm_);
+            dump.status = dumpsys.startDumpThread(dumpTypeFlags, services[i], args);
+            if (dump.status == OK) {
+                dump.status = dumpsys.readDump(services[i], timeout, asProto,
+                                               dump.elapsedDuration, dump.bytesWritten,
+                                               [&dump](const char* data, size_t size) {
+                                                   dump.output.append(data, size);
+                                                   return true;
+                                               });
+                dumpsys.stopDumpThread(dump.status == OK);
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            dump.done = true;
+            dumpDone.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::min<size_t>(parallelism, N); i++) {
+        threads.emplace_back(dumpServices);
+    }
+
+    // Writes each dump as soon as it and the ones before it are done.
+    for (size_t i = 0; i < N; i++) {
+        ServiceDump& dump = dumps[i];
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            dumpDone.wait(guard, [&dump]() { return dump.done; });
+        }
+        if (dump.status == NAME_NOT_FOUND) {
+            continue;
+        }
+        if (!asProto) {
+            writeDumpHeader(fd, services[i], priorityFlags);
+        }
+        WriteFully(fd, dump.output.data(), dump.output.size());
+        if (dump.status == TIMED_OUT) {
+            std::string msg =
+                StringPrintf("\n*** SERVICE '%s' DUMP TIMEOUT (%llums) EXPIRED ***\n\n",
+                             String8(services[i]).c_str(), timeout.count());
+            WriteStringToFd(msg, fd);
+        }
+        if (!asProto) {
+            writeDumpFooter(fd, services[i], dump.elapsedDuration);
+        }
+        // Don't hold every dump in memory until the end.
+        std::string().swap(dump.output);
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (asProto) {
+        return;
+    }
+    std::chrono::duration<double> totalDuration = std::chrono::steady_clock::now() - start;
+    std::string msg =
+        StringPrintf("--------- %.3fs was the duration of dumpsys for %zu services on %zu "
+                     "threads\n",
+                     totalDuration.count(), N, threads.size());
+    StringAppendF(&msg, "%-40s %10s %12s %12s  %s\n", "SERVICE", "START_MS", "DURATION_MS",
+                  "BYTES", "STATUS");
+    for (size_t i = 0; i < N; i++) {
+        const ServiceDump& dump = dumps[i];
+        long long startMs =
+            std::chrono::duration_cast<std::chrono::milliseconds>(dump.start - start).count();
+        long long durationMs =
+            std::chrono::duration_cast<std::chrono::milliseconds>(dump.elapsedDuration).count();
+        std::string status;
+        if (dump.status == OK) {
+            status = "OK";
+        } else if (dump.status == TIMED_OUT) {
+            status = "TIMED OUT";
+        } else if (dump.status == NAME_NOT_FOUND) {
+            status = "NOT FOUND";
+        } else {
+            status = statusToString(dump.status);
+        }
+        StringAppendF(&msg, "%-40s %10lld %12lld %12zu  %s\n", String8(services[i]).c_str(),
+                      startMs, durationMs, dump.bytesWritten, status.c_str());
+    }
+    WriteStringToFd(msg, fd);
+}
@@ -17,6 +17,8 @@
 #ifndef FRAMEWORK_NATIVE_CMD_DUMPSYS_H_
 #define FRAMEWORK_NATIVE_CMD_DUMPSYS_H_
 
+#include <chrono>
+#include <functional>
 #include <thread>
 
 #include <android-base/unique_fd.h>
@@ -57,6 +59,9 @@ class Dumpsys {
         TYPE_STABILITY = 0x4,  // dump stability information of server
         TYPE_THREAD = 0x8,     // dump thread usage of server only
         TYPE_CLIENTS = 0x10,   // dump pid of clients
+        TYPE_BINDER_PROFILE = 0x20,        // dump binder transaction profile of server
+        TYPE_BINDER_PROFILE_START = 0x40,  // start profiling binder transactions of server
+        TYPE_BINDER_PROFILE_STOP = 0x80,   // stop profiling binder transactions of server
     };
 
     /**
@@ -125,7 +130,35 @@ class Dumpsys {
         return redirectFd_.get();
     }
 
+    /**
+     * Dumps services on up to {@code parallelism} threads at once, each one into its own
+     * buffer, and writes the dumps to a file descriptor in the order of {@code services},
+     * followed by a table of how long each dump took. Each dump still times out on its own.
+     * @param fd file descriptor to write data
+     * @param services services to dump, in the order their dumps are written
+     * @param dumpTypeFlags operations to perform
+     * @param args list of arguments to pass to service dump method.
+     * @param priorityFlags dump priority specified
+     * @param timeout timeout to terminate each dump if not completed
+     * @param asProto used to supresses additional output to the fd such as the section
+     * separators and the timing table
+     * @param parallelism maximum number of services dumped at once
+     */
+    void dumpServicesInParallel(int fd, const Vector<String16>& services, int dumpTypeFlags,
+                                const Vector<String16>& args, int priorityFlags,
+                                std::chrono::milliseconds timeout, bool asProto,
+                                int parallelism) const;
+
   private:
+    /**
+     * Same as {@code writeDump}, but hands the dump to {@code write} rather than writing it to a
+     * file descriptor. {@code write} returns {@code false} and sets errno if it fails.
+     */
+    status_t readDump(const String16& serviceName, std::chrono::milliseconds timeout,
+                      bool asProto, std::chrono::duration<double>& elapsedDuration,
+                      size_t& bytesWritten,
+                      const std::function<bool(const char*, size_t)>& write) const;
+
     android::IServiceManager* sm_;
     std::thread activeThread_;
     mutable android::base::unique_fd redirectFd_;
@@ -454,6 +454,47 @@ TEST_F(DumpsysTest, DumpMultipleServices) {
     AssertDumped("running3", "dump3");
 }
 
+// Tests 'dumpsys --parallel 2', which should keep the order of the dumps
+TEST_F(DumpsysTest, DumpMultipleServicesInParallel) {
+    ExpectListServices({"running1", "stopped2", "running3", "running4"});
+    ExpectDump("running1", "dump1");
+    ExpectCheckService("stopped2", false);
+    ExpectDump("running3", "dump3");
+    ExpectDump("running4", "dump4");
+
+    CallMain({"--parallel", "2"});
+
+    AssertRunningServices({"running1", "running3", "running4"});
+    AssertStopped("stopped2");
+    AssertOutputFormat(
+        "(.|\n)*DUMP OF SERVICE running1:\ndump1(.|\n)*"
+        "DUMP OF SERVICE running3:\ndump3(.|\n)*"
+        "DUMP OF SERVICE running4:\ndump4(.|\n)*"
+        "was the duration of dumpsys for 4 services on 2 threads\n"
+        "SERVICE +START_MS +DURATION_MS +BYTES +STATUS\n"
+        "running1 +[0-9]+ +[0-9]+ +5 +OK\n"
+        "running3 +[0-9]+ +[0-9]+ +5 +OK\n"
+        "running4 +[0-9]+ +[0-9]+ +5 +OK\n"
+        "stopped2 +[0-9]+ +[0-9]+ +0 +NOT FOUND\n");
+}
+
+// Tests 'dumpsys --parallel 2 -T 500' on a service that times out after 2s
+TEST_F(DumpsysTest, DumpInParallelWithTimeout) {
+    ExpectListServices({"hanging1", "running2"});
+    sp<BinderMock> binder_mock = ExpectDumpAndHang("hanging1", 2, "dump1");
+    ExpectDump("running2", "dump2");
+
+    CallMain({"--parallel", "2", "-T", "500"});
+
+    AssertOutputContains("SERVICE 'hanging1' DUMP TIMEOUT (500ms) EXPIRED");
+    AssertNotDumped("dump1");
+    AssertDumped("running2", "dump2");
+    AssertOutputContains("TIMED OUT\n");
+
+    // TODO(b/65056227): BinderMock is not destructed because thread is detached on dumpsys.cpp
+    Mock::AllowLeak(binder_mock.get());
+}
+
 // Tests 'dumpsys --skip skipped3 skipped5', which should skip these services
 TEST_F(DumpsysTest, DumpWithSkip) {
     ExpectListServices({"running1", "stopped2", "skipped3", "running4", "skipped5"});
@@ -620,7 +661,8 @@ TEST_F(DumpsysTest, ListAllServicesWithThread) {
 
     AssertRunningServices({"Locksmith", "Valet"});
 
-    const std::string format("(.|\n)*((Threads in use: [0-9]+/[0-9]+)?\n-(.|\n)*){2}");
+    const std::string format(
+            "(.|\n)*((Threads in use: [0-9]+/[0-9]+\nThread pool: [^\n]*)?\n-(.|\n)*){2}");
     AssertOutputFormat(format);
 }
 
@@ -630,10 +672,26 @@ TEST_F(DumpsysTest, ListServiceWithThread) {
 
     CallMain({"--thread", "Locksmith"});
     // returns an empty string without root enabled
-    const std::string format("(^$|Threads in use: [0-9]/[0-9]+\n)");
+    const std::string format(
+            "(^$|Threads in use: [0-9]/[0-9]+\nThread pool: [0-9]+/[0-9]+ threads.*\n)");
     AssertOutputFormat(format);
 }
 
+// Tests 'dumpsys --binder-profile ACTION service_name'
+TEST_F(DumpsysTest, ServiceWithBinderProfile) {
+    ExpectCheckService("Locksmith");
+
+    CallMain({"--binder-profile", "start", "Locksmith"});
+    AssertOutputFormat("^$");
+
+    CallMain({"--binder-profile", "dump", "Locksmith"});
+    AssertOutputContains("Binder transaction profile (enabled");
+
+    CallMain({"--binder-profile", "stop", "Locksmith"});
+    CallMain({"--binder-profile", "dump", "Locksmith"});
+    AssertOutputContains("Binder transaction profile (disabled");
+}
+
 // Tests 'dumpsys --clients'
 TEST_F(DumpsysTest, ListAllServicesWithClients) {
     ExpectListServices({"Locksmith", "Valet"});
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BatchExecutor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace android {
+namespace installd {
+
+BatchExecutor::BatchExecutor(size_t maxThreads) : mMaxThreads(std::max<size_t>(maxThreads, 1)) {}
+
+void BatchExecutor::run(const std::vector<std::string>& keys, const Task& task) const {
+    // Shards in the order their first entry appears in the batch, so that the head of the batch
+    // is handled first, like it would be serially.
+    std::vector<std::vector<size_t>> shards;
+    {
+        std::unordered_map<std::string_view, size_t> shardOfKey;
+        for (size_t i = 0; i < keys.size(); i++) {
+            auto [it, inserted] = shardOfKey.emplace(keys[i], shards.size());
+            if (inserted) {
+                shards.emplace_back();
+            }
+            shards[it->second].push_back(i);
+        }
+    }
+
+    std::atomic<size_t> nextShard = 0;
+    auto work = [&] {
+        size_t shard;
+        while ((shard = nextShard.fetch_add(1, std::memory_order_relaxed)) < shards.size()) {
+            for (size_t index : shards[shard]) {
+                task(index);
+            }
+        }
+    };
+
+    // The calling thread is one of the workers.
+    const size_t threadCount = std::min(mMaxThreads, shards.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+}  // namespace installd
+}  // namespace android
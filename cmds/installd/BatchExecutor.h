@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_INSTALLD_BATCH_EXECUTOR_H
+#define ANDROID_INSTALLD_BATCH_EXECUTOR_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace installd {
+
+/**
+ * Runs the entries of a batched request on several threads at once.
+ *
+ * Entries are sharded by key, usually the name of the package they touch. The entries of a shard
+ * run one after the other on the same thread, in the order of the batch, so that a batch which
+ * touches a package several times behaves as if it ran serially. Threads take the next shard
+ * whenever they're done with one, which keeps them busy when some packages take longer than
+ * others. Threads are only started for the duration of a batch, and a batch with a single shard
+ * runs on the calling thread alone.
+ */
+class BatchExecutor {
+public:
+    /**
+     * Called for each entry of the batch, with its index, possibly from several threads at once.
+     */
+    using Task = std::function<void(size_t index)>;
+
+    static constexpr size_t kDefaultMaxThreads = 4;
+
+    explicit BatchExecutor(size_t maxThreads = kDefaultMaxThreads);
+
+    /**
+     * Runs task once for each entry of keys, and returns once every entry ran.
+     */
+    void run(const std::vector<std::string>& keys, const Task& task) const;
+
+private:
+    const size_t mMaxThreads;
+
+    DISALLOW_COPY_AND_ASSIGN(BatchExecutor);
+};
+
+}  // namespace installd
+}  // namespace android
+
+#endif  // ANDROID_INSTALLD_BATCH_EXECUTOR_H
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CacheIndex.h"
+
+#include <errno.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <android-base/logging.h>
+
+namespace android {
+namespace installd {
+
+namespace {
+
+// Bounds on the memory and inotify watches used by the index.
+constexpr size_t kMaxItems = 100000;
+constexpr size_t kMaxWatches = 8192;
+
+// File times only have the granularity of the kernel clock tick, so a directory
+// changed right around its walk may change again without its times changing.
+// Trees with directories changed that recently aren't indexed.
+constexpr time_t kRacyWindowSeconds = 2;
+
+constexpr uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM
+        | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+bool same_time(const struct timespec& left, const struct timespec& right) {
+    return left.tv_sec == right.tv_sec && left.tv_nsec == right.tv_nsec;
+}
+
+std::string directory_path(const std::string& root, const CacheIndex::DirectoryStamp& directory) {
+    return directory.path.empty() ? root : root + "/" + directory.path;
+}
+
+}  // namespace
+
+CacheIndex::CacheIndex() : mInotifyFd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+    if (mInotifyFd == -1) {
+        PLOG(WARNING) << "Failed to init inotify; cache items won't be indexed";
+    }
+}
+
+CacheIndex::~CacheIndex() {
+}
+
+bool CacheIndex::lookup(const std::string& path,
+                        std::vector<std::shared_ptr<CacheItem>>* items) {
+    std::lock_guard<std::mutex> lock(mLock);
+    drainEventsLocked();
+
+    auto it = mTrees.find(path);
+    if (it == mTrees.end()) {
+        return false;
+    }
+    for (const auto& directory : it->second.directories) {
+        struct stat st;
+        if (lstat(directory_path(path, directory).c_str(), &st) != 0
+                || st.st_ino != directory.inode
+                || !same_time(st.st_mtim, directory.modified)
+                || !same_time(st.st_ctim, directory.changed)) {
+            invalidateLocked(path);
+            return false;
+        }
+    }
+    items->insert(items->end(), it->second.items.begin(), it->second.items.end());
+    return true;
+}
+
+void CacheIndex::update(const std::string& path,
+                        const std::vector<std::shared_ptr<CacheItem>>& items,
+                        std::vector<DirectoryStamp> directories, const struct timespec& walkStart) {
+    std::lock_guard<std::mutex> lock(mLock);
+    invalidateLocked(path);
+
+    // Without watches, files rewritten in place would go unnoticed
+    if (mInotifyFd == -1 || mItemCount + items.size() > kMaxItems
+            || mWatches.size() + directories.size() > kMaxWatches) {
+        return;
+    }
+    for (const auto& directory : directories) {
+        if (directory.modified.tv_sec + kRacyWindowSeconds >= walkStart.tv_sec
+                || directory.changed.tv_sec + kRacyWindowSeconds >= walkStart.tv_sec) {
+            return;
+        }
+    }
+
+    Tree& tree = mTrees[path];
+    tree.items = items;
+    tree.directories = std::move(directories);
+    mItemCount += items.size();
+    if (!watchLocked(path, &tree) || !verifyLocked(path, tree, walkStart)) {
+        invalidateLocked(path);
+    }
+}
+
+void CacheIndex::invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mLock);
+    invalidateLocked(path);
+}
+
+void CacheIndex::invalidateLocked(const std::string& path) {
+    auto it = mTrees.find(path);
+    if (it == mTrees.end()) {
+        return;
+    }
+    for (int watch : it->second.watches) {
+        inotify_rm_watch(mInotifyFd.get(), watch);
+        mWatches.erase(watch);
+    }
+    mItemCount -= it->second.items.size();
+    mTrees.erase(it);
+}
+
+bool CacheIndex::watchLocked(const std::string& path, Tree* tree) {
+    for (const auto& directory : tree->directories) {
+        int watch = inotify_add_watch(mInotifyFd.get(), directory_path(path, directory).c_str(),
+                kWatchMask);
+        if (watch == -1) {
+            PLOG(DEBUG) << "Failed to watch " << directory_path(path, directory);
+            return false;
+        }
+        tree->watches.push_back(watch);
+        mWatches[watch] = path;
+    }
+    return true;
+}
+
+bool CacheIndex::verifyLocked(const std::string& path, const Tree& tree,
+                              const struct timespec& walkStart) {
+    // Changes made after the walk saw an entry but before the watches were in place aren't
+    // reported, so check that the tree still looks the way it was walked.
+    for (const auto& directory : tree.directories) {
+        struct stat st;
+        if (lstat(directory_path(path, directory).c_str(), &st) != 0
+                || st.st_ino != directory.inode
+                || !same_time(st.st_mtim, directory.modified)
+                || !same_time(st.st_ctim, directory.changed)) {
+            return false;
+        }
+    }
+    for (const auto& item : tree.items) {
+        if (item->directory) {
+            continue;
+        }
+        struct stat st;
+        if (lstat(item->buildPath().c_str(), &st) != 0
+                || st.st_mtime + kRacyWindowSeconds >= walkStart.tv_sec
+                || st.st_mtime != item->modified
+                || st.st_blocks * 512 != item->size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CacheIndex::drainEventsLocked() {
+    if (mInotifyFd == -1) {
+        return;
+    }
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t size;
+    while ((size = TEMP_FAILURE_RETRY(read(mInotifyFd.get(), buffer, sizeof(buffer)))) > 0) {
+        for (ssize_t offset = 0; offset < size;) {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost, so nothing indexed can be trusted anymore
+                while (!mTrees.empty()) {
+                    invalidateLocked(std::string(mTrees.begin()->first));
+                }
+                continue;
+            }
+            auto it = mWatches.find(event->wd);
+            if (it != mWatches.end()) {
+                invalidateLocked(std::string(it->second));
+            }
+        }
+    }
+}
+
+}  // namespace installd
+}  // namespace android
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_INSTALLD_CACHE_INDEX_H
+#define ANDROID_INSTALLD_CACHE_INDEX_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+#include <time.h>
+
+#include <android-base/macros.h>
+#include <android-base/thread_annotations.h>
+#include <android-base/unique_fd.h>
+
+#include "CacheItem.h"
+
+namespace android {
+namespace installd {
+
+/**
+ * Index of the items found under cache directories, so that freeing cache
+ * doesn't have to walk every cache directory each time.
+ *
+ * Along with its items, each indexed tree records the inode and times of its
+ * directories. Creating, deleting or renaming an entry updates the
+ * modification time of its directory, and setting the cache xattrs updates
+ * its change time, so a tree is reused for as long as its directories stat
+ * the same. Every directory of an indexed tree is also watched with inotify,
+ * which catches files that are rewritten in place; trees that can't be fully
+ * watched aren't indexed. The index only lives in memory, since nothing
+ * watches the trees while installd isn't running.
+ */
+class CacheIndex {
+public:
+    /**
+     * Directory of an indexed tree, with its identity when the tree was walked.
+     */
+    struct DirectoryStamp {
+        // Path relative to the root of the tree, empty for the root itself.
+        std::string path;
+        ino_t inode;
+        struct timespec modified;
+        struct timespec changed;
+    };
+
+    CacheIndex();
+    ~CacheIndex();
+
+    /**
+     * Appends the items of the tree at path to items, if they're indexed and
+     * still up to date.
+     */
+    bool lookup(const std::string& path, std::vector<std::shared_ptr<CacheItem>>* items);
+
+    /**
+     * Indexes the items of the tree at path, as found by a walk which started
+     * at walkStart, along with the stamps of its directories. Nothing is
+     * indexed if the tree changed since, or if it can't be fully watched.
+     */
+    void update(const std::string& path, const std::vector<std::shared_ptr<CacheItem>>& items,
+                std::vector<DirectoryStamp> directories, const struct timespec& walkStart);
+
+    /**
+     * Forgets the tree at path, after its contents changed.
+     */
+    void invalidate(const std::string& path);
+
+private:
+    struct Tree {
+        std::vector<std::shared_ptr<CacheItem>> items;
+        std::vector<DirectoryStamp> directories;
+        std::vector<int> watches;
+    };
+
+    void drainEventsLocked() REQUIRES(mLock);
+    // Returns false unless every directory of the tree is watched.
+    bool watchLocked(const std::string& path, Tree* tree) REQUIRES(mLock);
+    // Returns false if the tree changed since it was walked.
+    bool verifyLocked(const std::string& path, const Tree& tree,
+                      const struct timespec& walkStart) REQUIRES(mLock);
+    void invalidateLocked(const std::string& path) REQUIRES(mLock);
+
+    std::mutex mLock;
+    size_t mItemCount GUARDED_BY(mLock) = 0;
+    std::unordered_map<std::string, Tree> mTrees GUARDED_BY(mLock);
+
+    android::base::unique_fd mInotifyFd;
+    // Root of the tree each inotify watch belongs to.
+    std::unordered_map<int, std::string> mWatches GUARDED_BY(mLock);
+
+    DISALLOW_COPY_AND_ASSIGN(CacheIndex);
+};
+
+}  // namespace installd
+}  // namespace android
+
+#endif  // ANDROID_INSTALLD_CACHE_INDEX_H
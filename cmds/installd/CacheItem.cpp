@@ -16,6 +16,7 @@
 
 #include "CacheItem.h"
 
+#include <fts.h>
 #include <inttypes.h>
 #include <stdint.h>
 #include <sys/xattr.h>
@@ -30,22 +31,22 @@ using android::base::StringPrintf;
 namespace android {
 namespace installd {
 
-CacheItem::CacheItem(FTSENT* p) {
-    level = p->fts_level;
-    directory = S_ISDIR(p->fts_statp->st_mode);
-    size = p->fts_statp->st_blocks * 512;
-    modified = p->fts_statp->st_mtime;
+CacheItem::CacheItem(const TreeEntry& entry) {
+    level = entry.level;
+    directory = S_ISDIR(entry.st.st_mode);
+    size = entry.st.st_blocks * 512;
+    modified = entry.st.st_mtime;
 
-    mParent = static_cast<CacheItem*>(p->fts_parent->fts_pointer);
+    mParent = static_cast<CacheItem*>(entry.parentPointer);
     if (mParent) {
         group = mParent->group;
         tombstone = mParent->tombstone;
-        mName = p->fts_name;
+        mName = entry.name();
         mName.insert(0, "/");
     } else {
         group = false;
         tombstone = false;
-        mName = p->fts_path;
+        mName = entry.path;
     }
 }
 
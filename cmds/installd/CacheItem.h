@@ -20,12 +20,13 @@
 #include <memory>
 #include <string>
 
-#include <fts.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
 #include <android-base/macros.h>
 
+#include "TreeWalker.h"
+
 namespace android {
 namespace installd {
 
@@ -36,7 +37,7 @@ namespace installd {
  */
 class CacheItem {
 public:
-    CacheItem(FTSENT* p);
+    CacheItem(const TreeEntry& entry);
     ~CacheItem();
 
     std::string toString();
@@ -18,14 +18,20 @@
 
 #include "CacheTracker.h"
 
-#include <fts.h>
 #include <sys/xattr.h>
+#include <time.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
 #include <android-base/logging.h>
 #include <android-base/stringprintf.h>
 
 #include "QuotaUtils.h"
+#include "TreeWalker.h"
 #include "utils.h"
 
 using android::base::StringPrintf;
@@ -33,13 +39,15 @@ using android::base::StringPrintf;
 namespace android {
 namespace installd {
 
-CacheTracker::CacheTracker(userid_t userId, appid_t appId, const std::string& uuid)
+CacheTracker::CacheTracker(userid_t userId, appid_t appId, const std::string& uuid,
+                           CacheIndex* index)
       : cacheUsed(0),
         cacheQuota(0),
         mUserId(userId),
         mAppId(appId),
         mItemsLoaded(false),
-        mUuid(uuid) {
+        mUuid(uuid),
+        mIndex(index) {
 }
 
 CacheTracker::~CacheTracker() {
@@ -95,74 +103,87 @@ bool CacheTracker::loadQuotaStats() {
 }
 
 void CacheTracker::loadItemsFrom(const std::string& path) {
-    FTS *fts;
-    FTSENT *p;
-    char *argv[] = { (char*) path.c_str(), nullptr };
-    if (!(fts = fts_open(argv, FTS_PHYSICAL | FTS_NOCHDIR | FTS_XDEV, nullptr))) {
-        PLOG(WARNING) << "Failed to fts_open " << path;
+    mItemPaths.push_back(path);
+    if (mIndex && mIndex->lookup(path, &items)) {
         return;
     }
-    while ((p = fts_read(fts)) != nullptr) {
-        if (p->fts_level == 0) continue;
 
-        // Create tracking nodes for everything we encounter
-        switch (p->fts_info) {
-        case FTS_D:
-        case FTS_DEFAULT:
-        case FTS_F:
-        case FTS_SL:
-        case FTS_SLNONE: {
-            auto item = std::shared_ptr<CacheItem>(new CacheItem(p));
-            p->fts_pointer = static_cast<void*>(item.get());
-            items.push_back(item);
+    // Items found in each directory, in the order they were listed. The walk runs on several
+    // threads, so items are only put in order once it's over.
+    std::mutex lock;
+    std::unordered_map<CacheItem*, std::vector<std::shared_ptr<CacheItem>>> children;
+    std::vector<CacheIndex::DirectoryStamp> directories;
+    struct timespec walkStart;
+    clock_gettime(CLOCK_REALTIME, &walkStart);
+
+    int res = TreeWalker().walk(path, [&](TreeEntry& entry) {
+        if (S_ISDIR(entry.st.st_mode)) {
+            // Remember directories as the index saw them, to tell when they change
+            std::string relativePath = entry.path.substr(std::min(path.size(), entry.path.size()));
+            if (!relativePath.empty() && relativePath[0] == '/') {
+                relativePath.erase(0, 1);
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            directories.push_back({std::move(relativePath), entry.st.st_ino, entry.st.st_mtim,
+                                   entry.st.st_ctim});
         }
+        if (entry.level == 0) return true;
+
+        auto parent = static_cast<CacheItem*>(entry.parentPointer);
+        if (parent && parent->group) {
+            // Everything under a group is collected into the group itself
+            std::lock_guard<std::mutex> guard(lock);
+            parent->size += entry.st.st_blocks * 512;
+            parent->modified = std::max(parent->modified, entry.st.st_mtime);
+            entry.pointer = parent;
+            return true;
         }
 
-        switch (p->fts_info) {
-        case FTS_D: {
-            auto item = static_cast<CacheItem*>(p->fts_pointer);
-            item->group |= (getxattr(p->fts_path, kXattrCacheGroup, nullptr, 0) >= 0);
-            item->tombstone |= (getxattr(p->fts_path, kXattrCacheTombstone, nullptr, 0) >= 0);
-
-            // When group, immediately collect all files under tree
-            if (item->group) {
-                while ((p = fts_read(fts)) != nullptr) {
-                    if (p->fts_info == FTS_DP && p->fts_level == item->level) break;
-                    switch (p->fts_info) {
-                    case FTS_D:
-                    case FTS_DEFAULT:
-                    case FTS_F:
-                    case FTS_SL:
-                    case FTS_SLNONE:
-                        item->size += p->fts_statp->st_blocks * 512;
-                        item->modified = std::max(item->modified, p->fts_statp->st_mtime);
-                    }
-                }
-            }
+        // Create tracking nodes for everything we encounter
+        auto item = std::shared_ptr<CacheItem>(new CacheItem(entry));
+        if (S_ISDIR(entry.st.st_mode)) {
+            item->group |= (getxattr(entry.path.c_str(), kXattrCacheGroup, nullptr, 0) >= 0);
+            item->tombstone |=
+                    (getxattr(entry.path.c_str(), kXattrCacheTombstone, nullptr, 0) >= 0);
+            entry.pointer = item.get();
         }
+        std::lock_guard<std::mutex> guard(lock);
+        children[parent].push_back(std::move(item));
+        return true;
+    });
+    if (res != 0) {
+        if (errno != ENOENT) {
+            PLOG(WARNING) << "Failed to walk " << path;
         }
+        return;
+    }
 
-        // Bubble up modified time to parent
-        CHECK(p != nullptr);
-        switch (p->fts_info) {
-        case FTS_DP:
-        case FTS_DEFAULT:
-        case FTS_F:
-        case FTS_SL:
-        case FTS_SLNONE: {
-            auto item = static_cast<CacheItem*>(p->fts_pointer);
-            auto parent = static_cast<CacheItem*>(p->fts_parent->fts_pointer);
+    // Lay out items in the same order as a depth-first walk, and bubble up modified times to
+    // parents on the way back up
+    const size_t first = items.size();
+    std::function<void(CacheItem*)> addChildren = [&](CacheItem* parent) {
+        auto it = children.find(parent);
+        if (it == children.end()) return;
+        for (const auto& item : it->second) {
+            items.push_back(item);
+            addChildren(item.get());
             if (parent) {
                 parent->modified = std::max(parent->modified, item->modified);
             }
         }
-        }
+    };
+    addChildren(nullptr);
+
+    if (mIndex) {
+        mIndex->update(path, std::vector<std::shared_ptr<CacheItem>>(items.begin() + first,
+                                                                     items.end()),
+                       std::move(directories), walkStart);
     }
-    fts_close(fts);
 }
 
 void CacheTracker::loadItems() {
     items.clear();
+    mItemPaths.clear();
 
     ATRACE_BEGIN("loadItems");
     for (const auto& path : mDataPaths) {
@@ -196,6 +217,14 @@ void CacheTracker::ensureItems() {
     }
 }
 
+void CacheTracker::invalidateIndex() {
+    if (mIndex) {
+        for (const auto& path : mItemPaths) {
+            mIndex->invalidate(path);
+        }
+    }
+}
+
 int CacheTracker::getCacheRatio() {
     if (cacheQuota == 0) {
         return 0;
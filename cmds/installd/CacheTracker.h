@@ -27,6 +27,7 @@
 #include <android-base/macros.h>
 #include <cutils/multiuser.h>
 
+#include "CacheIndex.h"
 #include "CacheItem.h"
 
 namespace android {
@@ -39,7 +40,8 @@ namespace installd {
  */
 class CacheTracker {
 public:
-    CacheTracker(userid_t userId, appid_t appId, const std::string& uuid);
+    CacheTracker(userid_t userId, appid_t appId, const std::string& uuid,
+                 CacheIndex* index = nullptr);
     ~CacheTracker();
 
     std::string toString();
@@ -51,6 +53,11 @@ public:
 
     void ensureItems();
 
+    /**
+     * Drops the indexed items of this tracker, after some were purged.
+     */
+    void invalidateIndex();
+
     int getCacheRatio();
 
     int64_t cacheUsed;
@@ -63,8 +70,10 @@ private:
     appid_t mAppId;
     bool mItemsLoaded;
     const std::string& mUuid;
+    CacheIndex* mIndex;
 
     std::vector<std::string> mDataPaths;
+    std::vector<std::string> mItemPaths;
 
     bool loadQuotaStats();
     void loadItemsFrom(const std::string& path);
@@ -0,0 +1,356 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DexoptScheduler.h"
+
+#include <dirent.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#include <android-base/logging.h>
+#include <android-base/parseint.h>
+#include <android-base/properties.h>
+#include <android-base/strings.h>
+
+#ifndef LOG_TAG
+#define LOG_TAG "installd"
+#endif
+
+namespace android {
+namespace installd {
+
+// Heap of dex2oat when dalvik.vm.dex2oat-Xmx isn't set.
+constexpr int64_t kDefaultJobMemory = 512 * 1024 * 1024;
+
+// Memory can free up without any job finishing, so jobs waiting for memory check it again after
+// this long.
+constexpr std::chrono::milliseconds kMemoryPollInterval(500);
+
+// Parses a cpu list such as "0,1,4-7", skipping anything malformed.
+static std::vector<int> parse_cpu_set(const std::string& cpuSet) {
+    std::vector<int> cpus;
+    for (const auto& range : android::base::Split(cpuSet, ",")) {
+        auto bounds = android::base::Split(android::base::Trim(range), "-");
+        int first, last;
+        if (bounds.size() == 1 && android::base::ParseInt(bounds[0], &first, 0, CPU_SETSIZE - 1)) {
+            cpus.push_back(first);
+        } else if (bounds.size() == 2 &&
+                   android::base::ParseInt(bounds[0], &first, 0, CPU_SETSIZE - 1) &&
+                   android::base::ParseInt(bounds[1], &last, first, CPU_SETSIZE - 1)) {
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+static std::string join_cpus(const std::vector<int>& cpus) {
+    std::vector<std::string> names;
+    for (int cpu : cpus) {
+        names.push_back(std::to_string(cpu));
+    }
+    return android::base::Join(names, ",");
+}
+
+// Whether two jobs may compete for cpus. Jobs whose cpus are unknown may run anywhere.
+static bool overlaps(const std::vector<int>& a, const std::vector<int>& b) {
+    if (a.empty() || b.empty()) {
+        return true;
+    }
+    auto first = a.begin();
+    auto second = b.begin();
+    while (first != a.end() && second != b.end()) {
+        if (*first == *second) {
+            return true;
+        }
+        *first < *second ? first++ : second++;
+    }
+    return false;
+}
+
+DexoptScheduler::Job::Job(DexoptScheduler* scheduler, uint64_t id, std::string cpuSet,
+                          int threads)
+      : mScheduler(scheduler), mId(id), mCpuSet(std::move(cpuSet)), mThreads(threads) {}
+
+DexoptScheduler::Job::~Job() {
+    mScheduler->release(mId);
+}
+
+void DexoptScheduler::Job::setPid(pid_t pid) {
+    mScheduler->setPid(mId, pid);
+}
+
+DexoptScheduler::DexoptScheduler(size_t maxJobs) : mMaxJobs(std::max<size_t>(maxJobs, 1)) {}
+
+DexoptScheduler::~DexoptScheduler() {}
+
+std::unique_ptr<DexoptScheduler::Job> DexoptScheduler::acquire(const std::string& cpuSet,
+                                                               int threads) {
+    const int64_t jobMemory = getJobMemory();
+
+    std::unique_lock<std::mutex> lock(mLock);
+    const std::vector<int>& allowed = resolveCpusLocked(cpuSet);
+    while (true) {
+        if (mBlocked) {
+            return nullptr;
+        }
+
+        if (!canStartLocked(allowed)) {
+            mCondition.wait(lock);
+            continue;
+        }
+
+        // Running jobs may still grow up to their own heap limit. /proc/meminfo is read without
+        // the lock, so the jobs which started, finished or got blocked meanwhile are checked for
+        // after.
+        if (!mJobs.empty()) {
+            const size_t running = mJobs.size();
+            lock.unlock();
+            const int64_t available = getAvailableMemory();
+            lock.lock();
+            if (available >= 0 && available < jobMemory * static_cast<int64_t>(running + 1)) {
+                mCondition.wait_for(lock, kMemoryPollInterval);
+                continue;
+            }
+            if (mBlocked || mJobs.size() > running || !canStartLocked(allowed)) {
+                continue;
+            }
+        }
+
+        const bool alone = mJobs.empty();
+        const uint64_t id = mNextJobId++;
+        RunningJob& job = mJobs[id];
+        job.allowed = allowed;
+        rebalanceLocked();
+
+        // Alone, the job keeps whatever was configured, and only gets moved once other jobs
+        // start next to it.
+        if (alone || job.cpus.empty()) {
+            job.applied = job.allowed;
+            return std::unique_ptr<Job>(new Job(this, id, "", 0));
+        }
+        job.applied = job.cpus;
+        const int shareThreads = static_cast<int>(job.cpus.size());
+        return std::unique_ptr<Job>(new Job(this, id, join_cpus(job.cpus),
+                                            threads > 0 ? std::min(threads, shareThreads)
+                                                        : shareThreads));
+    }
+}
+
+void DexoptScheduler::setBlocked(bool blocked) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mBlocked = blocked;
+    mCondition.notify_all();
+}
+
+const std::vector<int>& DexoptScheduler::resolveCpusLocked(const std::string& cpuSet) {
+    auto it = mResolvedCpus.find(cpuSet);
+    if (it != mResolvedCpus.end()) {
+        return it->second;
+    }
+
+    const std::vector<int> available = getAvailableCpus();
+    std::vector<int> cpus;
+    if (cpuSet.empty()) {
+        cpus = available;
+    } else {
+        for (int cpu : parse_cpu_set(cpuSet)) {
+            if (available.empty() || std::binary_search(available.begin(), available.end(), cpu)) {
+                cpus.push_back(cpu);
+            }
+        }
+        if (cpus.empty()) {
+            // Stick to what was configured, even if installd itself can't run there.
+            cpus = parse_cpu_set(cpuSet);
+        }
+    }
+
+    LOG(DEBUG) << "Dexopt jobs for cpu set '" << cpuSet << "' run on cpus '" << join_cpus(cpus)
+               << "'";
+    return mResolvedCpus[cpuSet] = std::move(cpus);
+}
+
+bool DexoptScheduler::canStartLocked(const std::vector<int>& allowed) {
+    if (mJobs.size() >= mMaxJobs) {
+        return false;
+    }
+    const size_t overlapping = std::count_if(mJobs.begin(), mJobs.end(), [&](const auto& entry) {
+        return overlaps(entry.second.allowed, allowed);
+    });
+    return overlapping == 0 || (overlapping + 1) * kCpusPerJob <= allowed.size();
+}
+
+void DexoptScheduler::rebalanceLocked() {
+    std::vector<int> cpus;
+    for (const auto& [id, job] : mJobs) {
+        cpus.insert(cpus.end(), job.allowed.begin(), job.allowed.end());
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    auto allows = [](const RunningJob& job, int cpu) {
+        return std::binary_search(job.allowed.begin(), job.allowed.end(), cpu);
+    };
+
+    // Size the share of each job by handing every cpu to the job that may run there and has the
+    // fewest cpus so far.
+    std::map<uint64_t, size_t> shares;
+    for (int cpu : cpus) {
+        auto owner = shares.end();
+        for (const auto& [id, job] : mJobs) {
+            if (allows(job, cpu)) {
+                auto share = shares.try_emplace(id, 0).first;
+                if (owner == shares.end() || share->second < owner->second) {
+                    owner = share;
+                }
+            }
+        }
+        owner->second++;
+    }
+
+    // Then lay the shares out over contiguous cpus, which keeps each job within as few clusters
+    // as possible. The jobs with the fewest cpus to choose from pick first.
+    std::vector<std::pair<uint64_t, RunningJob*>> order;
+    for (auto& [id, job] : mJobs) {
+        job.cpus.clear();
+        order.emplace_back(id, &job);
+    }
+    std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+        return a.second->allowed.size() < b.second->allowed.size();
+    });
+    for (int cpu : cpus) {
+        RunningJob* owner = nullptr;
+        for (const auto& [id, job] : order) {
+            if (allows(*job, cpu) && job->cpus.size() < shares[id]) {
+                owner = job;
+                break;
+            }
+        }
+        if (owner == nullptr) {
+            for (const auto& [id, job] : order) {
+                if (allows(*job, cpu) &&
+                    (owner == nullptr || job->cpus.size() < owner->cpus.size())) {
+                    owner = job;
+                }
+            }
+        }
+        owner->cpus.push_back(cpu);
+    }
+
+    for (auto& [id, job] : mJobs) {
+        if (job.cpus.empty()) {
+            // Every cpu went to other jobs, so share them rather than not running at all.
+            job.cpus = job.allowed;
+        }
+        if (job.pid != 0 && !job.cpus.empty() && job.cpus != job.applied) {
+            setAffinity(job.pid, job.cpus);
+            job.applied = job.cpus;
+        }
+    }
+}
+
+void DexoptScheduler::setPid(uint64_t id, pid_t pid) {
+    std::lock_guard<std::mutex> lock(mLock);
+    RunningJob& job = mJobs[id];
+    job.pid = pid;
+    // Other jobs may have started or finished since this one did.
+    if (!job.cpus.empty() && job.cpus != job.applied) {
+        setAffinity(job.pid, job.cpus);
+        job.applied = job.cpus;
+    }
+}
+
+void DexoptScheduler::release(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mJobs.erase(id);
+    rebalanceLocked();
+    mCondition.notify_all();
+}
+
+std::vector<int> DexoptScheduler::getAvailableCpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        PLOG(WARNING) << "Failed to get the cpu affinity of installd";
+        return cpus;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+void DexoptScheduler::setAffinity(pid_t pid, const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+
+    // Every thread has its own affinity, and dex2oat may have started its workers already.
+    std::unique_ptr<DIR, decltype(&closedir)> tasks(
+            opendir(("/proc/" + std::to_string(pid) + "/task").c_str()), closedir);
+    if (tasks == nullptr) {
+        return;
+    }
+    while (dirent* entry = readdir(tasks.get())) {
+        pid_t tid;
+        if (!android::base::ParseInt(entry->d_name, &tid, 1)) {
+            continue;
+        }
+        if (sched_setaffinity(tid, sizeof(set), &set) != 0 && errno != ESRCH) {
+            PLOG(WARNING) << "Failed to move dexopt thread " << tid << " to cpus "
+                          << join_cpus(cpus);
+        }
+    }
+}
+
+int64_t DexoptScheduler::getAvailableMemory() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string line;
+    while (std::getline(meminfo, line)) {
+        if (android::base::StartsWith(line, "MemAvailable:")) {
+            // Formatted as "MemAvailable:    1234 kB".
+            auto fields = android::base::Tokenize(line, " ");
+            int64_t kilobytes;
+            if (fields.size() >= 2 && android::base::ParseInt(fields[1], &kilobytes, int64_t(0))) {
+                return kilobytes * 1024;
+            }
+            break;
+        }
+    }
+    return -1;
+}
+
+int64_t DexoptScheduler::getJobMemory() {
+    uint64_t bytes;
+    const std::string xmx = android::base::GetProperty("dalvik.vm.dex2oat-Xmx", "");
+    if (!xmx.empty() && android::base::ParseByteCount(xmx, &bytes) && bytes > 0) {
+        return static_cast<int64_t>(bytes);
+    }
+    return kDefaultJobMemory;
+}
+
+}  // namespace installd
+}  // namespace android
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_INSTALLD_DEXOPT_SCHEDULER_H
+#define ANDROID_INSTALLD_DEXOPT_SCHEDULER_H
+
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <android-base/macros.h>
+#include <android-base/thread_annotations.h>
+
+namespace android {
+namespace installd {
+
+/**
+ * Decides how many compilation jobs run at once, and on which cpus.
+ *
+ * A job that starts alone keeps its configured cpu set and thread count. Once jobs run next to
+ * each other, the cpus they may use are split between them, so that they don't fight over the
+ * same cores: a job starting next to others gets its share through --cpu-set and -j, while the
+ * processes of the running jobs are moved to theirs with sched_setaffinity. Their shares grow
+ * again as the other jobs finish. Jobs whose cpu sets overlap only start while each of them can
+ * get at least kCpusPerJob cpus, and a job only starts once the memory available leaves room for
+ * its heap and for the one of every running job.
+ */
+class DexoptScheduler {
+public:
+    /**
+     * Resources granted to a compilation job, until the job is destroyed.
+     */
+    class Job {
+    public:
+        ~Job();
+
+        // Cpus the job may run on, as a list for --cpu-set, or empty to keep the configured ones.
+        const std::string& cpuSet() const { return mCpuSet; }
+        // Number of threads for -j, or 0 to keep the configured one.
+        int threads() const { return mThreads; }
+
+        // Registers the process running the job, so that it can be moved to other cpus as jobs
+        // start and finish next to it.
+        void setPid(pid_t pid);
+
+    private:
+        friend class DexoptScheduler;
+
+        Job(DexoptScheduler* scheduler, uint64_t id, std::string cpuSet, int threads);
+
+        DexoptScheduler* const mScheduler;
+        const uint64_t mId;
+        const std::string mCpuSet;
+        const int mThreads;
+
+        DISALLOW_COPY_AND_ASSIGN(Job);
+    };
+
+    static constexpr size_t kDefaultMaxJobs = 4;
+    static constexpr size_t kCpusPerJob = 2;
+
+    explicit DexoptScheduler(size_t maxJobs = kDefaultMaxJobs);
+    virtual ~DexoptScheduler();
+
+    /**
+     * Waits until a job configured with the given cpu set, a list like "0,1,4-7" or empty for
+     * every cpu, and with the given number of threads, or 0 if not configured, can start.
+     * Returns nullptr if dexopt gets blocked while waiting.
+     */
+    std::unique_ptr<Job> acquire(const std::string& cpuSet, int threads);
+
+    /**
+     * Blocks or unblocks new jobs. Blocking also cancels the jobs waiting to start.
+     */
+    void setBlocked(bool blocked);
+
+protected:
+    // Cpus installd may run on.
+    virtual std::vector<int> getAvailableCpus();
+    // Memory available to new processes in bytes, or -1 if unknown.
+    virtual int64_t getAvailableMemory();
+    // Memory a single compilation job may need in bytes.
+    virtual int64_t getJobMemory();
+    // Moves every thread of the given process to the given cpus.
+    virtual void setAffinity(pid_t pid, const std::vector<int>& cpus);
+
+private:
+    struct RunningJob {
+        // Cpus the job was configured with.
+        std::vector<int> allowed;
+        // Cpus the job should run on next to the other jobs.
+        std::vector<int> cpus;
+        // Cpus the process of the job was last put on.
+        std::vector<int> applied;
+        pid_t pid = 0;
+    };
+
+    const std::vector<int>& resolveCpusLocked(const std::string& cpuSet) REQUIRES(mLock);
+    bool canStartLocked(const std::vector<int>& allowed) REQUIRES(mLock);
+    void rebalanceLocked() REQUIRES(mLock);
+    void setPid(uint64_t id, pid_t pid);
+    void release(uint64_t id);
+
+    const size_t mMaxJobs;
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    bool mBlocked GUARDED_BY(mLock) = false;
+    uint64_t mNextJobId GUARDED_BY(mLock) = 0;
+    // Ordered by start, so that older jobs get the first cpus when shares are even.
+    std::map<uint64_t, RunningJob> mJobs GUARDED_BY(mLock);
+    std::unordered_map<std::string, std::vector<int>> mResolvedCpus GUARDED_BY(mLock);
+
+    DISALLOW_COPY_AND_ASSIGN(DexoptScheduler);
+};
+
+}  // namespace installd
+}  // namespace android
+
+#endif  // ANDROID_INSTALLD_DEXOPT_SCHEDULER_H
@@ -36,6 +36,7 @@
 #include <sys/xattr.h>
 #include <unistd.h>
 #include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <functional>
@@ -114,6 +115,9 @@ static constexpr const char* CODE_CACHE_DIR_POSTFIX = "/code_cache";
 
 static constexpr const char* kFuseProp = "persist.sys.fuse";
 
+// Longest freeCache() goes on evicting on estimated sizes, before checking actual free space.
+static constexpr std::chrono::milliseconds kFreeCachePassDuration(250);
+
 /**
  * Property to control if app data isolation is enabled.
  */
@@ -407,6 +411,25 @@ using PackageLockGuard = std::lock_guard<PackageLock>;
 
 #endif // GRANULAR_LOCKS
 
+// Batched calls are sharded by package, so that packages are handled in parallel while the
+// entries of each package still run in order.
+template <class Args>
+std::vector<std::string> batchPackageNames(const std::vector<Args>& args) {
+    std::vector<std::string> packageNames;
+    packageNames.reserve(args.size());
+    for (const auto& arg : args) {
+        packageNames.push_back(arg.packageName);
+    }
+    return packageNames;
+}
+
+android::os::AppDataResult appDataResult(const binder::Status& status) {
+    android::os::AppDataResult result;
+    result.exceptionCode = status.exceptionCode();
+    result.exceptionMessage = status.exceptionMessage();
+    return result;
+}
+
 }  // namespace
 
 binder::Status InstalldNativeService::FsveritySetupAuthToken::authenticate(
@@ -994,15 +1017,14 @@ binder::Status InstalldNativeService::createAppDataBatched(
         ENFORCE_VALID_USER(arg.userId);
     }
 
-    // Locking is performed depeer in the callstack.
+    // Locking is performed deeper in the callstack, per package, so that packages are prepared
+    // in parallel. The worker threads aren't binder threads, and pass ENFORCE_UID as installd
+    // itself.
 
-    std::vector<android::os::CreateAppDataResult> results;
-    for (const auto &arg : args) {
-        android::os::CreateAppDataResult result;
-        createAppData(arg, &result);
-        results.push_back(result);
-    }
-    *_aidl_return = results;
+    std::vector<android::os::CreateAppDataResult> results(args.size());
+    mBatchExecutor.run(batchPackageNames(args),
+                       [&](size_t i) { createAppData(args[i], &results[i]); });
+    *_aidl_return = std::move(results);
     return ok();
 }
 
@@ -1431,6 +1453,26 @@ binder::Status InstalldNativeService::destroyAppData(const std::optional<std::st
     return res;
 }
 
+binder::Status InstalldNativeService::destroyAppDataBatched(
+        const std::vector<android::os::DestroyAppDataArgs>& args,
+        std::vector<android::os::AppDataResult>* _aidl_return) {
+    ENFORCE_UID(AID_SYSTEM);
+    for (const auto& arg : args) {
+        ENFORCE_VALID_USER(arg.userId);
+    }
+
+    // Locking is performed deeper in the callstack, per package.
+
+    std::vector<android::os::AppDataResult> results(args.size());
+    mBatchExecutor.run(batchPackageNames(args), [&](size_t i) {
+        const auto& arg = args[i];
+        results[i] = appDataResult(destroyAppData(arg.uuid, arg.packageName, arg.userId, arg.flags,
+                                                  arg.ceDataInode));
+    });
+    *_aidl_return = std::move(results);
+    return ok();
+}
+
 binder::Status InstalldNativeService::destroySdkSandboxDataPackageDirectory(
         const std::optional<std::string>& uuid, const std::string& packageName, int32_t userId,
         int32_t flags) {
@@ -1460,105 +1502,127 @@ static gid_t get_cache_gid(uid_t uid) {
     return (gid != -1) ? gid : uid;
 }
 
-binder::Status InstalldNativeService::fixupAppData(const std::optional<std::string>& uuid,
-        int32_t flags) {
-    ENFORCE_UID(AID_SYSTEM);
-    CHECK_ARGUMENT_UUID(uuid);
-
-    const char* uuid_ = uuid ? uuid->c_str() : nullptr;
-    for (auto userId : get_known_users(uuid_)) {
-        LOCK_USER();
-        atrace_pm_begin("fixup user");
-        FTS* fts;
-        FTSENT* p;
-        auto ce_path = create_data_user_ce_path(uuid_, userId);
-        auto de_path = create_data_user_de_path(uuid_, userId);
-        char *argv[] = { (char*) ce_path.c_str(), (char*) de_path.c_str(), nullptr };
-        if (!(fts = fts_open(argv, FTS_PHYSICAL | FTS_NOCHDIR | FTS_XDEV, nullptr))) {
-            return error("Failed to fts_open");
-        }
-        while ((p = fts_read(fts)) != nullptr) {
-            if (p->fts_info == FTS_D && p->fts_level == 1) {
-                // Track down inodes of cache directories
-                uint64_t raw = 0;
-                ino_t inode_cache = 0;
-                ino_t inode_code_cache = 0;
-                if (getxattr(p->fts_path, kXattrInodeCache, &raw, sizeof(raw)) == sizeof(raw)) {
-                    inode_cache = raw;
-                }
-                if (getxattr(p->fts_path, kXattrInodeCodeCache, &raw, sizeof(raw)) == sizeof(raw)) {
-                    inode_code_cache = raw;
-                }
+// Fixes up the GIDs of everything under the data directory of a single package.
+static bool fixup_package_data(const std::string& path, int32_t flags) {
+    FTS* fts;
+    FTSENT* p;
+    char *argv[] = { (char*) path.c_str(), nullptr };
+    if (!(fts = fts_open(argv, FTS_PHYSICAL | FTS_NOCHDIR | FTS_XDEV, nullptr))) {
+        return false;
+    }
+    while ((p = fts_read(fts)) != nullptr) {
+        if (p->fts_info == FTS_D && p->fts_level == 0) {
+            // Track down inodes of cache directories
+            uint64_t raw = 0;
+            ino_t inode_cache = 0;
+            ino_t inode_code_cache = 0;
+            if (getxattr(p->fts_path, kXattrInodeCache, &raw, sizeof(raw)) == sizeof(raw)) {
+                inode_cache = raw;
+            }
+            if (getxattr(p->fts_path, kXattrInodeCodeCache, &raw, sizeof(raw)) == sizeof(raw)) {
+                inode_code_cache = raw;
+            }
 
-                // Figure out expected GID of each child
-                FTSENT* child = fts_children(fts, 0);
-                while (child != nullptr) {
-                    if ((child->fts_statp->st_ino == inode_cache)
-                            || (child->fts_statp->st_ino == inode_code_cache)
-                            || !strcmp(child->fts_name, "cache")
-                            || !strcmp(child->fts_name, "code_cache")) {
-                        child->fts_number = get_cache_gid(p->fts_statp->st_uid);
-                    } else {
-                        child->fts_number = p->fts_statp->st_uid;
-                    }
-                    child = child->fts_link;
-                }
-            } else if (p->fts_level >= 2) {
-                if (p->fts_level > 2) {
-                    // Inherit GID from parent once we're deeper into tree
-                    p->fts_number = p->fts_parent->fts_number;
+            // Figure out expected GID of each child
+            FTSENT* child = fts_children(fts, 0);
+            while (child != nullptr) {
+                if ((child->fts_statp->st_ino == inode_cache)
+                        || (child->fts_statp->st_ino == inode_code_cache)
+                        || !strcmp(child->fts_name, "cache")
+                        || !strcmp(child->fts_name, "code_cache")) {
+                    child->fts_number = get_cache_gid(p->fts_statp->st_uid);
+                } else {
+                    child->fts_number = p->fts_statp->st_uid;
                 }
+                child = child->fts_link;
+            }
+        } else if (p->fts_level >= 1) {
+            if (p->fts_level > 1) {
+                // Inherit GID from parent once we're deeper into tree
+                p->fts_number = p->fts_parent->fts_number;
+            }
 
-                uid_t uid = p->fts_parent->fts_statp->st_uid;
-                gid_t cache_gid = get_cache_gid(uid);
-                gid_t expected = p->fts_number;
-                gid_t actual = p->fts_statp->st_gid;
-                if (actual == expected) {
+            uid_t uid = p->fts_parent->fts_statp->st_uid;
+            gid_t cache_gid = get_cache_gid(uid);
+            gid_t expected = p->fts_number;
+            gid_t actual = p->fts_statp->st_gid;
+            if (actual == expected) {
 #if FIXUP_DEBUG
-                    LOG(DEBUG) << "Ignoring " << p->fts_path << " with expected GID " << expected;
+                LOG(DEBUG) << "Ignoring " << p->fts_path << " with expected GID " << expected;
 #endif
-                    if (!(flags & FLAG_FORCE)) {
-                        fts_set(fts, p, FTS_SKIP);
-                    }
-                } else if ((actual == uid) || (actual == cache_gid)) {
-                    // Only consider fixing up when current GID belongs to app
-                    if (p->fts_info != FTS_D) {
-                        LOG(INFO) << "Fixing " << p->fts_path << " with unexpected GID " << actual
-                                << " instead of " << expected;
-                    }
-                    switch (p->fts_info) {
-                    case FTS_DP:
-                        // If we're moving towards cache GID, we need to set S_ISGID
-                        if (expected == cache_gid) {
-                            if (chmod(p->fts_path, 02771) != 0) {
-                                PLOG(WARNING) << "Failed to chmod " << p->fts_path;
-                            }
-                        }
-                        [[fallthrough]]; // also set GID
-                    case FTS_F:
-                        if (chown(p->fts_path, -1, expected) != 0) {
-                            PLOG(WARNING) << "Failed to chown " << p->fts_path;
-                        }
-                        break;
-                    case FTS_SL:
-                    case FTS_SLNONE:
-                        if (lchown(p->fts_path, -1, expected) != 0) {
-                            PLOG(WARNING) << "Failed to chown " << p->fts_path;
+                if (!(flags & FLAG_FORCE)) {
+                    fts_set(fts, p, FTS_SKIP);
+                }
+            } else if ((actual == uid) || (actual == cache_gid)) {
+                // Only consider fixing up when current GID belongs to app
+                if (p->fts_info != FTS_D) {
+                    LOG(INFO) << "Fixing " << p->fts_path << " with unexpected GID " << actual
+                            << " instead of " << expected;
+                }
+                switch (p->fts_info) {
+                case FTS_DP:
+                    // If we're moving towards cache GID, we need to set S_ISGID
+                    if (expected == cache_gid) {
+                        if (chmod(p->fts_path, 02771) != 0) {
+                            PLOG(WARNING) << "Failed to chmod " << p->fts_path;
                         }
-                        break;
                     }
-                } else {
-                    // Ignore all other GID transitions, since they're kinda shady
-                    LOG(WARNING) << "Ignoring " << p->fts_path << " with unexpected GID " << actual
-                            << " instead of " << expected;
-                    if (!(flags & FLAG_FORCE)) {
-                        fts_set(fts, p, FTS_SKIP);
+                    [[fallthrough]]; // also set GID
+                case FTS_F:
+                    if (chown(p->fts_path, -1, expected) != 0) {
+                        PLOG(WARNING) << "Failed to chown " << p->fts_path;
+                    }
+                    break;
+                case FTS_SL:
+                case FTS_SLNONE:
+                    if (lchown(p->fts_path, -1, expected) != 0) {
+                        PLOG(WARNING) << "Failed to chown " << p->fts_path;
                     }
+                    break;
+                }
+            } else {
+                // Ignore all other GID transitions, since they're kinda shady
+                LOG(WARNING) << "Ignoring " << p->fts_path << " with unexpected GID " << actual
+                        << " instead of " << expected;
+                if (!(flags & FLAG_FORCE)) {
+                    fts_set(fts, p, FTS_SKIP);
                 }
             }
         }
-        fts_close(fts);
+    }
+    fts_close(fts);
+    return true;
+}
+
+binder::Status InstalldNativeService::fixupAppData(const std::optional<std::string>& uuid,
+        int32_t flags) {
+    ENFORCE_UID(AID_SYSTEM);
+    CHECK_ARGUMENT_UUID(uuid);
+
+    const char* uuid_ = uuid ? uuid->c_str() : nullptr;
+    for (auto userId : get_known_users(uuid_)) {
+        LOCK_USER();
+        atrace_pm_begin("fixup user");
+        // Packages are fixed up in parallel, under the lock of the user.
+        std::vector<std::string> packageNames;
+        std::vector<std::string> paths;
+        for (const auto& userPath :
+             {create_data_user_ce_path(uuid_, userId), create_data_user_de_path(uuid_, userId)}) {
+            foreach_subdir(userPath, [&](const std::string& packageName) {
+                packageNames.push_back(packageName);
+                paths.push_back(userPath + "/" + packageName);
+            });
+        }
+        std::atomic<bool> failed = false;
+        mBatchExecutor.run(packageNames, [&](size_t i) {
+            if (!fixup_package_data(paths[i], flags)) {
+                failed = true;
+            }
+        });
         atrace_pm_end();
+        if (failed) {
+            return error("Failed to fts_open");
+        }
     }
     return ok();
 }
@@ -2105,6 +2169,9 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
         return error("Failed to determine free space for " + data_path);
     }
 
+    const int64_t startFree = free;
+    const auto startTime = std::chrono::steady_clock::now();
+
     int64_t needed = targetFreeBytes - free;
     if (!defy_target) {
         LOG(DEBUG) << "Device " << data_path << " has " << free << " free; requested "
@@ -2181,8 +2248,10 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
                     if (search != trackers.end()) {
                         search->second->addDataPath(p->fts_path);
                     } else {
-                        auto tracker = std::shared_ptr<CacheTracker>(new CacheTracker(
-                                multiuser_get_user_id(uid), multiuser_get_app_id(uid), uuidString));
+                        auto tracker = std::shared_ptr<CacheTracker>(
+                                new CacheTracker(multiuser_get_user_id(uid),
+                                                 multiuser_get_app_id(uid), uuidString,
+                                                 &mCacheIndex));
                         tracker->addDataPath(p->fts_path);
                         {
                             std::lock_guard<std::recursive_mutex> lock(mQuotasLock);
@@ -2220,6 +2289,7 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
         // the most over their assigned quota
         atrace_pm_begin("bounce");
         std::shared_ptr<CacheTracker> active;
+        auto passDeadline = std::chrono::steady_clock::now() + kFreeCachePassDuration;
         while (active || !queue.empty()) {
             // Only look at apps under quota when explicitly requested
             if (active && (active->getCacheRatio() < 10000)
@@ -2255,6 +2325,7 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
                 LOG(DEBUG) << "Purging " << item->toString() << " from " << active->toString();
                 if (!noop) {
                     item->purge();
+                    active->invalidateIndex();
                 }
                 active->cacheUsed -= item->size;
                 needed -= item->size;
@@ -2262,20 +2333,32 @@ binder::Status InstalldNativeService::freeCache(const std::optional<std::string>
 
             if (!defy_target) {
                 // Verify that we're actually done before bailing, since sneaky
-                // apps might be using hardlinks
-                if (needed <= 0) {
+                // apps might be using hardlinks. Indexed sizes may also be stale,
+                // so check the actual free space after each bounded pass too
+                const bool expectDone = needed <= 0;
+                if (expectDone || std::chrono::steady_clock::now() >= passDeadline) {
                     free = data_disk_free(data_path);
                     needed = targetFreeBytes - free;
                     if (needed <= 0) {
                         break;
-                    } else {
+                    } else if (expectDone) {
                         LOG(WARNING) << "Expected to be done but still need " << needed;
                     }
+                    passDeadline = std::chrono::steady_clock::now() + kFreeCachePassDuration;
                 }
             }
         }
         atrace_pm_end();
 
+        const int64_t freed = data_disk_free(data_path) - startFree;
+        const int64_t elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - startTime).count();
+        LOG(INFO) << "Freed " << freed << " bytes of cache on " << data_path << " in "
+                << elapsedNs / 1000000 << "ms"
+                << (freed > 0 ? StringPrintf(" (%.3f ns per byte)",
+                                             static_cast<double>(elapsedNs) / freed)
+                              : "");
+
     } else {
         return error("Legacy cache logic no longer supported");
     }
@@ -3417,6 +3500,26 @@ binder::Status InstalldNativeService::restoreconAppData(const std::optional<std:
     return restoreconAppDataLocked(uuid, packageName, userId, flags, appId, seInfo);
 }
 
+binder::Status InstalldNativeService::restoreconAppDataBatched(
+        const std::vector<android::os::RestoreconAppDataArgs>& args,
+        std::vector<android::os::AppDataResult>* _aidl_return) {
+    ENFORCE_UID(AID_SYSTEM);
+    for (const auto& arg : args) {
+        ENFORCE_VALID_USER(arg.userId);
+    }
+
+    // Locking is performed deeper in the callstack, per package.
+
+    std::vector<android::os::AppDataResult> results(args.size());
+    mBatchExecutor.run(batchPackageNames(args), [&](size_t i) {
+        const auto& arg = args[i];
+        results[i] = appDataResult(restoreconAppData(arg.uuid, arg.packageName, arg.userId,
+                                                     arg.flags, arg.appId, arg.seInfo));
+    });
+    *_aidl_return = std::move(results);
+    return ok();
+}
+
 binder::Status InstalldNativeService::restoreconAppDataLocked(
         const std::optional<std::string>& uuid, const std::string& packageName, int32_t userId,
         int32_t flags, int32_t appId, const std::string& seInfo) {
@@ -30,6 +30,8 @@
 #include <binder/BinderService.h>
 #include <cutils/multiuser.h>
 
+#include "BatchExecutor.h"
+#include "CacheIndex.h"
 #include "android/os/BnInstalld.h"
 #include "installd_constants.h"
 
@@ -82,6 +84,9 @@ public:
     binder::Status restoreconAppData(const std::optional<std::string>& uuid,
             const std::string& packageName, int32_t userId, int32_t flags, int32_t appId,
             const std::string& seInfo);
+    binder::Status restoreconAppDataBatched(
+            const std::vector<android::os::RestoreconAppDataArgs>& args,
+            std::vector<android::os::AppDataResult>* _aidl_return);
 
     binder::Status migrateAppData(const std::optional<std::string>& uuid,
             const std::string& packageName, int32_t userId, int32_t flags);
@@ -89,6 +94,9 @@ public:
             const std::string& packageName, int32_t userId, int32_t flags, int64_t ceDataInode);
     binder::Status destroyAppData(const std::optional<std::string>& uuid,
             const std::string& packageName, int32_t userId, int32_t flags, int64_t ceDataInode);
+    binder::Status destroyAppDataBatched(
+            const std::vector<android::os::DestroyAppDataArgs>& args,
+            std::vector<android::os::AppDataResult>* _aidl_return);
 
     binder::Status fixupAppData(const std::optional<std::string>& uuid, int32_t flags);
 
@@ -229,6 +237,12 @@ private:
     /* Map from UID to cache quota size */
     std::unordered_map<uid_t, int64_t> mCacheQuotas;
 
+    /* Cache items of apps, reused across calls to freeCache() */
+    CacheIndex mCacheIndex;
+
+    /* Runs the per-package work of batched calls on several threads */
+    BatchExecutor mBatchExecutor;
+
     std::string findDataMediaPath(const std::optional<std::string>& uuid, userid_t userid);
 
     binder::Status createAppDataLocked(const std::optional<std::string>& uuid,
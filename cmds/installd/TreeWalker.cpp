@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TreeWalker.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <android-base/thread_annotations.h>
+#include <android-base/unique_fd.h>
+
+namespace android {
+namespace installd {
+
+namespace {
+
+// Large enough to list most app directories with a single getdents64() call.
+constexpr size_t kDirentBufferSize = 32 * 1024;
+
+struct PendingDirectory {
+    std::string path;
+    short level;
+    void* pointer;
+};
+
+// Directories queued by one thread. The owner takes the newest one, so that it goes depth first,
+// while other threads steal the oldest one, which tends to hold the largest subtree.
+struct WorkQueue {
+    std::mutex lock;
+    std::deque<PendingDirectory> directories GUARDED_BY(lock);
+};
+
+class Walk {
+public:
+    Walk(const TreeWalker::Visitor& visitor, dev_t rootDevice, size_t maxThreads)
+          : mVisitor(visitor), mRootDevice(rootDevice), mMaxThreads(maxThreads),
+            mQueues(maxThreads) {}
+
+    // Walks everything under root on the calling thread, with the help of other threads if
+    // needed, and returns once every directory was listed.
+    void run(PendingDirectory root) {
+        push(0, std::move(root));
+        work(0);
+
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            threads.swap(mThreads);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+private:
+    void work(size_t index) {
+        std::unique_ptr<char[]> buffer(new char[kDirentBufferSize]);
+        PendingDirectory directory;
+        while (true) {
+            if (take(index, &directory)) {
+                list(index, directory, buffer.get());
+                if (mPending.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(mLock);
+                    mCondition.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mLock);
+            mIdle++;
+            mCondition.wait(lock, [this] { return mPending == 0 || mQueued > 0; });
+            mIdle--;
+            if (mPending == 0) {
+                return;
+            }
+        }
+    }
+
+    bool take(size_t index, PendingDirectory* directory) {
+        if (mQueued == 0) {
+            return false;
+        }
+        {
+            WorkQueue& queue = mQueues[index];
+            std::lock_guard<std::mutex> lock(queue.lock);
+            if (!queue.directories.empty()) {
+                *directory = std::move(queue.directories.back());
+                queue.directories.pop_back();
+                mQueued--;
+                return true;
+            }
+        }
+        for (size_t i = 1; i < mMaxThreads; i++) {
+            WorkQueue& queue = mQueues[(index + i) % mMaxThreads];
+            std::lock_guard<std::mutex> lock(queue.lock);
+            if (!queue.directories.empty()) {
+                *directory = std::move(queue.directories.front());
+                queue.directories.pop_front();
+                mQueued--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void push(size_t index, PendingDirectory directory) {
+        mPending++;
+        {
+            WorkQueue& queue = mQueues[index];
+            std::lock_guard<std::mutex> lock(queue.lock);
+            queue.directories.push_back(std::move(directory));
+        }
+        const size_t queued = ++mQueued;
+
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mIdle > 0) {
+            mCondition.notify_one();
+        } else if (queued > 1 && mThreads.size() + 1 < mMaxThreads) {
+            // Directories are piling up faster than they are listed, bring in another thread.
+            const size_t helper = mThreads.size() + 1;
+            mThreads.emplace_back([this, helper] { work(helper); });
+        }
+    }
+
+    void list(size_t index, const PendingDirectory& directory, char* buffer) {
+        android::base::unique_fd fd(TEMP_FAILURE_RETRY(
+                open(directory.path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)));
+        if (fd == -1) {
+            // Like FTS_DNR: the directory itself was visited, but its contents can't be.
+            return;
+        }
+        const bool needsSeparator = directory.path.empty() || directory.path.back() != '/';
+
+        long size;
+        while ((size = syscall(SYS_getdents64, fd.get(), buffer, kDirentBufferSize)) > 0) {
+            for (long offset = 0; offset < size;) {
+                const auto* dirent = reinterpret_cast<const struct dirent64*>(buffer + offset);
+                offset += dirent->d_reclen;
+                const char* name = dirent->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                    continue;
+                }
+
+                TreeEntry entry;
+                if (fstatat(fd.get(), name, &entry.st, AT_SYMLINK_NOFOLLOW) != 0) {
+                    continue;
+                }
+                entry.path.reserve(directory.path.size() + 1 + strlen(name));
+                entry.path = directory.path;
+                if (needsSeparator) {
+                    entry.path += '/';
+                }
+                entry.nameOffset = entry.path.size();
+                entry.path += name;
+                entry.level = directory.level + 1;
+                entry.parentPointer = directory.pointer;
+                entry.pointer = nullptr;
+
+                if (mVisitor(entry) && S_ISDIR(entry.st.st_mode) &&
+                    entry.st.st_dev == mRootDevice) {
+                    push(index, {std::move(entry.path), entry.level, entry.pointer});
+                }
+            }
+        }
+    }
+
+    const TreeWalker::Visitor& mVisitor;
+    const dev_t mRootDevice;
+    const size_t mMaxThreads;
+    std::vector<WorkQueue> mQueues;
+
+    // Directories queued or being listed. The walk is over when this drops to zero.
+    std::atomic<size_t> mPending = 0;
+    // Directories queued and not taken yet.
+    std::atomic<size_t> mQueued = 0;
+
+    std::mutex mLock;
+    std::condition_variable mCondition;
+    size_t mIdle GUARDED_BY(mLock) = 0;
+    std::vector<std::thread> mThreads GUARDED_BY(mLock);
+};
+
+}  // namespace
+
+TreeWalker::TreeWalker(size_t maxThreads) : mMaxThreads(std::max<size_t>(maxThreads, 1)) {}
+
+int TreeWalker::walk(const std::string& root, const Visitor& visitor) const {
+    TreeEntry entry;
+    if (lstat(root.c_str(), &entry.st) != 0) {
+        return -1;
+    }
+    entry.path = root;
+    entry.nameOffset = 0;
+    entry.level = 0;
+    entry.parentPointer = nullptr;
+    entry.pointer = nullptr;
+    if (!visitor(entry) || !S_ISDIR(entry.st.st_mode)) {
+        return 0;
+    }
+
+    Walk walk(visitor, entry.st.st_dev, mMaxThreads);
+    walk.run({std::move(entry.path), entry.level, entry.pointer});
+    return 0;
+}
+
+}  // namespace installd
+}  // namespace android
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_INSTALLD_TREE_WALKER_H
+#define ANDROID_INSTALLD_TREE_WALKER_H
+
+#include <functional>
+#include <string>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <android-base/macros.h>
+
+namespace android {
+namespace installd {
+
+/**
+ * Single entry found while walking a tree, similar to an FTSENT.
+ */
+struct TreeEntry {
+    // Path of the entry, starting with the root of the walk.
+    std::string path;
+    // Offset of the name of the entry in path.
+    size_t nameOffset;
+    // Depth of the entry, the root being at level 0.
+    short level;
+    struct stat st;
+
+    // Pointer set by the visitor on the parent directory, like fts_pointer.
+    void* parentPointer;
+    // Pointer handed to the children of this directory as their parentPointer.
+    void* pointer;
+
+    const char* name() const { return path.c_str() + nameOffset; }
+};
+
+/**
+ * Walks directory trees with the semantics of fts_open(FTS_PHYSICAL | FTS_NOCHDIR | FTS_XDEV),
+ * but lists and stats directories on several threads at once.
+ *
+ * Each directory is read in large batches with getdents64(), and its entries are stat'ed
+ * relative to the directory fd, which skips resolving the full path of each entry. Threads share
+ * pending directories through work stealing: each one goes depth first through its own queue,
+ * and takes the oldest directory from another queue when it runs out. Helper threads are only
+ * started once directories start to pile up, so that small trees are walked on the calling
+ * thread alone.
+ */
+class TreeWalker {
+public:
+    /**
+     * Called for each entry that could be stat'ed, possibly from several threads at once. The
+     * entries of a directory are all visited on the same thread, in the order the directory
+     * lists them, and after the directory itself. Return false to skip the contents of a
+     * directory, like fts_set(FTS_SKIP).
+     */
+    using Visitor = std::function<bool(TreeEntry& entry)>;
+
+    static constexpr size_t kDefaultMaxThreads = 4;
+
+    explicit TreeWalker(size_t maxThreads = kDefaultMaxThreads);
+
+    /**
+     * Walks the tree at root, and returns once every entry was visited. Directories that can't
+     * be read are visited but not descended into, and entries that can't be stat'ed are
+     * skipped. Returns 0 on success, or -1 with errno set if the root can't be stat'ed.
+     */
+    int walk(const std::string& root, const Visitor& visitor) const;
+
+private:
+    const size_t mMaxThreads;
+
+    DISALLOW_COPY_AND_ASSIGN(TreeWalker);
+};
+
+}  // namespace installd
+}  // namespace android
+
+#endif  // ANDROID_INSTALLD_TREE_WALKER_H
@@ -36,6 +36,7 @@
 #include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/no_destructor.h>
+#include <android-base/parseint.h>
 #include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
@@ -54,6 +55,7 @@
 #include <utils/Mutex.h>
 #include <ziparchive/zip_archive.h>
 
+#include "DexoptScheduler.h"
 #include "dexopt.h"
 #include "dexopt_return_codes.h"
 #include "execv_helper.h"
@@ -76,6 +78,7 @@ using android::base::StringPrintf;
 using android::base::WriteFully;
 using android::base::borrowed_fd;
 using android::base::unique_fd;
+using android::installd::DexoptScheduler;
 
 namespace {
 
@@ -153,6 +156,9 @@ class DexOptStatus {
 
 android::base::NoDestructor<DexOptStatus> dexopt_status_;
 
+// Runs several compilations at once when dexopt is called concurrently.
+android::base::NoDestructor<DexoptScheduler> dexopt_scheduler_;
+
 } // namespace
 
 namespace android {
@@ -1608,6 +1614,7 @@ static std::string join_fds(const std::vector<unique_fd>& fds) {
 
 void control_dexopt_blocking(bool block) {
     dexopt_status_->control_dexopt_blocking(block);
+    dexopt_scheduler_->setBlocked(block);
 }
 
 bool is_dexopt_blocked() {
@@ -1961,6 +1968,20 @@ int dexopt(const char* dex_path, uid_t uid, const char* pkgname, const char* ins
     LOG(VERBOSE) << "DexInv: --- BEGIN '" << dex_path << "' ---";
 
     RunDex2Oat runner(dex2oat_bin, execv_helper.get());
+
+    // Wait for room to run alongside the other compilations, and take a share of the cpus.
+    int threads = 0;
+    android::base::ParseInt(
+            runner.GetThreads(boot_complete, for_restore, background_job_compile), &threads);
+    std::unique_ptr<DexoptScheduler::Job> job = dexopt_scheduler_->acquire(
+            runner.GetCpuSet(boot_complete, for_restore, background_job_compile), threads);
+    if (job == nullptr) {
+        // cancelled, not an error
+        *completed = false;
+        reference_profile.DisableCleanup();
+        return 0;
+    }
+    runner.SetCpuSetAndThreads(job->cpuSet(), job->threads());
     runner.Initialize(out_oat.GetUniqueFile(), out_vdex.GetUniqueFile(), out_image.GetUniqueFile(),
                       in_dex, in_vdex, dex_metadata, reference_profile, class_loader_context,
                       join_fds(context_input_fds), swap_fd.get(), instruction_set, compiler_filter,
@@ -1991,6 +2012,9 @@ int dexopt(const char* dex_path, uid_t uid, const char* pkgname, const char* ins
 
         runner.Exec(DexoptReturnCodes::kDex2oatExec);
     } else {
+        // Lets the scheduler move dex2oat as other jobs start and finish. dex2oat applies its own
+        // --cpu-set once it starts, which may undo a move made before then, until the next one.
+        job->setPid(pid);
         int res = wait_child_with_timeout(pid, kLongTimeoutMs);
         bool cancelled = dexopt_status_->check_if_killed_and_remove_dexopt_pid(pid);
         if (res == 0) {
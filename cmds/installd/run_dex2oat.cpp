@@ -278,41 +278,19 @@ void RunDex2Oat::PrepareCompilerRuntimeAndPerfConfigFlags(bool post_bootcomplete
                                                           bool for_restore,
                                                           bool background_job_compile) {
     // CPU set
-    {
-        std::string cpu_set_format = "--cpu-set=%s";
-        std::string dex2oat_cpu_set_arg = post_bootcomplete
-                ? (for_restore
-                   ? MapPropertyToArgWithBackup(
-                           "dalvik.vm.restore-dex2oat-cpu-set",
-                           "dalvik.vm.dex2oat-cpu-set",
-                           cpu_set_format)
-                   : (background_job_compile
-                      ? MapPropertyToArgWithBackup(
-                              "dalvik.vm.background-dex2oat-cpu-set",
-                              "dalvik.vm.dex2oat-cpu-set",
-                              cpu_set_format)
-                      : MapPropertyToArg("dalvik.vm.dex2oat-cpu-set", cpu_set_format)))
-                : MapPropertyToArg("dalvik.vm.boot-dex2oat-cpu-set", cpu_set_format);
-        AddArg(dex2oat_cpu_set_arg);
+    std::string cpu_set = cpu_set_.empty()
+            ? GetCpuSet(post_bootcomplete, for_restore, background_job_compile)
+            : cpu_set_;
+    if (!cpu_set.empty()) {
+        AddArg("--cpu-set=" + cpu_set);
     }
 
     // Number of threads
-    {
-        std::string threads_format = "-j%s";
-        std::string dex2oat_threads_arg = post_bootcomplete
-                ? (for_restore
-                   ? MapPropertyToArgWithBackup(
-                           "dalvik.vm.restore-dex2oat-threads",
-                           "dalvik.vm.dex2oat-threads",
-                           threads_format)
-                   : (background_job_compile
-                      ? MapPropertyToArgWithBackup(
-                              "dalvik.vm.background-dex2oat-threads",
-                              "dalvik.vm.dex2oat-threads",
-                              threads_format)
-                      : MapPropertyToArg("dalvik.vm.dex2oat-threads", threads_format)))
-                : MapPropertyToArg("dalvik.vm.boot-dex2oat-threads", threads_format);
-        AddArg(dex2oat_threads_arg);
+    std::string threads = threads_ <= 0
+            ? GetThreads(post_bootcomplete, for_restore, background_job_compile)
+            : std::to_string(threads_);
+    if (!threads.empty()) {
+        AddArg("-j" + threads);
     }
 
     AddRuntimeArg(MapPropertyToArg("dalvik.vm.dex2oat-Xms", "-Xms%s"));
@@ -325,6 +303,31 @@ void RunDex2Oat::PrepareCompilerRuntimeAndPerfConfigFlags(bool post_bootcomplete
     }
 }
 
+std::string RunDex2Oat::GetCpuSet(bool post_bootcomplete,
+                                  bool for_restore,
+                                  bool background_job_compile) {
+    return GetJobProperty(post_bootcomplete, for_restore, background_job_compile,
+                          "dalvik.vm.boot-dex2oat-cpu-set",
+                          "dalvik.vm.restore-dex2oat-cpu-set",
+                          "dalvik.vm.background-dex2oat-cpu-set",
+                          "dalvik.vm.dex2oat-cpu-set");
+}
+
+std::string RunDex2Oat::GetThreads(bool post_bootcomplete,
+                                   bool for_restore,
+                                   bool background_job_compile) {
+    return GetJobProperty(post_bootcomplete, for_restore, background_job_compile,
+                          "dalvik.vm.boot-dex2oat-threads",
+                          "dalvik.vm.restore-dex2oat-threads",
+                          "dalvik.vm.background-dex2oat-threads",
+                          "dalvik.vm.dex2oat-threads");
+}
+
+void RunDex2Oat::SetCpuSetAndThreads(const std::string& cpu_set, int threads) {
+    cpu_set_ = cpu_set;
+    threads_ = threads;
+}
+
 void RunDex2Oat::Exec(int exit_code) {
     execv_helper_->Exec(exit_code);
 }
@@ -356,16 +359,24 @@ std::string RunDex2Oat::MapPropertyToArg(const std::string& property,
     return "";
 }
 
-std::string RunDex2Oat::MapPropertyToArgWithBackup(
-        const std::string& property,
-        const std::string& backupProperty,
-        const std::string& format,
-        const std::string& default_value) {
-    std::string value = GetProperty(property, default_value);
-    if (!value.empty()) {
-        return StringPrintf(format.c_str(), value.c_str());
+std::string RunDex2Oat::GetJobProperty(bool post_bootcomplete,
+                                       bool for_restore,
+                                       bool background_job_compile,
+                                       const std::string& boot_property,
+                                       const std::string& restore_property,
+                                       const std::string& background_property,
+                                       const std::string& property) {
+    if (!post_bootcomplete) {
+        return GetProperty(boot_property, "");
+    }
+    std::string value;
+    if (for_restore) {
+        value = GetProperty(restore_property, "");
+    } else if (background_job_compile) {
+        value = GetProperty(background_property, "");
     }
-    return MapPropertyToArg(backupProperty, format, default_value);
+    // The restore and background properties fall back to the default one.
+    return value.empty() ? GetProperty(property, "") : value;
 }
 
 }  // namespace installd
@@ -56,6 +56,14 @@ class RunDex2Oat {
 
     void Exec(int exit_code);
 
+    // Cpu set and number of threads configured for a job, or empty if not configured.
+    std::string GetCpuSet(bool post_bootcomplete, bool for_restore, bool background_job_compile);
+    std::string GetThreads(bool post_bootcomplete, bool for_restore, bool background_job_compile);
+
+    // Overrides the configured cpu set and number of threads, before Initialize(). Empty or 0
+    // keeps the configured value.
+    void SetCpuSetAndThreads(const std::string& cpu_set, int threads);
+
   protected:
     void PrepareBootImageFlags(bool use_jitzygote);
     void PrepareInputFileFlags(const UniqueFile& output_oat,
@@ -92,13 +100,18 @@ class RunDex2Oat {
                                  const std::string& format,
                                  const std::string& default_value = "");
 
-    std::string MapPropertyToArgWithBackup(const std::string& property,
-                                           const std::string& backupProperty,
-                                           const std::string& format,
-                                           const std::string& default_value = "");
+    std::string GetJobProperty(bool post_bootcomplete,
+                               bool for_restore,
+                               bool background_job_compile,
+                               const std::string& boot_property,
+                               const std::string& restore_property,
+                               const std::string& background_property,
+                               const std::string& property);
 
     const std::string dex2oat_bin_;
     ExecVHelper* execv_helper_;  // not owned
+    std::string cpu_set_;
+    int threads_ = 0;
 };
 
 }  // namespace installd
@@ -117,6 +117,8 @@ class RunDex2OatTest : public testing::Test {
         bool use_jitzygote = false;
         bool background_job_compile = false;
         const char* compilation_reason = nullptr;
+        std::string scheduled_cpu_set;
+        int scheduled_threads = 0;
     };
 
     class FakeExecVHelper : public ExecVHelper {
@@ -241,6 +243,7 @@ class RunDex2OatTest : public testing::Test {
 
     void CallRunDex2Oat(std::unique_ptr<RunDex2OatArgs> args) {
         FakeRunDex2Oat runner(execv_helper_.get(), &system_properties_);
+        runner.SetCpuSetAndThreads(args->scheduled_cpu_set, args->scheduled_threads);
         runner.Initialize(args->output_oat,
                           args->output_vdex,
                           args->output_image,
@@ -425,6 +428,20 @@ TEST_F(RunDex2OatTest, CpuSetPostBootCompleteForRestore_Backup) {
     VerifyExpectedFlags();
 }
 
+TEST_F(RunDex2OatTest, CpuSetAndThreadsScheduled) {
+    setSystemProperty("dalvik.vm.dex2oat-cpu-set", "0,1,2,3");
+    setSystemProperty("dalvik.vm.dex2oat-threads", "4");
+    auto args = RunDex2OatArgs::MakeDefaultTestArgs();
+    args->post_bootcomplete = true;
+    args->scheduled_cpu_set = "2,3";
+    args->scheduled_threads = 2;
+    CallRunDex2Oat(std::move(args));
+
+    SetExpectedFlagUsed("--cpu-set", "=2,3");
+    SetExpectedFlagUsed("-j", "2");
+    VerifyExpectedFlags();
+}
+
 TEST_F(RunDex2OatTest, Runtime) {
     setSystemProperty("dalvik.vm.dex2oat-Xms", "1234m");
     setSystemProperty("dalvik.vm.dex2oat-Xmx", "5678m");
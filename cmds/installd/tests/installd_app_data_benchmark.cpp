@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include <android-base/macros.h>
+#include <android-base/stringprintf.h>
+#include <benchmark/benchmark.h>
+#include <cutils/multiuser.h>
+#include <cutils/properties.h>
+
+#include "InstalldNativeService.h"
+#include "globals.h"
+#include "utils.h"
+
+using android::base::StringPrintf;
+
+namespace android {
+namespace installd {
+
+constexpr const char* kTestUuid = "TEST";
+constexpr int32_t kFirstAppId = 10000;
+
+int get_property(const char *key, char *value, const char *default_value) {
+    return property_get(key, value, default_value);
+}
+
+bool calculate_oat_file_path(char path[PKG_PATH_MAX] ATTRIBUTE_UNUSED,
+        const char *oat_dir ATTRIBUTE_UNUSED,
+        const char *apk_path ATTRIBUTE_UNUSED,
+        const char *instruction_set ATTRIBUTE_UNUSED) {
+    return false;
+}
+
+bool calculate_odex_file_path(char path[PKG_PATH_MAX] ATTRIBUTE_UNUSED,
+        const char *apk_path ATTRIBUTE_UNUSED,
+        const char *instruction_set ATTRIBUTE_UNUSED) {
+    return false;
+}
+
+bool create_cache_path(char path[PKG_PATH_MAX] ATTRIBUTE_UNUSED,
+        const char *src ATTRIBUTE_UNUSED,
+        const char *instruction_set ATTRIBUTE_UNUSED) {
+    return false;
+}
+
+bool force_compile_without_image() {
+    return false;
+}
+
+// Starts from an empty user, like the first boot of a device.
+static void reset_user_data() {
+    system("rm -rf /data/local/tmp/user /data/local/tmp/user_de");
+    system("rm -rf /data/local/tmp/misc_ce /data/local/tmp/misc_de");
+    system("mkdir -p /data/local/tmp/user/0 /data/local/tmp/user_de/0");
+    system("mkdir -p /data/local/tmp/misc_ce/0/sdksandbox /data/local/tmp/misc_de/0/sdksandbox");
+}
+
+// Arguments for preparing the data of the given number of packages, as PackageManager does on
+// first boot.
+static std::vector<android::os::CreateAppDataArgs> first_boot_args(int packages) {
+    std::vector<android::os::CreateAppDataArgs> args;
+    for (int i = 0; i < packages; i++) {
+        android::os::CreateAppDataArgs arg;
+        arg.uuid = kTestUuid;
+        arg.packageName = StringPrintf("com.example.app%d", i);
+        arg.userId = 0;
+        arg.flags = FLAG_STORAGE_CE | FLAG_STORAGE_DE;
+        arg.appId = kFirstAppId + i;
+        arg.previousAppId = -1;
+        arg.seInfo = "default";
+        arg.targetSdkVersion = 34;
+        args.push_back(arg);
+    }
+    return args;
+}
+
+// Baseline: one package after the other, as createAppDataBatched() used to do.
+static void BM_FirstBoot_CreateAppData(benchmark::State& state) {
+    init_globals_from_data_and_root();
+    InstalldNativeService service;
+    auto args = first_boot_args(state.range(0));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        reset_user_data();
+        state.ResumeTiming();
+        for (const auto& arg : args) {
+            android::os::CreateAppDataResult result;
+            service.createAppData(arg, &result);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * args.size());
+    reset_user_data();
+}
+BENCHMARK(BM_FirstBoot_CreateAppData)->Arg(50)->Arg(300)->UseRealTime();
+
+static void BM_FirstBoot_CreateAppDataBatched(benchmark::State& state) {
+    init_globals_from_data_and_root();
+    InstalldNativeService service;
+    auto args = first_boot_args(state.range(0));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        reset_user_data();
+        state.ResumeTiming();
+        std::vector<android::os::CreateAppDataResult> results;
+        service.createAppDataBatched(args, &results);
+    }
+    state.SetItemsProcessed(state.iterations() * args.size());
+    reset_user_data();
+}
+BENCHMARK(BM_FirstBoot_CreateAppDataBatched)->Arg(50)->Arg(300)->UseRealTime();
+
+// Fixing up the data of every package, as done after an OTA.
+static void BM_FirstBoot_FixupAppData(benchmark::State& state) {
+    init_globals_from_data_and_root();
+    InstalldNativeService service;
+    reset_user_data();
+    std::vector<android::os::CreateAppDataResult> results;
+    service.createAppDataBatched(first_boot_args(state.range(0)), &results);
+
+    for (auto _ : state) {
+        service.fixupAppData(kTestUuid, InstalldNativeService::FLAG_FORCE);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    reset_user_data();
+}
+BENCHMARK(BM_FirstBoot_FixupAppData)->Arg(300)->UseRealTime();
+
+}  // namespace installd
+}  // namespace android
@@ -16,15 +16,19 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/statvfs.h>
 #include <sys/xattr.h>
+#include <time.h>
 
 #include <android-base/logging.h>
 #include <android-base/stringprintf.h>
 #include <cutils/properties.h>
 #include <gtest/gtest.h>
 
+#include "CacheIndex.h"
 #include "InstalldNativeService.h"
+#include "TreeWalker.h"
 #include "globals.h"
 #include "utils.h"
 
@@ -116,6 +120,24 @@ static void setxattr(const char* path, const char* key) {
     ::setxattr(fullPath.c_str(), key, "", 0, 0);
 }
 
+static std::shared_ptr<CacheItem> cache_item(const char* path) {
+    TreeEntry entry;
+    entry.path = StringPrintf("/data/local/tmp/user/0/%s", path);
+    entry.nameOffset = entry.path.rfind('/') + 1;
+    entry.level = 1;
+    entry.parentPointer = nullptr;
+    entry.pointer = nullptr;
+    ::lstat(entry.path.c_str(), &entry.st);
+    return std::shared_ptr<CacheItem>(new CacheItem(entry));
+}
+
+static CacheIndex::DirectoryStamp directory_stamp(const char* path) {
+    const std::string fullPath = StringPrintf("/data/local/tmp/user/0/%s", path);
+    struct stat buf;
+    ::lstat(fullPath.c_str(), &buf);
+    return {"", buf.st_ino, buf.st_mtim, buf.st_ctim};
+}
+
 class CacheTest : public testing::Test {
 protected:
     InstalldNativeService* service;
@@ -389,5 +411,69 @@ TEST_F(CacheTest, FreeCache_GroupTombstone) {
     EXPECT_EQ(0, size("com.example/cache/tomb/group/dir/file2"));
 }
 
+TEST_F(CacheTest, CacheIndex_ReusesUnchangedTrees) {
+    LOG(INFO) << "CacheIndex_ReusesUnchangedTrees";
+
+    mkdir("com.example");
+    mkdir("com.example/cache");
+    touch("com.example/cache/one", kMbInBytes, -60);
+
+    const std::string cachePath = "/data/local/tmp/user/0/com.example/cache";
+    const std::vector<std::shared_ptr<CacheItem>> items = {cache_item("com.example/cache/one")};
+
+    // Pretend the tree was walked long after it last changed
+    struct timespec walkStart;
+    clock_gettime(CLOCK_REALTIME, &walkStart);
+    walkStart.tv_sec += 60;
+
+    CacheIndex index;
+    index.update(cachePath, items, {directory_stamp("com.example/cache")}, walkStart);
+    std::vector<std::shared_ptr<CacheItem>> found;
+    EXPECT_TRUE(index.lookup(cachePath, &found));
+    ASSERT_EQ(1u, found.size());
+    EXPECT_EQ(items[0], found[0]);
+
+    // Adding an entry changes the directory, which invalidates the tree
+    touch("com.example/cache/two", kMbInBytes, -60);
+    found.clear();
+    EXPECT_FALSE(index.lookup(cachePath, &found));
+    EXPECT_TRUE(found.empty());
+
+    // Trees that changed right before they were walked aren't trusted
+    clock_gettime(CLOCK_REALTIME, &walkStart);
+    index.update(cachePath, items, {directory_stamp("com.example/cache")}, walkStart);
+    EXPECT_FALSE(index.lookup(cachePath, &found));
+}
+
+TEST_F(CacheTest, CacheIndex_DropsTreesRewrittenInPlace) {
+    LOG(INFO) << "CacheIndex_DropsTreesRewrittenInPlace";
+
+    mkdir("com.example");
+    mkdir("com.example/cache");
+    touch("com.example/cache/one", kMbInBytes, -60);
+
+    const std::string cachePath = "/data/local/tmp/user/0/com.example/cache";
+    struct timespec walkStart;
+    clock_gettime(CLOCK_REALTIME, &walkStart);
+    walkStart.tv_sec += 60;
+
+    CacheIndex index;
+    index.update(cachePath, {cache_item("com.example/cache/one")},
+                 {directory_stamp("com.example/cache")}, walkStart);
+    std::vector<std::shared_ptr<CacheItem>> found;
+    EXPECT_TRUE(index.lookup(cachePath, &found));
+
+    // Growing a file leaves its directory alone, but is reported by inotify
+    touch("com.example/cache/one", 2 * kMbInBytes, -60);
+    found.clear();
+    EXPECT_FALSE(index.lookup(cachePath, &found));
+
+    // A tree which already differs from its walk isn't indexed
+    const std::vector<std::shared_ptr<CacheItem>> stale = {cache_item("com.example/cache/one")};
+    touch("com.example/cache/one", 3 * kMbInBytes, -60);
+    index.update(cachePath, stale, {directory_stamp("com.example/cache")}, walkStart);
+    EXPECT_FALSE(index.lookup(cachePath, &found));
+}
+
 }  // namespace installd
 }  // namespace android
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <android-base/file.h>
+#include <android-base/parseint.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <benchmark/benchmark.h>
+
+#include "DexoptScheduler.h"
+
+using android::base::StringPrintf;
+
+namespace android {
+namespace installd {
+
+constexpr const char* kFakeCompilerPath = "/data/local/tmp/installd_fake_dex2oat.sh";
+
+// Number of compilation jobs in each run, like a batch of apps to optimize.
+constexpr int kJobs = 8;
+
+// Stands in for dex2oat: a serial phase, like verification and linking, then a phase split
+// between the threads given with -j, like compiling methods.
+constexpr const char* kFakeCompiler = R"(#!/system/bin/sh
+threads=1
+for arg in "$@"; do
+    case "$arg" in -j*) threads=${arg#-j};; esac
+done
+spin() {
+    i=0
+    while [ $i -lt $1 ]; do i=$((i + 1)); done
+}
+spin 20000
+n=0
+while [ $n -lt $threads ]; do
+    spin $((80000 / threads)) &
+    n=$((n + 1))
+done
+wait
+)";
+
+static void write_fake_compiler() {
+    android::base::WriteStringToFile(kFakeCompiler, kFakeCompilerPath);
+    chmod(kFakeCompilerPath, 0700);
+}
+
+// Runs the fake compiler like dexopt() runs dex2oat, with --cpu-set applied to the process.
+static void run_fake_compiler(DexoptScheduler::Job& job, int threads) {
+    const std::string& cpuSet = job.cpuSet();
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (!cpuSet.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (const auto& cpu : android::base::Split(cpuSet, ",")) {
+                int index;
+                if (android::base::ParseInt(cpu, &index, 0, CPU_SETSIZE - 1)) {
+                    CPU_SET(index, &set);
+                }
+            }
+            sched_setaffinity(0, sizeof(set), &set);
+        }
+        const std::string jobs = StringPrintf("-j%d", threads);
+        execl("/system/bin/sh", "sh", kFakeCompilerPath, jobs.c_str(), nullptr);
+        _exit(1);
+    }
+    job.setPid(pid);
+    int status;
+    waitpid(pid, &status, 0);
+}
+
+// Baseline: one job after the other, each with a thread per cpu, as with a single caller.
+static void BM_Dexopt_Serial(benchmark::State& state) {
+    write_fake_compiler();
+    const int cpus = std::thread::hardware_concurrency();
+    DexoptScheduler scheduler(1);
+    for (auto _ : state) {
+        for (int i = 0; i < kJobs; i++) {
+            auto job = scheduler.acquire("", 0);
+            run_fake_compiler(*job, cpus);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kJobs);
+}
+BENCHMARK(BM_Dexopt_Serial)->UseRealTime();
+
+// All jobs requested at once, and run as the scheduler allows.
+static void BM_Dexopt_Scheduled(benchmark::State& state) {
+    write_fake_compiler();
+    const int cpus = std::thread::hardware_concurrency();
+    DexoptScheduler scheduler(state.range(0));
+    for (auto _ : state) {
+        std::vector<std::thread> callers;
+        for (int i = 0; i < kJobs; i++) {
+            callers.emplace_back([&] {
+                auto job = scheduler.acquire("", 0);
+                run_fake_compiler(*job, job->threads() > 0 ? job->threads() : cpus);
+            });
+        }
+        for (auto& caller : callers) {
+            caller.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kJobs);
+}
+BENCHMARK(BM_Dexopt_Scheduled)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+}  // namespace installd
+}  // namespace android
@@ -1339,6 +1339,47 @@ TEST_F(DestroyAppDataTest, DestroySdkSandboxDataDirectories_WithoutCeFlag) {
     ASSERT_FALSE(exists("/data/local/tmp/misc_de/0/sdksandbox/com.foo"));
 }
 
+TEST_F(DestroyAppDataTest, CreateAndDestroyAppDataBatched) {
+    std::vector<android::os::CreateAppDataArgs> createArgs;
+    for (int i = 0; i < 10; i++) {
+        createArgs.push_back(createAppDataArgs(StringPrintf("com.foo%d", i)));
+    }
+    // Entries of the same package run in order: this one finds the data created above.
+    createArgs.push_back(createAppDataArgs("com.foo0"));
+
+    std::vector<android::os::CreateAppDataResult> createResults;
+    ASSERT_BINDER_SUCCESS(service->createAppDataBatched(createArgs, &createResults));
+    ASSERT_EQ(createArgs.size(), createResults.size());
+    for (size_t i = 0; i < createArgs.size(); i++) {
+        ASSERT_EQ(0, createResults[i].exceptionCode) << createResults[i].exceptionMessage;
+        ASSERT_TRUE(exists(("/data/local/tmp/misc_ce/0/sdksandbox/" + createArgs[i].packageName)
+                                   .c_str()));
+    }
+    EXPECT_EQ(createResults[0].ceDataInode, createResults.back().ceDataInode);
+
+    std::vector<android::os::DestroyAppDataArgs> destroyArgs;
+    for (size_t i = 0; i < createArgs.size() - 1; i++) {
+        android::os::DestroyAppDataArgs args;
+        args.uuid = createArgs[i].uuid;
+        args.packageName = createArgs[i].packageName;
+        args.userId = createArgs[i].userId;
+        args.flags = createArgs[i].flags;
+        args.ceDataInode = createResults[i].ceDataInode;
+        destroyArgs.push_back(args);
+    }
+
+    std::vector<android::os::AppDataResult> destroyResults;
+    ASSERT_BINDER_SUCCESS(service->destroyAppDataBatched(destroyArgs, &destroyResults));
+    ASSERT_EQ(destroyArgs.size(), destroyResults.size());
+    for (size_t i = 0; i < destroyArgs.size(); i++) {
+        ASSERT_EQ(0, destroyResults[i].exceptionCode) << destroyResults[i].exceptionMessage;
+        ASSERT_FALSE(exists(("/data/local/tmp/misc_ce/0/sdksandbox/" + destroyArgs[i].packageName)
+                                    .c_str()));
+        ASSERT_FALSE(exists(("/data/local/tmp/misc_de/0/sdksandbox/" + destroyArgs[i].packageName)
+                                    .c_str()));
+    }
+}
+
 class ClearAppDataTest : public SdkSandboxDataTest {
 public:
     void createTestSdkData(const std::string& packageName, std::vector<std::string> sdkNames) {
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <fts.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <benchmark/benchmark.h>
+
+#include "TreeWalker.h"
+
+using android::base::StringPrintf;
+
+namespace android {
+namespace installd {
+
+constexpr const char* kBenchmarkDir = "/data/local/tmp/installd_tree_walker_benchmark";
+
+// Shapes of synthetic trees, which roughly look like app data directories.
+struct TreeShape {
+    const char* name;
+    int fanout;
+    int depth;
+    int files;
+};
+
+constexpr TreeShape kShapes[] = {
+        // Many small directories side by side, like the data of all the apps of a user.
+        {"wide", 48, 2, 8},
+        // Few large and deep directories, like a media cache.
+        {"deep", 3, 6, 16},
+};
+
+static void create_tree(const std::string& path, int fanout, int depth, int files) {
+    mkdir(path.c_str(), 0700);
+    for (int i = 0; i < files; i++) {
+        android::base::WriteStringToFile(std::string(512 * (i + 1), 'x'),
+                                         StringPrintf("%s/file%d", path.c_str(), i));
+    }
+    if (depth > 0) {
+        for (int i = 0; i < fanout; i++) {
+            create_tree(StringPrintf("%s/dir%d", path.c_str(), i), fanout, depth - 1, files);
+        }
+    }
+}
+
+static std::string tree_path(const benchmark::State& state) {
+    const TreeShape& shape = kShapes[state.range(0)];
+    std::string path = StringPrintf("%s/%s", kBenchmarkDir, shape.name);
+    if (access(path.c_str(), F_OK) != 0) {
+        mkdir(kBenchmarkDir, 0700);
+        create_tree(path, shape.fanout, shape.depth, shape.files);
+    }
+    return path;
+}
+
+// Baseline: the serial walk calculate_tree_size() used to do.
+static void BM_TreeSize_Fts(benchmark::State& state) {
+    std::string path = tree_path(state);
+    state.SetLabel(kShapes[state.range(0)].name);
+
+    size_t entries = 0;
+    for (auto _ : state) {
+        int64_t size = 0;
+        char* argv[] = {(char*)path.c_str(), nullptr};
+        FTS* fts = fts_open(argv, FTS_PHYSICAL | FTS_NOCHDIR | FTS_XDEV, nullptr);
+        FTSENT* p;
+        while ((p = fts_read(fts)) != nullptr) {
+            switch (p->fts_info) {
+                case FTS_D:
+                case FTS_DEFAULT:
+                case FTS_F:
+                case FTS_SL:
+                case FTS_SLNONE:
+                    size += p->fts_statp->st_blocks * 512;
+                    entries++;
+                    break;
+            }
+        }
+        fts_close(fts);
+        benchmark::DoNotOptimize(size);
+    }
+    state.SetItemsProcessed(entries);
+}
+BENCHMARK(BM_TreeSize_Fts)->DenseRange(0, 1);
+
+// Walks with up to the given number of threads.
+static void BM_TreeSize_TreeWalker(benchmark::State& state) {
+    std::string path = tree_path(state);
+    state.SetLabel(kShapes[state.range(0)].name);
+    TreeWalker walker(state.range(1));
+
+    std::atomic<size_t> entries = 0;
+    for (auto _ : state) {
+        std::atomic<int64_t> size = 0;
+        walker.walk(path, [&](TreeEntry& entry) {
+            size.fetch_add(entry.st.st_blocks * 512, std::memory_order_relaxed);
+            entries.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        });
+        benchmark::DoNotOptimize(size.load());
+    }
+    state.SetItemsProcessed(entries);
+}
+BENCHMARK(BM_TreeSize_TreeWalker)->ArgsProduct({{0, 1}, {1, 2, 4}})->UseRealTime();
+
+}  // namespace installd
+}  // namespace android
@@ -15,17 +15,29 @@
  */
 
 #include <errno.h>
+#include <fts.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+
+#include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/scopeguard.h>
+#include <android-base/stringprintf.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include "DexoptScheduler.h"
 #include "InstalldNativeService.h"
 #include "MatchExtensionGen.h"
+#include "TreeWalker.h"
 #include "globals.h"
 #include "utils.h"
 
@@ -48,8 +60,52 @@
 namespace android {
 namespace installd {
 
+using android::base::StringPrintf;
 using ::testing::UnorderedElementsAre;
 
+// Creates a tree with a few files and a symlink in each directory, and four subdirectories in each
+// directory above the given depth.
+static void create_test_tree(const std::string& path, int depth) {
+    ::mkdir(path.c_str(), 0700);
+    for (int i = 0; i < 3; i++) {
+        android::base::WriteStringToFile(std::string(4096 * (i + 1), 'x'),
+                                         StringPrintf("%s/file%d", path.c_str(), i));
+    }
+    ::symlink("file0", (path + "/link").c_str());
+    if (depth > 0) {
+        for (int i = 0; i < 4; i++) {
+            create_test_tree(StringPrintf("%s/dir%d", path.c_str(), i), depth - 1);
+        }
+    }
+}
+
+// Lists the paths and sizes of a tree with fts, which the tree walker is expected to match.
+static std::vector<std::string> fts_walk(const std::string& path, int64_t* size,
+                                         const std::string& skip = "") {
+    std::vector<std::string> paths;
+    char* argv[] = {(char*)path.c_str(), nullptr};
+    FTS* fts = fts_open(argv, FTS_PHYSICAL | FTS_NOCHDIR | FTS_XDEV, nullptr);
+    FTSENT* p;
+    while ((p = fts_read(fts)) != nullptr) {
+        switch (p->fts_info) {
+            case FTS_D:
+                if (p->fts_name == skip) {
+                    fts_set(fts, p, FTS_SKIP);
+                }
+                [[fallthrough]];
+            case FTS_DEFAULT:
+            case FTS_F:
+            case FTS_SL:
+            case FTS_SLNONE:
+                paths.push_back(p->fts_path);
+                *size += p->fts_statp->st_blocks * 512;
+                break;
+        }
+    }
+    fts_close(fts);
+    return paths;
+}
+
 class UtilsTest : public testing::Test {
 protected:
     virtual void SetUp() {
@@ -681,6 +737,245 @@ TEST_F(UtilsTest, TestForEachSubdir) {
     EXPECT_THAT(result, UnorderedElementsAre("com.foo", "com.bar"));
 }
 
+TEST_F(UtilsTest, CalculateTreeSize) {
+    system("mkdir -p /data/local/tmp/user");
+    auto deleter = [&]() {
+        delete_dir_contents_and_dir("/data/local/tmp/user/0", true /* ignore_if_missing */);
+    };
+    auto scope_guard = android::base::make_scope_guard(deleter);
+    create_test_tree("/data/local/tmp/user/0", 3);
+
+    int64_t expected = 0;
+    fts_walk("/data/local/tmp/user/0", &expected);
+    ASSERT_GT(expected, 0);
+
+    int64_t size = 0;
+    ASSERT_EQ(0, calculate_tree_size("/data/local/tmp/user/0", &size));
+    EXPECT_EQ(expected, size);
+
+    // Sizes are added to the existing value.
+    ASSERT_EQ(0, calculate_tree_size("/data/local/tmp/user/0/", &size));
+    EXPECT_EQ(2 * expected, size);
+
+    // Only entries of the included group count.
+    size = 0;
+    ASSERT_EQ(0, calculate_tree_size("/data/local/tmp/user/0", &size, getgid() + 1));
+    EXPECT_EQ(0, size);
+    ASSERT_EQ(0, calculate_tree_size("/data/local/tmp/user/0", &size, -1, getgid()));
+    EXPECT_EQ(0, size);
+
+    size = 0;
+    EXPECT_EQ(-1, calculate_tree_size("/data/local/tmp/user/0/missing", &size));
+    EXPECT_EQ(0, size);
+}
+
+TEST_F(UtilsTest, TreeWalkerMatchesFts) {
+    system("mkdir -p /data/local/tmp/user");
+    auto deleter = [&]() {
+        delete_dir_contents_and_dir("/data/local/tmp/user/0", true /* ignore_if_missing */);
+    };
+    auto scope_guard = android::base::make_scope_guard(deleter);
+    create_test_tree("/data/local/tmp/user/0", 3);
+
+    int64_t expectedSize = 0;
+    std::vector<std::string> expected = fts_walk("/data/local/tmp/user/0", &expectedSize, "dir1");
+
+    std::mutex lock;
+    std::vector<std::string> visited;
+    // Directory paths, handed to children through their pointer.
+    std::deque<std::string> directories;
+    TreeWalker walker(4);
+    ASSERT_EQ(0, walker.walk("/data/local/tmp/user/0", [&](TreeEntry& entry) {
+        std::lock_guard<std::mutex> guard(lock);
+        visited.push_back(entry.path);
+        if (entry.level == 0) {
+            EXPECT_EQ(nullptr, entry.parentPointer);
+        } else {
+            auto parent = static_cast<std::string*>(entry.parentPointer);
+            EXPECT_NE(nullptr, parent);
+            if (parent != nullptr) {
+                EXPECT_EQ(*parent + "/" + entry.name(), entry.path);
+            }
+        }
+        if (S_ISDIR(entry.st.st_mode)) {
+            entry.pointer = &directories.emplace_back(entry.path);
+        }
+        return strcmp(entry.name(), "dir1") != 0;
+    }));
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(visited.begin(), visited.end());
+    EXPECT_EQ(expected, visited);
+}
+
+// Scheduler for eight cpus, with enough memory for the given number of jobs.
+class FakeDexoptScheduler : public DexoptScheduler {
+public:
+    static constexpr int64_t kJobMemory = 100;
+
+    explicit FakeDexoptScheduler(int64_t memoryJobs) : mMemory(memoryJobs * kJobMemory) {}
+
+    std::atomic<int64_t> mMemory;
+    // Cpus each process was last moved to.
+    std::map<pid_t, std::vector<int>> mAffinities;
+
+protected:
+    std::vector<int> getAvailableCpus() override { return {0, 1, 2, 3, 4, 5, 6, 7}; }
+    int64_t getAvailableMemory() override { return mMemory; }
+    int64_t getJobMemory() override { return kJobMemory; }
+    void setAffinity(pid_t pid, const std::vector<int>& cpus) override {
+        mAffinities[pid] = cpus;
+    }
+};
+
+TEST_F(UtilsTest, DexoptSchedulerKeepsLoneJob) {
+    FakeDexoptScheduler scheduler(8);
+
+    auto job = scheduler.acquire("", 0);
+    ASSERT_NE(nullptr, job);
+    EXPECT_EQ("", job->cpuSet());
+    EXPECT_EQ(0, job->threads());
+    job->setPid(100);
+    job.reset();
+
+    job = scheduler.acquire("4-7", 3);
+    ASSERT_NE(nullptr, job);
+    EXPECT_EQ("", job->cpuSet());
+    EXPECT_EQ(0, job->threads());
+    job->setPid(101);
+    EXPECT_TRUE(scheduler.mAffinities.empty());
+}
+
+TEST_F(UtilsTest, DexoptSchedulerSplitsCpus) {
+    FakeDexoptScheduler scheduler(8);
+
+    auto first = scheduler.acquire("", 0);
+    ASSERT_NE(nullptr, first);
+    first->setPid(100);
+
+    // The running job makes room for the next one.
+    auto second = scheduler.acquire("", 0);
+    ASSERT_NE(nullptr, second);
+    EXPECT_EQ("4,5,6,7", second->cpuSet());
+    EXPECT_EQ(4, second->threads());
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3}), scheduler.mAffinities[100]);
+
+    // And gets its cpus back once it runs alone again.
+    second.reset();
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}), scheduler.mAffinities[100]);
+
+    // Overlapping cpu sets are split as well, up to the configured threads.
+    auto big = scheduler.acquire("4-7", 1);
+    ASSERT_NE(nullptr, big);
+    EXPECT_EQ("4,5,6,7", big->cpuSet());
+    EXPECT_EQ(1, big->threads());
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3}), scheduler.mAffinities[100]);
+
+    // A set too small to share kCpusPerJob cpus with a running job waits for it.
+    big.reset();
+    auto waiting = std::async(std::launch::async, [&] { return scheduler.acquire("6,7", 0); });
+    EXPECT_EQ(std::future_status::timeout, waiting.wait_for(std::chrono::milliseconds(100)));
+    first.reset();
+    auto small = waiting.get();
+    ASSERT_NE(nullptr, small);
+    EXPECT_EQ("", small->cpuSet());
+}
+
+TEST_F(UtilsTest, DexoptSchedulerMovesJobStartedBeforeSplit) {
+    FakeDexoptScheduler scheduler(8);
+
+    // The second job starts before the first one's process is known.
+    auto first = scheduler.acquire("", 0);
+    ASSERT_NE(nullptr, first);
+    auto second = scheduler.acquire("", 0);
+    ASSERT_NE(nullptr, second);
+    EXPECT_TRUE(scheduler.mAffinities.empty());
+
+    first->setPid(100);
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3}), scheduler.mAffinities[100]);
+    // The second one was started on its share already.
+    second->setPid(101);
+    EXPECT_EQ(0u, scheduler.mAffinities.count(101));
+}
+
+TEST_F(UtilsTest, DexoptSchedulerWaitsForSlot) {
+    FakeDexoptScheduler scheduler(8);
+
+    std::vector<std::unique_ptr<DexoptScheduler::Job>> jobs;
+    for (size_t i = 0; i < DexoptScheduler::kDefaultMaxJobs; i++) {
+        jobs.push_back(scheduler.acquire("", 0));
+        ASSERT_NE(nullptr, jobs.back());
+        jobs.back()->setPid(100 + i);
+    }
+    EXPECT_EQ((std::vector<int>{0, 1}), scheduler.mAffinities[100]);
+    EXPECT_EQ("6,7", jobs.back()->cpuSet());
+
+    auto waiting = std::async(std::launch::async, [&] { return scheduler.acquire("", 0); });
+    EXPECT_EQ(std::future_status::timeout, waiting.wait_for(std::chrono::milliseconds(100)));
+    jobs[2].reset();
+    auto job = waiting.get();
+    ASSERT_NE(nullptr, job);
+    // The running jobs spread out once the job is done, and make room again for the next one.
+    EXPECT_EQ("6,7", job->cpuSet());
+    EXPECT_EQ((std::vector<int>{0, 1}), scheduler.mAffinities[100]);
+    EXPECT_EQ((std::vector<int>{2, 3}), scheduler.mAffinities[101]);
+    EXPECT_EQ((std::vector<int>{4, 5}), scheduler.mAffinities[103]);
+}
+
+TEST_F(UtilsTest, DexoptSchedulerWaitsForMemory) {
+    FakeDexoptScheduler scheduler(1);
+
+    auto first = scheduler.acquire("", 0);
+    ASSERT_NE(nullptr, first);
+
+    auto waiting = std::async(std::launch::async, [&] { return scheduler.acquire("", 0); });
+    EXPECT_EQ(std::future_status::timeout, waiting.wait_for(std::chrono::milliseconds(100)));
+    scheduler.mMemory = 2 * FakeDexoptScheduler::kJobMemory;
+    EXPECT_NE(nullptr, waiting.get());
+}
+
+// Unblocks the scheduler while it reads the available memory, which takes its lock.
+class ReentrantDexoptScheduler : public FakeDexoptScheduler {
+public:
+    ReentrantDexoptScheduler() : FakeDexoptScheduler(8) {}
+
+protected:
+    int64_t getAvailableMemory() override {
+        setBlocked(false);
+        return FakeDexoptScheduler::getAvailableMemory();
+    }
+};
+
+TEST_F(UtilsTest, DexoptSchedulerReadsMemoryWithoutLock) {
+    ReentrantDexoptScheduler scheduler;
+
+    auto first = scheduler.acquire("", 0);
+    ASSERT_NE(nullptr, first);
+    auto second = std::async(std::launch::async, [&] { return scheduler.acquire("", 0); });
+    ASSERT_EQ(std::future_status::ready, second.wait_for(std::chrono::seconds(5)));
+    EXPECT_NE(nullptr, second.get());
+}
+
+TEST_F(UtilsTest, DexoptSchedulerBlocking) {
+    FakeDexoptScheduler scheduler(8);
+
+    std::vector<std::unique_ptr<DexoptScheduler::Job>> jobs;
+    for (size_t i = 0; i < DexoptScheduler::kDefaultMaxJobs; i++) {
+        jobs.push_back(scheduler.acquire("", 0));
+    }
+
+    // Blocking cancels waiting jobs, and keeps new ones from starting.
+    auto waiting = std::async(std::launch::async, [&] { return scheduler.acquire("", 0); });
+    EXPECT_EQ(std::future_status::timeout, waiting.wait_for(std::chrono::milliseconds(100)));
+    scheduler.setBlocked(true);
+    EXPECT_EQ(nullptr, waiting.get());
+    jobs.clear();
+    EXPECT_EQ(nullptr, scheduler.acquire("", 0));
+
+    scheduler.setBlocked(false);
+    EXPECT_NE(nullptr, scheduler.acquire("", 0));
+}
+
 TEST_F(UtilsTest, TestSdkSandboxDataPaths) {
     // Ce data paths
     EXPECT_EQ("/data/misc_ce/0/sdksandbox",
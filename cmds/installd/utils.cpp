@@ -30,6 +30,8 @@
 #include <unistd.h>
 #include <uuid/uuid.h>
 
+#include <atomic>
+
 #include <android-base/file.h>
 #include <android-base/logging.h>
 #include <android-base/stringprintf.h>
@@ -45,6 +47,7 @@
 #include "dexopt_return_codes.h"
 #include "globals.h"  // extern variables.
 #include "QuotaUtils.h"
+#include "TreeWalker.h"
 
 #ifndef LOG_TAG
 #define LOG_TAG "installd"
@@ -466,45 +469,31 @@ int set_quota_project_id(const std::string& path, long project_id, bool set_inhe
 
 int calculate_tree_size(const std::string& path, int64_t* size,
         int32_t include_gid, int32_t exclude_gid, bool exclude_apps) {
-    FTS *fts;
-    FTSENT *p;
-    int64_t matchedSize = 0;
-    char *argv[] = { (char*) path.c_str(), nullptr };
-    if (!(fts = fts_open(argv, FTS_PHYSICAL | FTS_NOCHDIR | FTS_XDEV, nullptr))) {
+    std::atomic<int64_t> atomicSize = 0;
+    int res = TreeWalker().walk(path, [&](TreeEntry& entry) {
+        int32_t uid = entry.st.st_uid;
+        int32_t gid = entry.st.st_gid;
+        int32_t user_uid = multiuser_get_app_id(uid);
+        int32_t user_gid = multiuser_get_app_id(gid);
+        if (exclude_apps && ((user_uid >= AID_APP_START && user_uid <= AID_APP_END)
+                || (user_gid >= AID_CACHE_GID_START && user_gid <= AID_CACHE_GID_END)
+                || (user_gid >= AID_SHARED_GID_START && user_gid <= AID_SHARED_GID_END))) {
+            // Don't traverse inside or measure
+            return false;
+        }
+        if ((include_gid == -1 || gid == include_gid)
+                && (exclude_gid == -1 || gid != exclude_gid)) {
+            atomicSize.fetch_add(entry.st.st_blocks * 512, std::memory_order_relaxed);
+        }
+        return true;
+    });
+    if (res != 0) {
         if (errno != ENOENT) {
-            PLOG(ERROR) << "Failed to fts_open " << path;
+            PLOG(ERROR) << "Failed to walk " << path;
         }
         return -1;
     }
-    while ((p = fts_read(fts)) != nullptr) {
-        switch (p->fts_info) {
-        case FTS_D:
-        case FTS_DEFAULT:
-        case FTS_F:
-        case FTS_SL:
-        case FTS_SLNONE:
-            int32_t uid = p->fts_statp->st_uid;
-            int32_t gid = p->fts_statp->st_gid;
-            int32_t user_uid = multiuser_get_app_id(uid);
-            int32_t user_gid = multiuser_get_app_id(gid);
-            if (exclude_apps && ((user_uid >= AID_APP_START && user_uid <= AID_APP_END)
-                    || (user_gid >= AID_CACHE_GID_START && user_gid <= AID_CACHE_GID_END)
-                    || (user_gid >= AID_SHARED_GID_START && user_gid <= AID_SHARED_GID_END))) {
-                // Don't traverse inside or measure
-                fts_set(fts, p, FTS_SKIP);
-                break;
-            }
-            if (include_gid != -1 && gid != include_gid) {
-                break;
-            }
-            if (exclude_gid != -1 && gid == exclude_gid) {
-                break;
-            }
-            matchedSize += (p->fts_statp->st_blocks * 512);
-            break;
-        }
-    }
-    fts_close(fts);
+    int64_t matchedSize = atomicSize;
 #if MEASURE_DEBUG
     if ((include_gid == -1) && (exclude_gid == -1)) {
         LOG(DEBUG) << "Measured " << path << " size " << matchedSize;
@@ -26,6 +26,7 @@
 #include <map>
 #include <regex>
 #include <sstream>
+#include <thread>
 
 #include <android-base/file.h>
 #include <android-base/hex.h>
@@ -54,6 +55,9 @@ using ::android::hidl::manager::V1_0::IServiceManager;
 namespace android {
 namespace lshal {
 
+// Upper bound of threads fetching binderized HALs at the same time.
+static constexpr size_t kMaxFetchThreads = 8;
+
 vintf::SchemaType toSchemaType(Partition p) {
     return (p == Partition::SYSTEM) ? vintf::SchemaType::FRAMEWORK : vintf::SchemaType::DEVICE;
 }
@@ -211,13 +215,16 @@ bool ListCommand::getPidInfo(
 }
 
 const BinderPidInfo* ListCommand::getPidInfoCached(pid_t serverPid) {
-    auto pair = mCachedPidInfos.insert({serverPid, BinderPidInfo{}});
-    if (pair.second /* did insertion take place? */) {
-        if (!getPidInfo(serverPid, &pair.first->second)) {
-            return nullptr;
-        }
+    CachedPidInfo* cached;
+    {
+        std::lock_guard<std::mutex> lock(mCachedPidInfosLock);
+        cached = &mCachedPidInfos[serverPid];
     }
-    return &pair.first->second;
+    // Parsing the binder logs is slow, so do it without holding the lock. Threads asking for the
+    // same PID wait for the first one instead of parsing them again.
+    std::call_once(cached->once,
+                   [&] { cached->valid = getPidInfo(serverPid, &cached->info); });
+    return cached->valid ? &cached->info : nullptr;
 }
 
 bool ListCommand::shouldFetchHalType(const HalType &type) const {
@@ -619,17 +626,57 @@ Status ListCommand::fetchBinderized(const sp<IServiceManager> &manager) {
         return DUMP_BINDERIZED_ERROR;
     }
 
-    Status status = OK;
     std::map<std::string, TableEntry> allTableEntries;
+    std::vector<TableEntry*> entries;
     for (const auto& fqInstanceName : *fqInstanceNames) {
         // create entry and default assign all fields.
         TableEntry& entry = allTableEntries[fqInstanceName];
         entry.interfaceName = fqInstanceName;
         entry.transport = mode;
         entry.serviceStatus = ServiceStatus::NON_RESPONSIVE;
+    }
+    for (auto& pair : allTableEntries) {
+        entries.push_back(&pair.second);
+    }
 
-        status |= fetchBinderizedEntry(manager, &entry);
+    // Each entry takes several IPCs, each of which may time out, so fetch them on a few threads.
+    // Results and warnings are kept per entry and reported in the order of the sorted names.
+    std::vector<Status> statuses(entries.size(), OK);
+    std::vector<std::ostringstream> warnings(entries.size());
+    std::mutex nextLock;
+    size_t next = 0;
+    const auto fetchEntries = [&] {
+        while (true) {
+            size_t i;
+            {
+                std::lock_guard<std::mutex> lock(nextLock);
+                if (next >= entries.size()) {
+                    return;
+                }
+                i = next++;
+            }
+            statuses[i] = fetchBinderizedEntry(manager, entries[i], warnings[i]);
+        }
+    };
+    size_t threadCount = std::min(kMaxFetchThreads, entries.size());
+    if (threadCount <= 1) {
+        fetchEntries();
+    } else {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < threadCount; ++i) {
+            threads.emplace_back(fetchEntries);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    Status status = OK;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        err() << warnings[i].str();
+        status |= statuses[i];
     }
+    err().flush();
 
     for (auto& pair : allTableEntries) {
         putEntry(HalType::BINDERIZED_SERVICES, std::move(pair.second));
@@ -638,10 +685,10 @@ Status ListCommand::fetchBinderized(const sp<IServiceManager> &manager) {
 }
 
 Status ListCommand::fetchBinderizedEntry(const sp<IServiceManager> &manager,
-                                         TableEntry *entry) {
+                                         TableEntry *entry, std::ostream &warnings) {
     Status status = OK;
     const auto handleError = [&](Status additionalError, const std::string& msg) {
-        err() << "Warning: Skipping \"" << entry->interfaceName << "\": " << msg << std::endl;
+        warnings << "Warning: Skipping \"" << entry->interfaceName << "\": " << msg << std::endl;
         status |= DUMP_BINDERIZED_ERROR | additionalError;
     };
 
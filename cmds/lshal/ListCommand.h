@@ -20,6 +20,8 @@
 #include <stdint.h>
 
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -99,14 +101,17 @@ protected:
     Status fetchManifestHals();
     Status fetchLazyHals();
 
+    // Warnings are written to |warnings| rather than err() so that entries can be fetched on
+    // several threads and still be reported in a deterministic order.
     Status fetchBinderizedEntry(const sp<::android::hidl::manager::V1_0::IServiceManager> &manager,
-                                TableEntry *entry);
+                                TableEntry *entry, std::ostream &warnings);
 
     // Get relevant information for a PID by parsing files under
     // /dev/binderfs/binder_logs or /d/binder.
     // It is a virtual member function so that it can be mocked.
     virtual bool getPidInfo(pid_t serverPid, BinderPidInfo *info) const;
     // Retrieve from mCachedPidInfos and call getPidInfo if necessary.
+    // Thread-safe; getPidInfo is called at most once per PID.
     const BinderPidInfo* getPidInfoCached(pid_t serverPid);
 
     void dumpTable(const NullableOStream<std::ostream>& out) const;
@@ -185,8 +190,14 @@ protected:
     // If an entry exist and not empty, it contains the cached content of /proc/{pid}/cmdline.
     std::map<pid_t, std::string> mCmdlines;
 
-    // Cache for getPidInfo.
-    std::map<pid_t, BinderPidInfo> mCachedPidInfos;
+    // Cache for getPidInfo. Entries are never removed, so pointers to them stay valid.
+    struct CachedPidInfo {
+        std::once_flag once;
+        bool valid = false;
+        BinderPidInfo info;
+    };
+    std::mutex mCachedPidInfosLock;
+    std::map<pid_t, CachedPidInfo> mCachedPidInfos;
 
     // Cache for getPartition.
     std::map<pid_t, Partition> mPartitions;
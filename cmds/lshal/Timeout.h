@@ -18,6 +18,7 @@
 
 #include <chrono>
 #include <future>
+#include <mutex>
 
 #include <hidl/Status.h>
 #include <utils/Errors.h>
@@ -47,8 +48,13 @@ timeoutIPC(std::chrono::duration<R, P> wait, const sp<I> &interfaceObject, Funct
     // Putting this in the global list avoids std::future::~future() that may wait for the
     // result to come back.
     // This leaks memory, but lshal is a debugging tool, so this is fine.
+    // timeoutIPC() may be called from several threads at once.
+    static std::mutex gDeadPoolLock;
     static std::vector<decltype(future)> gDeadPool{};
-    gDeadPool.emplace_back(std::move(future));
+    {
+        std::lock_guard<std::mutex> lock(gDeadPoolLock);
+        gDeadPool.emplace_back(std::move(future));
+    }
 
     if (status == std::future_status::timeout) {
         return Status::fromStatusT(TIMED_OUT);
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <chrono>
 #include <future>
 #include <mutex>
@@ -459,6 +460,53 @@ TEST_F(ListTest, GetPidInfoCached) {
     EXPECT_NE(nullptr, mockList->getPidInfoCached(5));
 }
 
+TEST_F(ListTest, GetPidInfoCachedConcurrently) {
+    EXPECT_CALL(*mockList, getPidInfo(5, _)).Times(1);
+
+    std::vector<const BinderPidInfo*> pidInfos(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < pidInfos.size(); ++i) {
+        threads.emplace_back([&, i] { pidInfos[i] = mockList->getPidInfoCached(5); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_NE(nullptr, pidInfos[0]);
+    for (const auto* pidInfo : pidInfos) {
+        EXPECT_EQ(pidInfos[0], pidInfo);
+    }
+}
+
+TEST_F(ListTest, FetchManyBinderized) {
+    // More services than threads fetching them, so that threads pick up several entries.
+    std::vector<std::string> fqInstanceNames;
+    for (pid_t id = 1; id <= 20; ++id) {
+        fqInstanceNames.push_back(getFqInstanceName(id));
+        EXPECT_CALL(*mockList, getPidInfo(id, _)).Times(1);
+    }
+    ON_CALL(*serviceManager, list(_)).WillByDefault(Invoke([&](IServiceManager::list_cb cb) {
+        std::vector<hidl_string> ret(fqInstanceNames.begin(), fqInstanceNames.end());
+        cb(ret);
+        return hardware::Void();
+    }));
+
+    optind = 1; // mimic Lshal::parseArg()
+    ASSERT_EQ(0u, mockList->parseArgs(createArg({"lshal", "--types=b"})));
+    ASSERT_EQ(0u, mockList->fetch());
+
+    // Entries come out sorted by name no matter which thread fetched them.
+    std::sort(fqInstanceNames.begin(), fqInstanceNames.end());
+    std::vector<std::string> fetched;
+    mockList->forEachTable([&](const Table& table) {
+        for (const auto& entry : table) {
+            fetched.push_back(entry.interfaceName);
+            EXPECT_EQ(getPidInfoFromId(entry.serverPid).threadCount, entry.threadCount);
+        }
+    });
+    EXPECT_EQ(fqInstanceNames, fetched);
+    EXPECT_EQ("", err.str());
+}
+
 TEST_F(ListTest, Fetch) {
     optind = 1; // mimic Lshal::parseArg()
     ASSERT_EQ(0u, mockList->parseArgs(createArg({"lshal"})));
@@ -27,6 +27,7 @@
 #include <binder/Parcel.h>
 #include <binder/RecordedTransaction.h>
 #include <binder/RpcServer.h>
+#include <binder/TransactionProfiler.h>
 #include <binder/unique_fd.h>
 #include <pthread.h>
 
@@ -185,6 +186,104 @@ status_t IBinder::getDebugPid(pid_t* out) {
     return OK;
 }
 
+static status_t getLocalThreadPoolStats(std::string* out) {
+    if (!kEnableKernelIpc) {
+        return INVALID_OPERATION;
+    }
+    sp<ProcessState> process = ProcessState::selfOrNull();
+    if (process == nullptr) {
+        return INVALID_OPERATION;
+    }
+    *out = process->getThreadPoolStats().toString();
+    return OK;
+}
+
+status_t IBinder::getDebugThreadPoolStats(std::string* out) {
+    if (this->localBinder() != nullptr) {
+        return getLocalThreadPoolStats(out);
+    }
+
+    Parcel data;
+    Parcel reply;
+    status_t status = transact(DEBUG_THREAD_POOL_TRANSACTION, data, &reply);
+    if (status != OK) return status;
+    return reply.readUtf8FromUtf16(out);
+}
+
+// Commands of DEBUG_TRANSACTION_PROFILE_TRANSACTION.
+enum : int32_t {
+    kTransactionProfileDump = 0,
+    kTransactionProfileStart = 1,
+    kTransactionProfileStop = 2,
+};
+
+static status_t runTransactionProfileCommand(int32_t command, std::string* out) {
+    using binder::debug::TransactionProfiler;
+    if (!kEnableKernelIpc) {
+        return INVALID_OPERATION;
+    }
+    switch (command) {
+        case kTransactionProfileDump:
+            *out = TransactionProfiler::dump();
+            return OK;
+        case kTransactionProfileStart:
+            TransactionProfiler::reset();
+            TransactionProfiler::setEnabled(true);
+            return OK;
+        case kTransactionProfileStop:
+            TransactionProfiler::setEnabled(false);
+            return OK;
+        default:
+            return BAD_VALUE;
+    }
+}
+
+static status_t transactionProfileCommand(IBinder* binder, int32_t command, std::string* out) {
+    if (binder->localBinder() != nullptr) {
+        return runTransactionProfileCommand(command, out);
+    }
+
+    Parcel data;
+    Parcel reply;
+    status_t status;
+    if (status = data.writeInt32(command); status != OK) return status;
+    status = binder->transact(IBinder::DEBUG_TRANSACTION_PROFILE_TRANSACTION, data, &reply);
+    if (status != OK || command != kTransactionProfileDump) return status;
+    return reply.readUtf8FromUtf16(out);
+}
+
+status_t IBinder::setDebugTransactionProfiling(bool enabled) {
+    std::string unused;
+    return transactionProfileCommand(this,
+                                     enabled ? kTransactionProfileStart : kTransactionProfileStop,
+                                     &unused);
+}
+
+status_t IBinder::getDebugTransactionProfile(std::string* out) {
+    return transactionProfileCommand(this, kTransactionProfileDump, out);
+}
+
+// Runs a DEBUG_TRANSACTION_PROFILE_TRANSACTION for a remote caller.
+static status_t handleTransactionProfileTransaction(const Parcel& data, Parcel* reply) {
+    if (!kEnableKernelIpc) {
+        ALOGW("Binder transaction profiling disallowed because kernel binder is not enabled");
+        return INVALID_OPERATION;
+    }
+    int32_t command;
+    if (status_t status = data.readInt32(&command); status != OK) return status;
+    // The profile names the interfaces and codes the process was called with.
+    uid_t uid = IPCThreadState::self()->getCallingUid();
+    if (uid != kUidRoot) {
+        ALOGE("Binder transaction profiling not allowed because client %" PRIu32 " is not root",
+              uid);
+        return PERMISSION_DENIED;
+    }
+    std::string profile;
+    status_t status = runTransactionProfileCommand(command, &profile);
+    if (status != OK || command != kTransactionProfileDump) return status;
+    return reply->writeUtf8AsUtf16(profile);
+}
+
 status_t IBinder::setRpcClientDebug(unique_fd socketFd, const sp<IBinder>& keepAliveBinder) {
     if (!kEnableRpcDevServers) {
         ALOGW("setRpcClientDebug disallowed because RPC is not enabled");
@@ -400,6 +499,18 @@ status_t BBinder::transact(
             LOG_ALWAYS_FATAL_IF(reply == nullptr, "reply == nullptr");
             err = reply->writeInt32(getDebugPid());
             break;
+        case DEBUG_THREAD_POOL_TRANSACTION: {
+            LOG_ALWAYS_FATAL_IF(reply == nullptr, "reply == nullptr");
+            std::string stats;
+            err = getLocalThreadPoolStats(&stats);
+            if (err == OK) err = reply->writeUtf8AsUtf16(stats);
+            break;
+        }
+        case DEBUG_TRANSACTION_PROFILE_TRANSACTION: {
+            LOG_ALWAYS_FATAL_IF(reply == nullptr, "reply == nullptr");
+            err = handleTransactionProfileTransaction(data, reply);
+            break;
+        }
         case SET_RPC_CLIENT_TRANSACTION: {
             err = setRpcClientDebug(data);
             break;
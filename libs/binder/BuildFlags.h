@@ -28,4 +28,10 @@ constexpr bool kEnableKernelIpc = true;
 constexpr bool kEnableKernelIpc = false;
 #endif // BINDER_WITH_KERNEL_IPC
 
+#if defined(__linux__) && !defined(BINDER_RPC_SINGLE_THREADED)
+constexpr bool kEnableRpcReactor = true;
+#else
+constexpr bool kEnableRpcReactor = false;
+#endif
+
 } // namespace android
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HandleTable.h"
+
+#include <sched.h>
+
+namespace android {
+
+HandleTable::Entry* HandleTable::find(int32_t handle) const {
+    if (handle < 0) return nullptr;
+
+    const Directory* directory = mDirectory.load(std::memory_order_acquire);
+    const size_t index = static_cast<size_t>(handle) / kSegmentSize;
+    if (directory == nullptr || index >= directory->segments.size()) return nullptr;
+
+    Entry* segment = directory->segments[index];
+    if (segment == nullptr) return nullptr;
+    return &segment[static_cast<size_t>(handle) % kSegmentSize];
+}
+
+HandleTable::Entry* HandleTable::findOrCreate(int32_t handle) {
+    if (handle < 0) return nullptr;
+
+    Entry* entry = find(handle);
+    if (entry != nullptr) return entry;
+
+    auto segment = std::make_unique<Entry[]>(kSegmentSize);
+    auto directory = std::make_unique<Directory>();
+
+    // Readers may be using the current directory, so copy it rather than adding to it.
+    const size_t index = static_cast<size_t>(handle) / kSegmentSize;
+    const Directory* current = mDirectory.load(std::memory_order_relaxed);
+    if (current != nullptr) directory->segments = current->segments;
+    if (directory->segments.size() <= index) directory->segments.resize(index + 1, nullptr);
+    directory->segments[index] = segment.get();
+    entry = &segment[static_cast<size_t>(handle) % kSegmentSize];
+
+    mDirectory.store(directory.get(), std::memory_order_release);
+    mSegments.push_back(std::move(segment));
+    mDirectories.push_back(std::move(directory));
+    return entry;
+}
+
+void HandleTable::publish(Entry* entry, IBinder* binder) {
+    entry->binder.store(binder, std::memory_order_seq_cst);
+}
+
+void HandleTable::expunge(Entry* entry, IBinder* binder) {
+    IBinder* expected = binder;
+    entry->binder.compare_exchange_strong(expected, nullptr, std::memory_order_seq_cst);
+
+    // A ReadGuard created after this point can't load |binder| anymore, and those created before
+    // only take a weak reference, so this doesn't wait for long.
+    while (entry->readers.load(std::memory_order_seq_cst) != 0) {
+        sched_yield();
+    }
+}
+
+} // namespace android
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <binder/IBinder.h>
+
+namespace android {
+
+/**
+ * The proxies of the handles a process holds, indexed by handle.
+ *
+ * Lookups are lock-free. Entries live in fixed-size segments which never move once allocated,
+ * and are found through a directory which is copied, not resized, when it has to grow. Replaced
+ * directories are kept until the table is destroyed, so a reader may keep using the one it
+ * loaded however long it takes.
+ *
+ * Writers are serialized by the caller (ProcessState::mLock). A writer removing a proxy waits
+ * for the readers which may have seen it, see expunge(), so readers may touch the proxy without
+ * holding a reference on it.
+ */
+class HandleTable {
+public:
+    struct Entry {
+        std::atomic<IBinder*> binder = nullptr;
+        // Number of ReadGuards on this entry.
+        std::atomic<uint32_t> readers = 0;
+    };
+
+    /**
+     * While it exists, the proxy it read, if any, is not destroyed past expungeHandle().
+     * This is meant to be held just long enough to take a weak reference on it.
+     */
+    class ReadGuard {
+    public:
+        explicit ReadGuard(Entry* entry) : mEntry(entry) {
+            mEntry->readers.fetch_add(1, std::memory_order_seq_cst);
+            mBinder = mEntry->binder.load(std::memory_order_seq_cst);
+        }
+        ~ReadGuard() { mEntry->readers.fetch_sub(1, std::memory_order_release); }
+
+        IBinder* binder() const { return mBinder; }
+
+    private:
+        Entry* mEntry;
+        IBinder* mBinder;
+    };
+
+    HandleTable() = default;
+    HandleTable(const HandleTable&) = delete;
+    HandleTable& operator=(const HandleTable&) = delete;
+
+    /** Returns the entry of |handle|, or nullptr if it was never created. Thread-safe. */
+    Entry* find(int32_t handle) const;
+
+    /** Like find(), but creates the entry if needed. Writers only. */
+    Entry* findOrCreate(int32_t handle);
+
+    /** Sets the proxy of |entry|. Writers only. */
+    static void publish(Entry* entry, IBinder* binder);
+
+    /**
+     * Clears |entry| if it still holds |binder|, which may have been replaced already, then waits
+     * for the readers which may have loaded |binder| to be done. Writers only.
+     */
+    static void expunge(Entry* entry, IBinder* binder);
+
+private:
+    static constexpr size_t kSegmentSize = 256;
+
+    struct Directory {
+        // Indexed by handle / kSegmentSize, nullptr for segments not allocated yet.
+        std::vector<Entry*> segments;
+    };
+
+    std::atomic<const Directory*> mDirectory = nullptr;
+
+    // Owned by the writers.
+    std::vector<std::unique_ptr<Entry[]>> mSegments;
+    std::vector<std::unique_ptr<Directory>> mDirectories;
+};
+
+} // namespace android
@@ -64,6 +64,7 @@
 namespace android {
 
 using namespace std::chrono_literals;
+using binder::debug::TransactionProfiler;
 
 // Static const and functions will be optimized out if not used,
 // when LOG_NDEBUG and references in IF_LOG_COMMANDS() are optimized out.
@@ -693,11 +694,13 @@ status_t IPCThreadState::getAndExecuteCommand()
             mProcess->mStarvationStartTime
                     .compare_exchange_strong(expected, std::chrono::steady_clock::now());
         }
+        mProcess->onCommandStarted(newThreadsCount);
 
         result = executeCommand(cmd);
 
         size_t maxThreads = mProcess->mMaxThreads;
         newThreadsCount = mProcess->mExecutingThreadsCount.fetch_sub(1) - 1;
+        mProcess->onCommandFinished(newThreadsCount);
         if (newThreadsCount < maxThreads) {
             auto starvationStartTime =
                     mProcess->mStarvationStartTime.exchange(ProcessState::never());
@@ -773,13 +776,23 @@ void IPCThreadState::processPostWriteDerefs()
 
 void IPCThreadState::joinThreadPool(bool isMain)
 {
+    joinThreadPool(isMain, false /*isSpawned*/);
+}
+
+void IPCThreadState::joinThreadPool(bool isMain, bool isSpawned)
+{
+    if (isSpawned && !isMain) {
+        mProcess->waitForSpawnDemand();
+    }
+
     LOG_THREADPOOL("**** THREAD %p (PID %d) IS JOINING THE THREAD POOL\n", (void*)pthread_self(),
                    getpid());
-    mProcess->mCurrentThreads++;
+    mProcess->onThreadJoined();
     mOut.writeInt32(isMain ? BC_ENTER_LOOPER : BC_REGISTER_LOOPER);
 
     mIsLooper = true;
     status_t result;
+    bool retired = false;
     do {
         processPendingDerefs();
         // now get the next command to be processed, waiting if necessary
@@ -795,6 +808,14 @@ void IPCThreadState::joinThreadPool(bool isMain)
         if(result == TIMED_OUT && !isMain) {
             break;
         }
+
+        // Only retire once the commands read from the driver are all handled.
+        if (isSpawned && !isMain && mIn.dataPosition() >= mIn.dataSize() &&
+            mProcess->shouldRetireThread()) {
+            processPendingDerefs();
+            retired = true;
+            break;
+        }
     } while (result != -ECONNREFUSED && result != -EBADF);
 
     LOG_THREADPOOL("**** THREAD %p (PID %d) IS LEAVING THE THREAD POOL err=%d\n",
@@ -808,6 +829,9 @@ void IPCThreadState::joinThreadPool(bool isMain)
                         "Threadpool thread count underflowed. Thread cannot exist and exit in "
                         "empty threadpool\n"
                         "Misconfiguration. Increase threadpool max threads configuration\n");
+    if (retired) {
+        mProcess->onThreadRetired();
+    }
 }
 
 status_t IPCThreadState::setupPolling(int* fd)
@@ -819,7 +843,7 @@ status_t IPCThreadState::setupPolling(int* fd)
     mOut.writeInt32(BC_ENTER_LOOPER);
     flushCommands();
     *fd = mProcess->mDriverFD;
-    mProcess->mCurrentThreads++;
+    mProcess->onThreadJoined();
     return 0;
 }
 
@@ -864,6 +888,11 @@ status_t IPCThreadState::transact(int32_t handle,
         ALOGI("%s", message.c_str());
     }
 
+    const bool profiling = TransactionProfiler::isEnabled();
+    const auto profilingStart =
+            profiling ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    size_t replySize = 0;
+
     LOG_ONEWAY(">>>> SEND from pid %d uid %d %s", getpid(), getuid(),
         (flags & TF_ONE_WAY) == 0 ? "READ REPLY" : "ONE WAY");
     err = writeTransactionData(BC_TRANSACTION, flags, handle, code, data, nullptr);
@@ -893,9 +922,11 @@ status_t IPCThreadState::transact(int32_t handle,
 #endif
         if (reply) {
             err = waitForResponse(reply);
+            replySize = reply->dataSize();
         } else {
             Parcel fakeReply;
             err = waitForResponse(&fakeReply);
+            replySize = fakeReply.dataSize();
         }
         #if 0
         if (code == 4) { // relayout
@@ -920,6 +951,12 @@ status_t IPCThreadState::transact(int32_t handle,
         err = waitForResponse(nullptr, nullptr);
     }
 
+    if (profiling) {
+        TransactionProfiler::record(&mTransactionProfile, TransactionProfiler::Direction::OUTGOING,
+                                    static_cast<uint32_t>(handle), code, data, replySize,
+                                    profilingStart);
+    }
+
     return err;
 }
 
@@ -1040,6 +1077,7 @@ IPCThreadState::IPCThreadState()
 
 IPCThreadState::~IPCThreadState()
 {
+    TransactionProfiler::retire(&mTransactionProfile);
 }
 
 status_t IPCThreadState::sendReply(const Parcel& reply, uint32_t flags)
@@ -1462,6 +1500,9 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
                 std::string message = logStream.str();
                 ALOGI("%s", message.c_str());
             }
+            const bool profiling = TransactionProfiler::isEnabled();
+            const auto profilingStart = profiling ? std::chrono::steady_clock::now()
+                                                  : std::chrono::steady_clock::time_point();
             if (tr.target.ptr) {
                 // We only have a weak reference on the target object, so we must first try to
                 // safely acquire a strong reference before doing anything else with it.
@@ -1478,6 +1519,13 @@ status_t IPCThreadState::executeCommand(int32_t cmd)
                 error = the_context_object->transact(tr.code, buffer, &reply, tr.flags);
             }
 
+            if (profiling) {
+                TransactionProfiler::record(&mTransactionProfile,
+                                            TransactionProfiler::Direction::INCOMING,
+                                            tr.target.ptr, tr.code, buffer, reply.dataSize(),
+                                            profilingStart);
+            }
+
             //ALOGI("<<<< TRANSACT from pid %d restore pid %d sid %s uid %d\n",
             //     mCallingPid, origPid, (origSid ? origSid : "<N/A>"), origUid);
 
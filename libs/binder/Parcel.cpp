@@ -1012,6 +1012,20 @@ uid_t Parcel::readCallingWorkSourceUid() const
     return uid;
 }
 
+const char16_t* Parcel::peekInterfaceToken(size_t* outLen) const {
+    auto* kernelFields = maybeKernelFields();
+    if (kernelFields == nullptr || !kernelFields->mRequestHeaderPresent) {
+        return nullptr;
+    }
+
+    const size_t initialPosition = dataPosition();
+    // The work source is followed by the vendor header, and then the descriptor.
+    setDataPosition(kernelFields->mWorkSourceRequestHeaderPosition + 2 * sizeof(int32_t));
+    const char16_t* str = readString16Inplace(outLen);
+    setDataPosition(initialPosition);
+    return str;
+}
+
 bool Parcel::checkInterface(IBinder* binder) const
 {
     return enforceInterface(binder->getInterfaceDescriptor());
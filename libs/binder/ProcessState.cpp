@@ -28,6 +28,7 @@
 #include <utils/String8.h>
 #include <utils/Thread.h>
 
+#include "HandleTable.h"
 #include "Static.h"
 #include "Utils.h"
 #include "binder_module.h"
@@ -42,7 +43,9 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
 #include <mutex>
+#include <sstream>
 
 #define BINDER_VM_SIZE ((1 * 1024 * 1024) - sysconf(_SC_PAGE_SIZE) * 2)
 #define DEFAULT_MAX_BINDER_THREADS 15
@@ -91,7 +94,7 @@ public:
 protected:
     virtual bool threadLoop()
     {
-        IPCThreadState::self()->joinThreadPool(mIsMain);
+        IPCThreadState::self()->joinThreadPool(mIsMain, true /*isSpawned*/);
         return false;
     }
 
@@ -310,43 +313,55 @@ void ProcessState::setCallRestriction(CallRestriction restriction) {
     mCallRestriction = restriction;
 }
 
-ProcessState::handle_entry* ProcessState::lookupHandleLocked(int32_t handle)
+// see b/166779391: cannot change the VNDK interface, so access like this
+extern sp<BBinder> the_context_object;
+
+// Returns the proxy of |e| if there is one and it isn't being destroyed.
+static sp<IBinder> promoteHandleEntry(HandleTable::Entry* e, const void* id)
 {
-    const size_t N=mHandleToObject.size();
-    if (N <= (size_t)handle) {
-        handle_entry e;
-        e.binder = nullptr;
-        e.refs = nullptr;
-        status_t err = mHandleToObject.insertAt(e, N, handle+1-N);
-        if (err < NO_ERROR) return nullptr;
+    if (e == nullptr) return nullptr;
+
+    IBinder* b;
+    {
+        // The attemptIncWeak() is safe because we know the BpBinder destructor will always
+        // call expungeHandle(), which waits for this guard to be released. It fails if
+        // someone is releasing the last reference on this BpBinder while a new reference on
+        // its handle arrives from the driver, and then the caller creates a new BpBinder.
+        HandleTable::ReadGuard guard(e);
+        b = guard.binder();
+        if (b == nullptr || !b->getWeakRefs()->attemptIncWeak(id)) return nullptr;
     }
-    return &mHandleToObject.editItemAt(handle);
-}
 
-// see b/166779391: cannot change the VNDK interface, so access like this
-extern sp<BBinder> the_context_object;
+    // This little bit of nastyness is to allow us to add a primary
+    // reference to the remote proxy when this team doesn't have one
+    // but another team is sending the handle to us.
+    sp<IBinder> result;
+    result.force_set(b);
+    b->getWeakRefs()->decWeak(id);
+    return result;
+}
 
 sp<IBinder> ProcessState::getStrongProxyForHandle(int32_t handle)
 {
-    sp<IBinder> result;
+    if (handle == 0 && the_context_object != nullptr) return the_context_object;
+
+    // Most of the time the handle already has a live proxy, which is found without mLock so
+    // that binder threads unparceling binders at the same time don't contend on it.
+    sp<IBinder> result = promoteHandleEntry(mHandleToObject->find(handle), this);
+    if (result != nullptr) return result;
+
     std::function<void()> postTask;
 
     std::unique_lock<std::mutex> _l(mLock);
 
-    if (handle == 0 && the_context_object != nullptr) return the_context_object;
-
-    handle_entry* e = lookupHandleLocked(handle);
+    HandleTable::Entry* e = mHandleToObject->findOrCreate(handle);
 
     if (e != nullptr) {
         // We need to create a new BpBinder if there isn't currently one, OR we
-        // are unable to acquire a weak reference on this current one.  The
-        // attemptIncWeak() is safe because we know the BpBinder destructor will always
-        // call expungeHandle(), which acquires the same lock we are holding now.
-        // We need to do this because there is a race condition between someone
-        // releasing a reference on this BpBinder, and a new reference on its handle
-        // arriving from the driver.
-        IBinder* b = e->binder;
-        if (b == nullptr || !e->refs->attemptIncWeak(this)) {
+        // are unable to acquire a weak reference on this current one. Another
+        // thread may have created it since we looked above.
+        result = promoteHandleEntry(e, this);
+        if (result == nullptr) {
             if (handle == 0) {
                 // Special case for context manager...
                 // The context manager is the only object for which we create
@@ -378,15 +393,8 @@ sp<IBinder> ProcessState::getStrongProxyForHandle(int32_t handle)
             }
 
             sp<BpBinder> b = BpBinder::PrivateAccessor::create(handle, &postTask);
-            e->binder = b.get();
-            if (b) e->refs = b->getWeakRefs();
+            HandleTable::publish(e, b.get());
             result = b;
-        } else {
-            // This little bit of nastyness is to allow us to add a primary
-            // reference to the remote proxy when this team doesn't have one
-            // but another team is sending the handle to us.
-            result.force_set(b);
-            e->refs->decWeak(this);
         }
     }
 
@@ -401,12 +409,12 @@ void ProcessState::expungeHandle(int32_t handle, IBinder* binder)
 {
     std::unique_lock<std::mutex> _l(mLock);
 
-    handle_entry* e = lookupHandleLocked(handle);
+    HandleTable::Entry* e = mHandleToObject->find(handle);
 
     // This handle may have already been replaced with a new BpBinder
     // (if someone failed the AttemptIncWeak() above); we don't want
     // to overwrite it.
-    if (e && e->binder == binder) e->binder = nullptr;
+    if (e) HandleTable::expunge(e, binder);
 }
 
 String8 ProcessState::makeBinderThreadName() {
@@ -430,6 +438,7 @@ void ProcessState::spawnPooledThread(bool isMain)
         sp<Thread> t = sp<PoolThread>::make(isMain);
         t->run(name.c_str());
         mKernelStartedThreads++;
+        mSpawnedThreads++;
     }
     // TODO: if startThreadPool is called on another thread after the process
     // starts up, the kernel might think that it already requested those
@@ -442,7 +451,10 @@ status_t ProcessState::setThreadPoolMaxThreadCount(size_t maxThreads) {
     LOG_ALWAYS_FATAL_IF(mThreadPoolStarted && maxThreads < mMaxThreads,
            "Binder threadpool cannot be shrunk after starting");
     status_t result = NO_ERROR;
-    if (ioctl(mDriverFD, BINDER_SET_MAX_THREADS, &maxThreads) != -1) {
+    // The kernel doesn't forget about the threads it asked for when they exit, so it is told
+    // about those that retired.
+    size_t kernelMaxThreads = maxThreads + mRetiredThreads;
+    if (ioctl(mDriverFD, BINDER_SET_MAX_THREADS, &kernelMaxThreads) != -1) {
         mMaxThreads = maxThreads;
     } else {
         result = -errno;
@@ -451,6 +463,23 @@ status_t ProcessState::setThreadPoolMaxThreadCount(size_t maxThreads) {
     return result;
 }
 
+status_t ProcessState::setThreadPoolAutoscale(const ThreadPoolAutoscaleConfig& config) {
+    LOG_ALWAYS_FATAL_IF(mThreadPoolStarted,
+                        "Binder threadpool autoscaling must be set before starting it");
+    if (config.minThreads > config.maxThreads + 1 || config.idleTimeout.count() <= 0 ||
+        config.spawnDelay.count() < 0) {
+        ALOGE("Invalid binder threadpool autoscaling configuration");
+        return BAD_VALUE;
+    }
+    status_t result = setThreadPoolMaxThreadCount(config.maxThreads);
+    if (result != NO_ERROR) return result;
+
+    mAutoscaleConfig = config;
+    mWindowStart = std::chrono::steady_clock::now();
+    mAutoscale = true;
+    return NO_ERROR;
+}
+
 size_t ProcessState::getThreadPoolMaxTotalThreadCount() const {
     // Need to read `mKernelStartedThreads` before `mThreadPoolStarted` (with
     // non-relaxed memory ordering) to avoid a race like the following:
@@ -501,6 +530,141 @@ bool ProcessState::isThreadPoolStarted() const {
     return mThreadPoolStarted;
 }
 
+ProcessState::ThreadPoolStats ProcessState::getThreadPoolStats() const {
+    ThreadPoolStats stats;
+    stats.autoscale = mAutoscale;
+    if (stats.autoscale) stats.minThreads = mAutoscaleConfig.minThreads;
+    stats.maxThreads = mMaxThreads;
+    stats.currentThreads = mCurrentThreads;
+    stats.peakThreads = mPeakThreads;
+    stats.executingThreads = mExecutingThreadsCount;
+    stats.spawnedThreads = mSpawnedThreads;
+    stats.retiredThreads = mRetiredThreads;
+    stats.deferredSpawns = mDeferredSpawns;
+    stats.saturatedTime = std::chrono::nanoseconds(mSaturatedNs);
+    stats.maxSaturatedTime = std::chrono::nanoseconds(mMaxSaturatedNs);
+
+    // Count the ongoing saturation too.
+    auto saturatedSince = mSaturatedSince.load();
+    if (saturatedSince != never()) {
+        auto saturated = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - saturatedSince);
+        stats.saturatedTime += saturated;
+        stats.maxSaturatedTime = std::max(stats.maxSaturatedTime, saturated);
+    }
+    return stats;
+}
+
+std::string ProcessState::ThreadPoolStats::toString() const {
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    std::ostringstream out;
+    out << currentThreads << "/" << maxThreads << " threads (peak " << peakThreads << "), "
+        << executingThreads << " executing";
+    if (autoscale) {
+        out << ", adaptive (min " << minThreads << ")";
+    }
+    out << ", " << spawnedThreads << " spawned, " << retiredThreads << " retired, "
+        << deferredSpawns << " deferred, saturated for "
+        << duration_cast<milliseconds>(saturatedTime).count() << " ms (longest "
+        << duration_cast<milliseconds>(maxSaturatedTime).count() << " ms)";
+    return out.str();
+}
+
+template <typename T>
+static void updateMax(std::atomic<T>& max, T value) {
+    T current = max.load(std::memory_order_relaxed);
+    while (current < value &&
+           !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void ProcessState::onThreadJoined() {
+    size_t current = mCurrentThreads.fetch_add(1) + 1;
+    updateMax(mPeakThreads, current);
+}
+
+void ProcessState::onCommandStarted(size_t executingThreads) {
+    if (mAutoscale.load(std::memory_order_relaxed)) {
+        updateMax(mWindowPeakExecuting, executingThreads);
+    }
+    if (executingThreads < mCurrentThreads.load(std::memory_order_relaxed)) return;
+
+    auto expected = never();
+    if (mSaturatedSince.compare_exchange_strong(expected, std::chrono::steady_clock::now()) &&
+        mStandbyThreads > 0) {
+        std::lock_guard<std::mutex> lock(mStandbyLock);
+        mStandbyCondVar.notify_all();
+    }
+}
+
+void ProcessState::onCommandFinished(size_t executingThreads) {
+    if (executingThreads >= mCurrentThreads.load(std::memory_order_relaxed) ||
+        mSaturatedSince.load(std::memory_order_relaxed) == never()) {
+        return;
+    }
+    auto saturatedSince = mSaturatedSince.exchange(never());
+    if (saturatedSince == never()) return;
+
+    uint64_t saturatedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - saturatedSince)
+                                   .count();
+    mSaturatedNs += saturatedNs;
+    updateMax(mMaxSaturatedNs, saturatedNs);
+}
+
+void ProcessState::waitForSpawnDemand() {
+    if (!mAutoscale) return;
+
+    // The kernel asks for one thread at a time, and only once the previous one joined, so at
+    // most one thread waits here.
+    std::unique_lock<std::mutex> lock(mStandbyLock);
+    mStandbyThreads++;
+    bool deferred = false;
+    while (mCurrentThreads >= mAutoscaleConfig.minThreads) {
+        auto saturatedSince = mSaturatedSince.load();
+        if (saturatedSince == never()) {
+            mStandbyCondVar.wait(lock);
+        } else if (std::chrono::steady_clock::now() - saturatedSince <
+                   mAutoscaleConfig.spawnDelay) {
+            mStandbyCondVar.wait_until(lock, saturatedSince + mAutoscaleConfig.spawnDelay);
+        } else {
+            break;
+        }
+        deferred = true;
+    }
+    mStandbyThreads--;
+    if (deferred) mDeferredSpawns++;
+}
+
+bool ProcessState::shouldRetireThread() {
+    if (!mAutoscale.load(std::memory_order_relaxed)) return false;
+
+    auto now = std::chrono::steady_clock::now();
+    auto windowStart = mWindowStart.load(std::memory_order_relaxed);
+    if (now - windowStart < mAutoscaleConfig.idleTimeout) return false;
+    // Only one thread gets to close the window, so at most one retires per window.
+    if (!mWindowStart.compare_exchange_strong(windowStart, now)) return false;
+
+    size_t peak = mWindowPeakExecuting.exchange(mExecutingThreadsCount);
+    size_t current = mCurrentThreads;
+    // Keep one spare thread, so that the pool doesn't shrink just to grow right back.
+    return current > mAutoscaleConfig.minThreads && peak + 1 < current;
+}
+
+void ProcessState::onThreadRetired() {
+    mKernelStartedThreads--;
+    mRetiredThreads++;
+
+    // Let the kernel ask for a thread again when it needs one.
+    std::unique_lock<std::mutex> _l(mLock);
+    size_t kernelMaxThreads = mMaxThreads + mRetiredThreads;
+    if (ioctl(mDriverFD, BINDER_SET_MAX_THREADS, &kernelMaxThreads) == -1) {
+        ALOGE("Binder ioctl to set max threads failed: %s", strerror(errno));
+    }
+}
+
 #define DRIVER_FEATURES_PATH "/dev/binderfs/features/"
 bool ProcessState::isDriverFeatureEnabled(const DriverFeature feature) {
     // Use static variable to cache the results.
@@ -579,6 +743,9 @@ ProcessState::ProcessState(const char* driver)
         mCurrentThreads(0),
         mKernelStartedThreads(0),
         mStarvationStartTime(never()),
+        mSaturatedSince(never()),
+        mWindowStart(never()),
+        mHandleToObject(std::make_unique<HandleTable>()),
         mForked(false),
         mThreadPoolStarted(false),
         mThreadPoolSeq(1),
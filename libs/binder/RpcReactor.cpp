@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "RpcReactor"
+
+#include "RpcReactor.h"
+
+#if defined(__linux__) && !defined(BINDER_RPC_SINGLE_THREADED)
+
+#include <inttypes.h>
+#include <string.h>
+#include <sys/epoll.h>
+
+#include <log/log.h>
+
+#include "JavaThreadAttacher.h"
+#include "OS.h"
+#include "RpcState.h"
+
+namespace android {
+
+using android::binder::unique_fd;
+
+std::shared_ptr<RpcReactor> RpcReactor::make(size_t threads,
+                                             std::chrono::milliseconds commandTimeout) {
+    LOG_ALWAYS_FATAL_IF(threads == 0, "RpcReactor needs at least one thread");
+
+    std::shared_ptr<RpcReactor> reactor(new RpcReactor(commandTimeout));
+    reactor->mEpoll = unique_fd(epoll_create1(EPOLL_CLOEXEC));
+    if (!reactor->mEpoll.ok()) {
+        ALOGE("Could not create epoll instance: %s", strerror(errno));
+        return nullptr;
+    }
+
+    reactor->mStopTrigger = FdTrigger::make();
+    if (reactor->mStopTrigger == nullptr) return nullptr;
+
+    // Level-triggered, so that it wakes up all the threads.
+    epoll_event event{.events = EPOLLIN, .data = {.u64 = kStopKey}};
+    if (epoll_ctl(reactor->mEpoll.get(), EPOLL_CTL_ADD, reactor->mStopTrigger->readFd().get(),
+                  &event) != 0) {
+        ALOGE("Could not watch stop trigger: %s", strerror(errno));
+        return nullptr;
+    }
+
+    // The threads only get a raw pointer, shutdown() joins them before the reactor goes away.
+    reactor->mThreads.reserve(threads);
+    for (size_t i = 0; i < threads; i++) {
+        reactor->mThreads.emplace_back(&RpcReactor::loop, reactor.get());
+    }
+    return reactor;
+}
+
+RpcReactor::~RpcReactor() {
+    shutdown();
+}
+
+void RpcReactor::addConnection(sp<RpcSession>&& session,
+                               RpcSession::PreJoinSetupResult&& setupResult) {
+    if (setupResult.status != OK) {
+        // cleans up like for any other failed connection
+        RpcSession::join(std::move(session), std::move(setupResult));
+        return;
+    }
+    LOG_ALWAYS_FATAL_IF(!setupResult.connection, "must have connection if setup succeeded");
+
+    {
+        // From now on the connection isn't owned by this thread, which exits.
+        RpcMutexLockGuard _l(session->mMutex);
+        auto it = session->mConnections.mThreads.find(rpc_this_thread::get_id());
+        LOG_ALWAYS_FATAL_IF(it == session->mConnections.mThreads.end());
+        it->second.detach();
+        session->mConnections.mThreads.erase(it);
+        setupResult.connection->exclusiveTid = std::nullopt;
+        setupResult.connection->commandTimeout = mCommandTimeout;
+    }
+
+    Registration dropped;
+    {
+        RpcMutexLockGuard _l(mLock);
+        if (mStopped || session->mShutdownTrigger->isTriggered()) {
+            dropped.session = std::move(session);
+            dropped.connection = std::move(setupResult.connection);
+        } else {
+            const uint64_t key = mNextKey++;
+            epoll_event event{.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT, .data = {.u64 = key}};
+            int ret = epoll_ctl(mEpoll.get(), EPOLL_CTL_ADD,
+                                setupResult.connection->rpcTransport->pollFd().get(), &event);
+            LOG_ALWAYS_FATAL_IF(ret != 0, "Could not watch connection: %s", strerror(errno));
+
+            auto [sessionIt, inserted] = mSessions.try_emplace(session.get());
+            if (inserted) {
+                // Once the session is shut down, its idle connections are dropped.
+                sessionIt->second.triggerKey = mNextKey++;
+                epoll_event triggerEvent{.events = EPOLLIN | EPOLLONESHOT,
+                                         .data = {.u64 = sessionIt->second.triggerKey}};
+                ret = epoll_ctl(mEpoll.get(), EPOLL_CTL_ADD,
+                                session->mShutdownTrigger->readFd().get(), &triggerEvent);
+                LOG_ALWAYS_FATAL_IF(ret != 0, "Could not watch session shutdown trigger: %s",
+                                    strerror(errno));
+                mRegistrations[sessionIt->second.triggerKey].session = session;
+            }
+            sessionIt->second.connections++;
+
+            Registration& registration = mRegistrations[key];
+            registration.session = std::move(session);
+            registration.connection = std::move(setupResult.connection);
+        }
+    }
+    dropConnection(std::move(dropped));
+}
+
+void RpcReactor::shutdown() {
+    {
+        RpcMutexLockGuard _l(mLock);
+        if (mStopped) return;
+        mStopped = true;
+    }
+
+    // not set if make() failed
+    if (mStopTrigger != nullptr) mStopTrigger->trigger();
+    for (auto& thread : mThreads) {
+        if (thread.joinable()) thread.join();
+    }
+    mThreads.clear();
+
+    std::vector<Registration> dropped;
+    {
+        RpcMutexLockGuard _l(mLock);
+        std::vector<uint64_t> keys;
+        for (const auto& [key, registration] : mRegistrations) {
+            if (registration.connection != nullptr) keys.push_back(key);
+        }
+        // the shutdown triggers of the sessions go along with their last connection
+        for (uint64_t key : keys) {
+            dropped.push_back(unregisterLocked(key));
+        }
+        LOG_ALWAYS_FATAL_IF(!mRegistrations.empty(), "Registrations left without connections");
+        LOG_ALWAYS_FATAL_IF(!mSessions.empty(), "Sessions left without connections");
+    }
+    for (auto& registration : dropped) {
+        dropConnection(std::move(registration));
+    }
+}
+
+void RpcReactor::loop() {
+    [[maybe_unused]] JavaThreadAttacher javaThreadAttacher;
+
+    while (true) {
+        epoll_event event;
+        int ret = TEMP_FAILURE_RETRY(epoll_wait(mEpoll.get(), &event, 1, -1));
+        LOG_ALWAYS_FATAL_IF(ret < 0, "epoll_wait failed: %s", strerror(errno));
+        if (ret == 0) continue;
+        if (event.data.u64 == kStopKey) return;
+
+        handleEvent(event.data.u64);
+    }
+}
+
+void RpcReactor::handleEvent(uint64_t key) {
+    sp<RpcSession> session;
+    sp<RpcSession::RpcConnection> connection;
+    std::vector<Registration> dropped;
+    {
+        RpcMutexLockGuard _l(mLock);
+        auto it = mRegistrations.find(key);
+        if (it == mRegistrations.end()) return; // dropped since
+
+        if (it->second.connection == nullptr) {
+            // The session was shut down. Connections which are served now are dropped when
+            // that is done.
+            RpcSession* shutDown = it->second.session.get();
+            std::vector<uint64_t> idle;
+            for (const auto& [otherKey, registration] : mRegistrations) {
+                if (registration.session.get() == shutDown && registration.connection != nullptr &&
+                    registration.idle) {
+                    idle.push_back(otherKey);
+                }
+            }
+            for (uint64_t idleKey : idle) {
+                dropped.push_back(unregisterLocked(idleKey));
+            }
+        } else {
+            it->second.idle = false;
+            session = it->second.session;
+            connection = it->second.connection;
+        }
+    }
+
+    if (connection != nullptr) {
+        {
+            // so that nested transactions find it
+            RpcMutexLockGuard _l(session->mMutex);
+            connection->exclusiveTid = binder::os::GetThreadId();
+        }
+        status_t status =
+                session->state()->drainCommands(connection, session, RpcState::CommandType::ANY);
+        if (status != OK) {
+            LOG_RPC_DETAIL("Binder connection closing w/ status %s",
+                           statusToString(status).c_str());
+        }
+        {
+            RpcMutexLockGuard _l(session->mMutex);
+            connection->exclusiveTid = std::nullopt;
+        }
+
+        RpcMutexLockGuard _l(mLock);
+        if (status != OK || mStopped || session->mShutdownTrigger->isTriggered()) {
+            dropped.push_back(unregisterLocked(key));
+        } else {
+            mRegistrations[key].idle = true;
+            epoll_event event{.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT, .data = {.u64 = key}};
+            int ret = epoll_ctl(mEpoll.get(), EPOLL_CTL_MOD,
+                                connection->rpcTransport->pollFd().get(), &event);
+            LOG_ALWAYS_FATAL_IF(ret != 0, "Could not rearm connection: %s", strerror(errno));
+        }
+    }
+
+    session = nullptr;
+    connection = nullptr;
+    for (auto& registration : dropped) {
+        dropConnection(std::move(registration));
+    }
+}
+
+RpcReactor::Registration RpcReactor::unregisterLocked(uint64_t key) {
+    auto it = mRegistrations.find(key);
+    LOG_ALWAYS_FATAL_IF(it == mRegistrations.end() || it->second.connection == nullptr,
+                        "Not a connection: %" PRIu64, key);
+    Registration registration = std::move(it->second);
+    mRegistrations.erase(it);
+
+    // A file descriptor is removed from epoll once closed, but connections are only closed
+    // after the session is done with them.
+    (void)epoll_ctl(mEpoll.get(), EPOLL_CTL_DEL,
+                    registration.connection->rpcTransport->pollFd().get(), nullptr);
+
+    auto sessionIt = mSessions.find(registration.session.get());
+    LOG_ALWAYS_FATAL_IF(sessionIt == mSessions.end());
+    if (--sessionIt->second.connections == 0) {
+        (void)epoll_ctl(mEpoll.get(), EPOLL_CTL_DEL,
+                        registration.session->mShutdownTrigger->readFd().get(), nullptr);
+        mRegistrations.erase(sessionIt->second.triggerKey);
+        mSessions.erase(sessionIt);
+    }
+    return registration;
+}
+
+void RpcReactor::dropConnection(Registration&& registration) {
+    if (registration.connection == nullptr) return;
+
+    sp<RpcSession::EventListener> listener;
+    {
+        RpcMutexLockGuard _l(registration.session->mMutex);
+        listener = registration.session->mEventListener.promote();
+    }
+
+    // like at the end of RpcSession::join, session shutdown progresses via these callbacks
+    LOG_ALWAYS_FATAL_IF(!registration.session->removeIncomingConnection(registration.connection),
+                        "bad state: connection object guaranteed to be in list");
+    registration.connection = nullptr;
+    registration.session = nullptr;
+
+    if (listener != nullptr) {
+        listener->onSessionIncomingThreadEnded();
+    }
+}
+
+} // namespace android
+
+#endif // defined(__linux__) && !defined(BINDER_RPC_SINGLE_THREADED)
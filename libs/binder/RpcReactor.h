@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <binder/RpcSession.h>
+#include <binder/RpcThreads.h>
+#include <binder/unique_fd.h>
+
+#include "FdTrigger.h"
+
+namespace android {
+
+/**
+ * Serves the incoming connections of server sessions with a fixed pool of threads, instead of
+ * a thread per connection as RpcSession::join does. See RpcServer::setEventDrivenThreads.
+ *
+ * Idle connections are all waited on with a single epoll instance. When one becomes readable,
+ * one of the threads takes it, executes the commands available on it, and hands it back to
+ * epoll. Each connection is armed with EPOLLONESHOT, so that only one thread reads from it at
+ * a time. While it does, the connection is assigned to that thread, so nested transactions
+ * work as they do with a thread per connection.
+ */
+class RpcReactor {
+public:
+    /**
+     * Starts |threads| threads. |commandTimeout| is how long a command may take to arrive fully
+     * once it started arriving. A client which doesn't keep up would otherwise hold on to one of
+     * the threads, which serve all sessions. Its session is shut down instead. Returns nullptr
+     * for error case.
+     */
+    static std::shared_ptr<RpcReactor> make(size_t threads,
+                                            std::chrono::milliseconds commandTimeout);
+
+    RpcReactor(const RpcReactor&) = delete;
+    RpcReactor& operator=(const RpcReactor&) = delete;
+    ~RpcReactor();
+
+    /**
+     * Takes over a connection which RpcServer::establishConnection set up, in place of
+     * RpcSession::join. Called on the thread which set it up, which then exits.
+     */
+    void addConnection(sp<RpcSession>&& session, RpcSession::PreJoinSetupResult&& setupResult);
+
+    /**
+     * Stops the threads and drops the connections which are left, e.g. after the sessions were
+     * shut down. Connections added afterwards are dropped right away. Must not be called from
+     * one of the threads.
+     */
+    void shutdown();
+
+private:
+    explicit RpcReactor(std::chrono::milliseconds commandTimeout)
+          : mCommandTimeout(commandTimeout) {}
+
+    struct Registration {
+        sp<RpcSession> session;
+        // nullptr for the registration of the shutdown trigger of |session|
+        sp<RpcSession::RpcConnection> connection;
+        // whether the connection is waited on, rather than served by a thread
+        bool idle = true;
+    };
+
+    struct SessionState {
+        // key of the registration of the shutdown trigger of the session
+        uint64_t triggerKey = 0;
+        size_t connections = 0;
+    };
+
+    void loop();
+    void handleEvent(uint64_t key);
+
+    // Unregisters the connection of |key|, and the shutdown trigger of its session if it was
+    // the last one. The connection must then be dropped, without holding mLock.
+    Registration unregisterLocked(uint64_t key);
+    static void dropConnection(Registration&& registration);
+
+    static constexpr uint64_t kStopKey = 0;
+
+    const std::chrono::milliseconds mCommandTimeout;
+    binder::unique_fd mEpoll;
+    std::unique_ptr<FdTrigger> mStopTrigger;
+    std::vector<RpcMaybeThread> mThreads;
+
+    RpcMutex mLock; // for below
+    bool mStopped = false;
+    uint64_t mNextKey = kStopKey + 1;
+    // Keys are the epoll_data of the registered FDs. They are never reused, so that an event
+    // for a registration which was dropped in the meantime can be told apart.
+    std::map<uint64_t, Registration> mRegistrations;
+    std::map<RpcSession*, SessionState> mSessions;
+};
+
+} // namespace android
@@ -34,6 +34,7 @@
 #include "BuildFlags.h"
 #include "FdTrigger.h"
 #include "OS.h"
+#include "RpcReactor.h"
 #include "RpcSocketAddress.h"
 #include "RpcState.h"
 #include "RpcTransportUtils.h"
@@ -139,6 +140,19 @@ size_t RpcServer::getMaxThreads() {
     return mMaxThreads;
 }
 
+status_t RpcServer::setEventDrivenThreads(size_t threads,
+                                          std::chrono::milliseconds commandTimeout) {
+    if constexpr (!kEnableRpcReactor) {
+        (void)threads;
+        (void)commandTimeout;
+        return INVALID_OPERATION;
+    }
+    LOG_ALWAYS_FATAL_IF(mJoinThreadRunning, "Cannot set event driven threads while running");
+    mEventDrivenThreads = threads;
+    mEventDrivenCommandTimeout = commandTimeout;
+    return OK;
+}
+
 bool RpcServer::setProtocolVersion(uint32_t version) {
     if (!RpcState::validateProtocolVersion(version)) {
         return false;
@@ -264,6 +278,27 @@ void RpcServer::join() {
         LOG_ALWAYS_FATAL_IF(mShutdownTrigger == nullptr, "Cannot create join signaler");
     }
 
+    std::function<void(sp<RpcSession>&&, RpcSession::PreJoinSetupResult&&)> joinFn =
+            RpcSession::join;
+    if constexpr (kEnableRpcReactor) {
+        if (mEventDrivenThreads > 0) {
+            std::shared_ptr<RpcReactor> reactor;
+            {
+                RpcMutexLockGuard _l(mLock);
+                if (mReactor == nullptr) {
+                    mReactor = RpcReactor::make(mEventDrivenThreads, mEventDrivenCommandTimeout);
+                    LOG_ALWAYS_FATAL_IF(mReactor == nullptr, "Cannot create RpcReactor");
+                }
+                reactor = mReactor;
+            }
+            // Connections are set up on their own thread, then handed over to the reactor.
+            joinFn = [reactor](sp<RpcSession>&& session,
+                               RpcSession::PreJoinSetupResult&& setupResult) {
+                reactor->addConnection(std::move(session), std::move(setupResult));
+            };
+        }
+    }
+
     status_t status;
     while ((status = mShutdownTrigger->triggerablePoll(mServer, POLLIN)) == OK) {
         std::array<uint8_t, kRpcAddressSize> addr;
@@ -296,7 +331,7 @@ void RpcServer::join() {
             RpcMaybeThread thread =
                     RpcMaybeThread(&RpcServer::establishConnection,
                                    sp<RpcServer>::fromExisting(this), std::move(clientSocket), addr,
-                                   addrLen, RpcSession::join);
+                                   addrLen, joinFn);
 
             auto& threadRef = mConnectingThreads[thread.get_id()];
             threadRef = std::move(thread);
@@ -348,6 +383,14 @@ bool RpcServer::shutdown() {
         }
     }
 
+    // Sessions are done, so only connections which were shut down before being dropped, if
+    // any, are left.
+    if (std::shared_ptr<RpcReactor> reactor = std::move(mReactor); reactor != nullptr) {
+        _l.unlock();
+        reactor->shutdown();
+        _l.lock();
+    }
+
     // At this point, we know join() is about to exit, but the thread that calls
     // join() may not have exited yet.
     // If RpcServer owns the join thread (aka start() is called), make sure the thread exits;
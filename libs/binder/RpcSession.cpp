@@ -18,7 +18,6 @@
 
 #include <binder/RpcSession.h>
 
-#include <dlfcn.h>
 #include <inttypes.h>
 #include <netinet/tcp.h>
 #include <poll.h>
@@ -36,6 +35,7 @@
 
 #include "BuildFlags.h"
 #include "FdTrigger.h"
+#include "JavaThreadAttacher.h"
 #include "OS.h"
 #include "RpcSocketAddress.h"
 #include "RpcState.h"
@@ -43,11 +43,6 @@
 #include "RpcWireFormat.h"
 #include "Utils.h"
 
-#if defined(__ANDROID__) && !defined(__ANDROID_RECOVERY__)
-#include <jni.h>
-extern "C" JavaVM* AndroidRuntimeGetJavaVM();
-#endif
-
 namespace android {
 
 using namespace android::binder::impl;
@@ -361,68 +356,6 @@ RpcSession::PreJoinSetupResult RpcSession::preJoinSetup(
     };
 }
 
-namespace {
-#if !defined(__ANDROID__) || defined(__ANDROID_RECOVERY__)
-class JavaThreadAttacher {};
-#else
-// RAII object for attaching / detaching current thread to JVM if Android Runtime exists. If
-// Android Runtime doesn't exist, no-op.
-class JavaThreadAttacher {
-public:
-    JavaThreadAttacher() {
-        // Use dlsym to find androidJavaAttachThread because libandroid_runtime is loaded after
-        // libbinder.
-        auto vm = getJavaVM();
-        if (vm == nullptr) return;
-
-        char threadName[16];
-        if (0 != pthread_getname_np(pthread_self(), threadName, sizeof(threadName))) {
-            constexpr const char* defaultThreadName = "UnknownRpcSessionThread";
-            memcpy(threadName, defaultThreadName,
-                   std::min<size_t>(sizeof(threadName), strlen(defaultThreadName) + 1));
-        }
-        LOG_RPC_DETAIL("Attaching current thread %s to JVM", threadName);
-        JavaVMAttachArgs args;
-        args.version = JNI_VERSION_1_2;
-        args.name = threadName;
-        args.group = nullptr;
-        JNIEnv* env;
-
-        LOG_ALWAYS_FATAL_IF(vm->AttachCurrentThread(&env, &args) != JNI_OK,
-                            "Cannot attach thread %s to JVM", threadName);
-        mAttached = true;
-    }
-    ~JavaThreadAttacher() {
-        if (!mAttached) return;
-        auto vm = getJavaVM();
-        LOG_ALWAYS_FATAL_IF(vm == nullptr,
-                            "Unable to detach thread. No JavaVM, but it was present before!");
-
-        LOG_RPC_DETAIL("Detaching current thread from JVM");
-        int ret = vm->DetachCurrentThread();
-        if (ret == JNI_OK) {
-            mAttached = false;
-        } else {
-            ALOGW("Unable to detach current thread from JVM (%d)", ret);
-        }
-    }
-
-private:
-    JavaThreadAttacher(const JavaThreadAttacher&) = delete;
-    void operator=(const JavaThreadAttacher&) = delete;
-
-    bool mAttached = false;
-
-    static JavaVM* getJavaVM() {
-        static auto fn = reinterpret_cast<decltype(&AndroidRuntimeGetJavaVM)>(
-                dlsym(RTLD_DEFAULT, "AndroidRuntimeGetJavaVM"));
-        if (fn == nullptr) return nullptr;
-        return fn();
-    }
-};
-#endif
-} // namespace
-
 void RpcSession::join(sp<RpcSession>&& session, PreJoinSetupResult&& setupResult) {
     sp<RpcConnection>& connection = setupResult.connection;
 
@@ -24,13 +24,17 @@
 #include <binder/RpcServer.h>
 
 #include "Debug.h"
+#include "FdTrigger.h"
 #include "RpcWireFormat.h"
 #include "Utils.h"
 
+#include <chrono>
 #include <random>
 #include <sstream>
 
 #include <inttypes.h>
+#include <limits.h>
+#include <poll.h>
 
 #ifdef __ANDROID__
 #include <cutils/properties.h>
@@ -381,12 +385,48 @@ status_t RpcState::rpcSend(const sp<RpcSession::RpcConnection>& connection,
     return OK;
 }
 
+#ifndef BINDER_RPC_SINGLE_THREADED
+// Like FdTrigger::triggerablePoll for reading, but returns TIMED_OUT at |deadline|.
+static status_t pollReadUntil(borrowed_fd fd, FdTrigger* fdTrigger,
+                              std::chrono::steady_clock::time_point deadline) {
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0) return TIMED_OUT;
+
+    pollfd pfd[]{
+            {.fd = fd.get(), .events = POLLIN, .revents = 0},
+            {.fd = fdTrigger->readFd().get(), .events = 0, .revents = 0},
+    };
+    int timeoutMs = static_cast<int>(std::min<int64_t>(remaining.count(), INT_MAX));
+    int ret = TEMP_FAILURE_RETRY(poll(pfd, countof(pfd), timeoutMs));
+    if (ret < 0) return -errno;
+    if (ret == 0) return TIMED_OUT;
+    if (pfd[1].revents & POLLHUP) return DEAD_OBJECT;
+    return OK;
+}
+#endif
+
 status_t RpcState::rpcRec(const sp<RpcSession::RpcConnection>& connection,
                           const sp<RpcSession>& session, const char* what, iovec* iovs, int niovs,
                           std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) {
+    std::optional<SmallFunction<status_t()>> altPoll;
+#ifndef BINDER_RPC_SINGLE_THREADED
+    auto pollUntilDeadline = [&] {
+        status_t status = pollReadUntil(connection->rpcTransport->pollFd(),
+                                        session->mShutdownTrigger.get(),
+                                        *connection->commandDeadline);
+        if (status == TIMED_OUT) {
+            ALOGW("Command did not arrive within %lldms, terminating session",
+                  static_cast<long long>(connection->commandTimeout->count()));
+        }
+        return status;
+    };
+    if (connection->commandDeadline) altPoll = std::ref(pollUntilDeadline);
+#endif
+
     if (status_t status =
                 connection->rpcTransport->interruptableReadFully(session->mShutdownTrigger.get(),
-                                                                 iovs, niovs, std::nullopt,
+                                                                 iovs, niovs, altPoll,
                                                                  ancillaryFds);
         status != OK) {
         LOG_RPC_DETAIL("Failed to read %s (%d iovs) on RpcTransport %p, error: %s", what, niovs,
@@ -767,6 +807,14 @@ status_t RpcState::getAndExecuteCommand(const sp<RpcSession::RpcConnection>& con
                                         const sp<RpcSession>& session, CommandType type) {
     LOG_RPC_DETAIL("getAndExecuteCommand on RpcTransport %p", connection->rpcTransport.get());
 
+    // The deadline only covers reading the command. processTransact and processDecStrong clear
+    // it once they read the body, before they execute it.
+    if (connection->commandTimeout) {
+        connection->commandDeadline =
+                std::chrono::steady_clock::now() + *connection->commandTimeout;
+    }
+    auto clearDeadline = make_scope_guard([&]() { connection->commandDeadline = std::nullopt; });
+
     std::vector<std::variant<unique_fd, borrowed_fd>> ancillaryFds;
     RpcWireHeader command;
     iovec iov{&command, sizeof(command)};
@@ -847,6 +895,7 @@ status_t RpcState::processTransact(
     if (status_t status = rpcRec(connection, session, "transaction body", &iov, 1, nullptr);
         status != OK)
         return status;
+    connection->commandDeadline = std::nullopt;
 
     return processTransactInternal(connection, session, std::move(transactionData),
                                    std::move(ancillaryFds));
@@ -1163,6 +1212,7 @@ status_t RpcState::processDecStrong(const sp<RpcSession::RpcConnection>& connect
     if (status_t status = rpcRec(connection, session, "dec ref body", &iov, 1, nullptr);
         status != OK)
         return status;
+    connection->commandDeadline = std::nullopt;
 
     uint64_t addr = RpcWireAddress::toRaw(body.address);
     RpcMutexUniqueLock _l(mNodeMutex);
@@ -85,6 +85,8 @@ public:
 
     bool isWaiting() override { return mSocket.isInPollingState(); }
 
+    borrowed_fd pollFd() override { return mSocket.fd; }
+
 private:
     android::RpcTransportFd mSocket;
 };
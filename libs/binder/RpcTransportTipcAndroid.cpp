@@ -128,6 +128,8 @@ public:
 
     bool isWaiting() override { return mSocket.isInPollingState(); }
 
+    borrowed_fd pollFd() override { return mSocket.fd; }
+
 private:
     status_t adjustStatus(status_t status) {
         if (status == -ENOTCONN) {
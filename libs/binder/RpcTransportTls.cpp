@@ -18,9 +18,11 @@
 #include <log/log.h>
 
 #include <poll.h>
+#include <string.h>
 #include <sys/socket.h>
 
 #include <openssl/bn.h>
+#include <openssl/sha.h>
 #include <openssl/ssl.h>
 
 #include <binder/RpcTlsUtils.h>
@@ -30,6 +32,8 @@
 #include "RpcState.h"
 #include "Utils.h"
 
+#include <map>
+#include <mutex>
 #include <sstream>
 
 #define SHOULD_LOG_TLS_DETAIL false
@@ -282,6 +286,55 @@ private:
     bssl::UniquePtr<SSL> mSsl;
 };
 
+// Index of the ex data of client SSLs which holds the key of their session in SessionCache.
+int sessionKeyIndex() {
+    static const int index =
+            SSL_get_ex_new_index(0, nullptr, nullptr, nullptr,
+                                 [](void*, void* ptr, CRYPTO_EX_DATA*, int, long, // NOLINT
+                                    void*) { delete static_cast<std::string*>(ptr); });
+    return index;
+}
+
+// The TLS sessions of the client contexts of this process, so that connecting to a server again,
+// e.g. for the other connections of an RpcSession or after reconnecting, resumes a session
+// rather than doing a full handshake.
+//
+// Sessions are keyed by the certificate of the client, which they authenticate, and by the
+// address of the server. The latest session with a server is reused until the server sends
+// another one. Both sides present certificates anyway, so that this makes connections linkable
+// to each other doesn't matter.
+class SessionCache {
+public:
+    static SessionCache& get() {
+        // Leaked, since connections may be made while static destructors run.
+        static SessionCache* cache = new SessionCache();
+        return *cache;
+    }
+
+    bssl::UniquePtr<SSL_SESSION> find(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mSessions.find(key);
+        if (it == mSessions.end()) return nullptr;
+        SSL_SESSION_up_ref(it->second.get());
+        return bssl::UniquePtr<SSL_SESSION>(it->second.get());
+    }
+
+    void insert(const std::string& key, bssl::UniquePtr<SSL_SESSION> session) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mSessions.size() >= kMaxSessions && mSessions.find(key) == mSessions.end()) {
+            // A process connecting to that many servers doesn't do it often.
+            mSessions.erase(mSessions.begin());
+        }
+        mSessions[key] = std::move(session);
+    }
+
+private:
+    static constexpr size_t kMaxSessions = 64;
+
+    std::mutex mMutex;
+    std::map<std::string, bssl::UniquePtr<SSL_SESSION>> mSessions;
+};
+
 } // namespace
 
 class RpcTransportTls : public RpcTransport {
@@ -300,9 +353,16 @@ public:
 
     bool isWaiting() override { return mSocket.isInPollingState(); };
 
+    borrowed_fd pollFd() override { return mSocket.fd; }
+
 private:
+    status_t writeFully(FdTrigger* fdTrigger, const uint8_t* buffer, size_t size,
+                        const std::optional<SmallFunction<status_t()>>& altPoll);
+
     android::RpcTransportFd mSocket;
     Ssl mSsl;
+    // For coalescing the iovecs of a write into as few records as possible.
+    std::vector<uint8_t> mWriteBuffer;
 };
 
 // Error code is errno.
@@ -340,36 +400,76 @@ status_t RpcTransportTls::interruptableWriteFully(
 
     size_t size = 0;
     for (int i = 0; i < niovs; i++) {
-        const iovec& iov = iovs[i];
-        if (iov.iov_len == 0) {
-            continue;
-        }
-        size += iov.iov_len;
+        size += iovs[i].iov_len;
+    }
 
-        auto buffer = reinterpret_cast<const uint8_t*>(iov.iov_base);
-        const uint8_t* end = buffer + iov.iov_len;
-        while (buffer < end) {
-            size_t todo = std::min<size_t>(end - buffer, std::numeric_limits<int>::max());
-            auto [writeSize, errorQueue] = mSsl.call(SSL_write, buffer, todo);
-            if (writeSize > 0) {
-                buffer += writeSize;
-                errorQueue.clear();
+    // Every SSL_write() makes at least one record, with its own header, MAC, and send(2). So
+    // small iovecs, like the header and the body of a command, are copied together into records
+    // of up to the maximum size, while data which fills whole records is written in place.
+    constexpr size_t kMaxRecordSize = SSL3_RT_MAX_PLAIN_LENGTH;
+    size_t remaining = size;
+    size_t buffered = 0;
+    for (int i = 0; i < niovs; i++) {
+        auto buffer = reinterpret_cast<const uint8_t*>(iovs[i].iov_base);
+        size_t len = iovs[i].iov_len;
+        while (len > 0) {
+            if (buffered == 0 && (len == remaining || len >= kMaxRecordSize)) {
+                size_t todo = len == remaining ? len : len - len % kMaxRecordSize;
+                if (status_t status = writeFully(fdTrigger, buffer, todo, altPoll); status != OK) {
+                    return status;
+                }
+                buffer += todo;
+                len -= todo;
+                remaining -= todo;
                 continue;
             }
-            // SSL_write() should never return 0 unless BIO_write were to return 0.
-            int sslError = mSsl.getError(writeSize);
-            // TODO(b/195788248): BIO should contain the FdTrigger, and send(2) / recv(2) should be
-            //   triggerablePoll()-ed. Then additionalEvent is no longer necessary.
-            status_t pollStatus = errorQueue.pollForSslError(mSocket, sslError, fdTrigger,
-                                                             "SSL_write", POLLIN, altPoll);
-            if (pollStatus != OK) return pollStatus;
-            // Do not advance buffer. Try SSL_write() again.
+
+            if (size_t needed = std::min(buffered + remaining, kMaxRecordSize);
+                mWriteBuffer.size() < needed) {
+                mWriteBuffer.resize(needed);
+            }
+            size_t todo = std::min(len, mWriteBuffer.size() - buffered);
+            memcpy(mWriteBuffer.data() + buffered, buffer, todo);
+            buffered += todo;
+            buffer += todo;
+            len -= todo;
+            remaining -= todo;
+            if (buffered == mWriteBuffer.size() || remaining == 0) {
+                if (status_t status = writeFully(fdTrigger, mWriteBuffer.data(), buffered, altPoll);
+                    status != OK) {
+                    return status;
+                }
+                buffered = 0;
+            }
         }
     }
     LOG_TLS_DETAIL("TLS: Sent %zu bytes!", size);
     return OK;
 }
 
+status_t RpcTransportTls::writeFully(FdTrigger* fdTrigger, const uint8_t* buffer, size_t size,
+                                     const std::optional<SmallFunction<status_t()>>& altPoll) {
+    const uint8_t* end = buffer + size;
+    while (buffer < end) {
+        size_t todo = std::min<size_t>(end - buffer, std::numeric_limits<int>::max());
+        auto [writeSize, errorQueue] = mSsl.call(SSL_write, buffer, todo);
+        if (writeSize > 0) {
+            buffer += writeSize;
+            errorQueue.clear();
+            continue;
+        }
+        // SSL_write() should never return 0 unless BIO_write were to return 0.
+        int sslError = mSsl.getError(writeSize);
+        // TODO(b/195788248): BIO should contain the FdTrigger, and send(2) / recv(2) should be
+        //   triggerablePoll()-ed. Then additionalEvent is no longer necessary.
+        status_t pollStatus = errorQueue.pollForSslError(mSocket, sslError, fdTrigger,
+                                                         "SSL_write", POLLIN, altPoll);
+        if (pollStatus != OK) return pollStatus;
+        // Do not advance buffer. Try SSL_write() again.
+    }
+    return OK;
+}
+
 status_t RpcTransportTls::interruptableReadFully(
         FdTrigger* fdTrigger, iovec* iovs, int niovs,
         const std::optional<SmallFunction<status_t()>>& altPoll,
@@ -459,7 +559,9 @@ public:
 
 protected:
     static ssl_verify_result_t sslCustomVerify(SSL* ssl, uint8_t* outAlert);
-    virtual void preHandshake(Ssl* ssl) const = 0;
+    // Called once mCtx is set up.
+    virtual bool init() { return true; }
+    virtual void preHandshake(Ssl* ssl, const android::RpcTransportFd& socket) const = 0;
     bssl::UniquePtr<SSL_CTX> mCtx;
     std::shared_ptr<RpcCertificateVerifier> mCertVerifier;
 };
@@ -512,6 +614,14 @@ std::unique_ptr<RpcTransportCtxTls> RpcTransportCtxTls::create(
     // Require at least TLS 1.3
     TEST_AND_RETURN(nullptr, SSL_CTX_set_min_proto_version(ctx.get(), TLS1_3_VERSION));
 
+    // Resumed sessions skip the certificate exchange. Verify the certificate the session was
+    // established with again, in case the verifier no longer trusts it.
+    SSL_CTX_set_reverify_on_resume(ctx.get(), 1);
+    static constexpr uint8_t kSessionIdContext[] = "RPC binder";
+    TEST_AND_RETURN(nullptr,
+                    SSL_CTX_set_session_id_context(ctx.get(), kSessionIdContext,
+                                                   sizeof(kSessionIdContext)));
+
     if constexpr (SHOULD_LOG_TLS_DETAIL) { // NOLINT
         SSL_CTX_set_info_callback(ctx.get(), sslDebugLog);
     }
@@ -521,6 +631,7 @@ std::unique_ptr<RpcTransportCtxTls> RpcTransportCtxTls::create(
     TEST_AND_RETURN(nullptr, SSL_CTX_set_app_data(ctx.get(), reinterpret_cast<void*>(ret.get())));
     ret->mCtx = std::move(ctx);
     ret->mCertVerifier = std::move(verifier);
+    TEST_AND_RETURN(nullptr, ret->init());
     return ret;
 }
 
@@ -530,23 +641,85 @@ std::unique_ptr<RpcTransport> RpcTransportCtxTls::newTransport(android::RpcTrans
     TEST_AND_RETURN(nullptr, ssl != nullptr);
     Ssl wrapped(std::move(ssl));
 
-    preHandshake(&wrapped);
+    preHandshake(&wrapped, socket);
     TEST_AND_RETURN(nullptr, setFdAndDoHandshake(&wrapped, socket, fdTrigger));
     return std::make_unique<RpcTransportTls>(std::move(socket), std::move(wrapped));
 }
 
+// Servers send session tickets after handshakes, which is the default.
 class RpcTransportCtxTlsServer : public RpcTransportCtxTls {
 protected:
-    void preHandshake(Ssl* ssl) const override {
+    void preHandshake(Ssl* ssl, const android::RpcTransportFd&) const override {
         ssl->call(SSL_set_accept_state).errorQueue.clear();
     }
 };
 
 class RpcTransportCtxTlsClient : public RpcTransportCtxTls {
 protected:
-    void preHandshake(Ssl* ssl) const override {
+    bool init() override {
+        X509* x509 = SSL_CTX_get0_certificate(mCtx.get()); // does not own
+        if (x509 == nullptr) return true; // no session to resume without being authenticated
+        std::vector<uint8_t> der = serializeCertificate(x509, RpcCertificateFormat::DER);
+        TEST_AND_RETURN(false, !der.empty());
+        uint8_t digest[SHA256_DIGEST_LENGTH];
+        SHA256(der.data(), der.size(), digest);
+        mSessionKeyPrefix = std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+
+        // Sessions are stored by sslNewSession only, in SessionCache.
+        SSL_CTX_set_session_cache_mode(mCtx.get(),
+                                       SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_sess_set_new_cb(mCtx.get(), sslNewSession);
+        return true;
+    }
+
+    void preHandshake(Ssl* ssl, const android::RpcTransportFd& socket) const override {
         ssl->call(SSL_set_connect_state).errorQueue.clear();
+
+        std::optional<std::string> key = sessionKey(socket);
+        if (!key.has_value()) return;
+        if (bssl::UniquePtr<SSL_SESSION> session = SessionCache::get().find(*key)) {
+            auto [ret, errorQueue] = ssl->call(SSL_set_session, session.get());
+            if (ret != 1) {
+                ALOGW("Failed to resume TLS session: %s", errorQueue.toString().c_str());
+            } else {
+                errorQueue.clear();
+            }
+        }
+        // So that sslNewSession knows where to store the sessions the server sends.
+        auto ownedKey = std::make_unique<std::string>(std::move(*key));
+        auto [ret, errorQueue] = ssl->call(SSL_set_ex_data, sessionKeyIndex(), ownedKey.get());
+        if (ret != 1) {
+            ALOGW("Failed to set TLS session key: %s", errorQueue.toString().c_str());
+            return;
+        }
+        errorQueue.clear();
+        (void)ownedKey.release(); // deleted along with |ssl|
     }
+
+private:
+    // The key of the sessions with the server |socket| is connected to, or std::nullopt if
+    // sessions aren't resumed, e.g. for socket pairs, which have no address.
+    std::optional<std::string> sessionKey(const android::RpcTransportFd& socket) const {
+        if (!mSessionKeyPrefix.has_value()) return std::nullopt;
+        sockaddr_storage addr;
+        socklen_t addrLen = sizeof(addr);
+        if (0 != getpeername(socket.fd.get(), reinterpret_cast<sockaddr*>(&addr), &addrLen)) {
+            return std::nullopt;
+        }
+        if (addrLen <= sizeof(sa_family_t)) return std::nullopt;
+        return *mSessionKeyPrefix + std::string(reinterpret_cast<const char*>(&addr), addrLen);
+    }
+
+    // Called when the server sends a session ticket, after the handshake.
+    static int sslNewSession(SSL* ssl, SSL_SESSION* session) {
+        auto key = static_cast<const std::string*>(SSL_get_ex_data(ssl, sessionKeyIndex()));
+        if (key == nullptr) return 0;
+        SessionCache::get().insert(*key, bssl::UniquePtr<SSL_SESSION>(session));
+        return 1; // takes ownership of |session|
+    }
+
+    // SHA-256 of the certificate of this client, std::nullopt if it has none.
+    std::optional<std::string> mSessionKeyPrefix;
 };
 
 std::unique_ptr<RpcTransportCtx> RpcTransportCtxFactoryTls::newServerCtx() const {
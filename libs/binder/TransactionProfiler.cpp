@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <binder/TransactionProfiler.h>
+
+#include <binder/Parcel.h>
+#include <utils/String8.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string_view>
+#include <tuple>
+
+namespace android::binder::debug {
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::nanoseconds;
+
+std::atomic_bool TransactionProfiler::sEnabled = false;
+
+namespace {
+
+// Distinct transactions a thread keeps track of, a power of two. The others are only counted.
+constexpr size_t kSlots = 128;
+
+using Key = std::tuple<TransactionProfiler::Direction, std::string, uint32_t>;
+
+size_t latencyBucket(nanoseconds latency) {
+    uint64_t us = static_cast<uint64_t>(duration_cast<microseconds>(latency).count());
+    if (us == 0) return 0;
+    return std::min<size_t>(64 - __builtin_clzll(us), TransactionProfiler::kLatencyBuckets - 1);
+}
+
+// Only written by the thread owning it, so it doesn't need read-modify-write operations.
+void add(std::atomic_uint64_t& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void merge(TransactionProfiler::Entry* into, const TransactionProfiler::Entry& entry) {
+    into->count += entry.count;
+    into->dataBytes += entry.dataBytes;
+    into->replyBytes += entry.replyBytes;
+    into->totalLatency += entry.totalLatency;
+    into->maxLatency = std::max(into->maxLatency, entry.maxLatency);
+    for (size_t i = 0; i < TransactionProfiler::kLatencyBuckets; i++) {
+        into->latencyHistogram[i] += entry.latencyHistogram[i];
+    }
+}
+
+} // namespace
+
+/**
+ * The transactions of one thread, in an open-addressing table which only its thread inserts
+ * into and updates. Readers see a slot once |used| is set, after which its key never changes.
+ */
+class TransactionProfiler::ThreadProfile {
+public:
+    explicit ThreadProfile(uint64_t generation) : mGeneration(generation) {}
+
+    uint64_t generation() const { return mGeneration; }
+
+    // Owning thread only.
+    void record(Direction direction, uint64_t object, uint32_t code, const Parcel& data,
+                size_t replyBytes, nanoseconds latency) {
+        Slot* slot = findOrInsert(direction, object, code, data);
+        if (slot == nullptr) {
+            add(mOverflow, 1);
+            return;
+        }
+        add(slot->count, 1);
+        add(slot->dataBytes, data.dataSize());
+        add(slot->replyBytes, replyBytes);
+        add(slot->totalLatencyNs, latency.count());
+        if (static_cast<uint64_t>(latency.count()) >
+            slot->maxLatencyNs.load(std::memory_order_relaxed)) {
+            slot->maxLatencyNs.store(latency.count(), std::memory_order_relaxed);
+        }
+        add(slot->histogram[latencyBucket(latency)], 1);
+    }
+
+    // Any thread, with State::lock held.
+    void collect(std::map<Key, Entry>* entries, uint64_t* overflow) const {
+        for (const Slot& slot : mSlots) {
+            if (!slot.used.load(std::memory_order_acquire)) continue;
+
+            Entry entry;
+            entry.count = slot.count.load(std::memory_order_relaxed);
+            entry.dataBytes = slot.dataBytes.load(std::memory_order_relaxed);
+            entry.replyBytes = slot.replyBytes.load(std::memory_order_relaxed);
+            entry.totalLatency = nanoseconds(slot.totalLatencyNs.load(std::memory_order_relaxed));
+            entry.maxLatency = nanoseconds(slot.maxLatencyNs.load(std::memory_order_relaxed));
+            for (size_t i = 0; i < kLatencyBuckets; i++) {
+                entry.latencyHistogram[i] = slot.histogram[i].load(std::memory_order_relaxed);
+            }
+            const std::string descriptor =
+                    String8(slot.descriptor.data(), slot.descriptor.size()).c_str();
+            merge(&(*entries)[Key(slot.direction, descriptor, slot.code)], entry);
+        }
+        *overflow += mOverflow.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic_bool used = false;
+        // Set before |used|.
+        Direction direction = Direction::OUTGOING;
+        uint64_t object = 0;
+        uint32_t code = 0;
+        std::u16string descriptor;
+
+        std::atomic_uint64_t count = 0;
+        std::atomic_uint64_t dataBytes = 0;
+        std::atomic_uint64_t replyBytes = 0;
+        std::atomic_uint64_t totalLatencyNs = 0;
+        std::atomic_uint64_t maxLatencyNs = 0;
+        std::array<std::atomic_uint64_t, kLatencyBuckets> histogram{};
+    };
+
+    // The descriptor is part of the key since handles are recycled once their proxy is gone, and
+    // the addresses of local binders once they are freed.
+    Slot* findOrInsert(Direction direction, uint64_t object, uint32_t code, const Parcel& data) {
+        size_t tokenLen = 0;
+        const char16_t* token = data.peekInterfaceToken(&tokenLen);
+        const std::u16string_view descriptor =
+                token == nullptr ? std::u16string_view() : std::u16string_view(token, tokenLen);
+
+        size_t hash = std::hash<uint64_t>()(object) * 31 + code;
+        hash = hash * 2 + static_cast<size_t>(direction);
+        for (size_t i = 0; i < kSlots; i++) {
+            Slot& slot = mSlots[(hash + i) & (kSlots - 1)];
+            if (!slot.used.load(std::memory_order_relaxed)) {
+                slot.direction = direction;
+                slot.object = object;
+                slot.code = code;
+                slot.descriptor = descriptor;
+                slot.used.store(true, std::memory_order_release);
+                return &slot;
+            }
+            if (slot.direction == direction && slot.object == object && slot.code == code &&
+                slot.descriptor == descriptor) {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+
+    const uint64_t mGeneration;
+    Slot mSlots[kSlots];
+    std::atomic_uint64_t mOverflow = 0;
+};
+
+namespace {
+
+struct State {
+    std::mutex lock;
+    // Bumped by reset(), threads then start over with a new profile.
+    std::atomic_uint64_t generation = 0;
+    // Profiles of the threads which may still record, of any generation.
+    std::vector<std::shared_ptr<TransactionProfiler::ThreadProfile>> profiles;
+    // What the threads which exited recorded.
+    std::map<Key, TransactionProfiler::Entry> retired;
+    uint64_t retiredOverflow = 0;
+};
+
+// Leaked, since threads may exit after static destructors ran.
+State& state() {
+    static State* state = new State;
+    return *state;
+}
+
+} // namespace
+
+std::chrono::microseconds TransactionProfiler::Entry::latencyPercentile(double percentile) const {
+    uint64_t total = 0;
+    for (uint64_t bucketCount : latencyHistogram) total += bucketCount;
+    if (total == 0) return microseconds(0);
+
+    const uint64_t target =
+            std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(total * percentile / 100)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i + 1 < kLatencyBuckets; i++) {
+        seen += latencyHistogram[i];
+        if (seen >= target) {
+            return std::min(microseconds(uint64_t(1) << i),
+                            duration_cast<microseconds>(maxLatency + microseconds(1)));
+        }
+    }
+    return duration_cast<microseconds>(maxLatency + microseconds(1));
+}
+
+void TransactionProfiler::setEnabled(bool enabled) {
+    sEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void TransactionProfiler::reset() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.lock);
+    s.generation.fetch_add(1, std::memory_order_release);
+    s.profiles.clear();
+    s.retired.clear();
+    s.retiredOverflow = 0;
+}
+
+std::vector<TransactionProfiler::Entry> TransactionProfiler::snapshot() {
+    uint64_t uncategorized;
+    return collect(&uncategorized);
+}
+
+std::vector<TransactionProfiler::Entry> TransactionProfiler::collect(uint64_t* outUncategorized) {
+    State& s = state();
+    std::map<Key, Entry> merged;
+    {
+        std::lock_guard<std::mutex> lock(s.lock);
+        merged = s.retired;
+        *outUncategorized = s.retiredOverflow;
+        const uint64_t generation = s.generation.load(std::memory_order_relaxed);
+        for (const auto& profile : s.profiles) {
+            if (profile->generation() == generation) profile->collect(&merged, outUncategorized);
+        }
+    }
+
+    std::vector<Entry> entries;
+    entries.reserve(merged.size());
+    for (auto& [key, entry] : merged) {
+        std::tie(entry.direction, entry.descriptor, entry.code) = key;
+        entries.push_back(std::move(entry));
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const Entry& a, const Entry& b) { return a.count > b.count; });
+    return entries;
+}
+
+std::string TransactionProfiler::dump(size_t maxEntries) {
+    uint64_t uncategorized;
+    std::vector<Entry> entries = collect(&uncategorized);
+    const size_t shown = maxEntries == 0 ? entries.size() : std::min(maxEntries, entries.size());
+
+    std::ostringstream out;
+    out << "Binder transaction profile (" << (isEnabled() ? "enabled" : "disabled") << ", "
+        << entries.size() << " entries";
+    if (shown < entries.size()) out << ", top " << shown << " shown";
+    out << "):\n";
+    if (uncategorized != 0) {
+        out << uncategorized << " transactions of threads making too many different ones are "
+            << "only counted here\n";
+    }
+    out << std::left << std::setw(4) << "dir" << std::right << std::setw(10) << "count"
+        << std::setw(10) << "avg us" << std::setw(10) << "p50 us" << std::setw(10) << "p99 us"
+        << std::setw(10) << "max us" << std::setw(10) << "avg data" << std::setw(10)
+        << "avg reply"
+        << "  interface code\n";
+    for (size_t i = 0; i < shown; i++) {
+        const Entry& entry = entries[i];
+        const uint64_t count = std::max<uint64_t>(entry.count, 1);
+        out << std::left << std::setw(4)
+            << (entry.direction == Direction::OUTGOING ? "out" : "in") << std::right
+            << std::setw(10) << entry.count << std::setw(10)
+            << duration_cast<microseconds>(entry.totalLatency).count() / count << std::setw(10)
+            << entry.latencyPercentile(50).count() << std::setw(10)
+            << entry.latencyPercentile(99).count() << std::setw(10)
+            << duration_cast<microseconds>(entry.maxLatency).count() << std::setw(10)
+            << entry.dataBytes / count << std::setw(10) << entry.replyBytes / count << "  "
+            << (entry.descriptor.empty() ? "<none>" : entry.descriptor) << " " << entry.code
+            << "\n";
+    }
+    return out.str();
+}
+
+void TransactionProfiler::record(std::shared_ptr<ThreadProfile>* profile, Direction direction,
+                                 uint64_t object, uint32_t code, const Parcel& data,
+                                 size_t replyBytes, std::chrono::steady_clock::time_point start) {
+    const nanoseconds latency = std::chrono::steady_clock::now() - start;
+
+    State& s = state();
+    const uint64_t generation = s.generation.load(std::memory_order_acquire);
+    if (*profile == nullptr || (*profile)->generation() != generation) {
+        *profile = std::make_shared<ThreadProfile>(generation);
+        std::lock_guard<std::mutex> lock(s.lock);
+        s.profiles.push_back(*profile);
+    }
+    (*profile)->record(direction, object, code, data, replyBytes, latency);
+}
+
+void TransactionProfiler::retire(std::shared_ptr<ThreadProfile>* profile) {
+    if (*profile == nullptr) return;
+
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.lock);
+    if ((*profile)->generation() == s.generation.load(std::memory_order_relaxed)) {
+        (*profile)->collect(&s.retired, &s.retiredOverflow);
+    }
+    s.profiles.erase(std::remove(s.profiles.begin(), s.profiles.end(), *profile),
+                     s.profiles.end());
+    profile->reset();
+}
+
+} // namespace android::binder::debug
@@ -24,6 +24,7 @@
 #include <utils/Vector.h>
 
 #include <functional>
+#include <string>
 
 // linux/binder.h defines this, but we don't want to include it here in order to
 // avoid exporting the kernel headers
@@ -65,6 +66,8 @@ public:
         EXTENSION_TRANSACTION = B_PACK_CHARS('_', 'E', 'X', 'T'),
         DEBUG_PID_TRANSACTION = B_PACK_CHARS('_', 'P', 'I', 'D'),
         SET_RPC_CLIENT_TRANSACTION = B_PACK_CHARS('_', 'R', 'P', 'C'),
+        DEBUG_THREAD_POOL_TRANSACTION = B_PACK_CHARS('_', 'T', 'P', 'S'),
+        DEBUG_TRANSACTION_PROFILE_TRANSACTION = B_PACK_CHARS('_', 'P', 'R', 'F'),
 
         // See android.os.IBinder.TWEET_TRANSACTION
         // Most importantly, messages can be anything not exceeding 130 UTF-8
@@ -161,6 +164,25 @@ public:
      */
     status_t                getDebugPid(pid_t* outPid);
 
+    /**
+     * Dump the thread pool utilization of the process hosting a binder, for debugging.
+     * See ProcessState::getThreadPoolStats.
+     */
+    status_t                getDebugThreadPoolStats(std::string* outStats);
+
+    /**
+     * Start or stop profiling the transactions of the process hosting a binder, for debugging.
+     * Starting drops the previous profile. Only root may do this on a remote binder.
+     * See binder::debug::TransactionProfiler.
+     */
+    status_t                setDebugTransactionProfiling(bool enabled);
+
+    /**
+     * Dump the transaction profile of the process hosting a binder, for debugging.
+     * Only root may do this on a remote binder.
+     */
+    status_t                getDebugTransactionProfile(std::string* outProfile);
+
     /**
      * Set the RPC client fd to this binder service, for debugging. This is only available on
      * debuggable builds.
@@ -19,6 +19,7 @@
 #include <binder/Common.h>
 #include <binder/Parcel.h>
 #include <binder/ProcessState.h>
+#include <binder/TransactionProfiler.h>
 #include <utils/Errors.h>
 #include <utils/Vector.h>
 
@@ -209,9 +210,15 @@ public:
     LIBBINDER_EXPORTED static const int32_t kUnsetWorkSource = -1;
 
 private:
+    friend class PoolThread;
+
     IPCThreadState();
     ~IPCThreadState();
 
+    // joinThreadPool, for the threads spawned at the request of the kernel, which may retire
+    // when the thread pool is adaptive.
+    void joinThreadPool(bool isMain, bool isSpawned);
+
     [[nodiscard]] status_t sendReply(const Parcel& reply, uint32_t flags);
     [[nodiscard]] status_t waitForResponse(Parcel* reply, status_t* acquireResult = nullptr);
     [[nodiscard]] status_t talkWithDriver(bool doReceive = true);
@@ -254,6 +261,9 @@ private:
             int32_t             mStrictModePolicy;
             int32_t             mLastTransactionBinderFlags;
             CallRestriction     mCallRestriction;
+            // Created when profiling is enabled, see binder::debug::TransactionProfiler.
+            std::shared_ptr<binder::debug::TransactionProfiler::ThreadProfile>
+                    mTransactionProfile;
 };
 
 } // namespace android
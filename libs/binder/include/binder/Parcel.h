@@ -58,6 +58,7 @@ namespace binder {
 class Status;
 namespace debug {
 class RecordedTransaction;
+class TransactionProfiler;
 }
 }
 
@@ -690,6 +691,10 @@ private:
     status_t            validateReadData(size_t len) const;
 
     void                updateWorkSourceRequestHeaderPosition() const;
+    // The interface descriptor written by writeInterfaceToken() or checked by
+    // enforceInterface(), in place and without moving the data position. nullptr if there is
+    // none.
+    const char16_t*     peekInterfaceToken(size_t* outLen) const;
 
     status_t            finishFlattenBinder(const sp<IBinder>& binder);
     status_t            finishUnflattenBinder(const sp<IBinder>& binder, sp<IBinder>* out) const;
@@ -1489,6 +1494,8 @@ private:
 
     // Needed so that we can save object metadata to the disk
     friend class android::binder::debug::RecordedTransaction;
+    // Needed to tell which interface a transaction is for
+    friend class android::binder::debug::TransactionProfiler;
 };
 
 // ---------------------------------------------------------------------------
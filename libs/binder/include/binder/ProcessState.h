@@ -26,11 +26,14 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <string>
 
 // ---------------------------------------------------------------------------
 namespace android {
 
+class HandleTable;
 class IPCThreadState;
 
 /**
@@ -66,6 +69,27 @@ public:
     // threads started by 'startThreadPool' or 'joinRpcThreadpool'.
     LIBBINDER_EXPORTED status_t setThreadPoolMaxThreadCount(size_t maxThreads);
 
+    struct ThreadPoolAutoscaleConfig {
+        // Threads in the pool, including those joined directly, below which pooled threads
+        // neither wait to start nor retire.
+        size_t minThreads = 1;
+        // Same as the 'maxThreads' of setThreadPoolMaxThreadCount.
+        size_t maxThreads = 15;
+        // Length of the windows over which utilization is observed. A pooled thread retires
+        // at the end of a window during which at least two threads were never needed.
+        std::chrono::milliseconds idleTimeout = std::chrono::seconds(10);
+        // How long every thread of the pool must have been busy before a thread the kernel
+        // asked for starts taking transactions.
+        std::chrono::milliseconds spawnDelay = std::chrono::milliseconds(5);
+    };
+
+    // Like setThreadPoolMaxThreadCount, but the pool also shrinks back when it is idle, and
+    // grows only when transactions have been queueing for a while. Threads started by
+    // 'startThreadPool' or 'joinThreadPool' never retire.
+    //
+    // Must be called before startThreadPool.
+    LIBBINDER_EXPORTED status_t setThreadPoolAutoscale(const ThreadPoolAutoscaleConfig& config);
+
     // Libraries should not call this, as processes should configure
     // threadpools themselves. Should be called in the main function
     // directly before any code executes or joins the threadpool.
@@ -130,6 +154,31 @@ public:
      */
     LIBBINDER_EXPORTED bool isThreadPoolStarted() const;
 
+    struct ThreadPoolStats {
+        bool autoscale = false;
+        size_t minThreads = 0;
+        size_t maxThreads = 0;
+        // Threads currently in the pool, and the most there ever were.
+        size_t currentThreads = 0;
+        size_t peakThreads = 0;
+        size_t executingThreads = 0;
+        // Threads started for the kernel, and those of them which retired.
+        uint64_t spawnedThreads = 0;
+        uint64_t retiredThreads = 0;
+        // Spawned threads which had to wait for the pool to be busy long enough to start.
+        uint64_t deferredSpawns = 0;
+        // Time during which every thread of the pool was executing a command.
+        std::chrono::nanoseconds saturatedTime{0};
+        std::chrono::nanoseconds maxSaturatedTime{0};
+
+        LIBBINDER_EXPORTED std::string toString() const;
+    };
+
+    /**
+     * Utilization of the thread pool since the process started, for debugging.
+     */
+    LIBBINDER_EXPORTED ThreadPoolStats getThreadPoolStats() const;
+
     enum class DriverFeature {
         ONEWAY_SPAM_DETECTION,
         EXTENDED_ERROR,
@@ -155,12 +204,15 @@ private:
     ProcessState& operator=(const ProcessState& o);
     String8 makeBinderThreadName();
 
-    struct handle_entry {
-        IBinder* binder;
-        RefBase::weakref_type* refs;
-    };
-
-    handle_entry* lookupHandleLocked(int32_t handle);
+    // Thread pool bookkeeping, called by IPCThreadState.
+    void onThreadJoined();
+    void onCommandStarted(size_t executingThreads);
+    void onCommandFinished(size_t executingThreads);
+    // Blocks a newly spawned thread until the pool needs it, in adaptive mode.
+    void waitForSpawnDemand();
+    // Whether the calling spawned thread should leave the pool, in adaptive mode.
+    bool shouldRetireThread();
+    void onThreadRetired();
 
     String8 mDriverName;
     int mDriverFD;
@@ -182,11 +234,32 @@ private:
     // Time when thread pool was emptied
     std::atomic<std::chrono::steady_clock::time_point> mStarvationStartTime;
 
+    // Time since every thread of the pool is executing a command.
+    std::atomic<std::chrono::steady_clock::time_point> mSaturatedSince;
+    std::atomic_uint64_t mSaturatedNs = 0;
+    std::atomic_uint64_t mMaxSaturatedNs = 0;
+    std::atomic_size_t mPeakThreads = 0;
+    std::atomic_uint64_t mSpawnedThreads = 0;
+    std::atomic_uint64_t mRetiredThreads = 0;
+    std::atomic_uint64_t mDeferredSpawns = 0;
+
+    // Set once by setThreadPoolAutoscale(), before the thread pool starts.
+    std::atomic_bool mAutoscale = false;
+    ThreadPoolAutoscaleConfig mAutoscaleConfig;
+    // Start of the current utilization window, and the most threads executing during it.
+    std::atomic<std::chrono::steady_clock::time_point> mWindowStart;
+    std::atomic_size_t mWindowPeakExecuting = 0;
+    // Spawned threads waiting in waitForSpawnDemand().
+    std::mutex mStandbyLock;
+    std::condition_variable mStandbyCondVar;
+    std::atomic_size_t mStandbyThreads = 0;
+
     static constexpr auto never = &std::chrono::steady_clock::time_point::min;
 
-    mutable std::mutex mLock; // protects everything below.
+    // Read without a lock, written with mLock held.
+    const std::unique_ptr<HandleTable> mHandleToObject;
 
-    Vector<handle_entry> mHandleToObject;
+    mutable std::mutex mLock; // protects everything below.
 
     bool mForked;
     std::atomic_bool mThreadPoolStarted;
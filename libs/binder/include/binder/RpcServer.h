@@ -25,12 +25,14 @@
 #include <utils/RefBase.h>
 
 #include <bitset>
+#include <chrono>
 #include <mutex>
 #include <thread>
 
 namespace android {
 
 class FdTrigger;
+class RpcReactor;
 class RpcServerTrusty;
 class RpcSocketAddress;
 
@@ -135,11 +137,32 @@ public:
      * If this is not specified, this will be a single-threaded server.
      *
      * TODO(b/167966510): these are currently created per client, but these
-     * should be shared.
+     * should be shared. See setEventDrivenThreads.
      */
     LIBBINDER_EXPORTED void setMaxThreads(size_t threads);
     LIBBINDER_EXPORTED size_t getMaxThreads();
 
+    /**
+     * Serve the incoming connections of all sessions with a fixed pool of
+     * |threads| threads, rather than with a thread per connection. Idle
+     * connections are waited on with epoll, so a server with many mostly idle
+     * clients only needs as many threads as it serves calls concurrently.
+     * setMaxThreads still limits the number of connections per session.
+     *
+     * Only |threads| calls are executed at a time, across all sessions. If
+     * they all block on other incoming calls, the server deadlocks. A thread
+     * also stays with a connection until the command which started arriving
+     * on it is complete, so a client sending commands slowly holds on to
+     * threads. Such a client's session is shut down when a command takes
+     * more than |commandTimeout| to arrive.
+     *
+     * 0, the default, creates a thread per connection. This must be called
+     * before join() or start(). Returns INVALID_OPERATION if not supported on
+     * this platform.
+     */
+    [[nodiscard]] LIBBINDER_EXPORTED status_t setEventDrivenThreads(
+            size_t threads, std::chrono::milliseconds commandTimeout = std::chrono::seconds(10));
+
     /**
      * By default, the latest protocol version which is supported by a client is
      * used. However, this can be used in order to prevent newer protocol
@@ -272,6 +295,8 @@ private:
 
     const std::unique_ptr<RpcTransportCtx> mCtx;
     size_t mMaxThreads = 1;
+    size_t mEventDrivenThreads = 0;
+    std::chrono::milliseconds mEventDrivenCommandTimeout{0};
     std::optional<uint32_t> mProtocolVersion;
     // A mode is supported if the N'th bit is on, where N is the mode enum's value.
     std::bitset<8> mSupportedFileDescriptorTransportModes = std::bitset<8>().set(
@@ -290,6 +315,8 @@ private:
     std::function<void(binder::borrowed_fd)> mServerSocketModifier;
     std::map<std::vector<uint8_t>, sp<RpcSession>> mSessions;
     std::unique_ptr<FdTrigger> mShutdownTrigger;
+    // serves the connections if mEventDrivenThreads > 0, created by join()
+    std::shared_ptr<RpcReactor> mReactor;
     RpcConditionVariable mShutdownCv;
     std::function<status_t(const RpcServer& server, RpcTransportFd* out)> mAcceptFn;
 };
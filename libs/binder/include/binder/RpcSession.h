@@ -23,6 +23,7 @@
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
 
+#include <chrono>
 #include <map>
 #include <optional>
 #include <vector>
@@ -30,6 +31,7 @@
 namespace android {
 
 class Parcel;
+class RpcReactor;
 class RpcServer;
 class RpcServerTrusty;
 class RpcSocketAddress;
@@ -228,6 +230,7 @@ public:
 
 private:
     friend sp<RpcSession>;
+    friend RpcReactor;
     friend RpcServer;
     friend RpcServerTrusty;
     friend RpcState;
@@ -268,6 +271,13 @@ private:
         std::optional<uint64_t> exclusiveTid;
 
         bool allowNested = false;
+
+        // Only set for connections served by RpcReactor: how long a command may take to
+        // arrive fully once it started arriving, so that a slow client can't hold on to one of
+        // the few threads serving all sessions.
+        std::optional<std::chrono::milliseconds> commandTimeout;
+        // when the command being read must have arrived, see commandTimeout
+        std::optional<std::chrono::steady_clock::time_point> commandDeadline;
     };
 
     [[nodiscard]] status_t readId();
@@ -104,6 +104,13 @@ public:
      */
     [[nodiscard]] virtual bool isWaiting() = 0;
 
+    /**
+     * The FD this transport reads from, for waiting on many transports at once, e.g. with
+     * epoll. It becoming readable only hints that pollRead() may return OK, which must still be
+     * checked, since the transport may also buffer data.
+     */
+    [[nodiscard]] virtual binder::borrowed_fd pollFd() = 0;
+
 private:
     // limit the classes which can implement RpcTransport. Being able to change this
     // interface is important to allow development of RPC binder. In the past, we
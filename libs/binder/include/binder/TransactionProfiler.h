@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <binder/Common.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace android {
+
+class IPCThreadState;
+class Parcel;
+
+namespace binder::debug {
+
+/**
+ * Counts, payload sizes and latencies of the kernel binder transactions of this process, per
+ * interface descriptor and code, for finding the chattiest interfaces without tracing.
+ *
+ * Profiling is off until enabled. Each thread then aggregates its own transactions without
+ * taking locks, and snapshot() merges the threads. Outgoing latencies are measured from
+ * sending the transaction until its reply arrives, incoming ones over the execution of the
+ * transaction, so the difference between the two sides of an interface is the time it spent
+ * in the driver and queued for a thread.
+ *
+ * The interface descriptor is the one written by writeInterfaceToken() and checked with
+ * enforceInterface(). Transactions without one, such as pings, have an empty descriptor.
+ */
+class TransactionProfiler {
+public:
+    enum class Direction : uint8_t {
+        OUTGOING,
+        INCOMING,
+    };
+
+    // Bucket 0 counts latencies below 1us, bucket i those in [2^(i-1), 2^i) us, and the last
+    // bucket everything above.
+    static constexpr size_t kLatencyBuckets = 24;
+
+    struct Entry {
+        Direction direction = Direction::OUTGOING;
+        std::string descriptor;
+        uint32_t code = 0;
+        uint64_t count = 0;
+        uint64_t dataBytes = 0;
+        uint64_t replyBytes = 0;
+        std::chrono::nanoseconds totalLatency{0};
+        std::chrono::nanoseconds maxLatency{0};
+        std::array<uint64_t, kLatencyBuckets> latencyHistogram{};
+
+        // Upper bound of the latency of |percentile| (in [0, 100]) of the transactions, to the
+        // precision of the histogram.
+        LIBBINDER_EXPORTED std::chrono::microseconds latencyPercentile(double percentile) const;
+    };
+
+    LIBBINDER_EXPORTED static void setEnabled(bool enabled);
+    static bool isEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+    // Drops what was recorded so far.
+    LIBBINDER_EXPORTED static void reset();
+
+    // Everything recorded since the last reset, including by threads which exited since,
+    // the most frequent transactions first.
+    LIBBINDER_EXPORTED static std::vector<Entry> snapshot();
+
+    // A table of the |maxEntries| most frequent transactions, all of them if 0.
+    LIBBINDER_EXPORTED static std::string dump(size_t maxEntries = 0);
+
+    // What a thread recorded, internal.
+    class ThreadProfile;
+
+private:
+    friend class ::android::IPCThreadState;
+
+    // Like snapshot(), also counting the transactions which weren't told apart.
+    static std::vector<Entry> collect(uint64_t* outUncategorized);
+
+    // Called by IPCThreadState on the thread owning |profile|, which is created as needed.
+    static void record(std::shared_ptr<ThreadProfile>* profile, Direction direction,
+                       uint64_t object, uint32_t code, const Parcel& data, size_t replyBytes,
+                       std::chrono::steady_clock::time_point start);
+    // Called when the owning thread exits, so that what it recorded outlives it.
+    static void retire(std::shared_ptr<ThreadProfile>* profile);
+
+    LIBBINDER_EXPORTED static std::atomic_bool sEnabled;
+};
+
+} // namespace binder::debug
+
+} // namespace android
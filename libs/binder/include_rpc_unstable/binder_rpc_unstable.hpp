@@ -84,6 +84,14 @@ void ARpcServer_setSupportedFileDescriptorTransportModes(
 // If this is not specified, this will be a single-threaded server.
 void ARpcServer_setMaxThreads(ARpcServer* server, size_t threads);
 
+// Sets the number of threads which serve the incoming connections of all
+// sessions, waiting on idle connections with epoll, instead of a thread per
+// connection. 0, the default, disables this.
+//
+// This must be called before the server is started. Returns false if this is
+// not supported.
+[[nodiscard]] bool ARpcServer_setEventDrivenThreads(ARpcServer* server, size_t threads);
+
 // Runs ARpcServer_join() in a background thread. Immediately returns.
 void ARpcServer_start(ARpcServer* server);
 
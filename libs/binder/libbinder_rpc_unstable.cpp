@@ -171,6 +171,10 @@ void ARpcServer_setMaxThreads(ARpcServer* handle, size_t threads) {
     handleToStrongPointer<RpcServer>(handle)->setMaxThreads(threads);
 }
 
+bool ARpcServer_setEventDrivenThreads(ARpcServer* handle, size_t threads) {
+    return handleToStrongPointer<RpcServer>(handle)->setEventDrivenThreads(threads) == OK;
+}
+
 void ARpcServer_start(ARpcServer* handle) {
     handleToStrongPointer<RpcServer>(handle)->start();
 }
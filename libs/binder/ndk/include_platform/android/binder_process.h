@@ -97,4 +97,25 @@ __attribute__((weak)) binder_status_t ABinderProcess_setupPolling(int* fd) __INT
  */
 __attribute__((weak)) binder_status_t ABinderProcess_handlePolledCommands(void) __INTRODUCED_IN(31);
 
+/**
+ * Starts or stops profiling the binder transactions of this process: how many of each
+ * interface and transaction code are sent and received, their sizes and their latencies.
+ * Starting drops what was recorded before. Profiling is off by default.
+ *
+ * The profile of any process can also be controlled with `dumpsys --binder-profile`.
+ *
+ * \param enabled whether to record transactions from now on.
+ */
+__attribute__((weak)) void ABinderProcess_setTransactionProfilingEnabled(bool enabled)
+        __INTRODUCED_IN(36);
+
+/**
+ * Writes the binder transaction profile of this process, as text, to fd.
+ *
+ * \param fd file descriptor to write the profile to.
+ * \return STATUS_OK on success
+ */
+__attribute__((weak)) binder_status_t ABinderProcess_dumpTransactionProfile(int fd)
+        __INTRODUCED_IN(36);
+
 __END_DECLS
@@ -14,13 +14,16 @@
  * limitations under the License.
  */
 
+#include <android-base/file.h>
 #include <android/binder_process.h>
 #include <binder/IPCThreadState.h>
+#include <binder/TransactionProfiler.h>
 
 #include <mutex>
 
 using ::android::IPCThreadState;
 using ::android::ProcessState;
+using ::android::binder::debug::TransactionProfiler;
 
 void ABinderProcess_startThreadPool(void) {
     ProcessState::self()->startThreadPool();
@@ -43,3 +46,15 @@ binder_status_t ABinderProcess_setupPolling(int* fd) {
 binder_status_t ABinderProcess_handlePolledCommands(void) {
     return IPCThreadState::self()->handlePolledCommands();
 }
+
+void ABinderProcess_setTransactionProfilingEnabled(bool enabled) {
+    if (enabled) TransactionProfiler::reset();
+    TransactionProfiler::setEnabled(enabled);
+}
+
+binder_status_t ABinderProcess_dumpTransactionProfile(int fd) {
+    if (!android::base::WriteStringToFd(TransactionProfiler::dump(), fd)) {
+        return STATUS_UNKNOWN_ERROR;
+    }
+    return STATUS_OK;
+}
@@ -39,6 +39,7 @@
 #include <binder/RpcServer.h>
 #include <binder/RpcSession.h>
 #include <binder/Status.h>
+#include <binder/TransactionProfiler.h>
 #include <binder/unique_fd.h>
 #include <input/BlockingQueue.h>
 #include <processgroup/processgroup.h>
@@ -1831,6 +1832,83 @@ TEST_F(BinderLibTest, ThreadPoolStarted) {
     EXPECT_TRUE(reply.readBool());
 }
 
+TEST_F(BinderLibTest, ThreadPoolStats) {
+    sp<IBinder> server = addServer();
+    ASSERT_TRUE(server != nullptr);
+    std::string stats;
+    EXPECT_THAT(server->getDebugThreadPoolStats(&stats), StatusEq(NO_ERROR));
+    // Servers set their maximum to kKernelThreads.
+    EXPECT_NE(std::string::npos, stats.find("/" + std::to_string(kKernelThreads) + " threads"))
+            << stats;
+
+    ProcessState::ThreadPoolStats local = ProcessState::self()->getThreadPoolStats();
+    EXPECT_FALSE(local.autoscale);
+    EXPECT_GE(local.peakThreads, local.currentThreads);
+    EXPECT_EQ(0u, local.retiredThreads);
+}
+
+TEST_F(BinderLibTest, TransactionProfile) {
+    using android::binder::debug::TransactionProfiler;
+    sp<IBinder> server = addServer();
+    ASSERT_TRUE(server != nullptr);
+
+    TransactionProfiler::reset();
+    TransactionProfiler::setEnabled(true);
+    for (int i = 0; i < 10; i++) {
+        Parcel data, reply;
+        data.writeInterfaceToken(String16("binderLibTest.profile"));
+        EXPECT_THAT(server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, &reply),
+                    StatusEq(NO_ERROR));
+    }
+    TransactionProfiler::setEnabled(false);
+
+    std::vector<TransactionProfiler::Entry> entries = TransactionProfiler::snapshot();
+    auto it = std::find_if(entries.begin(), entries.end(), [](const auto& entry) {
+        return entry.descriptor == "binderLibTest.profile";
+    });
+    ASSERT_NE(it, entries.end()) << TransactionProfiler::dump();
+    EXPECT_EQ(TransactionProfiler::Direction::OUTGOING, it->direction);
+    EXPECT_EQ(static_cast<uint32_t>(BINDER_LIB_TEST_NOP_TRANSACTION), it->code);
+    EXPECT_EQ(10u, it->count);
+    EXPECT_GE(it->maxLatency, it->totalLatency / 10);
+    EXPECT_NE(std::string::npos, TransactionProfiler::dump().find("binderLibTest.profile"));
+
+    // The server doesn't profile unless asked to, but can always be dumped.
+    std::string profile;
+    EXPECT_THAT(server->getDebugTransactionProfile(&profile), StatusEq(NO_ERROR));
+    EXPECT_NE(std::string::npos, profile.find("(disabled")) << profile;
+}
+
+TEST_F(BinderLibTest, TransactionProfileRecycledHandle) {
+    using android::binder::debug::TransactionProfiler;
+    sp<IBinder> server = addServer();
+    ASSERT_TRUE(server != nullptr);
+
+    // Once a proxy is gone its handle goes to the next binder received, which to the profiler
+    // looks like the same handle being used with another interface.
+    TransactionProfiler::reset();
+    TransactionProfiler::setEnabled(true);
+    for (const char* descriptor : {"binderLibTest.before", "binderLibTest.after",
+                                   "binderLibTest.after"}) {
+        Parcel data, reply;
+        data.writeInterfaceToken(String16(descriptor));
+        EXPECT_THAT(server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, &reply),
+                    StatusEq(NO_ERROR));
+    }
+    TransactionProfiler::setEnabled(false);
+
+    std::vector<TransactionProfiler::Entry> entries = TransactionProfiler::snapshot();
+    auto countOf = [&](const std::string& descriptor) -> uint64_t {
+        auto it = std::find_if(entries.begin(), entries.end(), [&](const auto& entry) {
+            return entry.descriptor == descriptor &&
+                    entry.code == static_cast<uint32_t>(BINDER_LIB_TEST_NOP_TRANSACTION);
+        });
+        return it == entries.end() ? 0 : it->count;
+    };
+    EXPECT_EQ(1u, countOf("binderLibTest.before")) << TransactionProfiler::dump();
+    EXPECT_EQ(2u, countOf("binderLibTest.after")) << TransactionProfiler::dump();
+}
+
 size_t epochMillis() {
     using std::chrono::duration_cast;
     using std::chrono::milliseconds;
@@ -1867,6 +1945,40 @@ TEST_F(BinderLibTest, HangingServices) {
     EXPECT_GE(epochMsAfter, epochMsBefore + delay);
 }
 
+TEST_F(BinderLibTest, ConcurrentProxyLookup) {
+    sp<IBinder> server = addServer();
+    ASSERT_NE(server, nullptr);
+
+    uint32_t initialCount = BpBinder::getBinderProxyCount();
+    // Threads keep creating and dropping proxies for new handles, which may be reused by the
+    // driver, while looking up the same proxy over and over.
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 8; t++) {
+        threads.emplace_back([&] {
+            for (size_t i = 0; i < 50; i++) {
+                Parcel data, reply;
+                ASSERT_THAT(server->transact(BINDER_LIB_TEST_CREATE_BINDER_TRANSACTION, data,
+                                             &reply),
+                            StatusEq(NO_ERROR));
+                sp<IBinder> proxy = reply.readStrongBinder();
+                ASSERT_NE(proxy, nullptr);
+                for (size_t j = 0; j < 20; j++) {
+                    Parcel p;
+                    p.writeStrongBinder(proxy);
+                    p.writeStrongBinder(server);
+                    p.setDataPosition(0);
+                    EXPECT_EQ(proxy, p.readStrongBinder());
+                    EXPECT_EQ(server, p.readStrongBinder());
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(BpBinder::getBinderProxyCount(), initialCount);
+}
+
 TEST_F(BinderLibTest, BinderProxyCount) {
     Parcel data, reply;
     sp<IBinder> server = addServer();
@@ -15,6 +15,7 @@
  */
 
 #include <binder/Parcel.h>
+#include <binder/ProcessState.h>
 #include <benchmark/benchmark.h>
 
 // Usage: atest binderParcelBenchmark
@@ -169,4 +170,29 @@ BENCHMARK(BM_CharVector)->Apply(VectorArgs);
 BENCHMARK(BM_Int32Vector)->Apply(VectorArgs);
 BENCHMARK(BM_Int64Vector)->Apply(VectorArgs);
 
+/*
+  Unparcel a proxy on several threads at once, as binder threads of a busy
+  process do. Every read looks the handle up in ProcessState.
+*/
+static void BM_ReadStrongBinder(benchmark::State& state) {
+    static const android::sp<android::IBinder> binder =
+            android::ProcessState::self()->getContextObject(nullptr);
+    if (binder == nullptr) {
+        state.SkipWithError("No context object");
+        return;
+    }
+
+    android::Parcel p;
+    p.writeStrongBinder(binder);
+    while (state.KeepRunning()) {
+        p.setDataPosition(0);
+        android::sp<android::IBinder> b = p.readStrongBinder();
+
+        benchmark::DoNotOptimize(b);
+        benchmark::ClobberMemory();
+    }
+}
+
+BENCHMARK(BM_ReadStrongBinder)->ThreadRange(1, 64)->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -33,8 +33,10 @@
 
 #include <thread>
 
+#include <dirent.h>
 #include <signal.h>
 #include <sys/prctl.h>
+#include <sys/resource.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -128,15 +130,19 @@ static const std::initializer_list<int64_t> kTransportList = {
         Transport::RPC_TLS,
 };
 
+std::unique_ptr<RpcTransportCtxFactory> makeFactoryTls(bssl::UniquePtr<EVP_PKEY> pkey,
+                                                       bssl::UniquePtr<X509> cert) {
+    auto verifier = std::make_shared<RpcCertificateVerifierNoOp>(OK);
+    auto auth = std::make_unique<RpcAuthPreSigned>(std::move(pkey), std::move(cert));
+    return RpcTransportCtxFactoryTls::make(verifier, std::move(auth));
+}
+
 std::unique_ptr<RpcTransportCtxFactory> makeFactoryTls() {
     auto pkey = android::makeKeyPairForSelfSignedCert();
     CHECK_NE(pkey.get(), nullptr);
     auto cert = android::makeSelfSignedCert(pkey.get(), android::kCertValidSeconds);
     CHECK_NE(cert.get(), nullptr);
-
-    auto verifier = std::make_shared<RpcCertificateVerifierNoOp>(OK);
-    auto auth = std::make_unique<RpcAuthPreSigned>(std::move(pkey), std::move(cert));
-    return RpcTransportCtxFactoryTls::make(verifier, std::move(auth));
+    return makeFactoryTls(std::move(pkey), std::move(cert));
 }
 
 static sp<RpcSession> gSession = RpcSession::make();
@@ -145,6 +151,7 @@ static sp<IBinder> gRpcBinder;
 // Skip certificate validation to simplify the setup process.
 static sp<RpcSession> gSessionTls = RpcSession::make(makeFactoryTls());
 static sp<IBinder> gRpcTlsBinder;
+static std::string gTlsAddr;
 #ifdef __BIONIC__
 static const String16 kKernelBinderInstance = String16(u"binderRpcBenchmark-control");
 static sp<IBinder> gKernelBinder;
@@ -250,6 +257,68 @@ BENCHMARK(BM_throughputForTransportAndBytes)
         ->ArgsProduct({kTransportList,
                        {64, 1024, 2048, 4096, 8182, 16364, 32728, 65535, 65536, 65537}});
 
+// Transactions per second for small payloads, for which the per-message overhead of the
+// transport dominates, e.g. the TLS records of each write.
+void BM_smallMessageThroughput(benchmark::State& state) {
+    sp<IBinder> binder = getBinderForOptions(state);
+    sp<IBinderRpcBenchmark> iface = interface_cast<IBinderRpcBenchmark>(binder);
+    CHECK(iface != nullptr);
+
+    std::vector<uint8_t> bytes = std::vector<uint8_t>(state.range(1), 'a');
+    while (state.KeepRunning()) {
+        std::vector<uint8_t> out;
+        Status ret = iface->repeatBytes(bytes, &out);
+        CHECK(ret.isOk()) << ret;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes.size()) * 2);
+
+    SetLabel(state);
+}
+BENCHMARK(BM_smallMessageThroughput)->ArgsProduct({kTransportList, {0, 16, 128, 512}});
+
+enum TlsHandshake {
+    FULL,
+    RESUMED,
+};
+
+// Time to set up a TLS session. A client resumes the TLS session it has with a server, if it
+// connected before with the same certificate.
+void BM_tlsConnect(benchmark::State& state) {
+    TlsHandshake handshake = static_cast<TlsHandshake>(state.range(0));
+
+    static bssl::UniquePtr<EVP_PKEY> sPkey = android::makeKeyPairForSelfSignedCert();
+    static bssl::UniquePtr<X509> sCert =
+            android::makeSelfSignedCert(sPkey.get(), android::kCertValidSeconds);
+    CHECK(sPkey != nullptr && sCert != nullptr);
+
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        std::unique_ptr<RpcTransportCtxFactory> factory;
+        if (handshake == RESUMED) {
+            EVP_PKEY_up_ref(sPkey.get());
+            X509_up_ref(sCert.get());
+            factory = makeFactoryTls(bssl::UniquePtr<EVP_PKEY>(sPkey.get()),
+                                     bssl::UniquePtr<X509>(sCert.get()));
+        } else {
+            // a new certificate, for which there is no session yet
+            factory = makeFactoryTls();
+        }
+        sp<RpcSession> session = RpcSession::make(std::move(factory));
+        state.ResumeTiming();
+
+        status_t status = session->setupUnixDomainClient(gTlsAddr.c_str());
+        CHECK_EQ(OK, status) << "Could not connect: " << statusToString(status).c_str();
+
+        state.PauseTiming();
+        CHECK(session->shutdownAndWait(true));
+        state.ResumeTiming();
+    }
+
+    state.SetLabel(handshake == RESUMED ? "resumed" : "full");
+}
+BENCHMARK(BM_tlsConnect)->ArgsProduct({{FULL, RESUMED}});
+
 void BM_collectProxies(benchmark::State& state) {
     sp<IBinder> binder = getBinderForOptions(state);
     sp<IBinderRpcBenchmark> iface = interface_cast<IBinderRpcBenchmark>(binder);
@@ -301,14 +370,77 @@ void BM_repeatBinder(benchmark::State& state) {
 }
 BENCHMARK(BM_repeatBinder)->ArgsProduct({kTransportList});
 
-void forkRpcServer(const char* addr, const sp<RpcServer>& server) {
-    if (0 == fork()) {
+enum ServingMode {
+    THREAD_PER_CONNECTION,
+    EVENT_DRIVEN,
+};
+
+struct ScaleServer {
+    std::string addr;
+    pid_t pid = 0;
+};
+static ScaleServer gScaleServers[2];
+
+static size_t countThreads(pid_t pid) {
+    std::string path = "/proc/" + std::to_string(pid) + "/task";
+    DIR* dir = opendir(path.c_str());
+    CHECK(dir != nullptr) << "Could not open " << path;
+    size_t threads = 0;
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') threads++;
+    }
+    closedir(dir);
+    return threads;
+}
+
+// Many clients which are mostly idle, only one of them calling at a time.
+void BM_manyIdleSessions(benchmark::State& state) {
+    ServingMode mode = static_cast<ServingMode>(state.range(0));
+    const ScaleServer& server = gScaleServers[mode];
+    const size_t kNumSessions = state.range(1);
+
+    std::vector<sp<RpcSession>> sessions;
+    std::vector<sp<IBinder>> binders;
+    for (size_t i = 0; i < kNumSessions; i++) {
+        sp<RpcSession> session = RpcSession::make();
+        status_t status = session->setupUnixDomainClient(server.addr.c_str());
+        CHECK_EQ(OK, status) << "Could not connect session " << i << ": "
+                             << statusToString(status).c_str();
+        binders.push_back(session->getRootObject());
+        CHECK(binders.back() != nullptr);
+        sessions.push_back(std::move(session));
+    }
+    for (const auto& binder : binders) {
+        CHECK_EQ(OK, binder->pingBinder());
+    }
+    state.counters["server_threads"] = static_cast<double>(countThreads(server.pid));
+
+    size_t next = 0;
+    while (state.KeepRunning()) {
+        CHECK_EQ(OK, binders[next]->pingBinder());
+        next = (next + 1) % binders.size();
+    }
+
+    binders.clear();
+    for (const auto& session : sessions) {
+        CHECK(session->shutdownAndWait(true));
+    }
+
+    state.SetLabel(mode == EVENT_DRIVEN ? "event_driven" : "thread_per_connection");
+}
+BENCHMARK(BM_manyIdleSessions)
+        ->ArgsProduct({{THREAD_PER_CONNECTION, EVENT_DRIVEN}, {10, 100, 1000}});
+
+pid_t forkRpcServer(const char* addr, const sp<RpcServer>& server) {
+    pid_t pid = fork();
+    if (0 == pid) {
         prctl(PR_SET_PDEATHSIG, SIGHUP); // racey, okay
         server->setRootObject(sp<MyBinderRpcBenchmark>::make());
         CHECK_EQ(OK, server->setupUnixDomainServer(addr));
         server->join();
         exit(1);
     }
+    return pid;
 }
 
 void setupClient(const sp<RpcSession>& session, const char* addr) {
@@ -342,6 +474,12 @@ int main(int argc, char** argv) {
     CHECK_NE(nullptr, gKernelBinder.get());
 #endif
 
+    // BM_manyIdleSessions keeps a file descriptor per session open, on both sides.
+    rlimit files;
+    CHECK_EQ(0, getrlimit(RLIMIT_NOFILE, &files));
+    files.rlim_cur = files.rlim_max;
+    CHECK_EQ(0, setrlimit(RLIMIT_NOFILE, &files));
+
     std::string tmp = getenv("TMPDIR") ?: "/tmp";
 
     std::string addr = tmp + "/binderRpcBenchmark";
@@ -350,12 +488,26 @@ int main(int argc, char** argv) {
     setupClient(gSession, addr.c_str());
     gRpcBinder = gSession->getRootObject();
 
-    std::string tlsAddr = tmp + "/binderRpcTlsBenchmark";
-    (void)unlink(tlsAddr.c_str());
-    forkRpcServer(tlsAddr.c_str(), RpcServer::make(makeFactoryTls()));
-    setupClient(gSessionTls, tlsAddr.c_str());
+    gTlsAddr = tmp + "/binderRpcTlsBenchmark";
+    (void)unlink(gTlsAddr.c_str());
+    forkRpcServer(gTlsAddr.c_str(), RpcServer::make(makeFactoryTls()));
+    setupClient(gSessionTls, gTlsAddr.c_str());
     gRpcTlsBinder = gSessionTls->getRootObject();
 
+    for (ServingMode mode : {THREAD_PER_CONNECTION, EVENT_DRIVEN}) {
+        ScaleServer& scaleServer = gScaleServers[mode];
+        scaleServer.addr = tmp + "/binderRpcScaleBenchmark" + std::to_string(mode);
+        (void)unlink(scaleServer.addr.c_str());
+        sp<RpcServer> server = RpcServer::make(RpcTransportCtxFactoryRaw::make());
+        if (mode == EVENT_DRIVEN) CHECK_EQ(OK, server->setEventDrivenThreads(4));
+        scaleServer.pid = forkRpcServer(scaleServer.addr.c_str(), server);
+
+        // wait for the server to listen
+        sp<RpcSession> session = RpcSession::make();
+        setupClient(session, scaleServer.addr.c_str());
+        CHECK(session->shutdownAndWait(true));
+    }
+
     ::benchmark::RunSpecifiedBenchmarks();
     return 0;
 }
@@ -1644,6 +1644,114 @@ INSTANTIATE_TEST_SUITE_P(BinderRpc, BinderRpcServerOnly,
                                             ::testing::ValuesIn(testVersions())),
                          BinderRpcServerOnly::PrintTestParam);
 
+TEST(BinderRpc, EventDrivenServer) {
+    if constexpr (!kEnableRpcThreads) {
+        GTEST_SKIP() << "Test skipped because threads were disabled at build time";
+    }
+
+    constexpr size_t kNumSessions = 20;
+    auto addr = allocateSocketAddress();
+    auto server = RpcServer::make();
+    if (server->setEventDrivenThreads(2) == INVALID_OPERATION) {
+        GTEST_SKIP() << "Event driven RpcServer is not supported on this platform";
+    }
+    server->setMaxThreads(2);
+    server->setRootObject(sp<BBinder>::make());
+    ASSERT_EQ(OK, server->setupUnixDomainServer(addr.c_str()));
+    server->start();
+
+    // more connections than threads, all of them served
+    std::vector<sp<RpcSession>> sessions;
+    for (size_t i = 0; i < kNumSessions; i++) {
+        auto session = RpcSession::make();
+        ASSERT_EQ(OK, session->setupUnixDomainClient(addr.c_str()));
+        sp<IBinder> root = session->getRootObject();
+        ASSERT_NE(nullptr, root);
+        EXPECT_EQ(OK, root->pingBinder());
+        sessions.push_back(session);
+    }
+    for (const auto& session : sessions) {
+        EXPECT_EQ(OK, session->getRootObject()->pingBinder());
+    }
+    EXPECT_EQ(kNumSessions, server->listSessions().size());
+
+    // sessions the clients shut down go away
+    for (size_t i = 0; i < kNumSessions / 2; i++) {
+        EXPECT_TRUE(sessions[i]->shutdownAndWait(true));
+    }
+    sessions.erase(sessions.begin(), sessions.begin() + kNumSessions / 2);
+    for (size_t tries = 0; tries < 100 && server->listSessions().size() != sessions.size();
+         tries++) {
+        usleep(10 * 1000);
+    }
+    EXPECT_EQ(sessions.size(), server->listSessions().size());
+    for (const auto& session : sessions) {
+        EXPECT_EQ(OK, session->getRootObject()->pingBinder());
+    }
+
+    // and those which are left when the server shuts down, too
+    ASSERT_TRUE(server->shutdown());
+    for (const auto& session : sessions) {
+        EXPECT_TRUE(session->shutdownAndWait(true));
+    }
+}
+
+TEST(BinderRpc, EventDrivenServerTimesOutPartialCommand) {
+    if constexpr (!kEnableRpcThreads) {
+        GTEST_SKIP() << "Test skipped because threads were disabled at build time";
+    }
+
+    constexpr auto kCommandTimeout = 1000ms;
+    auto addr = allocateSocketAddress();
+    auto server = RpcServer::make();
+    if (server->setEventDrivenThreads(2, kCommandTimeout) == INVALID_OPERATION) {
+        GTEST_SKIP() << "Event driven RpcServer is not supported on this platform";
+    }
+    server->setRootObject(sp<BBinder>::make());
+    ASSERT_EQ(OK, server->setupUnixDomainServer(addr.c_str()));
+    server->start();
+
+    auto healthy = RpcSession::make();
+    ASSERT_EQ(OK, healthy->setupUnixDomainClient(addr.c_str()));
+    sp<IBinder> healthyRoot = healthy->getRootObject();
+    ASSERT_NE(nullptr, healthyRoot);
+
+    unique_fd stalledFd;
+    auto stalled = RpcSession::make();
+    ASSERT_EQ(OK, stalled->setupPreconnectedClient({}, [&]() {
+        unique_fd fd = connectTo(UnixSocketAddress(addr.c_str()));
+        if (!stalledFd.ok()) stalledFd.reset(dup(fd.get()));
+        return fd;
+    }));
+    ASSERT_TRUE(stalledFd.ok());
+
+    // Only part of a command header, which keeps a thread reading it.
+    const char partialHeader[4] = {};
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(partialHeader)),
+              TEMP_FAILURE_RETRY(write(stalledFd.get(), partialHeader, sizeof(partialHeader))));
+
+    // other sessions are still served meanwhile
+    EXPECT_EQ(OK, healthyRoot->pingBinder());
+    pollfd pfd{.fd = stalledFd.get(), .events = POLLIN, .revents = 0};
+    EXPECT_EQ(0, TEMP_FAILURE_RETRY(poll(&pfd, 1, 0))) << "Stalled session shut down too early";
+
+    // until the command times out and the server hangs up on the stalled session
+    ASSERT_EQ(1, TEMP_FAILURE_RETRY(poll(&pfd, 1, 10000)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, kCommandTimeout);
+    char c;
+    EXPECT_EQ(0, TEMP_FAILURE_RETRY(read(stalledFd.get(), &c, 1)));
+    for (size_t tries = 0; tries < 100 && server->listSessions().size() != 1; tries++) {
+        usleep(10 * 1000);
+    }
+    EXPECT_EQ(1u, server->listSessions().size());
+    EXPECT_EQ(OK, healthyRoot->pingBinder());
+
+    ASSERT_TRUE(server->shutdown());
+    EXPECT_TRUE(healthy->shutdownAndWait(true));
+    EXPECT_TRUE(stalled->shutdownAndWait(true));
+}
+
 class RpcTransportTestUtils {
 public:
     // Only parameterized only server version because `RpcSession` is bypassed
@@ -2,6 +2,7 @@
 #include <binder/IBinder.h>
 #include <binder/IPCThreadState.h>
 #include <binder/IServiceManager.h>
+#include <binder/ProcessState.h>
 #include <string>
 #include <cstring>
 #include <cstdlib>
@@ -51,6 +52,7 @@ public:
 };
 
 static uint64_t warn_latency = std::numeric_limits<uint64_t>::max();
+static bool adaptive_thread_pool = false;
 
 struct ProcResults {
     vector<uint64_t> data;
@@ -210,6 +212,9 @@ void worker_fx(int num,
                Pipe p)
 {
     // Create BinderWorkerService and for go.
+    if (adaptive_thread_pool) {
+        ProcessState::self()->setThreadPoolAutoscale(ProcessState::ThreadPoolAutoscaleConfig());
+    }
     ProcessState::self()->startThreadPool();
     sp<IServiceManager> serviceMgr = defaultServiceManager();
     sp<BinderWorkerService> service = new BinderWorkerService;
@@ -264,6 +269,9 @@ void worker_fx(int num,
         }
     }
 
+    cout << "BinderWorker" << num << " thread pool: "
+         << ProcessState::self()->getThreadPoolStats().toString() << endl;
+
     // Signal completion to master and wait.
     p.signal();
     p.wait();
@@ -387,6 +395,7 @@ int main(int argc, char *argv[])
             cout << "\t-t      : Run training round." << endl;
             cout << "\t-w N    : Specify total number of workers." << endl;
             cout << "\t-d FILE : Dump raw data to file." << endl;
+            cout << "\t-a      : Use adaptive binder thread pools." << endl;
             return 0;
         }
         if (string(argv[i]) == "-w") {
@@ -423,6 +432,10 @@ int main(int argc, char *argv[])
             cs_pair = true;
             continue;
         }
+        if (string(argv[i]) == "-a") {
+            adaptive_thread_pool = true;
+            continue;
+        }
         if (string(argv[i]) == "-t") {
             // Run one training round before actually collecting data
             // to get an approximation of max latency.
@@ -220,6 +220,8 @@ public:
 
     bool isWaiting() override { return mSocket.isInPollingState(); }
 
+    borrowed_fd pollFd() override { return mSocket.fd; }
+
 private:
     status_t ensureMessage(bool wait) {
         int rc;
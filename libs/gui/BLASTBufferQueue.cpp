@@ -75,7 +75,7 @@ namespace android {
 
 #define UNIQUE_LOCK_WITH_ASSERTION(mutex) \
     std::unique_lock _lock{mutex};        \
-    base::ScopedLockAssertion assumeLocked(mutex);
+    ftl::FakeGuard assumeLocked(mutex);
 
 #if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(BUFFER_RELEASE_CHANNEL)
 static ReleaseBufferCallback EMPTY_RELEASE_CALLBACK =
@@ -382,6 +382,10 @@ void BLASTBufferQueue::transactionCallback(nsecs_t /*latchTime*/, const sp<Fence
         std::lock_guard _lock{mMutex};
         BBQ_TRACE();
         BQA_LOGV("transactionCallback");
+#if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(BUFFER_RELEASE_RING)
+        // Apply real releases before deciding which submitted buffers are stale.
+        drainReleaseRingLocked();
+#endif
 
         if (!mSurfaceControlsWithPendingCallback.empty()) {
             sp<SurfaceControl> pendingSC = mSurfaceControlsWithPendingCallback.front();
@@ -463,12 +467,98 @@ ReleaseBufferCallback BLASTBufferQueue::makeReleaseBufferCallbackThunk() {
 void BLASTBufferQueue::releaseBufferCallback(
         const ReleaseCallbackId& id, const sp<Fence>& releaseFence,
         std::optional<uint32_t> currentMaxAcquiredBufferCount) {
+#if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(BUFFER_RELEASE_RING)
+    // Queue the release without waiting for mMutex, which the producer thread may be holding. If
+    // the mutex is free we apply the release (and any others queued behind it) ourselves, when
+    // unlocking it. Otherwise its holder applies it when unlocking. try_lock may also fail
+    // spuriously, or while the holder is past checking the ring, hence the retries.
+    if (mReleaseRing.push({id, releaseFence, currentMaxAcquiredBufferCount})) {
+        while (!mReleaseRing.empty()) {
+            if (mMutex.try_lock()) {
+                mMutex.unlock();
+                return;
+            }
+            if (mMutex.isHeld()) {
+                return;
+            }
+        }
+        return;
+    }
+#endif
     std::lock_guard _lock{mMutex};
+#if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(BUFFER_RELEASE_RING)
+    // The ring is full. Apply the releases queued before this one first.
+    BBQ_TRACE("ReleaseRingFull");
+    drainReleaseRingLocked();
+#else
     BBQ_TRACE();
+#endif
     releaseBufferCallbackLocked(id, releaseFence, currentMaxAcquiredBufferCount,
                                 false /* fakeRelease */);
 }
 
+#if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(BUFFER_RELEASE_RING)
+void BLASTBufferQueue::drainReleaseRingLocked() {
+    gui::BufferReleaseChannel::ReleaseRing::Entry entry;
+    while (mReleaseRing.pop(entry)) {
+        releaseBufferCallbackLocked(entry.releaseCallbackId, entry.releaseFence,
+                                    entry.maxAcquiredBufferCount, false /* fakeRelease */);
+    }
+}
+
+// The wrapped std::mutex is an implementation detail of the capability.
+void BLASTBufferQueue::ReleaseRingMutex::lock() NO_THREAD_SAFETY_ANALYSIS {
+    mMutex.lock();
+    mHeld = true;
+}
+
+bool BLASTBufferQueue::ReleaseRingMutex::try_lock() NO_THREAD_SAFETY_ANALYSIS {
+    if (!mMutex.try_lock()) {
+        return false;
+    }
+    mHeld = true;
+    return true;
+}
+
+void BLASTBufferQueue::ReleaseRingMutex::unlock() NO_THREAD_SAFETY_ANALYSIS {
+    while (true) {
+        mBbq.drainReleaseRingLocked();
+        // A callback which queues a release from now on either takes the mutex itself, or sees
+        // the ring not being empty below.
+        mHeld = false;
+        mMutex.unlock();
+        // Pairs with the fence in isHeld().
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (mBbq.mReleaseRing.empty() || !try_lock()) {
+            return;
+        }
+    }
+}
+
+void BLASTBufferQueue::ReleaseRingMutex::wait(std::condition_variable& cv)
+        NO_THREAD_SAFETY_ANALYSIS {
+    mBbq.drainReleaseRingLocked();
+    mHeld = false;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // Otherwise a release was queued since, which the caller applies when waiting again.
+    if (mBbq.mReleaseRing.empty()) {
+        std::unique_lock lock{mMutex, std::adopt_lock};
+        cv.wait(lock);
+        lock.release();
+    }
+    mHeld = true;
+}
+#endif
+
+void BLASTBufferQueue::waitForCallbackCVLocked(std::unique_lock<decltype(mMutex)>& lock) {
+#if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(BUFFER_RELEASE_RING)
+    (void)lock;
+    mMutex.wait(mCallbackCV);
+#else
+    mCallbackCV.wait(lock);
+#endif
+}
+
 void BLASTBufferQueue::releaseBufferCallbackLocked(
         const ReleaseCallbackId& id, const sp<Fence>& releaseFence,
         std::optional<uint32_t> currentMaxAcquiredBufferCount, bool fakeRelease) {
@@ -783,7 +873,7 @@ void BLASTBufferQueue::onFrameAvailable(const BufferItem& item) {
                 // need to flush the buffers before proceeding with the sync.
                 while (mNumFrameAvailable > 0) {
                     BQA_LOGD("waiting until no queued buffers");
-                    mCallbackCV.wait(_lock);
+                    waitForCallbackCVLocked(_lock);
                 }
             }
         }
@@ -809,7 +899,7 @@ void BLASTBufferQueue::onFrameAvailable(const BufferItem& item) {
             // instead of returning since we guarantee a buffer will be acquired for the sync.
             while (acquireNextBufferLocked(mSyncTransaction) == BufferQueue::NO_BUFFER_AVAILABLE) {
                 BQA_LOGD("waiting for available buffer");
-                mCallbackCV.wait(_lock);
+                waitForCallbackCVLocked(_lock);
             }
 
             // Only need a commit callback when syncing to ensure the buffer that's synced has been
@@ -1212,6 +1302,7 @@ void BLASTBufferQueue::createBufferQueue(sp<IGraphicBufferProducer>* outProducer
     consumer->setAllowExtraAcquire(true);
     LOG_ALWAYS_FATAL_IF(consumer == nullptr,
                         "BLASTBufferQueue: failed to create BufferQueueConsumer");
+    consumer->setAdaptiveBufferCountEnabled(flags::bq_adaptive_buffer_count());
 
     *outProducer = producer;
     *outConsumer = consumer;
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "BufferCountController"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <gui/BufferCountController.h>
+#include <gui/BufferQueueDefs.h>
+#include <system/graphics.h>
+#include <ui/PixelFormat.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <inttypes.h>
+
+namespace android {
+
+void BufferCountController::setEnabled(bool enabled) {
+    if (mEnabled == enabled) {
+        return;
+    }
+    mEnabled = enabled;
+    mExtraBuffers = INT32_MAX;
+    mLearned = false;
+    mWindowStart = 0;
+    mWindowMaxOccupancy = 0;
+    mWindowGrowths = 0;
+    mQuietWindows = 0;
+    mOverTargetSince = 0;
+}
+
+void BufferCountController::onOccupancyChange(size_t occupancy, nsecs_t now) {
+    if (!mEnabled) {
+        return;
+    }
+    if (mWindowStart == 0) {
+        mWindowStart = now;
+    }
+    mWindowMaxOccupancy = std::max(mWindowMaxOccupancy, occupancy);
+    if (now - mWindowStart >= EVALUATION_WINDOW) {
+        evaluateWindow(now);
+    }
+}
+
+void BufferCountController::evaluateWindow(nsecs_t now) {
+    // Besides the buffers the consumer may hold and the one the producer is
+    // drawing into, each queued buffer needs a buffer of its own.
+    const int needed = static_cast<int>(
+            std::min<size_t>(mWindowMaxOccupancy, BufferQueueDefs::NUM_BUFFER_SLOTS));
+
+    if (!mLearned) {
+        mExtraBuffers = needed + (mWindowGrowths > 0 ? 1 : 0);
+        mLearned = true;
+        mQuietWindows = 0;
+    } else if (mWindowGrowths > 0) {
+        mExtraBuffers = std::max(mExtraBuffers, needed) + 1;
+        mQuietWindows = 0;
+    } else if (needed > mExtraBuffers) {
+        mExtraBuffers = needed;
+        mQuietWindows = 0;
+    } else if (needed < mExtraBuffers) {
+        if (++mQuietWindows >= SHRINK_WINDOW_COUNT) {
+            mExtraBuffers--;
+            mQuietWindows = 0;
+        }
+    } else {
+        mQuietWindows = 0;
+    }
+    mExtraBuffers = std::min(mExtraBuffers, static_cast<int>(BufferQueueDefs::NUM_BUFFER_SLOTS));
+    ATRACE_INT("BufferCountController extra buffers", mExtraBuffers);
+
+    mWindowStart = now;
+    mWindowMaxOccupancy = 0;
+    mWindowGrowths = 0;
+}
+
+void BufferCountController::onTargetReached() {
+    if (!mEnabled) {
+        return;
+    }
+    ATRACE_NAME("BufferCountController grow");
+    mGrowthCount++;
+    mWindowGrowths++;
+    // Raise the target right away rather than waiting for the window to end,
+    // so that the producer can allocate.
+    if (mExtraBuffers < static_cast<int>(BufferQueueDefs::NUM_BUFFER_SLOTS)) {
+        mExtraBuffers++;
+    }
+    mQuietWindows = 0;
+}
+
+int BufferCountController::getTargetBufferCount(int minBufferCount, int maxBufferCount) const {
+    if (!mEnabled || mExtraBuffers >= maxBufferCount - minBufferCount) {
+        return maxBufferCount;
+    }
+    return std::clamp(minBufferCount + mExtraBuffers, minBufferCount, maxBufferCount);
+}
+
+bool BufferCountController::shouldTrim(int allocatedCount, int targetCount, nsecs_t now) {
+    if (!mEnabled || allocatedCount <= targetCount) {
+        mOverTargetSince = 0;
+        return false;
+    }
+    if (mOverTargetSince == 0) {
+        mOverTargetSince = now;
+    }
+    return now - mOverTargetSince >= IDLE_TIMEOUT;
+}
+
+void BufferCountController::onBuffersFreed(size_t count, size_t bytes) {
+    mFreedBufferCount += count;
+    mFreedBytes += bytes;
+    if (count > 0) {
+        mLastBufferBytes = bytes / count;
+    }
+    mOverTargetSince = 0;
+}
+
+size_t BufferCountController::estimateBufferBytes(uint32_t stride, uint32_t height,
+                                                  int32_t format, uint32_t layerCount) {
+    size_t bitsPerPixel;
+    switch (format) {
+        case HAL_PIXEL_FORMAT_YCBCR_P010:
+            bitsPerPixel = 24;
+            break;
+        case HAL_PIXEL_FORMAT_YCBCR_422_SP:
+        case HAL_PIXEL_FORMAT_YCBCR_422_I:
+        case HAL_PIXEL_FORMAT_YCBCR_422_888:
+        case HAL_PIXEL_FORMAT_RAW16:
+        case HAL_PIXEL_FORMAT_Y16:
+            bitsPerPixel = 16;
+            break;
+        case HAL_PIXEL_FORMAT_YCBCR_420_888:
+        case HAL_PIXEL_FORMAT_YCRCB_420_SP:
+        case HAL_PIXEL_FORMAT_YV12:
+        case HAL_PIXEL_FORMAT_RAW12:
+            bitsPerPixel = 12;
+            break;
+        case HAL_PIXEL_FORMAT_RAW10:
+            bitsPerPixel = 10;
+            break;
+        case HAL_PIXEL_FORMAT_Y8:
+        case HAL_PIXEL_FORMAT_BLOB:
+            bitsPerPixel = 8;
+            break;
+        default:
+            bitsPerPixel = bytesPerPixel(format) * 8;
+            break;
+    }
+    return static_cast<size_t>(stride) * height * bitsPerPixel / 8 * layerCount;
+}
+
+void BufferCountController::dump(const String8& prefix, String8* outResult, int minBufferCount,
+                                 int maxBufferCount) const {
+    if (!mEnabled) {
+        return;
+    }
+    const int target = getTargetBufferCount(minBufferCount, maxBufferCount);
+    // Memory currently not held compared to keeping every requested buffer.
+    const size_t savedBytes = static_cast<size_t>(maxBufferCount - target) * mLastBufferBytes;
+    outResult->appendFormat("%s  adaptive-buffer-count: target=%d/%d growths=%" PRIu64
+                            " freed=%" PRIu64 " (%" PRIu64 " KiB) saving=%zu KiB\n",
+                            prefix.c_str(), target, maxBufferCount, mGrowthCount, mFreedBufferCount,
+                            mFreedBytes / 1024, savedBytes / 1024);
+}
+
+} // namespace android
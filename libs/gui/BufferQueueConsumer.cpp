@@ -303,6 +303,7 @@ status_t BufferQueueConsumer::acquireBuffer(BufferItem* outBuffer,
 #ifndef NO_BINDER
         mCore->mOccupancyTracker.registerOccupancyChange(mCore->mQueue.size());
 #endif
+        mCore->mBufferCountController.onOccupancyChange(mCore->mQueue.size(), systemTime());
         VALIDATE_CONSISTENCY();
     }
 
@@ -478,6 +479,8 @@ status_t BufferQueueConsumer::releaseBuffer(int slot, uint64_t frameNumber,
     }
 
     sp<IProducerListener> listener;
+    sp<IProducerListener> discardListener;
+    std::vector<int32_t> discardedSlots;
     { // Autolock scope
         std::lock_guard<std::mutex> lock(mCore->mMutex);
 
@@ -520,6 +523,10 @@ status_t BufferQueueConsumer::releaseBuffer(int slot, uint64_t frameNumber,
         }
         BQ_LOGV("releaseBuffer: releasing slot %d", slot);
 
+        discardedSlots = mCore->trimIdleBuffersLocked();
+        if (!discardedSlots.empty()) {
+            discardListener = mCore->mConnectedProducerListener;
+        }
         mCore->mDequeueCondition.notify_all();
         VALIDATE_CONSISTENCY();
     } // Autolock scope
@@ -528,6 +535,9 @@ status_t BufferQueueConsumer::releaseBuffer(int slot, uint64_t frameNumber,
     if (listener != nullptr) {
         listener->onBufferReleased();
     }
+    if (discardListener != nullptr) {
+        discardListener->onBuffersDiscarded(discardedSlots);
+    }
 
     return NO_ERROR;
 }
@@ -856,4 +866,11 @@ void BufferQueueConsumer::setAllowExtraAcquire(bool allow) {
     mCore->mAllowExtraAcquire = allow;
 }
 
+void BufferQueueConsumer::setAdaptiveBufferCountEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mCore->mMutex);
+    mCore->mBufferCountController.setEnabled(enabled);
+    // The target may have changed in either direction.
+    mCore->mDequeueCondition.notify_all();
+}
+
 } // namespace android
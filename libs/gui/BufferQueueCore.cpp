@@ -160,6 +160,8 @@ void BufferQueueCore::dumpState(const String8& prefix, String8* outResult) const
                             mTransformHint, mFrameCounter);
     outResult->appendFormat("%s  mTransformHintInUse=%02x mAutoPrerotation=%d\n", prefix.c_str(),
                             mTransformHintInUse, mAutoPrerotation);
+    mBufferCountController.dump(prefix, outResult, getMinMaxBufferCountLocked(),
+                                getMaxBufferCountLocked());
 
     outResult->appendFormat("%sFIFO(%zu):\n", prefix.c_str(), mQueue.size());
 
@@ -323,6 +325,67 @@ void BufferQueueCore::discardFreeBuffersLocked() {
     VALIDATE_CONSISTENCY();
 }
 
+int BufferQueueCore::getAllocatedBufferCountLocked() const {
+    return static_cast<int>(mFreeBuffers.size() + mActiveBuffers.size());
+}
+
+int BufferQueueCore::getAdaptiveBufferCountLocked() const {
+    return mBufferCountController.getTargetBufferCount(getMinMaxBufferCountLocked(),
+                                                       getMaxBufferCountLocked());
+}
+
+bool BufferQueueCore::isAllocationCappedLocked(int dequeuedCount) const {
+    // Only blocking, non-shared queues can wait for a buffer to come back.
+    if (!mBufferCountController.isEnabled() || mAsyncMode || mDequeueBufferCannotBlock ||
+        mSharedBufferMode) {
+        return false;
+    }
+    const int allocatedCount = getAllocatedBufferCountLocked();
+    // If the producer holds every buffer, nothing will be released.
+    if (allocatedCount <= dequeuedCount) {
+        return false;
+    }
+    return allocatedCount >= getAdaptiveBufferCountLocked();
+}
+
+std::vector<int32_t> BufferQueueCore::trimIdleBuffersLocked() {
+    std::vector<int32_t> trimmedSlots;
+    if (!mBufferCountController.isEnabled() || mFreeBuffers.empty()) {
+        return trimmedSlots;
+    }
+
+    const int targetCount = getAdaptiveBufferCountLocked();
+    int allocatedCount = getAllocatedBufferCountLocked();
+    if (!mBufferCountController.shouldTrim(allocatedCount, targetCount, systemTime())) {
+        return trimmedSlots;
+    }
+
+    // mFreeBuffers is ordered by release time, so the front has been idle the
+    // longest.
+    size_t trimmedBytes = 0;
+    while (allocatedCount > targetCount && !mFreeBuffers.empty()) {
+        const int slot = mFreeBuffers.front();
+        mFreeBuffers.pop_front();
+        if (const sp<GraphicBuffer>& buffer = mSlots[slot].mGraphicBuffer; buffer != nullptr) {
+            trimmedBytes += BufferCountController::estimateBufferBytes(buffer->getStride(),
+                                                                       buffer->getHeight(),
+                                                                       buffer->getPixelFormat(),
+                                                                       buffer->getLayerCount());
+        }
+        mFreeSlots.insert(slot);
+        clearBufferSlotLocked(slot);
+        trimmedSlots.push_back(slot);
+        --allocatedCount;
+    }
+
+    BQ_LOGV("trimIdleBuffersLocked: freed %zu buffers (%zu bytes), target %d",
+            trimmedSlots.size(), trimmedBytes, targetCount);
+    mBufferCountController.onBuffersFreed(trimmedSlots.size(), trimmedBytes);
+
+    VALIDATE_CONSISTENCY();
+    return trimmedSlots;
+}
+
 bool BufferQueueCore::adjustAvailableSlotsLocked(int delta) {
     if (delta >= 0) {
         // If we're going to fail, do so before modifying anything
@@ -347,6 +347,12 @@ status_t BufferQueueProducer::waitForFreeSlotThenRelock(FreeSlotCaller caller,
                     if (slot != BufferQueueCore::INVALID_BUFFER_SLOT) {
                         *found = slot;
                     } else if (mCore->mAllowAllocation) {
+                        // No buffer is free, so waiting for one would stall
+                        // the producer. Grow the adaptive buffer count right
+                        // away instead.
+                        if (mCore->isAllocationCappedLocked(dequeuedCount)) {
+                            mCore->mBufferCountController.onTargetReached();
+                        }
                         *found = getFreeSlotLocked();
                     }
                 } else {
@@ -1096,6 +1102,7 @@ status_t BufferQueueProducer::queueBuffer(int slot,
 #ifndef NO_BINDER
         mCore->mOccupancyTracker.registerOccupancyChange(mCore->mQueue.size());
 #endif
+        mCore->mBufferCountController.onOccupancyChange(mCore->mQueue.size(), systemTime());
         // Take a ticket for the callback functions
         callbackTicket = mNextCallbackTicket++;
 
@@ -355,4 +355,59 @@ status_t BufferReleaseChannel::open(std::string name,
     return STATUS_OK;
 }
 
-} // namespace android::gui
\ No newline at end of file
+BufferReleaseChannel::ReleaseRing::ReleaseRing() {
+    for (size_t i = 0; i < kCapacity; i++) {
+        mCells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool BufferReleaseChannel::ReleaseRing::push(Entry entry) {
+    size_t position = mEnqueuePosition.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &mCells[position & (kCapacity - 1)];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (diff == 0) {
+            // The cell is free; try to claim it.
+            if (mEnqueuePosition.compare_exchange_weak(position, position + 1,
+                                                       std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The consumer hasn't caught up yet.
+            return false;
+        } else {
+            // Another producer claimed this cell.
+            position = mEnqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->entry = std::move(entry);
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool BufferReleaseChannel::ReleaseRing::pop(Entry& outEntry) {
+    const size_t position = mDequeuePosition.load(std::memory_order_relaxed);
+    Cell& cell = mCells[position & (kCapacity - 1)];
+    const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != position + 1) {
+        // Either empty, or a producer claimed the cell but hasn't published it yet.
+        return false;
+    }
+
+    mDequeuePosition.store(position + 1, std::memory_order_relaxed);
+    outEntry = std::move(cell.entry);
+    cell.entry.releaseFence = Fence::NO_FENCE;
+    cell.sequence.store(position + kCapacity, std::memory_order_release);
+    return true;
+}
+
+bool BufferReleaseChannel::ReleaseRing::empty() const {
+    const size_t position = mDequeuePosition.load(std::memory_order_relaxed);
+    const Cell& cell = mCells[position & (kCapacity - 1)];
+    return cell.sequence.load(std::memory_order_acquire) != position + 1;
+}
+
+} // namespace android::gui
@@ -21,8 +21,14 @@
 #include <com_android_graphics_libgui_flags.h>
 #include <gui/BufferItem.h>
 #include <gui/CpuConsumer.h>
+#include <pthread.h>
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #define CC_LOGV(x, ...) ALOGV("[%s] " x, mName.c_str(), ##__VA_ARGS__)
 // #define CC_LOGD(x, ...) ALOGD("[%s] " x, mName.c_str(), ##__VA_ARGS__)
 // #define CC_LOGI(x, ...) ALOGI("[%s] " x, mName.c_str(), ##__VA_ARGS__)
@@ -31,12 +37,21 @@
 
 namespace android {
 
+struct CpuConsumer::PrefetchThreadState {
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool started = false;
+    bool pending = false;
+    bool stopped = false;
+};
+
 #if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(WB_CONSUMER_BASE_OWNS_BQ)
 CpuConsumer::CpuConsumer(size_t maxLockedBuffers, bool controlledByApp,
                          bool isConsumerSurfaceFlinger)
       : ConsumerBase(controlledByApp, isConsumerSurfaceFlinger),
         mMaxLockedBuffers(maxLockedBuffers),
-        mCurrentLockedBuffers(0) {
+        mCurrentLockedBuffers(0),
+        mPrefetchThread(std::make_shared<PrefetchThreadState>()) {
     // Create tracking entries for locked buffers
     mAcquiredBuffers.insertAt(0, maxLockedBuffers);
 
@@ -49,7 +64,8 @@ CpuConsumer::CpuConsumer(const sp<IGraphicBufferConsumer>& bq, size_t maxLockedB
                          bool controlledByApp)
       : ConsumerBase(bq, controlledByApp),
         mMaxLockedBuffers(maxLockedBuffers),
-        mCurrentLockedBuffers(0) {
+        mCurrentLockedBuffers(0),
+        mPrefetchThread(std::make_shared<PrefetchThreadState>()) {
     // Create tracking entries for locked buffers
     mAcquiredBuffers.insertAt(0, maxLockedBuffers);
 
@@ -175,6 +191,25 @@ status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
         return NOT_ENOUGH_DATA;
     }
 
+    // A buffer being prefetched is older than anything still in the queue.
+    while (mPrefetchedBuffers.empty() && mPrefetchesInFlight > 0) {
+        mPrefetchCondition.wait(mMutex);
+    }
+
+    if (!mPrefetchedBuffers.empty()) {
+        PrefetchedBuffer prefetched = std::move(mPrefetchedBuffers.front());
+        mPrefetchedBuffers.pop_front();
+        requestPrefetch();
+
+        if (prefetched.status != OK) {
+            releaseBufferLocked(prefetched.item.mSlot, prefetched.item.mGraphicBuffer);
+            return prefetched.status;
+        }
+        *nativeBuffer = prefetched.buffer;
+        trackLockedBufferLocked(prefetched.item, *nativeBuffer);
+        return OK;
+    }
+
     BufferItem b;
     err = acquireBufferLocked(&b, 0);
     if (err != OK) {
@@ -195,18 +230,23 @@ status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
         return err;
     }
 
+    trackLockedBufferLocked(b, *nativeBuffer);
+    requestPrefetch();
+
+    return OK;
+}
+
+void CpuConsumer::trackLockedBufferLocked(const BufferItem& item, const LockedBuffer& buffer) {
     // find an unused AcquiredBuffer
     size_t lockedIdx = findAcquiredBufferLocked(AcquiredBuffer::kUnusedId);
     ALOG_ASSERT(lockedIdx < mMaxLockedBuffers);
     AcquiredBuffer& ab = mAcquiredBuffers.editItemAt(lockedIdx);
 
-    ab.mSlot = b.mSlot;
-    ab.mGraphicBuffer = b.mGraphicBuffer;
-    ab.mLockedBufferId = getLockedBufferId(*nativeBuffer);
+    ab.mSlot = item.mSlot;
+    ab.mGraphicBuffer = item.mGraphicBuffer;
+    ab.mLockedBufferId = getLockedBufferId(buffer);
 
     mCurrentLockedBuffers++;
-
-    return OK;
 }
 
 status_t CpuConsumer::unlockBuffer(const LockedBuffer &nativeBuffer) {
@@ -237,8 +277,114 @@ status_t CpuConsumer::unlockBuffer(const LockedBuffer &nativeBuffer) {
     ab.reset();
 
     mCurrentLockedBuffers--;
+    requestPrefetch();
 
     return OK;
 }
 
+void CpuConsumer::setPrefetchCount(size_t count) {
+    Mutex::Autolock _l(mMutex);
+    mPrefetchCount = std::min(count, mMaxLockedBuffers);
+    if (mPrefetchCount == 0 || mAbandoned) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(mPrefetchThread->mutex);
+        if (!mPrefetchThread->started) {
+            mPrefetchThread->started = true;
+            // The thread only promotes the consumer while it has work to do,
+            // so it never keeps the consumer alive on its own.
+            std::thread thread([state = mPrefetchThread, weakThis = wp<CpuConsumer>(this)]() {
+                while (true) {
+                    {
+                        std::unique_lock lock(state->mutex);
+                        state->condition.wait(lock,
+                                              [&] { return state->pending || state->stopped; });
+                        if (state->stopped) {
+                            return;
+                        }
+                        state->pending = false;
+                    }
+                    sp<CpuConsumer> consumer = weakThis.promote();
+                    if (consumer == nullptr) {
+                        return;
+                    }
+                    consumer->prefetchBuffers();
+                }
+            });
+            pthread_setname_np(thread.native_handle(), "CpuConsumerPrefetch");
+            thread.detach();
+        }
+    }
+    requestPrefetch();
+}
+
+void CpuConsumer::requestPrefetch() {
+    std::lock_guard lock(mPrefetchThread->mutex);
+    if (mPrefetchThread->started) {
+        mPrefetchThread->pending = true;
+        mPrefetchThread->condition.notify_one();
+    }
+}
+
+void CpuConsumer::prefetchBuffers() {
+    while (true) {
+        BufferItem item;
+        {
+            Mutex::Autolock _l(mMutex);
+            const size_t prefetching = mPrefetchedBuffers.size() + mPrefetchesInFlight;
+            if (mAbandoned || prefetching >= mPrefetchCount ||
+                mCurrentLockedBuffers + prefetching >= mMaxLockedBuffers) {
+                return;
+            }
+            if (acquireBufferLocked(&item, 0) != OK) {
+                return;
+            }
+            if (item.mGraphicBuffer == nullptr) {
+                item.mGraphicBuffer = mSlots[item.mSlot].mGraphicBuffer;
+            }
+            mPrefetchesInFlight++;
+        }
+
+        // Wait for the producer and lock without holding mMutex, so that
+        // buffers already handed out can still be unlocked.
+        LockedBuffer buffer;
+        const status_t status = lockBufferItem(item, &buffer);
+
+        Mutex::Autolock _l(mMutex);
+        mPrefetchesInFlight--;
+        mPrefetchCondition.broadcast();
+        if (mAbandoned) {
+            if (status == OK) {
+                item.mGraphicBuffer->unlock();
+            }
+            return;
+        }
+        mPrefetchedBuffers.push_back({std::move(item), buffer, status});
+    }
+}
+
+void CpuConsumer::onFrameAvailable(const BufferItem& item) {
+    requestPrefetch();
+    ConsumerBase::onFrameAvailable(item);
+}
+
+void CpuConsumer::abandonLocked() {
+    {
+        std::lock_guard lock(mPrefetchThread->mutex);
+        mPrefetchThread->stopped = true;
+        mPrefetchThread->condition.notify_one();
+    }
+    for (const auto& prefetched : mPrefetchedBuffers) {
+        if (prefetched.status == OK) {
+            prefetched.item.mGraphicBuffer->unlock();
+        }
+    }
+    mPrefetchedBuffers.clear();
+    mPrefetchCondition.broadcast();
+
+    ConsumerBase::abandonLocked();
+}
+
 } // namespace android
@@ -25,6 +25,7 @@
 #include <utils/Log.h>
 
 #include <algorithm>
+#include <cstring>
 #include <limits>
 #include <numeric>
 
@@ -88,6 +89,87 @@ void FrameEvents::checkFencesForCompletion() {
     releaseFence->getSignalTime();
 }
 
+// ============================================================================
+// FrameEventsSnapshot
+// ============================================================================
+
+FrameEventsSnapshot::FrameEventsSnapshot(const FrameEvents& frame)
+      : frameNumber(frame.frameNumber),
+        flags((frame.valid ? VALID : 0) |
+              (frame.addPostCompositeCalled ? ADD_POST_COMPOSITE_CALLED : 0) |
+              (frame.addReleaseCalled ? ADD_RELEASE_CALLED : 0) |
+              (frame.hasAcquireInfo() ? HAS_ACQUIRE : 0)),
+        requestedPresentTime(frame.requestedPresentTime),
+        latchTime(frame.latchTime),
+        firstRefreshStartTime(frame.firstRefreshStartTime),
+        lastRefreshStartTime(frame.lastRefreshStartTime),
+        dequeueReadyTime(frame.dequeueReadyTime),
+        acquireTime(frame.acquireFence->getCachedSignalTime()),
+        gpuCompositionDoneTime(frame.gpuCompositionDoneFence->getCachedSignalTime()),
+        displayPresentTime(frame.displayPresentFence->getCachedSignalTime()),
+        releaseTime(frame.releaseFence->getCachedSignalTime()) {}
+
+// ============================================================================
+// FrameEventsSnapshotRing
+// ============================================================================
+
+void FrameEventsSnapshotRing::publish(const FrameEvents& frame) {
+    if (!frame.valid) {
+        return;
+    }
+    store(mEntries[frame.frameNumber % CAPACITY], FrameEventsSnapshot(frame));
+}
+
+void FrameEventsSnapshotRing::invalidate(uint64_t frameNumber) {
+    Entry& entry = mEntries[frameNumber % CAPACITY];
+    // Only the writer modifies entries, so this read can't race. The frame
+    // number is the first word of a snapshot.
+    if (entry.words[0].load(std::memory_order_relaxed) == frameNumber) {
+        store(entry, FrameEventsSnapshot());
+    }
+}
+
+void FrameEventsSnapshotRing::store(Entry& entry, const FrameEventsSnapshot& snapshot) {
+    std::array<uint64_t, WORD_COUNT> words;
+    std::memcpy(words.data(), &snapshot, sizeof(snapshot));
+
+    const uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+    entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORD_COUNT; i++) {
+        entry.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool FrameEventsSnapshotRing::read(uint64_t frameNumber,
+                                   FrameEventsSnapshot* outSnapshot) const {
+    // A reader only retries if the producer republished the frame while it
+    // was being copied, which takes far less time than producing a frame.
+    constexpr int kMaxAttempts = 4;
+
+    const Entry& entry = mEntries[frameNumber % CAPACITY];
+    std::array<uint64_t, WORD_COUNT> words;
+    for (int attempt = 0; attempt < kMaxAttempts; attempt++) {
+        const uint32_t before = entry.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        for (size_t i = 0; i < WORD_COUNT; i++) {
+            words[i] = entry.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry.sequence.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+
+        std::memcpy(outSnapshot, words.data(), sizeof(*outSnapshot));
+        return outSnapshot->frameNumber == frameNumber &&
+                (outSnapshot->flags & FrameEventsSnapshot::VALID);
+    }
+    return false;
+}
+
 static void dumpFenceTime(std::string& outString, const char* name, bool pending,
                           const FenceTime& fenceTime) {
     StringAppendF(&outString, "--- %s", name);
@@ -266,6 +348,7 @@ void ProducerFrameEventHistory::updateAcquireFence(
         // ready for the consumer when posted.
         frame->acquireFence = std::make_shared<FenceTime>(frame->postedTime);
     }
+    mSnapshots.publish(*frame);
 }
 
 void ProducerFrameEventHistory::applyDelta(
@@ -300,6 +383,9 @@ void ProducerFrameEventHistory::applyDelta(
 
         if (frame.frameNumber != d.mFrameNumber) {
             // We got a new frame. Initialize some of the fields.
+            if (frame.valid) {
+                mSnapshots.invalidate(frame.frameNumber);
+            }
             frame.frameNumber = d.mFrameNumber;
             frame.acquireFence = FenceTime::NO_FENCE;
             frame.gpuCompositionDoneFence = FenceTime::NO_FENCE;
@@ -315,6 +401,7 @@ void ProducerFrameEventHistory::applyDelta(
                 &frame.displayPresentFence, d.mDisplayPresentFence);
         applyFenceDelta(&mReleaseTimeline,
                 &frame.releaseFence, d.mReleaseFence);
+        mSnapshots.publish(frame);
     }
 }
 
@@ -323,6 +410,9 @@ void ProducerFrameEventHistory::updateSignalTimes() {
     mGpuCompositionDoneTimeline.updateSignalTimes();
     mPresentTimeline.updateSignalTimes();
     mReleaseTimeline.updateSignalTimes();
+    for (const auto& frame : mFrames) {
+        mSnapshots.publish(frame);
+    }
 }
 
 void ProducerFrameEventHistory::applyFenceDelta(FenceTimeline* timeline,
@@ -49,11 +49,22 @@ status_t StreamSplitter::createSplitter(
 
     sp<StreamSplitter> splitter(new StreamSplitter(inputQueue));
     status_t status = splitter->mInput->consumerConnect(splitter, false);
-    if (status == NO_ERROR) {
-        splitter->mInput->setConsumerName(String8("StreamSplitter"));
-        *outSplitter = splitter;
+    if (status != NO_ERROR) {
+        return status;
     }
-    return status;
+
+    // Buffers are not detached from the input while the outputs hold them, so
+    // the input must allow all of them to be acquired at once.
+    status = splitter->mInput->setMaxAcquiredBufferCount(MAX_OUTSTANDING_BUFFERS);
+    if (status != NO_ERROR) {
+        ALOGE("createSplitter: failed to set max acquired buffer count (%d)", status);
+        splitter->mInput->consumerDisconnect();
+        return status;
+    }
+
+    splitter->mInput->setConsumerName(String8("StreamSplitter"));
+    *outSplitter = splitter;
+    return NO_ERROR;
 }
 
 StreamSplitter::StreamSplitter(const sp<IGraphicBufferConsumer>& inputQueue)
@@ -125,22 +136,25 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
     }
     ++mOutstandingBuffers;
 
-    // Acquire and detach the buffer from the input
+    // Acquire the buffer from the input. It stays attached to its input slot
+    // until every output has released it.
     BufferItem bufferItem;
     status_t status = mInput->acquireBuffer(&bufferItem, /* presentWhen */ 0);
     LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
             "acquiring buffer from input failed (%d)", status);
 
-    ALOGV("acquired buffer %#" PRIx64 " from input",
-            bufferItem.mGraphicBuffer->getId());
+    if (bufferItem.mGraphicBuffer != nullptr) {
+        mInputSlots[bufferItem.mSlot] = bufferItem.mGraphicBuffer;
+    }
+    const sp<GraphicBuffer> buffer = mInputSlots[bufferItem.mSlot];
+    LOG_ALWAYS_FATAL_IF(buffer == nullptr, "no buffer cached for input slot %d",
+            bufferItem.mSlot);
 
-    status = mInput->detachBuffer(bufferItem.mSlot);
-    LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
-            "detaching buffer from input failed (%d)", status);
+    ALOGV("acquired buffer %#" PRIx64 " from input", buffer->getId());
 
     // Initialize our reference count for this buffer
-    mBuffers.add(bufferItem.mGraphicBuffer->getId(),
-            new BufferTracker(bufferItem.mGraphicBuffer));
+    mBuffers.add(buffer->getId(),
+            new BufferTracker(buffer, bufferItem.mSlot, bufferItem.mFrameNumber));
 
     IGraphicBufferProducer::QueueBufferInput queueInput(
             bufferItem.mTimestamp, bufferItem.mIsAutoTimestamp,
@@ -152,14 +166,13 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
     Vector<sp<IGraphicBufferProducer> >::iterator output = mOutputs.begin();
     for (; output != mOutputs.end(); ++output) {
         int slot;
-        status = (*output)->attachBuffer(&slot, bufferItem.mGraphicBuffer);
+        status = (*output)->attachBuffer(&slot, buffer);
         if (status == NO_INIT) {
             // If we just discovered that this output has been abandoned, note
             // that, increment the release count so that we still release this
             // buffer eventually, and move on to the next output
             onAbandonedLocked();
-            mBuffers.editValueFor(bufferItem.mGraphicBuffer->getId())->
-                    incrementReleaseCountLocked();
+            mBuffers.editValueFor(buffer->getId())->incrementReleaseCount();
             continue;
         } else {
             LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
@@ -173,8 +186,7 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
             // that, increment the release count so that we still release this
             // buffer eventually, and move on to the next output
             onAbandonedLocked();
-            mBuffers.editValueFor(bufferItem.mGraphicBuffer->getId())->
-                    incrementReleaseCountLocked();
+            mBuffers.editValueFor(buffer->getId())->incrementReleaseCount();
             continue;
         } else {
             LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
@@ -182,14 +194,13 @@ void StreamSplitter::onFrameAvailable(const BufferItem& /* item */) {
         }
 
         ALOGV("queued buffer %#" PRIx64 " to output %p",
-                bufferItem.mGraphicBuffer->getId(), output->get());
+                buffer->getId(), output->get());
     }
 }
 
 void StreamSplitter::onBufferReleasedByOutput(
         const sp<IGraphicBufferProducer>& from) {
     ATRACE_CALL();
-    Mutex::Autolock lock(mMutex);
 
     sp<GraphicBuffer> buffer;
     sp<Fence> fence;
@@ -197,6 +208,7 @@ void StreamSplitter::onBufferReleasedByOutput(
     if (status == NO_INIT) {
         // If we just discovered that this output has been abandoned, note that,
         // but we can't do anything else, since buffer is invalid
+        Mutex::Autolock lock(mMutex);
         onAbandonedLocked();
         return;
     } else {
@@ -207,49 +219,77 @@ void StreamSplitter::onBufferReleasedByOutput(
     ALOGV("detached buffer %#" PRIx64 " from output %p",
           buffer->getId(), from.get());
 
-    const sp<BufferTracker>& tracker = mBuffers.editValueFor(buffer->getId());
+    sp<BufferTracker> tracker;
+    size_t outputCount;
+    {
+        Mutex::Autolock lock(mMutex);
+        tracker = mBuffers.valueFor(buffer->getId());
+        outputCount = mOutputs.size();
+    }
 
     // Merge the release fence of the incoming buffer so that the fence we send
     // back to the input includes all of the outputs' fences
     tracker->mergeFence(fence);
 
     // Check to see if this is the last outstanding reference to this buffer
-    size_t releaseCount = tracker->incrementReleaseCountLocked();
+    size_t releaseCount = tracker->incrementReleaseCount();
     ALOGV("buffer %#" PRIx64 " reference count %zu (of %zu)", buffer->getId(),
-            releaseCount, mOutputs.size());
-    if (releaseCount < mOutputs.size()) {
+            releaseCount, outputCount);
+    if (releaseCount < outputCount) {
         return;
     }
 
+    Mutex::Autolock lock(mMutex);
+    releaseToInputLocked(tracker);
+}
+
+void StreamSplitter::releaseToInputLocked(const sp<BufferTracker>& tracker) {
+    const uint64_t bufferId = tracker->getBuffer()->getId();
+
+    // We no longer need to track the buffer once every output has released
+    // it
+    mBuffers.removeItem(bufferId);
+
     // If we've been abandoned, we can't return the buffer to the input, so just
     // stop tracking it and move on
     if (mIsAbandoned) {
-        mBuffers.removeItem(buffer->getId());
         return;
     }
 
-    // Attach and release the buffer back to the input
-    int consumerSlot;
-    status = mInput->attachBuffer(&consumerSlot, tracker->getBuffer());
-    LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
-            "attaching buffer to input failed (%d)", status);
-
-    status = mInput->releaseBuffer(consumerSlot, /* frameNumber */ 0,
-            EGL_NO_DISPLAY, EGL_NO_SYNC_KHR, tracker->getMergedFence());
-    LOG_ALWAYS_FATAL_IF(status != NO_ERROR,
+    // Release the buffer back to the slot it was acquired from. The input may
+    // have freed the slot in the meantime, in which case the buffer is simply
+    // dropped.
+    status_t status = mInput->releaseBuffer(tracker->getSlot(),
+            tracker->getFrameNumber(), EGL_NO_DISPLAY, EGL_NO_SYNC_KHR,
+            tracker->getMergedFence());
+    LOG_ALWAYS_FATAL_IF(status != NO_ERROR &&
+            status != IGraphicBufferConsumer::STALE_BUFFER_SLOT,
             "releasing buffer to input failed (%d)", status);
 
-    ALOGV("released buffer %#" PRIx64 " to input", buffer->getId());
-
-    // We no longer need to track the buffer once it has been returned to the
-    // input
-    mBuffers.removeItem(buffer->getId());
+    ALOGV("released buffer %#" PRIx64 " to input", bufferId);
 
     // Notify any waiting onFrameAvailable calls
     --mOutstandingBuffers;
     mReleaseCondition.signal();
 }
 
+void StreamSplitter::onBuffersReleased() {
+    Mutex::Autolock lock(mMutex);
+    if (mIsAbandoned) {
+        return;
+    }
+
+    uint64_t mask = 0;
+    if (mInput->getReleasedBuffers(&mask) != NO_ERROR) {
+        return;
+    }
+    for (int slot = 0; slot < BufferQueueDefs::NUM_BUFFER_SLOTS; ++slot) {
+        if (mask & (1ULL << slot)) {
+            mInputSlots[slot].clear();
+        }
+    }
+}
+
 void StreamSplitter::onAbandonedLocked() {
     ALOGE("one of my outputs has abandoned me");
     if (!mIsAbandoned) {
@@ -275,12 +315,20 @@ void StreamSplitter::OutputListener::binderDied(const wp<IBinder>& /* who */) {
     mSplitter->onAbandonedLocked();
 }
 
-StreamSplitter::BufferTracker::BufferTracker(const sp<GraphicBuffer>& buffer)
-      : mBuffer(buffer), mMergedFence(Fence::NO_FENCE), mReleaseCount(0) {}
+StreamSplitter::BufferTracker::BufferTracker(const sp<GraphicBuffer>& buffer,
+        int slot, uint64_t frameNumber)
+      : mBuffer(buffer), mSlot(slot), mFrameNumber(frameNumber),
+        mMergedFence(Fence::NO_FENCE), mReleaseCount(0) {}
 
 StreamSplitter::BufferTracker::~BufferTracker() {}
 
+sp<Fence> StreamSplitter::BufferTracker::getMergedFence() const {
+    std::lock_guard lock(mFenceMutex);
+    return mMergedFence;
+}
+
 void StreamSplitter::BufferTracker::mergeFence(const sp<Fence>& with) {
+    std::lock_guard lock(mFenceMutex);
     mMergedFence = Fence::merge(String8("StreamSplitter"), mMergedFence, with);
 }
 
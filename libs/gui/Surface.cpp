@@ -245,6 +245,7 @@ void Surface::enableFrameTimestamps(bool enable) {
         mFrameEventHistory->applyDelta(delta);
     }
     mEnableFrameTimestamps = enable;
+    updateFrameTimestampsQueryableLocked();
 }
 
 status_t Surface::getCompositorTiming(
@@ -269,8 +270,10 @@ status_t Surface::getCompositorTiming(
     return NO_ERROR;
 }
 
+// Events is either FrameEvents or FrameEventsSnapshot.
+template <typename Events>
 static bool checkConsumerForUpdates(
-        const FrameEvents* e, const uint64_t lastFrameNumber,
+        const Events* e, const uint64_t lastFrameNumber,
         const nsecs_t* outLatchTime,
         const nsecs_t* outFirstRefreshStartTime,
         const nsecs_t* outLastRefreshStartTime,
@@ -310,6 +313,14 @@ static void getFrameTimestamp(nsecs_t *dst, const nsecs_t& src) {
     }
 }
 
+static nsecs_t fenceSignalTimeToTimestamp(nsecs_t signalTime) {
+    return (signalTime == Fence::SIGNAL_TIME_PENDING) ?
+                NATIVE_WINDOW_TIMESTAMP_PENDING :
+            (signalTime == Fence::SIGNAL_TIME_INVALID) ?
+                NATIVE_WINDOW_TIMESTAMP_INVALID :
+            signalTime;
+}
+
 static void getFrameTimestampFence(nsecs_t *dst,
         const std::shared_ptr<FenceTime>& src, bool fenceShouldBeKnown) {
     if (dst != nullptr) {
@@ -318,15 +329,101 @@ static void getFrameTimestampFence(nsecs_t *dst,
             return;
         }
 
-        nsecs_t signalTime = src->getSignalTime();
-        *dst = (signalTime == Fence::SIGNAL_TIME_PENDING) ?
-                    NATIVE_WINDOW_TIMESTAMP_PENDING :
-                (signalTime == Fence::SIGNAL_TIME_INVALID) ?
-                    NATIVE_WINDOW_TIMESTAMP_INVALID :
-                signalTime;
+        *dst = fenceSignalTimeToTimestamp(src->getSignalTime());
+    }
+}
+
+// Fix up the GPU completion fence at this layer -- eglGetFrameTimestampsANDROID() expects
+// that EGL_FIRST_COMPOSITION_GPU_FINISHED_TIME_ANDROID > EGL_RENDERING_COMPLETE_TIME_ANDROID.
+// This is typically true, but SurfaceFlinger may opt to cache prior GPU composition results,
+// which breaks that assumption, so zero out GPU composition time.
+static void fixUpGpuCompositionDoneTime(nsecs_t* outGpuCompositionDoneTime,
+        nsecs_t acquireTime, nsecs_t firstRefreshStartTime) {
+    if (outGpuCompositionDoneTime != nullptr
+            && *outGpuCompositionDoneTime > 0 && (acquireTime > 0 || firstRefreshStartTime > 0)
+            && *outGpuCompositionDoneTime <= std::max(acquireTime, firstRefreshStartTime)) {
+        *outGpuCompositionDoneTime = 0;
     }
 }
 
+bool Surface::getFrameTimestampsFromSnapshot(uint64_t frameNumber,
+        nsecs_t* outRequestedPresentTime, nsecs_t* outAcquireTime,
+        nsecs_t* outLatchTime, nsecs_t* outFirstRefreshStartTime,
+        nsecs_t* outLastRefreshStartTime, nsecs_t* outGpuCompositionDoneTime,
+        nsecs_t* outDisplayPresentTime, nsecs_t* outDequeueReadyTime,
+        nsecs_t* outReleaseTime) const {
+    if (!mFrameTimestampsQueryable.load(std::memory_order_acquire)) {
+        return false;
+    }
+    if (outDisplayPresentTime != nullptr &&
+        !mFrameTimestampsQueryableSupportsPresent.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    FrameEventsSnapshot events;
+    if (!mFrameEventHistory->getSnapshot(frameNumber, &events)) {
+        return false;
+    }
+    if (checkConsumerForUpdates(&events,
+            mLastQueuedFrameNumber.load(std::memory_order_acquire),
+            outLatchTime, outFirstRefreshStartTime, outLastRefreshStartTime,
+            outGpuCompositionDoneTime, outDisplayPresentTime,
+            outDequeueReadyTime, outReleaseTime)) {
+        return false;
+    }
+
+    // Fence times are resolved lazily: a fence that hadn't signaled when the
+    // snapshot was published is checked again on the locked path.
+    auto isPending = [](const nsecs_t* dst, nsecs_t signalTime, bool fenceShouldBeKnown) {
+        return dst != nullptr && fenceShouldBeKnown && signalTime == Fence::SIGNAL_TIME_PENDING;
+    };
+    const bool needsAcquireTime =
+            outAcquireTime != nullptr || outGpuCompositionDoneTime != nullptr;
+    if ((needsAcquireTime && events.hasAcquireInfo() &&
+         events.acquireTime == Fence::SIGNAL_TIME_PENDING) ||
+        isPending(outGpuCompositionDoneTime, events.gpuCompositionDoneTime,
+                  events.hasGpuCompositionDoneInfo()) ||
+        isPending(outDisplayPresentTime, events.displayPresentTime,
+                  events.hasDisplayPresentInfo()) ||
+        isPending(outReleaseTime, events.releaseTime, events.hasReleaseInfo())) {
+        return false;
+    }
+
+    auto getFenceTimestamp = [](nsecs_t* dst, nsecs_t signalTime, bool fenceShouldBeKnown) {
+        if (dst != nullptr) {
+            *dst = fenceShouldBeKnown ? fenceSignalTimeToTimestamp(signalTime)
+                                      : NATIVE_WINDOW_TIMESTAMP_PENDING;
+        }
+    };
+
+    getFrameTimestamp(outRequestedPresentTime, events.requestedPresentTime);
+    getFrameTimestamp(outLatchTime, events.latchTime);
+
+    nsecs_t firstRefreshStartTime = NATIVE_WINDOW_TIMESTAMP_INVALID;
+    getFrameTimestamp(&firstRefreshStartTime, events.firstRefreshStartTime);
+    if (outFirstRefreshStartTime) {
+        *outFirstRefreshStartTime = firstRefreshStartTime;
+    }
+
+    getFrameTimestamp(outLastRefreshStartTime, events.lastRefreshStartTime);
+    getFrameTimestamp(outDequeueReadyTime, events.dequeueReadyTime);
+
+    nsecs_t acquireTime = NATIVE_WINDOW_TIMESTAMP_INVALID;
+    getFenceTimestamp(&acquireTime, events.acquireTime, events.hasAcquireInfo());
+    if (outAcquireTime != nullptr) {
+        *outAcquireTime = acquireTime;
+    }
+
+    getFenceTimestamp(outGpuCompositionDoneTime, events.gpuCompositionDoneTime,
+                      events.hasGpuCompositionDoneInfo());
+    getFenceTimestamp(outDisplayPresentTime, events.displayPresentTime,
+                      events.hasDisplayPresentInfo());
+    getFenceTimestamp(outReleaseTime, events.releaseTime, events.hasReleaseInfo());
+
+    fixUpGpuCompositionDoneTime(outGpuCompositionDoneTime, acquireTime, firstRefreshStartTime);
+    return true;
+}
+
 status_t Surface::getFrameTimestamps(uint64_t frameNumber,
         nsecs_t* outRequestedPresentTime, nsecs_t* outAcquireTime,
         nsecs_t* outLatchTime, nsecs_t* outFirstRefreshStartTime,
@@ -335,6 +432,16 @@ status_t Surface::getFrameTimestamps(uint64_t frameNumber,
         nsecs_t* outReleaseTime) {
     ATRACE_CALL();
 
+    // Frame pacing libraries call this every frame from the render thread, so
+    // answer from the published snapshots when possible instead of contending
+    // with queueBuffer and dequeueBuffer for mMutex.
+    if (getFrameTimestampsFromSnapshot(frameNumber, outRequestedPresentTime, outAcquireTime,
+            outLatchTime, outFirstRefreshStartTime, outLastRefreshStartTime,
+            outGpuCompositionDoneTime, outDisplayPresentTime, outDequeueReadyTime,
+            outReleaseTime)) {
+        return NO_ERROR;
+    }
+
     Mutex::Autolock lock(mMutex);
 
     if (!mEnableFrameTimestamps) {
@@ -398,15 +505,10 @@ status_t Surface::getFrameTimestamps(uint64_t frameNumber,
     getFrameTimestampFence(outReleaseTime, events->releaseFence,
             events->hasReleaseInfo());
 
-    // Fix up the GPU completion fence at this layer -- eglGetFrameTimestampsANDROID() expects
-    // that EGL_FIRST_COMPOSITION_GPU_FINISHED_TIME_ANDROID > EGL_RENDERING_COMPLETE_TIME_ANDROID.
-    // This is typically true, but SurfaceFlinger may opt to cache prior GPU composition results,
-    // which breaks that assumption, so zero out GPU composition time.
-    if (outGpuCompositionDoneTime != nullptr
-            && *outGpuCompositionDoneTime > 0 && (acquireTime > 0 || firstRefreshStartTime > 0)
-            && *outGpuCompositionDoneTime <= std::max(acquireTime, firstRefreshStartTime)) {
-        *outGpuCompositionDoneTime = 0;
-    }
+    fixUpGpuCompositionDoneTime(outGpuCompositionDoneTime, acquireTime, firstRefreshStartTime);
+
+    // Fences resolved above can now be answered without the lock.
+    mFrameEventHistory->publishSnapshot(*events);
 
     return NO_ERROR;
 }
@@ -1164,6 +1266,7 @@ void Surface::onBufferQueuedLocked(int slot, sp<Fence> fence,
     }
 
     mLastFrameNumber = mNextFrameNumber;
+    mLastQueuedFrameNumber.store(mLastFrameNumber, std::memory_order_release);
 
     mDefaultWidth = output.width;
     mDefaultHeight = output.height;
@@ -1429,15 +1532,21 @@ void Surface::querySupportedTimestampsLocked() const {
     binder::Status status =
             composerServiceAIDL()->getSupportedFrameTimestamps(&supportedFrameTimestamps);
 
-    if (!status.isOk()) {
-        return;
-    }
-
-    for (auto sft : supportedFrameTimestamps) {
-        if (sft == FrameEvent::DISPLAY_PRESENT) {
-            mFrameTimestampsSupportsPresent = true;
+    if (status.isOk()) {
+        for (auto sft : supportedFrameTimestamps) {
+            if (sft == FrameEvent::DISPLAY_PRESENT) {
+                mFrameTimestampsSupportsPresent = true;
+            }
         }
     }
+    updateFrameTimestampsQueryableLocked();
+}
+
+void Surface::updateFrameTimestampsQueryableLocked() const {
+    mFrameTimestampsQueryableSupportsPresent.store(mFrameTimestampsSupportsPresent,
+                                                   std::memory_order_relaxed);
+    mFrameTimestampsQueryable.store(mEnableFrameTimestamps && mQueriedSupportedTimestamps,
+                                    std::memory_order_release);
 }
 
 int Surface::query(int what, int* value) const {
@@ -2144,6 +2253,7 @@ int Surface::disconnect(int api, IGraphicBufferProducer::DisconnectMode mode) {
         mStickyTransform = 0;
         mAutoPrerotation = false;
         mEnableFrameTimestamps = false;
+        updateFrameTimestampsQueryableLocked();
         mMaxBufferCount = NUM_BUFFER_SLOTS;
 
         if (api == NATIVE_WINDOW_API_CPU) {
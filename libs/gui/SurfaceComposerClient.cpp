@@ -471,6 +471,24 @@ void TransactionCompletedListener::addSurfaceControlToCallbacks(
 }
 
 void TransactionCompletedListener::onTransactionCompleted(ListenerStats listenerStats) {
+    std::shared_ptr<gui::TransactionCompletionChannel::ConsumerEndpoint> channel;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        channel = mCompletionChannel;
+    }
+    if (!channel) {
+        dispatchTransactionCompleted(std::move(listenerStats));
+        return;
+    }
+
+    // SurfaceFlinger falls back to binder when a batch cannot go through the channel. Batches it
+    // published before that must be dispatched first.
+    std::lock_guard<std::mutex> lock(mCompletionChannelReadMutex);
+    readCompletionChannelLocked(*channel);
+    dispatchTransactionCompleted(std::move(listenerStats));
+}
+
+void TransactionCompletedListener::dispatchTransactionCompleted(ListenerStats listenerStats) {
     std::unordered_map<CallbackId, CallbackTranslation, CallbackIdHash> callbacksMap;
     {
         std::lock_guard<std::mutex> lock(mMutex);
@@ -610,6 +628,127 @@ void TransactionCompletedListener::onTransactionCompleted(ListenerStats listener
     }
 }
 
+status_t TransactionCompletedListener::enableCompletionChannel() {
+    if (!com::android::graphics::libgui::flags::transaction_completion_channel()) {
+        return INVALID_OPERATION;
+    }
+
+    // Serializes enabling and disabling without holding mMutex across the binder calls.
+    std::lock_guard<std::mutex> channelLock(mCompletionChannelMutex);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mCompletionChannel) {
+            return OK;
+        }
+    }
+
+    gui::TransactionCompletionChannelFds fds;
+    binder::Status status =
+            ComposerServiceAIDL::getComposerService()
+                    ->openTransactionCompletionChannel(IInterface::asBinder(this), &fds);
+    if (!status.isOk()) {
+        ALOGE("Failed to open transaction completion channel: %s", status.toString8().c_str());
+        return statusTFromBinderStatus(status);
+    }
+
+    std::unique_ptr<gui::TransactionCompletionChannel::ConsumerEndpoint> consumer =
+            gui::TransactionCompletionChannel::ConsumerEndpoint::
+                    create("TransactionCompletion", fds.sharedMemory.release(),
+                           fds.fenceSocket.release());
+    if (!consumer) {
+        (void)ComposerServiceAIDL::getComposerService()->closeTransactionCompletionChannel(
+                IInterface::asBinder(this));
+        return UNKNOWN_ERROR;
+    }
+
+    std::shared_ptr<gui::TransactionCompletionChannel::ConsumerEndpoint> channel =
+            std::move(consumer);
+    auto running = std::make_shared<std::atomic_bool>(true);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        startListeningLocked();
+        mCompletionChannel = channel;
+        mCompletionChannelRunning = running;
+    }
+    std::thread([running, channel,
+                 weakListener = wp<TransactionCompletedListener>::fromExisting(this)]() {
+        pthread_setname_np(pthread_self(), "TxnCompletion");
+        while (*running) {
+            channel->waitForBatch();
+            sp<TransactionCompletedListener> listener = weakListener.promote();
+            if (!listener) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(listener->mCompletionChannelReadMutex);
+            listener->readCompletionChannelLocked(*channel);
+        }
+    }).detach();
+    return OK;
+}
+
+void TransactionCompletedListener::disableCompletionChannel() {
+    std::lock_guard<std::mutex> channelLock(mCompletionChannelMutex);
+    std::shared_ptr<gui::TransactionCompletionChannel::ConsumerEndpoint> channel;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        channel = mCompletionChannel;
+    }
+    if (!channel) {
+        return;
+    }
+
+    binder::Status status = ComposerServiceAIDL::getComposerService()
+                                    ->closeTransactionCompletionChannel(
+                                            IInterface::asBinder(this));
+    if (!status.isOk()) {
+        ALOGE("Failed to close transaction completion channel: %s",
+              status.toString8().c_str());
+    }
+
+    // SurfaceFlinger no longer writes to the channel. Dispatch what it published before, ahead
+    // of anything that arrives through binder from now on.
+    std::lock_guard<std::mutex> readLock(mCompletionChannelReadMutex);
+    readCompletionChannelLocked(*channel);
+    std::lock_guard<std::mutex> lock(mMutex);
+    *mCompletionChannelRunning = false;
+    mCompletionChannel->wake();
+    mCompletionChannel.reset();
+    mCompletionChannelRunning.reset();
+}
+
+void TransactionCompletedListener::readCompletionChannelLocked(
+        gui::TransactionCompletionChannel::ConsumerEndpoint& channel) {
+    // The channel identifies surfaces by layer id. Map them back to the handles that the
+    // registered callbacks know, like the binder path receives them.
+    auto resolveHandle = [this](const std::vector<CallbackId>& callbackIds,
+                                int32_t layerId) -> sp<IBinder> {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto& callbackId : callbackIds) {
+            auto it = mCallbacks.find(callbackId);
+            if (it == mCallbacks.end()) {
+                continue;
+            }
+            for (const auto& [handle, surfaceControl] : it->second.surfaceControls) {
+                if (surfaceControl && surfaceControl->getLayerId() == layerId) {
+                    return handle;
+                }
+            }
+        }
+        return nullptr;
+    };
+
+    ListenerStats listenerStats;
+    status_t status;
+    while ((status = channel.read(listenerStats, resolveHandle)) == OK) {
+        dispatchTransactionCompleted(std::move(listenerStats));
+        listenerStats = {};
+    }
+    if (status != WOULD_BLOCK) {
+        ALOGE("Transaction completion channel is broken: %s (%d)", statusToString(status).c_str(),
+              status);
+    }
+}
+
 void TransactionCompletedListener::onTransactionQueueStalled(const String8& reason) {
     std::unordered_map<void*, std::function<void(const std::string&)>> callbackCopy;
     {
@@ -0,0 +1,625 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "TransactionCompletionChannel"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include <array>
+#include <cinttypes>
+
+#include <log/log.h>
+
+#include <gui/TransactionCompletionChannel.h>
+
+namespace android::gui {
+
+namespace {
+
+// Fence indices for fences that are not sent over the socket.
+constexpr int32_t kNullFence = -1;
+constexpr int32_t kInvalidFence = -2;
+
+struct BatchRecord {
+    uint64_t sequence;
+    uint32_t transactionCount;
+    uint32_t fenceCount;
+};
+
+struct TransactionRecord {
+    int64_t latchTime;
+    int32_t presentFence;
+    uint32_t callbackIdCount;
+    uint32_t surfaceCount;
+};
+
+struct CallbackIdRecord {
+    int64_t id;
+    int32_t type;
+};
+
+struct SurfaceRecord {
+    int32_t layerId;
+    int32_t acquireFence;
+    int64_t acquireTime;
+    int32_t previousReleaseFence;
+    uint32_t hasTransformHint;
+    uint32_t transformHint;
+    uint32_t currentMaxAcquiredBufferCount;
+    uint64_t frameNumber;
+    uint64_t previousFrameNumber;
+    int32_t gpuCompositionDoneFence;
+    int64_t compositorDeadline;
+    int64_t compositorInterval;
+    int64_t compositorPresentLatency;
+    int64_t refreshStartTime;
+    int64_t dequeueReadyTime;
+    uint64_t previousReleaseBufferId;
+    uint64_t previousReleaseFrameNumber;
+};
+
+struct Record {
+    enum class Type : uint32_t { BATCH = 1, TRANSACTION, CALLBACK_ID, SURFACE };
+
+    Type type;
+    union {
+        BatchRecord batch;
+        TransactionRecord transaction;
+        CallbackIdRecord callbackId;
+        SurfaceRecord surface;
+    };
+};
+
+static_assert(std::is_trivially_copyable_v<Record>);
+
+} // namespace
+
+struct TransactionCompletionChannel::SharedRing {
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "positions are shared across processes");
+
+    // Written by the producer after the records of a batch, read by the consumer.
+    alignas(64) std::atomic<uint64_t> writePosition;
+    // Written by the consumer once it has copied a batch out, read by the producer.
+    alignas(64) std::atomic<uint64_t> readPosition;
+    alignas(64) std::array<Record, kCapacity> records;
+};
+
+namespace {
+
+using SharedRing = TransactionCompletionChannel::SharedRing;
+
+SharedRing* mapRing(const std::string& name, int fd) {
+    void* address = mmap(nullptr, sizeof(SharedRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED) {
+        ALOGE("[%s] Failed to map completion ring. errno=%d message='%s'", name.c_str(), errno,
+              strerror(errno));
+        return nullptr;
+    }
+    return static_cast<SharedRing*>(address);
+}
+
+void unmapRing(SharedRing* ring) {
+    if (ring) {
+        munmap(ring, sizeof(SharedRing));
+    }
+}
+
+void signalEventFd(const std::string& name, int fd) {
+    uint64_t value = 1;
+    if (::write(fd, &value, sizeof(value)) == -1 && errno != EAGAIN) {
+        ALOGE("[%s] Failed to signal completion eventfd. errno=%d message='%s'", name.c_str(),
+              errno, strerror(errno));
+    }
+}
+
+int32_t addFence(const sp<Fence>& fence, std::vector<int>& fds) {
+    if (fence == nullptr) {
+        return kNullFence;
+    }
+    if (!fence->isValid()) {
+        return kInvalidFence;
+    }
+    fds.push_back(fence->get());
+    return static_cast<int32_t>(fds.size() - 1);
+}
+
+status_t getFence(int32_t index, const std::vector<sp<Fence>>& fences, sp<Fence>& outFence) {
+    if (index == kNullFence) {
+        outFence = nullptr;
+        return OK;
+    }
+    if (index == kInvalidFence) {
+        outFence = sp<Fence>::make();
+        return OK;
+    }
+    if (index < 0 || static_cast<size_t>(index) >= fences.size()) {
+        return BAD_VALUE;
+    }
+    outFence = fences[static_cast<size_t>(index)];
+    return OK;
+}
+
+} // namespace
+
+TransactionCompletionChannel::ConsumerEndpoint::ConsumerEndpoint(
+        std::string name, android::base::unique_fd memoryFd, android::base::unique_fd wakeFd,
+        android::base::unique_fd fenceFd, SharedRing* ring)
+      : mName(std::move(name)),
+        mMemoryFd(std::move(memoryFd)),
+        mWakeFd(std::move(wakeFd)),
+        mFenceFd(std::move(fenceFd)),
+        mRing(ring) {}
+
+std::unique_ptr<TransactionCompletionChannel::ConsumerEndpoint>
+TransactionCompletionChannel::ConsumerEndpoint::create(std::string name,
+                                                       android::base::unique_fd memoryFd,
+                                                       android::base::unique_fd fenceFd) {
+    if (!memoryFd.ok() || !fenceFd.ok()) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(memoryFd.get(), &st) == -1 || st.st_size < static_cast<off_t>(sizeof(SharedRing))) {
+        ALOGE("[%s] Completion ring is too small", name.c_str());
+        return nullptr;
+    }
+
+    android::base::unique_fd wakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+    if (!wakeFd.ok()) {
+        ALOGE("[%s] Failed to create completion eventfd. errno=%d message='%s'", name.c_str(),
+              errno, strerror(errno));
+        return nullptr;
+    }
+
+    SharedRing* ring = mapRing(name, memoryFd.get());
+    if (!ring) {
+        return nullptr;
+    }
+    auto consumer = std::make_unique<ConsumerEndpoint>(std::move(name), std::move(memoryFd),
+                                                       std::move(wakeFd), std::move(fenceFd),
+                                                       ring);
+    consumer->mReadPosition = ring->readPosition.load(std::memory_order_acquire);
+    return consumer;
+}
+
+TransactionCompletionChannel::ConsumerEndpoint::~ConsumerEndpoint() {
+    unmapRing(mRing);
+}
+
+status_t TransactionCompletionChannel::ConsumerEndpoint::readFences(
+        uint64_t sequence, uint32_t fenceCount, std::vector<sp<Fence>>& outFences) {
+    uint64_t messageSequence = 0;
+    iovec iov{
+            .iov_base = &messageSequence,
+            .iov_len = sizeof(messageSequence),
+    };
+
+    std::array<uint8_t, CMSG_SPACE(sizeof(int) * kMaxFencesPerBatch)> controlMessageBuffer;
+    msghdr msg{
+            .msg_iov = &iov,
+            .msg_iovlen = 1,
+            .msg_control = controlMessageBuffer.data(),
+            .msg_controllen = controlMessageBuffer.size(),
+    };
+
+    ssize_t result;
+    do {
+        result = recvmsg(mFenceFd.get(), &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+    } while (result == -1 && errno == EINTR);
+    if (result == -1) {
+        ALOGE("[%s] Error reading fences from socket: error %#x (%s)", mName.c_str(), errno,
+              strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+
+    const cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    const size_t receivedFdCount = cmsg && cmsg->cmsg_type == SCM_RIGHTS
+            ? (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int)
+            : 0;
+    const int* fds = receivedFdCount ? reinterpret_cast<const int*>(CMSG_DATA(cmsg)) : nullptr;
+
+    // Take ownership of whatever was received before validating it, so that nothing leaks.
+    outFences.clear();
+    outFences.reserve(receivedFdCount);
+    for (size_t i = 0; i < receivedFdCount; i++) {
+        outFences.push_back(sp<Fence>::make(fds[i]));
+    }
+
+    if (result != sizeof(messageSequence) || messageSequence != sequence ||
+        receivedFdCount != fenceCount || (msg.msg_flags & MSG_CTRUNC)) {
+        ALOGE("[%s] Fences do not match batch %" PRIu64, mName.c_str(), sequence);
+        return UNKNOWN_ERROR;
+    }
+    return OK;
+}
+
+status_t TransactionCompletionChannel::ConsumerEndpoint::read(ListenerStats& outStats,
+                                                              const HandleResolver& resolveHandle) {
+    const uint64_t writePosition = mRing->writePosition.load(std::memory_order_acquire);
+    if (writePosition == mReadPosition) {
+        return WOULD_BLOCK;
+    }
+
+    uint64_t position = mReadPosition;
+    auto nextRecord = [&](Record::Type type, Record& outRecord) {
+        if (position == writePosition) {
+            return false;
+        }
+        outRecord = mRing->records[position++ % kCapacity];
+        return outRecord.type == type;
+    };
+
+    Record record;
+    if (!nextRecord(Record::Type::BATCH, record)) {
+        ALOGE("[%s] Expected a batch record", mName.c_str());
+        return UNKNOWN_ERROR;
+    }
+    const BatchRecord batch = record.batch;
+
+    // Every batch comes with a message, even without fences, which was sent before the batch was
+    // published.
+    std::vector<sp<Fence>> fences;
+    if (status_t err = readFences(batch.sequence, batch.fenceCount, fences); err != OK) {
+        return err;
+    }
+
+    outStats.transactionStats.clear();
+    outStats.transactionStats.reserve(batch.transactionCount);
+    for (uint32_t t = 0; t < batch.transactionCount; t++) {
+        if (!nextRecord(Record::Type::TRANSACTION, record)) {
+            ALOGE("[%s] Expected a transaction record", mName.c_str());
+            return UNKNOWN_ERROR;
+        }
+        const TransactionRecord transaction = record.transaction;
+
+        TransactionStats& stats = outStats.transactionStats.emplace_back();
+        stats.latchTime = transaction.latchTime;
+        if (getFence(transaction.presentFence, fences, stats.presentFence) != OK) {
+            return UNKNOWN_ERROR;
+        }
+
+        stats.callbackIds.reserve(transaction.callbackIdCount);
+        for (uint32_t c = 0; c < transaction.callbackIdCount; c++) {
+            if (!nextRecord(Record::Type::CALLBACK_ID, record)) {
+                ALOGE("[%s] Expected a callback id record", mName.c_str());
+                return UNKNOWN_ERROR;
+            }
+            stats.callbackIds.emplace_back(record.callbackId.id,
+                                           static_cast<CallbackId::Type>(record.callbackId.type));
+        }
+
+        stats.surfaceStats.reserve(transaction.surfaceCount);
+        for (uint32_t s = 0; s < transaction.surfaceCount; s++) {
+            if (!nextRecord(Record::Type::SURFACE, record)) {
+                ALOGE("[%s] Expected a surface record", mName.c_str());
+                return UNKNOWN_ERROR;
+            }
+            const SurfaceRecord& surface = record.surface;
+
+            SurfaceStats& surfaceStats = stats.surfaceStats.emplace_back();
+            surfaceStats.surfaceControl = resolveHandle(stats.callbackIds, surface.layerId);
+
+            if (surface.acquireFence != kNullFence) {
+                sp<Fence> acquireFence;
+                if (getFence(surface.acquireFence, fences, acquireFence) != OK) {
+                    return UNKNOWN_ERROR;
+                }
+                surfaceStats.acquireTimeOrFence = std::move(acquireFence);
+            } else {
+                surfaceStats.acquireTimeOrFence = surface.acquireTime;
+            }
+            if (getFence(surface.previousReleaseFence, fences,
+                         surfaceStats.previousReleaseFence) != OK) {
+                return UNKNOWN_ERROR;
+            }
+            surfaceStats.transformHint = surface.hasTransformHint
+                    ? std::make_optional(surface.transformHint)
+                    : std::nullopt;
+            surfaceStats.currentMaxAcquiredBufferCount = surface.currentMaxAcquiredBufferCount;
+
+            FrameEventHistoryStats& eventStats = surfaceStats.eventStats;
+            eventStats.frameNumber = surface.frameNumber;
+            eventStats.previousFrameNumber = surface.previousFrameNumber;
+            if (getFence(surface.gpuCompositionDoneFence, fences,
+                         eventStats.gpuCompositionDoneFence) != OK) {
+                return UNKNOWN_ERROR;
+            }
+            eventStats.compositorTiming.deadline = surface.compositorDeadline;
+            eventStats.compositorTiming.interval = surface.compositorInterval;
+            eventStats.compositorTiming.presentLatency = surface.compositorPresentLatency;
+            eventStats.refreshStartTime = surface.refreshStartTime;
+            eventStats.dequeueReadyTime = surface.dequeueReadyTime;
+
+            surfaceStats.previousReleaseCallbackId =
+                    ReleaseCallbackId(surface.previousReleaseBufferId,
+                                      surface.previousReleaseFrameNumber);
+        }
+    }
+
+    mReadPosition = position;
+    mRing->readPosition.store(mReadPosition, std::memory_order_release);
+    return OK;
+}
+
+void TransactionCompletionChannel::ConsumerEndpoint::waitForBatch() {
+    // The message of a batch stays queued until read() consumes it. It is sent just before the
+    // batch is published, so this may return once more before the batch can be read. Once the
+    // producer is gone, the socket stays readable, and only wake() is left to wait for.
+    std::array<pollfd, 2> pfds{{
+            {.fd = mProducerClosed ? -1 : mFenceFd.get(), .events = POLLIN},
+            {.fd = mWakeFd.get(), .events = POLLIN},
+    }};
+    int result;
+    do {
+        result = poll(pfds.data(), pfds.size(), -1 /* timeout */);
+    } while (result == -1 && errno == EINTR);
+
+    if (pfds[0].revents & (POLLHUP | POLLERR)) {
+        mProducerClosed = true;
+    }
+    if (pfds[1].revents & POLLIN) {
+        uint64_t value;
+        if (::read(mWakeFd.get(), &value, sizeof(value)) == -1 && errno != EAGAIN) {
+            ALOGE("[%s] Failed to read completion eventfd. errno=%d message='%s'", mName.c_str(),
+                  errno, strerror(errno));
+        }
+    }
+}
+
+void TransactionCompletionChannel::ConsumerEndpoint::wake() {
+    signalEventFd(mName, mWakeFd.get());
+}
+
+TransactionCompletionChannel::ProducerEndpoint::ProducerEndpoint(
+        std::string name, android::base::unique_fd memoryFd, android::base::unique_fd fenceFd,
+        SharedRing* ring)
+      : mName(std::move(name)),
+        mMemoryFd(std::move(memoryFd)),
+        mFenceFd(std::move(fenceFd)),
+        mRing(ring) {}
+
+TransactionCompletionChannel::ProducerEndpoint::~ProducerEndpoint() {
+    unmapRing(mRing);
+}
+
+status_t TransactionCompletionChannel::ProducerEndpoint::writeFences(uint64_t sequence,
+                                                                     const std::vector<int>& fds) {
+    iovec iov{
+            .iov_base = &sequence,
+            .iov_len = sizeof(sequence),
+    };
+
+    std::array<uint8_t, CMSG_SPACE(sizeof(int) * kMaxFencesPerBatch)> controlMessageBuffer;
+    msghdr msg{
+            .msg_iov = &iov,
+            .msg_iovlen = 1,
+    };
+
+    if (!fds.empty()) {
+        msg.msg_control = controlMessageBuffer.data();
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+    }
+
+    ssize_t result;
+    do {
+        result = sendmsg(mFenceFd.get(), &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (result == -1 && errno == EINTR);
+    if (result == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return WOULD_BLOCK;
+        }
+        ALOGD("[%s] Error writing fences to socket: error %#x (%s)", mName.c_str(), errno,
+              strerror(errno));
+        return -errno;
+    }
+    return OK;
+}
+
+status_t TransactionCompletionChannel::ProducerEndpoint::write(
+        const ListenerStats& stats, const LayerIdResolver& resolveLayerId) {
+    // The read position comes from the client, so don't trust it beyond what the ring allows.
+    const uint64_t readPosition = mRing->readPosition.load(std::memory_order_acquire);
+    if (readPosition > mWritePosition || mWritePosition - readPosition > kCapacity) {
+        ALOGE("[%s] Inconsistent completion ring read position", mName.c_str());
+        return BAD_VALUE;
+    }
+    const size_t freeRecords = kCapacity - static_cast<size_t>(mWritePosition - readPosition);
+
+    size_t recordCount = 1;
+    for (const auto& transactionStats : stats.transactionStats) {
+        recordCount += 1 + transactionStats.callbackIds.size() +
+                transactionStats.surfaceStats.size();
+    }
+    if (recordCount > freeRecords) {
+        return WOULD_BLOCK;
+    }
+
+    // Stage the records first, so that nothing is published if the fences can't be sent.
+    std::vector<Record> records;
+    records.reserve(recordCount);
+    std::vector<int> fds;
+
+    Record& batch = records.emplace_back();
+    batch.type = Record::Type::BATCH;
+    batch.batch.sequence = ++mBatchSequence;
+    batch.batch.transactionCount = static_cast<uint32_t>(stats.transactionStats.size());
+
+    for (const auto& transactionStats : stats.transactionStats) {
+        Record& transaction = records.emplace_back();
+        transaction.type = Record::Type::TRANSACTION;
+        transaction.transaction.latchTime = transactionStats.latchTime;
+        transaction.transaction.presentFence = addFence(transactionStats.presentFence, fds);
+        transaction.transaction.callbackIdCount =
+                static_cast<uint32_t>(transactionStats.callbackIds.size());
+        transaction.transaction.surfaceCount =
+                static_cast<uint32_t>(transactionStats.surfaceStats.size());
+
+        for (const auto& id : transactionStats.callbackIds) {
+            Record& callbackId = records.emplace_back();
+            callbackId.type = Record::Type::CALLBACK_ID;
+            callbackId.callbackId.id = id.id;
+            callbackId.callbackId.type = static_cast<int32_t>(id.type);
+        }
+
+        for (const auto& surfaceStats : transactionStats.surfaceStats) {
+            Record& record = records.emplace_back();
+            record.type = Record::Type::SURFACE;
+            SurfaceRecord& surface = record.surface;
+            surface.layerId = resolveLayerId(surfaceStats.surfaceControl);
+            const auto& acquireTimeOrFence = surfaceStats.acquireTimeOrFence;
+            if (const auto* acquireFence = std::get_if<sp<Fence>>(&acquireTimeOrFence)) {
+                // The consumer always gets a fence object back, as with binder.
+                surface.acquireFence =
+                        *acquireFence ? addFence(*acquireFence, fds) : kInvalidFence;
+                surface.acquireTime = -1;
+            } else {
+                surface.acquireFence = kNullFence;
+                surface.acquireTime = std::get<nsecs_t>(acquireTimeOrFence);
+            }
+            surface.previousReleaseFence = addFence(surfaceStats.previousReleaseFence, fds);
+            surface.hasTransformHint = surfaceStats.transformHint.has_value();
+            surface.transformHint = surfaceStats.transformHint.value_or(0);
+            surface.currentMaxAcquiredBufferCount = surfaceStats.currentMaxAcquiredBufferCount;
+
+            const FrameEventHistoryStats& eventStats = surfaceStats.eventStats;
+            surface.frameNumber = eventStats.frameNumber;
+            surface.previousFrameNumber = eventStats.previousFrameNumber;
+            surface.gpuCompositionDoneFence = addFence(eventStats.gpuCompositionDoneFence, fds);
+            surface.compositorDeadline = eventStats.compositorTiming.deadline;
+            surface.compositorInterval = eventStats.compositorTiming.interval;
+            surface.compositorPresentLatency = eventStats.compositorTiming.presentLatency;
+            surface.refreshStartTime = eventStats.refreshStartTime;
+            surface.dequeueReadyTime = eventStats.dequeueReadyTime;
+
+            surface.previousReleaseBufferId = surfaceStats.previousReleaseCallbackId.bufferId;
+            surface.previousReleaseFrameNumber =
+                    surfaceStats.previousReleaseCallbackId.framenumber;
+        }
+    }
+
+    if (fds.size() > kMaxFencesPerBatch) {
+        mBatchSequence--;
+        return WOULD_BLOCK;
+    }
+    records.front().batch.fenceCount = static_cast<uint32_t>(fds.size());
+
+    // The message must be queued on the socket before the consumer can see the batch. It also
+    // wakes the consumer up.
+    if (status_t err = writeFences(mBatchSequence, fds); err != OK) {
+        mBatchSequence--;
+        return err;
+    }
+
+    for (const Record& record : records) {
+        mRing->records[mWritePosition++ % kCapacity] = record;
+    }
+    mRing->writePosition.store(mWritePosition, std::memory_order_release);
+    return OK;
+}
+
+status_t TransactionCompletionChannel::create(std::string name,
+                                              std::shared_ptr<ProducerEndpoint>& outProducer,
+                                              android::base::unique_fd& outConsumerMemoryFd,
+                                              android::base::unique_fd& outConsumerFenceFd) {
+    outProducer.reset();
+    outConsumerMemoryFd.reset();
+    outConsumerFenceFd.reset();
+
+    android::base::unique_fd memoryFd(
+            memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (!memoryFd.ok()) {
+        ALOGE("[%s] Failed to create completion ring. errno=%d message='%s'", name.c_str(), errno,
+              strerror(errno));
+        return -errno;
+    }
+    // The ring is shared with the client, which must not be able to resize it under our mapping.
+    if (ftruncate(memoryFd.get(), sizeof(SharedRing)) == -1 ||
+        fcntl(memoryFd.get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == -1) {
+        ALOGE("[%s] Failed to size completion ring. errno=%d message='%s'", name.c_str(), errno,
+              strerror(errno));
+        return -errno;
+    }
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets)) {
+        ALOGE("[%s] Failed to create socket pair. errorno=%d message='%s'", name.c_str(), errno,
+              strerror(errno));
+        return -errno;
+    }
+    android::base::unique_fd consumerFenceFd(sockets[0]);
+    android::base::unique_fd producerFenceFd(sockets[1]);
+
+    // Messages are only ever read after their batch has been published, so reads never block.
+    if (fcntl(consumerFenceFd.get(), F_SETFL, O_NONBLOCK) == -1 ||
+        shutdown(consumerFenceFd.get(), SHUT_WR) == -1 ||
+        shutdown(producerFenceFd.get(), SHUT_RD) == -1) {
+        ALOGE("[%s] Failed to configure fence sockets. errno=%d message='%s'", name.c_str(), errno,
+              strerror(errno));
+        return -errno;
+    }
+
+    android::base::unique_fd consumerMemoryFd(fcntl(memoryFd.get(), F_DUPFD_CLOEXEC, 0));
+    if (!consumerMemoryFd.ok()) {
+        ALOGE("[%s] Failed to duplicate completion ring. errno=%d message='%s'", name.c_str(),
+              errno, strerror(errno));
+        return -errno;
+    }
+
+    SharedRing* ring = mapRing(name, memoryFd.get());
+    if (!ring) {
+        return NO_MEMORY;
+    }
+    // A fresh memfd is zero-filled, so both positions start at 0.
+    outProducer = std::make_shared<ProducerEndpoint>(std::move(name), std::move(memoryFd),
+                                                     std::move(producerFenceFd), ring);
+    outConsumerMemoryFd = std::move(consumerMemoryFd);
+    outConsumerFenceFd = std::move(consumerFenceFd);
+    return OK;
+}
+
+status_t TransactionCompletionChannel::open(std::string name,
+                                            std::unique_ptr<ConsumerEndpoint>& outConsumer,
+                                            std::shared_ptr<ProducerEndpoint>& outProducer) {
+    outConsumer.reset();
+    outProducer.reset();
+
+    std::shared_ptr<ProducerEndpoint> producer;
+    android::base::unique_fd memoryFd;
+    android::base::unique_fd fenceFd;
+    if (status_t err = create(name, producer, memoryFd, fenceFd); err != OK) {
+        return err;
+    }
+    outConsumer = ConsumerEndpoint::create(std::move(name), std::move(memoryFd),
+                                           std::move(fenceFd));
+    if (!outConsumer) {
+        return UNKNOWN_ERROR;
+    }
+    outProducer = std::move(producer);
+    return OK;
+}
+
+} // namespace android::gui
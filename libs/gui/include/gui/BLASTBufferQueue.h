@@ -29,6 +29,9 @@
 #include <utils/RefBase.h>
 
 #include <system/window.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <queue>
 
 #include <com_android_graphics_libgui_flags.h>
@@ -181,8 +184,41 @@ private:
     std::string mQueuedBufferTrace;
     sp<SurfaceControl> mSurfaceControl GUARDED_BY(mMutex);
 
+#if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(BUFFER_RELEASE_RING)
+    // A mutex which applies the releases queued in mReleaseRing before it is unlocked. Release
+    // callbacks never block on it: they queue their release and only apply it themselves if the
+    // mutex is free. Otherwise the thread holding it applies the release when it unlocks.
+    class CAPABILITY("mutex") ReleaseRingMutex {
+    public:
+        explicit ReleaseRingMutex(BLASTBufferQueue& bbq) : mBbq(bbq) {}
+
+        void lock() ACQUIRE();
+        bool try_lock() TRY_ACQUIRE(true);
+        void unlock() RELEASE();
+
+        // Waits for |cv| like std::condition_variable::wait, while the caller holds the mutex.
+        // Like unlock(), applies the queued releases first. May return spuriously.
+        void wait(std::condition_variable& cv);
+
+        // Whether some thread holds the mutex and is yet to check mReleaseRing in unlock(). A
+        // release queued before calling this is then seen by that thread.
+        bool isHeld() const {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return mHeld.load();
+        }
+
+    private:
+        BLASTBufferQueue& mBbq;
+        std::mutex mMutex;
+        std::atomic<bool> mHeld{false};
+    };
+
+    mutable ReleaseRingMutex mMutex{*this};
+#else
     mutable std::mutex mMutex;
+#endif
     std::condition_variable mCallbackCV;
+    void waitForCallbackCVLocked(std::unique_lock<decltype(mMutex)>& lock) REQUIRES(mMutex);
 
     // BufferQueue internally allows 1 more than
     // the max to be acquired
@@ -316,6 +352,13 @@ private:
 
     std::unordered_set<uint64_t> mSyncedFrameNumbers GUARDED_BY(mMutex);
 
+#if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(BUFFER_RELEASE_RING)
+    // Release callbacks are pushed here without taking mMutex, and applied in batches by
+    // whichever thread holds mMutex. See ReleaseRingMutex for details.
+    gui::BufferReleaseChannel::ReleaseRing mReleaseRing;
+    void drainReleaseRingLocked() REQUIRES(mMutex);
+#endif
+
 #if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(BUFFER_RELEASE_CHANNEL)
     class BufferReleaseReader {
     public:
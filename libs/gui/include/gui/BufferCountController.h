@@ -0,0 +1,109 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_GUI_BUFFERCOUNTCONTROLLER_H
+#define ANDROID_GUI_BUFFERCOUNTCONTROLLER_H
+
+#include <utils/String8.h>
+#include <utils/Timers.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace android {
+
+// BufferCountController decides how many buffers a BufferQueue should keep
+// allocated, based on the same queue occupancy signal that OccupancyTracker
+// records and on how often the producer needs more buffers than that.
+//
+// The producer still sees the buffer count it asked for. The controller only
+// limits how many of those slots actually hold a GraphicBuffer: a queue whose
+// producer never runs more than one frame ahead settles on double buffering,
+// and a queue whose producer runs out of free buffers grows back towards the
+// requested count.
+//
+// This class holds no lock of its own; BufferQueueCore calls it with its
+// mMutex held.
+class BufferCountController {
+public:
+    // Occupancy is evaluated over windows of this length.
+    static constexpr nsecs_t EVALUATION_WINDOW = ms2ns(500);
+
+    // Number of consecutive windows that must need fewer buffers before the
+    // target is lowered by one.
+    static constexpr int SHRINK_WINDOW_COUNT = 3;
+
+    // How long buffers above the target must stay unused before being freed.
+    static constexpr nsecs_t IDLE_TIMEOUT = s2ns(1);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return mEnabled; }
+
+    // Called whenever the number of queued buffers changes.
+    void onOccupancyChange(size_t occupancy, nsecs_t now);
+
+    // Called when a dequeue finds no free buffer while the target number of
+    // buffers is allocated. The target is raised right away, so that the
+    // producer allocates instead of stalling.
+    void onTargetReached();
+
+    // Returns the number of buffers that should be allocated, clamped to
+    // [minBufferCount, maxBufferCount].
+    int getTargetBufferCount(int minBufferCount, int maxBufferCount) const;
+
+    // Returns true once more than the target number of buffers have been
+    // allocated for at least IDLE_TIMEOUT.
+    bool shouldTrim(int allocatedCount, int targetCount, nsecs_t now);
+
+    void onBuffersFreed(size_t count, size_t bytes);
+
+    // Returns roughly how much memory a buffer takes, from the bits per pixel
+    // of its format. Planar YUV and raw camera formats are covered, but not
+    // the padding or compression of vendor layouts. Formats of unknown size
+    // count as 0.
+    static size_t estimateBufferBytes(uint32_t stride, uint32_t height, int32_t format,
+                                      uint32_t layerCount);
+
+    void dump(const String8& prefix, String8* outResult, int minBufferCount,
+              int maxBufferCount) const;
+
+private:
+    void evaluateWindow(nsecs_t now);
+
+    bool mEnabled = false;
+
+    // Extra buffers allowed on top of the minimum buffer count. Starts
+    // unlimited until the first window has been evaluated.
+    int mExtraBuffers = INT32_MAX;
+    bool mLearned = false;
+
+    nsecs_t mWindowStart = 0;
+    size_t mWindowMaxOccupancy = 0;
+    int mWindowGrowths = 0;
+    int mQuietWindows = 0;
+
+    nsecs_t mOverTargetSince = 0;
+
+    // Statistics reported in dumps.
+    uint64_t mGrowthCount = 0;
+    uint64_t mFreedBufferCount = 0;
+    uint64_t mFreedBytes = 0;
+    size_t mLastBufferBytes = 0;
+};
+
+} // namespace android
+
+#endif // ANDROID_GUI_BUFFERCOUNTCONTROLLER_H
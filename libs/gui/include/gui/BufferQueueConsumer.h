@@ -178,6 +178,12 @@ public:
     // will eventually be released or acquired by the consumer.
     void setAllowExtraAcquire(bool /* allow */);
 
+    // Lets the BufferQueue grow or shrink the number of allocated buffers,
+    // up to the requested buffer count, based on how many buffers the
+    // producer actually keeps queued. Buffers above the adaptive count are
+    // freed once idle. Disabled by default.
+    void setAdaptiveBufferCountEnabled(bool enabled);
+
 private:
     sp<BufferQueueCore> mCore;
 
@@ -20,6 +20,7 @@
 #include <com_android_graphics_libgui_flags.h>
 
 #include <gui/AdditionalOptions.h>
+#include <gui/BufferCountController.h>
 #include <gui/BufferItem.h>
 #include <gui/BufferQueueDefs.h>
 #include <gui/BufferSlot.h>
@@ -36,6 +37,7 @@
 #include <set>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 #define ATRACE_BUFFER_INDEX(index)                                                        \
     do {                                                                                  \
@@ -133,6 +135,26 @@ private:
     // waitWhileAllocatingLocked blocks until mIsAllocating is false.
     void waitWhileAllocatingLocked(std::unique_lock<std::mutex>& lock) const;
 
+    // getAllocatedBufferCountLocked returns the number of slots that currently
+    // hold a buffer or are being dequeued.
+    int getAllocatedBufferCountLocked() const;
+
+    // getAdaptiveBufferCountLocked returns the number of buffers that
+    // mBufferCountController currently wants allocated. This is
+    // getMaxBufferCountLocked() unless the adaptive buffer count is enabled.
+    int getAdaptiveBufferCountLocked() const;
+
+    // isAllocationCappedLocked returns true if the adaptive buffer count has
+    // been reached, so that allocating another buffer has to raise it.
+    // dequeuedCount is the number of buffers the producer currently holds.
+    bool isAllocationCappedLocked(int dequeuedCount) const;
+
+    // trimIdleBuffersLocked frees FREE buffers that have stayed above the
+    // adaptive buffer count for longer than the controller's idle timeout.
+    // Returns the freed slots; the caller must notify the producer through
+    // onBuffersDiscarded once it has released mMutex.
+    std::vector<int32_t> trimIdleBuffersLocked();
+
 #if DEBUG_ONLY_CODE
     // validateConsistencyLocked ensures that the free lists are in sync with
     // the information stored in mSlots
@@ -351,6 +373,11 @@ private:
 
     OccupancyTracker mOccupancyTracker;
 
+    // mBufferCountController adapts the number of allocated buffers to the
+    // observed occupancy. It is disabled unless the consumer opts in through
+    // BufferQueueConsumer::setAdaptiveBufferCountEnabled.
+    BufferCountController mBufferCountController;
+
     const uint64_t mUniqueId;
 
     // When buffer size is driven by the consumer and mTransformHint specifies
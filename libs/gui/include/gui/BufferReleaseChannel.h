@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -120,6 +123,57 @@ public:
     private:
         size_t getPodSize() const;
     };
+
+    /**
+     * In-process, lock-free queue of buffer releases.
+     *
+     * Release callbacks may arrive concurrently on several binder threads while the producer
+     * thread holds the BLASTBufferQueue lock. Pushing into the ring never blocks, so callback
+     * threads can hand off a release without waiting for that lock; whoever holds the lock
+     * drains the ring in one batch before unlocking it.
+     *
+     * push() is safe to call from any number of threads. pop() must be serialized by the caller.
+     */
+    class ReleaseRing {
+    public:
+        static constexpr size_t kCapacity = 64;
+
+        struct Entry {
+            ReleaseCallbackId releaseCallbackId;
+            sp<Fence> releaseFence = Fence::NO_FENCE;
+            std::optional<uint32_t> maxAcquiredBufferCount;
+        };
+
+        ReleaseRing();
+
+        ReleaseRing(const ReleaseRing&) = delete;
+        void operator=(const ReleaseRing&) = delete;
+
+        /**
+         * Returns false if the ring is full, in which case the caller must release the buffer
+         * through the locked path.
+         */
+        bool push(Entry entry);
+
+        /**
+         * Returns false if the ring is empty.
+         */
+        bool pop(Entry& outEntry);
+
+        bool empty() const;
+
+    private:
+        static_assert((kCapacity & (kCapacity - 1)) == 0, "kCapacity must be a power of two");
+
+        struct Cell {
+            std::atomic<size_t> sequence;
+            Entry entry;
+        };
+
+        std::array<Cell, kCapacity> mCells;
+        alignas(64) std::atomic<size_t> mEnqueuePosition{0};
+        alignas(64) std::atomic<size_t> mDequeuePosition{0};
+    };
 };
 
 } // namespace android::gui
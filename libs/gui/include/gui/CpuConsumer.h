@@ -23,8 +23,11 @@
 #include <gui/BufferQueue.h>
 #include <gui/ConsumerBase.h>
 
+#include <utils/Condition.h>
 #include <utils/Vector.h>
 
+#include <deque>
+#include <memory>
 
 namespace android {
 
@@ -121,6 +124,18 @@ class CpuConsumer : public ConsumerBase
     // lockNextBuffer.
     status_t unlockBuffer(const LockedBuffer &nativeBuffer);
 
+    // Locks up to count queued buffers ahead of lockNextBuffer on a worker
+    // thread, so that waiting on the producer's fence and the gralloc lock
+    // (including the CPU cache invalidation) happen before the buffer is
+    // needed. Prefetched buffers count against maxLockedBuffers, and are
+    // returned by lockNextBuffer in queue order. A count of 0, the default,
+    // disables prefetching.
+    void setPrefetchCount(size_t count);
+
+  protected:
+    void onFrameAvailable(const BufferItem& item) override;
+    void abandonLocked() override;
+
   private:
     // Maximum number of buffers that can be locked at a time
     const size_t mMaxLockedBuffers;
@@ -152,10 +167,39 @@ class CpuConsumer : public ConsumerBase
 
     status_t lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer) const;
 
+    // Records a buffer locked by lockNextBuffer as handed out to the user.
+    void trackLockedBufferLocked(const BufferItem& item, const LockedBuffer& buffer);
+
+    // Runs on the prefetch thread: acquires and locks queued buffers until
+    // the prefetch budget is used up or the queue is empty.
+    void prefetchBuffers();
+
+    // Wakes the prefetch thread, if it has been started.
+    void requestPrefetch();
+
     Vector<AcquiredBuffer> mAcquiredBuffers;
 
     // Count of currently locked buffers
     size_t mCurrentLockedBuffers;
+
+    struct PrefetchedBuffer {
+        BufferItem item;
+        LockedBuffer buffer;
+        status_t status;
+    };
+
+    // State shared with the prefetch thread, which only holds a weak
+    // reference to the CpuConsumer while idle.
+    struct PrefetchThreadState;
+
+    size_t mPrefetchCount = 0;
+    // Buffers acquired by the prefetch thread, in queue order.
+    std::deque<PrefetchedBuffer> mPrefetchedBuffers;
+    // Buffers acquired by the prefetch thread that are still being locked.
+    size_t mPrefetchesInFlight = 0;
+    // Signaled when a prefetch completes.
+    Condition mPrefetchCondition;
+    const std::shared_ptr<PrefetchThreadState> mPrefetchThread;
 };
 
 } // namespace android
@@ -26,7 +26,9 @@
 #include <utils/Timers.h>
 
 #include <array>
+#include <atomic>
 #include <bitset>
+#include <type_traits>
 #include <vector>
 
 namespace android {
@@ -85,6 +87,80 @@ struct FrameEvents {
     std::shared_ptr<FenceTime> releaseFence{FenceTime::NO_FENCE};
 };
 
+// A plain copy of the parts of FrameEvents the producer reports through
+// Surface::getFrameTimestamps. Fence times hold the FenceTime's cached signal
+// time from when the snapshot was taken, so they may read
+// SIGNAL_TIME_PENDING for a fence that has signaled since.
+struct FrameEventsSnapshot {
+    enum : uint64_t {
+        VALID = 1 << 0,
+        ADD_POST_COMPOSITE_CALLED = 1 << 1,
+        ADD_RELEASE_CALLED = 1 << 2,
+        HAS_ACQUIRE = 1 << 3,
+    };
+
+    FrameEventsSnapshot() = default;
+    explicit FrameEventsSnapshot(const FrameEvents& frame);
+
+    bool hasLatchInfo() const { return FrameEvents::isValidTimestamp(latchTime); }
+    bool hasFirstRefreshStartInfo() const {
+        return FrameEvents::isValidTimestamp(firstRefreshStartTime);
+    }
+    bool hasLastRefreshStartInfo() const { return flags & ADD_RELEASE_CALLED; }
+    bool hasDequeueReadyInfo() const { return FrameEvents::isValidTimestamp(dequeueReadyTime); }
+    bool hasAcquireInfo() const { return flags & HAS_ACQUIRE; }
+    bool hasGpuCompositionDoneInfo() const { return flags & ADD_POST_COMPOSITE_CALLED; }
+    bool hasDisplayPresentInfo() const { return flags & ADD_POST_COMPOSITE_CALLED; }
+    bool hasReleaseInfo() const { return flags & ADD_RELEASE_CALLED; }
+
+    uint64_t frameNumber{0};
+    uint64_t flags{0};
+
+    nsecs_t requestedPresentTime{FrameEvents::TIMESTAMP_PENDING};
+    nsecs_t latchTime{FrameEvents::TIMESTAMP_PENDING};
+    nsecs_t firstRefreshStartTime{FrameEvents::TIMESTAMP_PENDING};
+    nsecs_t lastRefreshStartTime{FrameEvents::TIMESTAMP_PENDING};
+    nsecs_t dequeueReadyTime{FrameEvents::TIMESTAMP_PENDING};
+
+    nsecs_t acquireTime{Fence::SIGNAL_TIME_INVALID};
+    nsecs_t gpuCompositionDoneTime{Fence::SIGNAL_TIME_INVALID};
+    nsecs_t displayPresentTime{Fence::SIGNAL_TIME_INVALID};
+    nsecs_t releaseTime{Fence::SIGNAL_TIME_INVALID};
+};
+
+// A fixed-size ring of FrameEventsSnapshots indexed by frame number. Each
+// entry is guarded by a sequence lock, so readers never block the producer
+// and never take a lock themselves.
+//
+// Only one thread may publish or invalidate at a time; the producer does so
+// with the Surface lock held. Any number of threads may read.
+class FrameEventsSnapshotRing {
+public:
+    static constexpr size_t CAPACITY = 32;
+
+    void publish(const FrameEvents& frame);
+    void invalidate(uint64_t frameNumber);
+
+    // Returns false if the frame is not in the ring, or if it kept being
+    // republished while reading it.
+    bool read(uint64_t frameNumber, FrameEventsSnapshot* outSnapshot) const;
+
+private:
+    static_assert(std::is_trivially_copyable_v<FrameEventsSnapshot>);
+    static_assert(sizeof(FrameEventsSnapshot) % sizeof(uint64_t) == 0);
+    static constexpr size_t WORD_COUNT = sizeof(FrameEventsSnapshot) / sizeof(uint64_t);
+
+    struct Entry {
+        // Odd while the entry is being written.
+        std::atomic<uint32_t> sequence{0};
+        std::array<std::atomic<uint64_t>, WORD_COUNT> words{};
+    };
+
+    void store(Entry& entry, const FrameEventsSnapshot& snapshot);
+
+    std::array<Entry, CAPACITY> mEntries;
+};
+
 // A short history of frames that are synchronized between the consumer and
 // producer via deltas.
 class FrameEventHistory {
@@ -131,6 +207,16 @@ public:
 
     void updateSignalTimes();
 
+    // Republishes the snapshot of a frame whose fence times may have been
+    // resolved since it was last published.
+    void publishSnapshot(const FrameEvents& frame) { mSnapshots.publish(frame); }
+
+    // Lock-free. Fills outSnapshot with the latest published state of the
+    // frame, if it is still in the history.
+    bool getSnapshot(uint64_t frameNumber, FrameEventsSnapshot* outSnapshot) const {
+        return mSnapshots.read(frameNumber, outSnapshot);
+    }
+
 protected:
     void applyFenceDelta(FenceTimeline* timeline,
             std::shared_ptr<FenceTime>* dst,
@@ -151,6 +237,10 @@ protected:
     FenceTimeline mGpuCompositionDoneTimeline;
     FenceTimeline mPresentTimeline;
     FenceTimeline mReleaseTimeline;
+
+    // Copies of the valid entries of mFrames, republished whenever they
+    // change.
+    FrameEventsSnapshotRing mSnapshots;
 };
 
 
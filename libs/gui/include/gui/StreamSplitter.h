@@ -17,6 +17,7 @@
 #ifndef ANDROID_GUI_STREAMSPLITTER_H
 #define ANDROID_GUI_STREAMSPLITTER_H
 
+#include <gui/BufferQueueDefs.h>
 #include <gui/IConsumerListener.h>
 #include <gui/IProducerListener.h>
 
@@ -25,6 +26,9 @@
 #include <utils/Mutex.h>
 #include <utils/StrongPointer.h>
 
+#include <atomic>
+#include <mutex>
+
 namespace android {
 
 class GraphicBuffer;
@@ -37,6 +41,10 @@ class IGraphicBufferProducer;
 // BufferQueue, where each buffer queued to the input is available to be
 // acquired by each of the outputs, and is able to be dequeued by the input
 // again only once all of the outputs have released it.
+//
+// Buffers stay attached to the input while the outputs hold them, so the
+// input's producer gets the same buffer back in the same slot and does not
+// have to re-import it.
 class StreamSplitter : public BnConsumerListener {
 public:
     // createSplitter creates a new splitter, outSplitter, using inputQueue as
@@ -77,10 +85,10 @@ private:
     virtual void onFrameAvailable(const BufferItem& item);
 
     // From IConsumerListener
-    // We don't care about released buffers because we detach each buffer as
-    // soon as we acquire it. See the comment for onBufferReleased below for
-    // some clarifying notes about the name.
-    virtual void onBuffersReleased() {}
+    // Drops the cached buffers of input slots that have been freed. See the
+    // comment for onBufferReleased below for some clarifying notes about the
+    // name.
+    virtual void onBuffersReleased();
 
     // From IConsumerListener
     // We don't care about sideband streams, since we won't be splitting them
@@ -94,7 +102,9 @@ private:
     // generated the callback, update our state tracking to see if this is the
     // last output releasing the buffer, and if so, release it to the input.
     // If we release the buffer to the input, we allow a blocked
-    // onFrameAvailable call to proceed.
+    // onFrameAvailable call to proceed. Only the tracker lookup and the final
+    // release happen with mMutex held, so outputs releasing the same frame do
+    // not serialize on each other's binder calls.
     void onBufferReleasedByOutput(const sp<IGraphicBufferProducer>& from);
 
     // When this is called, the splitter disconnects from (i.e., abandons) its
@@ -128,16 +138,19 @@ private:
 
     class BufferTracker : public LightRefBase<BufferTracker> {
     public:
-        explicit BufferTracker(const sp<GraphicBuffer>& buffer);
+        BufferTracker(const sp<GraphicBuffer>& buffer, int slot, uint64_t frameNumber);
 
         const sp<GraphicBuffer>& getBuffer() const { return mBuffer; }
-        const sp<Fence>& getMergedFence() const { return mMergedFence; }
+        int getSlot() const { return mSlot; }
+        uint64_t getFrameNumber() const { return mFrameNumber; }
+        sp<Fence> getMergedFence() const;
 
         void mergeFence(const sp<Fence>& with);
 
         // Returns the new value
-        // Only called while mMutex is held
-        size_t incrementReleaseCountLocked() { return ++mReleaseCount; }
+        size_t incrementReleaseCount() {
+            return mReleaseCount.fetch_add(1, std::memory_order_acq_rel) + 1;
+        }
 
     private:
         // Only destroy through LightRefBase
@@ -149,10 +162,18 @@ private:
         BufferTracker& operator=(const BufferTracker& other);
 
         sp<GraphicBuffer> mBuffer; // One instance that holds this native handle
+        // The input slot and frame number the buffer was acquired with
+        const int mSlot;
+        const uint64_t mFrameNumber;
+        mutable std::mutex mFenceMutex;
         sp<Fence> mMergedFence;
-        size_t mReleaseCount;
+        std::atomic<size_t> mReleaseCount;
     };
 
+    // Releases a buffer that every output is done with back to the input.
+    // This must be called with mMutex locked.
+    void releaseToInputLocked(const sp<BufferTracker>& tracker);
+
     // Only called from createSplitter
     explicit StreamSplitter(const sp<IGraphicBufferConsumer>& inputQueue);
 
@@ -173,6 +194,10 @@ private:
     sp<IGraphicBufferConsumer> mInput;
     Vector<sp<IGraphicBufferProducer> > mOutputs;
 
+    // The buffers attached to each input slot, since acquireBuffer only
+    // returns a buffer the first time a slot is acquired.
+    sp<GraphicBuffer> mInputSlots[BufferQueueDefs::NUM_BUFFER_SLOTS];
+
     // Map of GraphicBuffer IDs (GraphicBuffer::getId()) to buffer tracking
     // objects (which are mostly for counting how many outputs have released the
     // buffer, but also contain merged release fences).
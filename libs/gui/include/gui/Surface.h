@@ -31,6 +31,7 @@
 #include <utils/Mutex.h>
 #include <utils/RefBase.h>
 
+#include <atomic>
 #include <shared_mutex>
 #include <unordered_set>
 
@@ -517,6 +518,18 @@ protected:
 #endif // COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(WB_PLATFORM_API_IMPROVEMENTS)
 
     void querySupportedTimestampsLocked() const;
+    void updateFrameTimestampsQueryableLocked() const;
+
+    // Answers getFrameTimestamps() from the published frame event snapshots
+    // without taking mMutex. Returns false if the locked path must be taken,
+    // e.g. because the consumer may have newer timestamps or a requested
+    // fence time is still pending.
+    bool getFrameTimestampsFromSnapshot(uint64_t frameNumber,
+            nsecs_t* outRequestedPresentTime, nsecs_t* outAcquireTime,
+            nsecs_t* outLatchTime, nsecs_t* outFirstRefreshStartTime,
+            nsecs_t* outLastRefreshStartTime, nsecs_t* outGpuCompositionDoneTime,
+            nsecs_t* outDisplayPresentTime, nsecs_t* outDequeueReadyTime,
+            nsecs_t* outReleaseTime) const;
 
     void freeAllBuffers();
     int getSlotFromBufferLocked(android_native_buffer_t* buffer) const;
@@ -725,6 +738,14 @@ protected:
     bool mEnableFrameTimestamps = false;
     std::unique_ptr<ProducerFrameEventHistory> mFrameEventHistory;
 
+    // Copies of the frame timestamp state above for getFrameTimestamps()
+    // to read without mMutex. Only written with mMutex held.
+    // mFrameTimestampsQueryable is true once timestamps are enabled and the
+    // supported timestamps have been queried.
+    mutable std::atomic<bool> mFrameTimestampsQueryable{false};
+    mutable std::atomic<bool> mFrameTimestampsQueryableSupportsPresent{false};
+    std::atomic<uint64_t> mLastQueuedFrameNumber{0};
+
     // Reference to the SurfaceFlinger layer that was used to create this
     // surface. This is only populated when the Surface is created from
     // a BlastBufferQueue.
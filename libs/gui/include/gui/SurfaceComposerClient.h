@@ -51,6 +51,7 @@
 #include <gui/ITransactionCompletedListener.h>
 #include <gui/LayerState.h>
 #include <gui/SurfaceControl.h>
+#include <gui/TransactionCompletionChannel.h>
 #include <gui/WindowInfosListenerReporter.h>
 #include <math/vec3.h>
 
@@ -1009,6 +1010,18 @@ protected:
     std::unordered_map<int, std::tuple<TrustedPresentationCallback, void*>>
             mTrustedPresentationCallbacks;
 
+    // Set while completion callbacks are delivered through a TransactionCompletionChannel. The
+    // reader thread exits once this is cleared.
+    std::shared_ptr<std::atomic_bool> mCompletionChannelRunning GUARDED_BY(mMutex);
+    std::shared_ptr<gui::TransactionCompletionChannel::ConsumerEndpoint> mCompletionChannel
+            GUARDED_BY(mMutex);
+    // Held while enabling or disabling the channel, across the calls to SurfaceFlinger.
+    std::mutex mCompletionChannelMutex;
+    // Held while reading from the channel and dispatching, so that callbacks which arrive
+    // through binder are dispatched after the batches SurfaceFlinger published before them.
+    // Acquired before mMutex.
+    std::mutex mCompletionChannelReadMutex;
+
 public:
     static sp<TransactionCompletedListener> getInstance();
     static sp<ITransactionCompletedListener> getIInstance();
@@ -1038,6 +1051,16 @@ public:
 
     void setReleaseBufferCallback(const ReleaseCallbackId&, ReleaseBufferCallback);
 
+    /**
+     * Asks SurfaceFlinger to deliver this process's transaction completion callbacks through a
+     * shared-memory TransactionCompletionChannel instead of a binder call per frame. Callbacks are
+     * dispatched from a dedicated thread. Returns INVALID_OPERATION if the channel is not
+     * supported, and PERMISSION_DENIED unless the process has ACCESS_SURFACE_FLINGER. Neither may
+     * be called from a transaction completion callback.
+     */
+    status_t enableCompletionChannel();
+    void disableCompletionChannel();
+
     // BnTransactionCompletedListener overrides
     void onTransactionCompleted(ListenerStats stats) override;
     void onReleaseBuffer(ReleaseCallbackId, sp<Fence> releaseFence,
@@ -1054,6 +1077,9 @@ public:
 
 private:
     ReleaseBufferCallback popReleaseBufferCallbackLocked(const ReleaseCallbackId&) REQUIRES(mMutex);
+    void dispatchTransactionCompleted(ListenerStats stats);
+    void readCompletionChannelLocked(gui::TransactionCompletionChannel::ConsumerEndpoint& channel)
+            REQUIRES(mCompletionChannelReadMutex);
     static sp<TransactionCompletedListener> sInstance;
 };
 
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <android-base/unique_fd.h>
+
+#include <gui/ITransactionCompletedListener.h>
+#include <ui/Fence.h>
+#include <utils/Errors.h>
+
+namespace android::gui {
+
+/**
+ * Delivers transaction completion stats from SurfaceFlinger to a client process without a binder
+ * transaction per frame.
+ *
+ * SurfaceFlinger creates the channel and hands only the consumer side to the client. Completed
+ * ListenerStats are written as fixed-size records into a single-producer, single-consumer ring in
+ * shared memory. Each batch is announced by a message over a unix domain seqpacket socket, sent
+ * before the batch is published, which carries all the fences of the batch and wakes the client
+ * up. The producer owns its end of the socket, and sends with MSG_DONTWAIT, so nothing the client
+ * does to its own file descriptors can make the producer block.
+ *
+ * Surfaces are identified by layer id instead of by handle, so the consumer resolves handles
+ * through a callback when reading.
+ */
+class TransactionCompletionChannel {
+public:
+    // Number of records in the ring. A batch that does not fit must be sent through binder.
+    static constexpr size_t kCapacity = 256;
+
+    // Maximum number of fences sent with a single batch, well below SCM_MAX_FD.
+    static constexpr size_t kMaxFencesPerBatch = 128;
+
+    struct SharedRing;
+
+    class ConsumerEndpoint {
+    public:
+        /**
+         * Maps the shared ring of a channel created by TransactionCompletionChannel::create.
+         * Returns null if the memory is too small to hold the ring.
+         */
+        static std::unique_ptr<ConsumerEndpoint> create(std::string name,
+                                                        android::base::unique_fd memoryFd,
+                                                        android::base::unique_fd fenceFd);
+
+        ConsumerEndpoint(std::string name, android::base::unique_fd memoryFd,
+                         android::base::unique_fd wakeFd, android::base::unique_fd fenceFd,
+                         SharedRing* ring);
+        ~ConsumerEndpoint();
+
+        ConsumerEndpoint(const ConsumerEndpoint&) = delete;
+        void operator=(const ConsumerEndpoint&) = delete;
+
+        using HandleResolver =
+                std::function<sp<IBinder>(const std::vector<CallbackId>& callbackIds,
+                                          int32_t layerId)>;
+
+        /**
+         * Reads the next batch of completed transactions.
+         *
+         * Returns OK on success.
+         * Returns WOULD_BLOCK if no batch has been published.
+         * Other errors mean that the channel is broken.
+         */
+        status_t read(ListenerStats& outStats, const HandleResolver& resolveHandle);
+
+        /**
+         * Blocks until the producer publishes a batch or wake() is called.
+         */
+        void waitForBatch();
+
+        /**
+         * Interrupts waitForBatch().
+         */
+        void wake();
+
+    private:
+        status_t readFences(uint64_t sequence, uint32_t fenceCount,
+                            std::vector<sp<Fence>>& outFences);
+
+        std::string mName;
+        android::base::unique_fd mMemoryFd;
+        // Private to the consumer, only used by wake().
+        android::base::unique_fd mWakeFd;
+        android::base::unique_fd mFenceFd;
+        SharedRing* mRing;
+        uint64_t mReadPosition = 0;
+        bool mProducerClosed = false;
+    };
+
+    class ProducerEndpoint {
+    public:
+        ProducerEndpoint(std::string name, android::base::unique_fd memoryFd,
+                         android::base::unique_fd fenceFd, SharedRing* ring);
+        ~ProducerEndpoint();
+
+        ProducerEndpoint(const ProducerEndpoint&) = delete;
+        void operator=(const ProducerEndpoint&) = delete;
+
+        using LayerIdResolver = std::function<int32_t(const sp<IBinder>& surfaceControl)>;
+
+        /**
+         * Publishes one batch of completed transactions and wakes up the consumer.
+         *
+         * Returns OK on success.
+         * Returns WOULD_BLOCK if the batch does not fit in the ring or the socket, or carries too
+         * many fences, in which case nothing was written and the batch must be sent through
+         * binder.
+         * Other errors mean that the channel is broken.
+         */
+        status_t write(const ListenerStats& stats, const LayerIdResolver& resolveLayerId);
+
+    private:
+        status_t writeFences(uint64_t sequence, const std::vector<int>& fds);
+
+        std::string mName;
+        android::base::unique_fd mMemoryFd;
+        android::base::unique_fd mFenceFd;
+        SharedRing* mRing;
+        uint64_t mWritePosition = 0;
+        uint64_t mBatchSequence = 0;
+    };
+
+    /**
+     * Creates a channel on the producer side. The returned file descriptors are the consumer's
+     * ends, to be handed to ConsumerEndpoint::create in the client process.
+     *
+     * Return OK on success.
+     */
+    static status_t create(std::string name, std::shared_ptr<ProducerEndpoint>& outProducer,
+                           android::base::unique_fd& outConsumerMemoryFd,
+                           android::base::unique_fd& outConsumerFenceFd);
+
+    /**
+     * Create the two endpoints that make up a TransactionCompletionChannel in this process.
+     *
+     * Return OK on success.
+     */
+    static status_t open(std::string name, std::unique_ptr<ConsumerEndpoint>& outConsumer,
+                         std::shared_ptr<ProducerEndpoint>& outProducer);
+};
+
+} // namespace android::gui
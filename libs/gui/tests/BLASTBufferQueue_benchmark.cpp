@@ -0,0 +1,231 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <gui/BLASTBufferQueue.h>
+#include <gui/BufferReleaseChannel.h>
+#include <gui/Surface.h>
+#include <gui/SurfaceComposerClient.h>
+#include <system/window.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace {
+
+using gui::BufferReleaseChannel;
+using Transaction = SurfaceComposerClient::Transaction;
+
+// Simulates the work the producer thread does while holding the BLASTBufferQueue lock in
+// onFrameAvailable/acquireNextBufferLocked.
+void busyWork(int count = 200) {
+    for (int i = 0; i < count; i++) {
+        benchmark::ClobberMemory();
+    }
+}
+
+// Stands in for the state BLASTBufferQueue guards with its lock.
+struct ReleaseState {
+    std::deque<ReleaseCallbackId> pendingRelease;
+    uint64_t applied = 0;
+
+    // Simulates releaseBufferCallbackLocked.
+    void apply(const ReleaseCallbackId& id) {
+        pendingRelease.push_back(id);
+        while (pendingRelease.size() > 2) {
+            pendingRelease.pop_front();
+        }
+        busyWork(20);
+        applied++;
+    }
+};
+
+// Baseline: release callbacks take the same mutex as the producer, like the locked release path.
+void BM_ReleaseContention_Mutex(benchmark::State& state) {
+    static std::mutex sMutex;
+    static ReleaseState sState;
+
+    if (state.thread_index() == 0) {
+        // Producer thread.
+        sState = {};
+        for (auto _ : state) {
+            std::lock_guard lock{sMutex};
+            busyWork();
+        }
+    } else {
+        // Binder callback threads.
+        uint64_t frameNumber = 0;
+        for (auto _ : state) {
+            std::lock_guard lock{sMutex};
+            sState.apply({static_cast<uint64_t>(state.thread_index()), frameNumber++});
+        }
+    }
+
+    // Both variants are compared by the releases applied while the threads ran, rather than by
+    // how fast the callbacks return.
+    if (state.thread_index() == 0) {
+        std::lock_guard lock{sMutex};
+        state.SetItemsProcessed(sState.applied);
+    }
+}
+BENCHMARK(BM_ReleaseContention_Mutex)->ThreadRange(2, 8)->UseRealTime();
+
+// Mirrors BLASTBufferQueue::ReleaseRingMutex: the ring is drained whenever the mutex is unlocked.
+class ReleaseRingLock {
+public:
+    ReleaseRingLock(BufferReleaseChannel::ReleaseRing& ring, ReleaseState& state)
+          : mRing(ring), mState(state) {}
+
+    void lock() {
+        mMutex.lock();
+        mHeld = true;
+    }
+
+    bool try_lock() {
+        if (!mMutex.try_lock()) {
+            return false;
+        }
+        mHeld = true;
+        return true;
+    }
+
+    void unlock() {
+        while (true) {
+            BufferReleaseChannel::ReleaseRing::Entry entry;
+            while (mRing.pop(entry)) {
+                mState.apply(entry.releaseCallbackId);
+            }
+            mHeld = false;
+            mMutex.unlock();
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (mRing.empty() || !try_lock()) {
+                return;
+            }
+        }
+    }
+
+    // Like BLASTBufferQueue::releaseBufferCallback.
+    void release(const ReleaseCallbackId& id) {
+        if (mRing.push({id, Fence::NO_FENCE, std::nullopt})) {
+            while (!mRing.empty()) {
+                if (try_lock()) {
+                    unlock();
+                    return;
+                }
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (mHeld) {
+                    return;
+                }
+            }
+            return;
+        }
+        // Ring full: fall back to the locked path.
+        std::lock_guard lock{*this};
+        mState.apply(id);
+    }
+
+private:
+    BufferReleaseChannel::ReleaseRing& mRing;
+    ReleaseState& mState;
+    std::mutex mMutex;
+    std::atomic<bool> mHeld{false};
+};
+
+// Release callbacks push into the ring and whoever holds the lock applies them.
+void BM_ReleaseContention_Ring(benchmark::State& state) {
+    static BufferReleaseChannel::ReleaseRing sRing;
+    static ReleaseState sState;
+    static ReleaseRingLock sLock{sRing, sState};
+
+    if (state.thread_index() == 0) {
+        // Apply what the previous run left in the ring before starting over.
+        { std::lock_guard lock{sLock}; }
+        sState = {};
+        for (auto _ : state) {
+            std::lock_guard lock{sLock};
+            busyWork();
+        }
+    } else {
+        uint64_t frameNumber = 0;
+        for (auto _ : state) {
+            sLock.release({static_cast<uint64_t>(state.thread_index()), frameNumber++});
+        }
+    }
+
+    // Releases still queued in the ring haven't completed, so aren't counted.
+    if (state.thread_index() == 0) {
+        sLock.lock();
+        state.SetItemsProcessed(sState.applied);
+        sLock.unlock();
+    }
+}
+BENCHMARK(BM_ReleaseContention_Ring)->ThreadRange(2, 8)->UseRealTime();
+
+// End to end: a producer queueing as fast as possible into a triple-buffered BLASTBufferQueue
+// while SurfaceFlinger release callbacks arrive on binder threads. Compare builds with and
+// without the buffer_release_ring flag.
+void BM_BLASTBufferQueue_DequeueQueue(benchmark::State& state) {
+    sp<SurfaceComposerClient> client = sp<SurfaceComposerClient>::make();
+    if (client->initCheck() != NO_ERROR) {
+        state.SkipWithError("SurfaceFlinger is not available");
+        return;
+    }
+
+    constexpr int kSize = 64;
+    sp<SurfaceControl> surfaceControl =
+            client->createSurface(String8("BLASTBufferQueueBenchmark"), kSize, kSize,
+                                  PIXEL_FORMAT_RGBA_8888,
+                                  ISurfaceComposerClient::eFXSurfaceBufferState);
+    if (surfaceControl == nullptr) {
+        state.SkipWithError("Failed to create surface");
+        return;
+    }
+    Transaction()
+            .setLayer(surfaceControl, std::numeric_limits<int32_t>::max())
+            .show(surfaceControl)
+            .apply(true /* synchronous */);
+
+    sp<BLASTBufferQueue> blastBufferQueue =
+            sp<BLASTBufferQueue>::make("BLASTBufferQueueBenchmark", surfaceControl, kSize, kSize,
+                                       PIXEL_FORMAT_RGBA_8888);
+    sp<Surface> surface = blastBufferQueue->getSurface(false /* includeSurfaceControlHandle */);
+    ANativeWindow* window = surface.get();
+    native_window_api_connect(window, NATIVE_WINDOW_API_CPU);
+    surface->setMaxDequeuedBufferCount(state.range(0) - 1);
+
+    for (auto _ : state) {
+        ANativeWindowBuffer* buffer = nullptr;
+        int fenceFd = -1;
+        if (window->dequeueBuffer(window, &buffer, &fenceFd) != NO_ERROR) {
+            state.SkipWithError("dequeueBuffer failed");
+            break;
+        }
+        sp<Fence>::make(fenceFd)->waitForever("BLASTBufferQueueBenchmark");
+        window->queueBuffer(window, buffer, -1 /* fenceFd */);
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    native_window_api_disconnect(window, NATIVE_WINDOW_API_CPU);
+    Transaction().reparent(surfaceControl, nullptr).apply(true /* synchronous */);
+}
+BENCHMARK(BM_BLASTBufferQueue_DequeueQueue)->Arg(2)->Arg(3)->UseRealTime();
+
+} // namespace
+} // namespace android
@@ -20,6 +20,7 @@
 
 #include <android-base/thread_annotations.h>
 #include <android/hardware/graphics/common/1.2/types.h>
+#include <ftl/fake_guard.h>
 #include <gui/AidlUtil.h>
 #include <gui/BufferQueueCore.h>
 #include <gui/BufferQueueProducer.h>
@@ -45,6 +46,10 @@
 
 #include <com_android_graphics_libgui_flags.h>
 
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
 using namespace std::chrono_literals;
 
 namespace android {
@@ -61,6 +66,21 @@ public:
         mReleaseCallback.notify_one();
     }
 
+    void onBuffersDiscarded(const std::vector<int32_t>& slots) override {
+        std::scoped_lock<std::mutex> lock(mMutex);
+        mNumDiscarded += static_cast<int32_t>(slots.size());
+        mReleaseCallback.notify_one();
+    }
+
+    void waitOnNumberDiscarded(int32_t expectedNumDiscarded, std::chrono::seconds timeout) {
+        std::unique_lock lock{mMutex};
+        base::ScopedLockAssertion assumeLocked(mMutex);
+        while (mNumDiscarded < expectedNumDiscarded) {
+            ASSERT_NE(mReleaseCallback.wait_for(lock, timeout), std::cv_status::timeout)
+                    << "did not receive discarded buffers";
+        }
+    }
+
     void waitOnNumberReleased(int32_t expectedNumReleased) {
         std::unique_lock lock{mMutex};
         base::ScopedLockAssertion assumeLocked(mMutex);
@@ -75,6 +95,7 @@ private:
     std::mutex mMutex;
     std::condition_variable mReleaseCallback;
     int32_t mNumReleased GUARDED_BY(mMutex) = 0;
+    int32_t mNumDiscarded GUARDED_BY(mMutex) = 0;
 };
 
 class TestBLASTBufferQueue : public BLASTBufferQueue {
@@ -166,10 +187,10 @@ public:
 
     void waitForCallbacks() {
         std::unique_lock lock{mBlastBufferQueueAdapter->mMutex};
-        base::ScopedLockAssertion assumeLocked(mBlastBufferQueueAdapter->mMutex);
+        ftl::FakeGuard assumeLocked(mBlastBufferQueueAdapter->mMutex);
         // Wait until all but one of the submitted buffers have been released.
         while (mBlastBufferQueueAdapter->mSubmitted.size() > 1) {
-            mBlastBufferQueueAdapter->mCallbackCV.wait(lock);
+            mBlastBufferQueueAdapter->waitForCallbackCVLocked(lock);
         }
     }
 
@@ -177,6 +198,18 @@ public:
         mBlastBufferQueueAdapter->waitForCallback(frameNumber);
     }
 
+    // Returns the adaptive buffer count target reported in the BufferQueue dump, or -1.
+    int getAdaptiveBufferCount() {
+        String8 dump;
+        mBlastBufferQueueAdapter->mBufferItemConsumer->dumpState(dump);
+        const char* target = strstr(dump.c_str(), "adaptive-buffer-count: target=");
+        int count = -1;
+        if (target != nullptr) {
+            sscanf(target, "adaptive-buffer-count: target=%d", &count);
+        }
+        return count;
+    }
+
     void validateNumFramesSubmitted(size_t numFramesSubmitted) {
         std::scoped_lock lock{mBlastBufferQueueAdapter->mMutex};
         ASSERT_EQ(numFramesSubmitted, mBlastBufferQueueAdapter->mSubmitted.size());
@@ -515,6 +548,74 @@ TEST_F(BLASTBufferQueueTest, TripleBuffering) {
     adapter.waitForCallbacks();
 }
 
+TEST_F(BLASTBufferQueueTest, AdaptiveBufferCount) {
+    if (!flags::bq_adaptive_buffer_count()) {
+        GTEST_SKIP() << "bq_adaptive_buffer_count is disabled";
+    }
+    BLASTBufferQueueHelper adapter(mSurfaceControl, mDisplayWidth, mDisplayHeight);
+    sp<IGraphicBufferProducer> igbProducer;
+    setUpProducer(adapter, igbProducer, 3 /* maxBufferCount */);
+
+    int minUndequeuedBuffers = 0;
+    ASSERT_EQ(OK, igbProducer->query(NATIVE_WINDOW_MIN_UNDEQUEUED_BUFFERS, &minUndequeuedBuffers));
+    const int maxDequeued = 3;
+    const int bufferCount = minUndequeuedBuffers + maxDequeued;
+
+    auto dequeue = [&](int* outSlot, sp<Fence>* outFence) {
+        sp<GraphicBuffer> buf;
+        auto ret = igbProducer->dequeueBuffer(outSlot, outFence, mDisplayWidth, mDisplayHeight,
+                                              PIXEL_FORMAT_RGBA_8888,
+                                              GRALLOC_USAGE_SW_WRITE_OFTEN, nullptr, nullptr);
+        if (ret == IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+            EXPECT_EQ(OK, igbProducer->requestBuffer(*outSlot, &buf));
+            return OK;
+        }
+        return ret;
+    };
+
+    // Allocate every buffer the producer may use.
+    std::vector<std::pair<int, sp<Fence>>> dequeued(bufferCount);
+    for (auto& [slot, fence] : dequeued) {
+        ASSERT_EQ(OK, dequeue(&slot, &fence));
+    }
+    for (const auto& [slot, fence] : dequeued) {
+        igbProducer->cancelBuffer(slot, fence);
+    }
+
+    // Produce one frame at a time. The queue never holds more than one buffer, so the target
+    // drops below the buffer count, and the idle buffer is discarded.
+    const nsecs_t end = systemTime() + BufferCountController::EVALUATION_WINDOW +
+            BufferCountController::IDLE_TIMEOUT + ms2ns(500);
+    while (systemTime() < end) {
+        int slot;
+        sp<Fence> fence;
+        ASSERT_EQ(OK, dequeue(&slot, &fence));
+        IGraphicBufferProducer::QueueBufferOutput qbOutput;
+        IGraphicBufferProducer::QueueBufferInput input(systemTime(), true /* autotimestamp */,
+                                                       HAL_DATASPACE_UNKNOWN,
+                                                       Rect(mDisplayWidth, mDisplayHeight),
+                                                       NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                       Fence::NO_FENCE);
+        ASSERT_EQ(OK, igbProducer->queueBuffer(slot, input, &qbOutput));
+        adapter.waitForCallbacks();
+        std::this_thread::sleep_for(16ms);
+    }
+    const int shrunkCount = adapter.getAdaptiveBufferCount();
+    EXPECT_LT(shrunkCount, bufferCount);
+    ASSERT_NO_FATAL_FAILURE(mProducerListener->waitOnNumberDiscarded(1, 3s));
+
+    // A burst dequeuing every buffer allowed, while the last frame is still on screen, grows the
+    // target right away rather than waiting for a buffer to be released.
+    dequeued.resize(maxDequeued);
+    for (auto& [slot, fence] : dequeued) {
+        ASSERT_EQ(OK, dequeue(&slot, &fence));
+    }
+    EXPECT_GT(adapter.getAdaptiveBufferCount(), shrunkCount);
+    for (const auto& [slot, fence] : dequeued) {
+        igbProducer->cancelBuffer(slot, fence);
+    }
+}
+
 class WaitForCommittedCallback {
 public:
     WaitForCommittedCallback() = default;
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <gui/BufferCountController.h>
+#include <system/graphics.h>
+
+namespace android::test {
+namespace {
+
+constexpr int kMinBufferCount = 2;
+constexpr int kMaxBufferCount = 4;
+constexpr nsecs_t kWindow = BufferCountController::EVALUATION_WINDOW;
+
+// Feeds one evaluation window where the queue never holds more than maxOccupancy buffers.
+void runWindow(BufferCountController& controller, nsecs_t& now, size_t maxOccupancy) {
+    controller.onOccupancyChange(maxOccupancy, now);
+    controller.onOccupancyChange(0, now + kWindow / 2);
+    now += kWindow;
+    controller.onOccupancyChange(0, now);
+}
+
+} // namespace
+
+TEST(BufferCountControllerTest, DisabledUsesMaxBufferCount) {
+    BufferCountController controller;
+    nsecs_t now = 1;
+    runWindow(controller, now, 0);
+    EXPECT_EQ(kMaxBufferCount, controller.getTargetBufferCount(kMinBufferCount, kMaxBufferCount));
+    EXPECT_FALSE(controller.shouldTrim(kMaxBufferCount, kMinBufferCount, now + s2ns(10)));
+}
+
+TEST(BufferCountControllerTest, ShrinksToDoubleBuffering) {
+    BufferCountController controller;
+    controller.setEnabled(true);
+    EXPECT_EQ(kMaxBufferCount, controller.getTargetBufferCount(kMinBufferCount, kMaxBufferCount));
+
+    nsecs_t now = 1;
+    runWindow(controller, now, 1);
+    EXPECT_EQ(kMinBufferCount + 1,
+              controller.getTargetBufferCount(kMinBufferCount, kMaxBufferCount));
+
+    // The queue never holds a buffer: after enough quiet windows drop one more buffer.
+    for (int i = 0; i < BufferCountController::SHRINK_WINDOW_COUNT; i++) {
+        runWindow(controller, now, 0);
+    }
+    EXPECT_EQ(kMinBufferCount, controller.getTargetBufferCount(kMinBufferCount, kMaxBufferCount));
+}
+
+TEST(BufferCountControllerTest, GrowsOnOccupancyAndWhenTargetReached) {
+    BufferCountController controller;
+    controller.setEnabled(true);
+
+    nsecs_t now = 1;
+    runWindow(controller, now, 0);
+    EXPECT_EQ(kMinBufferCount, controller.getTargetBufferCount(kMinBufferCount, kMaxBufferCount));
+
+    controller.onTargetReached();
+    EXPECT_EQ(kMinBufferCount + 1,
+              controller.getTargetBufferCount(kMinBufferCount, kMaxBufferCount));
+
+    runWindow(controller, now, 2);
+    EXPECT_EQ(kMaxBufferCount, controller.getTargetBufferCount(kMinBufferCount, kMaxBufferCount));
+}
+
+TEST(BufferCountControllerTest, TrimsAfterIdleTimeout) {
+    BufferCountController controller;
+    controller.setEnabled(true);
+
+    nsecs_t now = 1;
+    EXPECT_FALSE(controller.shouldTrim(3, 2, now));
+    EXPECT_FALSE(controller.shouldTrim(3, 2, now + BufferCountController::IDLE_TIMEOUT / 2));
+    EXPECT_TRUE(controller.shouldTrim(3, 2, now + BufferCountController::IDLE_TIMEOUT));
+
+    // Dropping back to the target resets the idle timer.
+    EXPECT_FALSE(controller.shouldTrim(2, 2, now));
+    EXPECT_FALSE(controller.shouldTrim(3, 2, now + BufferCountController::IDLE_TIMEOUT));
+}
+
+TEST(BufferCountControllerTest, EstimatesPlanarBufferBytes) {
+    EXPECT_EQ(1920u * 1080 * 4,
+              BufferCountController::estimateBufferBytes(1920, 1080, HAL_PIXEL_FORMAT_RGBA_8888,
+                                                         1));
+    // Camera and video buffers are planar, with chroma subsampled.
+    EXPECT_EQ(1920u * 1080 * 3 / 2,
+              BufferCountController::estimateBufferBytes(1920, 1080,
+                                                         HAL_PIXEL_FORMAT_YCBCR_420_888, 1));
+    EXPECT_EQ(1920u * 1080 * 3,
+              BufferCountController::estimateBufferBytes(1920, 1080, HAL_PIXEL_FORMAT_YCBCR_P010,
+                                                         1));
+    EXPECT_EQ(2 * 64u * 64 * 2,
+              BufferCountController::estimateBufferBytes(64, 64, HAL_PIXEL_FORMAT_RAW16, 2));
+}
+
+} // namespace android::test
@@ -15,6 +15,7 @@
  */
 
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -135,4 +136,85 @@ TEST(BufferReleaseChannelTest, ProduceAndConsume) {
     }
 }
 
-} // namespace android
\ No newline at end of file
+TEST(BufferReleaseChannelTest, ReleaseRingPushAndPop) {
+    BufferReleaseChannel::ReleaseRing ring;
+    ASSERT_TRUE(ring.empty());
+
+    sp<Fence> fence = sp<Fence>::make(memfd_create("fake-fence-fd", 0));
+    ASSERT_TRUE(ring.push({ReleaseCallbackId{1, 2}, fence, 3u}));
+    ASSERT_TRUE(ring.push({ReleaseCallbackId{4, 5}, Fence::NO_FENCE, std::nullopt}));
+    ASSERT_FALSE(ring.empty());
+
+    BufferReleaseChannel::ReleaseRing::Entry entry;
+    ASSERT_TRUE(ring.pop(entry));
+    EXPECT_EQ((ReleaseCallbackId{1, 2}), entry.releaseCallbackId);
+    EXPECT_EQ(fence, entry.releaseFence);
+    EXPECT_EQ(3u, entry.maxAcquiredBufferCount);
+
+    ASSERT_TRUE(ring.pop(entry));
+    EXPECT_EQ((ReleaseCallbackId{4, 5}), entry.releaseCallbackId);
+    EXPECT_EQ(Fence::NO_FENCE, entry.releaseFence);
+    EXPECT_FALSE(entry.maxAcquiredBufferCount.has_value());
+
+    ASSERT_FALSE(ring.pop(entry));
+    ASSERT_TRUE(ring.empty());
+}
+
+TEST(BufferReleaseChannelTest, ReleaseRingRejectsWhenFull) {
+    BufferReleaseChannel::ReleaseRing ring;
+    constexpr size_t kCapacity = BufferReleaseChannel::ReleaseRing::kCapacity;
+    for (uint64_t i = 0; i < kCapacity; i++) {
+        ASSERT_TRUE(ring.push({ReleaseCallbackId{i, i}, Fence::NO_FENCE, std::nullopt}));
+    }
+    ASSERT_FALSE(ring.push({ReleaseCallbackId{kCapacity, kCapacity}, Fence::NO_FENCE,
+                            std::nullopt}));
+
+    BufferReleaseChannel::ReleaseRing::Entry entry;
+    ASSERT_TRUE(ring.pop(entry));
+    EXPECT_EQ((ReleaseCallbackId{0, 0}), entry.releaseCallbackId);
+    ASSERT_TRUE(ring.push({ReleaseCallbackId{kCapacity, kCapacity}, Fence::NO_FENCE,
+                           std::nullopt}));
+}
+
+TEST(BufferReleaseChannelTest, ReleaseRingConcurrentProducers) {
+    BufferReleaseChannel::ReleaseRing ring;
+    constexpr uint64_t kThreadCount = 4;
+    constexpr uint64_t kReleasesPerThread = 1000;
+
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < kThreadCount; t++) {
+        threads.emplace_back([&ring, t] {
+            for (uint64_t i = 0; i < kReleasesPerThread; i++) {
+                while (!ring.push({ReleaseCallbackId{t, i}, Fence::NO_FENCE, std::nullopt})) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Every producer's releases must come out in the order they were pushed. Keep consuming on
+    // failure, so that the producers can finish and be joined.
+    std::vector<uint64_t> nextFrameNumber(kThreadCount, 0);
+    uint64_t received = 0;
+    BufferReleaseChannel::ReleaseRing::Entry entry;
+    while (received < kThreadCount * kReleasesPerThread) {
+        if (!ring.pop(entry)) {
+            std::this_thread::yield();
+            continue;
+        }
+        received++;
+        const uint64_t t = static_cast<uint64_t>(entry.releaseCallbackId.bufferId);
+        EXPECT_LT(t, kThreadCount);
+        if (t < kThreadCount) {
+            EXPECT_EQ(nextFrameNumber[t], entry.releaseCallbackId.framenumber);
+            nextFrameNumber[t] = entry.releaseCallbackId.framenumber + 1;
+        }
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_TRUE(ring.empty());
+}
+
+} // namespace android
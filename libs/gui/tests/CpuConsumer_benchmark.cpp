@@ -0,0 +1,128 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <com_android_graphics_libgui_flags.h>
+#include <gui/BufferQueue.h>
+#include <gui/CpuConsumer.h>
+#include <gui/Surface.h>
+#include <system/window.h>
+#include <ui/GraphicBuffer.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace android {
+namespace {
+
+constexpr uint32_t kWidth = 1920;
+constexpr uint32_t kHeight = 1080;
+constexpr size_t kMaxLockedBuffers = 3;
+
+class FrameCounter : public CpuConsumer::FrameAvailableListener {
+public:
+    void onFrameAvailable(const BufferItem&) override {
+        std::lock_guard lock(mMutex);
+        mPendingFrames++;
+        mCondition.notify_one();
+    }
+
+    void waitForFrame() {
+        std::unique_lock lock(mMutex);
+        mCondition.wait(lock, [this] { return mPendingFrames > 0; });
+        mPendingFrames--;
+    }
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    int mPendingFrames = 0;
+};
+
+// Touches every row of the producer's buffer, like a camera or decoder writing a frame.
+void produceFrames(const sp<Surface>& surface, std::atomic<bool>& stop) {
+    ANativeWindow* window = surface.get();
+    while (!stop.load(std::memory_order_relaxed)) {
+        ANativeWindowBuffer* anb = nullptr;
+        if (native_window_dequeue_buffer_and_wait(window, &anb) != NO_ERROR) {
+            return;
+        }
+        sp<GraphicBuffer> buffer = GraphicBuffer::from(anb);
+        uint8_t* data = nullptr;
+        if (buffer->lock(GRALLOC_USAGE_SW_WRITE_OFTEN, reinterpret_cast<void**>(&data)) == OK) {
+            for (uint32_t y = 0; y < kHeight; y++) {
+                data[y * buffer->getStride() * 4] = static_cast<uint8_t>(y);
+            }
+            buffer->unlock();
+        }
+        window->queueBuffer(window, anb, -1 /* fenceFd */);
+    }
+}
+
+// A CPU reader processing frames as fast as a synthetic producer can queue them. The argument
+// is the CpuConsumer prefetch count; 0 locks each buffer on demand.
+void BM_CpuConsumerPipeline(benchmark::State& state) {
+#if COM_ANDROID_GRAPHICS_LIBGUI_FLAGS(WB_CONSUMER_BASE_OWNS_BQ)
+    sp<CpuConsumer> consumer = sp<CpuConsumer>::make(kMaxLockedBuffers);
+    sp<Surface> surface = consumer->getSurface();
+#else
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> bufferConsumer;
+    BufferQueue::createBufferQueue(&producer, &bufferConsumer);
+    sp<CpuConsumer> consumer = sp<CpuConsumer>::make(bufferConsumer, kMaxLockedBuffers);
+    sp<Surface> surface = sp<Surface>::make(producer);
+#endif
+    consumer->setName(String8("CpuConsumerBenchmark"));
+    sp<FrameCounter> frameCounter = sp<FrameCounter>::make();
+    consumer->setFrameAvailableListener(frameCounter);
+    consumer->setPrefetchCount(static_cast<size_t>(state.range(0)));
+
+    ANativeWindow* window = surface.get();
+    native_window_api_connect(window, NATIVE_WINDOW_API_CPU);
+    native_window_set_buffers_dimensions(window, kWidth, kHeight);
+    native_window_set_buffers_format(window, HAL_PIXEL_FORMAT_RGBA_8888);
+    native_window_set_usage(window, GRALLOC_USAGE_SW_WRITE_OFTEN);
+    native_window_set_buffer_count(window, kMaxLockedBuffers + 3);
+
+    std::atomic<bool> stop = false;
+    std::thread producerThread(produceFrames, surface, std::ref(stop));
+
+    for (auto _ : state) {
+        frameCounter->waitForFrame();
+        CpuConsumer::LockedBuffer buffer;
+        if (consumer->lockNextBuffer(&buffer) != OK) {
+            continue;
+        }
+        uint32_t sum = 0;
+        for (uint32_t y = 0; y < buffer.height; y++) {
+            sum += buffer.data[y * buffer.stride * 4];
+        }
+        benchmark::DoNotOptimize(sum);
+        consumer->unlockBuffer(buffer);
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    stop = true;
+    native_window_api_disconnect(window, NATIVE_WINDOW_API_CPU);
+    consumer->abandon();
+    producerThread.join();
+}
+BENCHMARK(BM_CpuConsumerPipeline)->Arg(0)->Arg(1)->Arg(2)->UseRealTime();
+
+} // namespace
+} // namespace android
@@ -605,6 +605,51 @@ TEST_P(CpuConsumerTest, FromCpuManyInQueue) {
     }
 }
 
+TEST_P(CpuConsumerTest, FromCpuManyInQueuePrefetch) {
+    status_t err;
+    CpuConsumerTestParams params = GetParam();
+
+    const int numInQueue = 5;
+    // Set up
+
+    ASSERT_NO_FATAL_FAILURE(configureANW(mANW, params, numInQueue));
+    mCC->setPrefetchCount(params.maxLockedBuffers);
+
+    // Produce
+
+    const int64_t time[numInQueue] = { 1L, 2L, 3L, 4L, 5L};
+    uint32_t stride[numInQueue];
+
+    for (int i = 0; i < numInQueue; i++) {
+        ALOGD("Producing frame %d", i);
+        ASSERT_NO_FATAL_FAILURE(produceOneFrame(mANW, params, time[i],
+                        &stride[i]));
+    }
+
+    // Consume, in queue order regardless of which buffers were prefetched
+
+    for (int i = 0; i < numInQueue; i++) {
+        ALOGD("Consuming frame %d", i);
+        CpuConsumer::LockedBuffer b;
+        err = mCC->lockNextBuffer(&b);
+        ASSERT_NO_ERROR(err, "getNextBuffer error: ");
+
+        ASSERT_TRUE(b.data != nullptr);
+        EXPECT_EQ(params.width,  b.width);
+        EXPECT_EQ(params.height, b.height);
+        EXPECT_EQ(params.format, b.format);
+        EXPECT_EQ(stride[i], b.stride);
+        EXPECT_EQ(time[i], b.timestamp);
+
+        checkAnyBuffer(b, GetParam().format);
+
+        mCC->unlockBuffer(b);
+    }
+
+    CpuConsumer::LockedBuffer b;
+    EXPECT_EQ(BAD_VALUE, mCC->lockNextBuffer(&b));
+}
+
 // This test is disabled because the HAL_PIXEL_FORMAT_RAW16 format is not
 // supported on all devices.
 TEST_P(CpuConsumerTest, FromCpuLockMax) {
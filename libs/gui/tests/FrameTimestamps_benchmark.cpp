@@ -0,0 +1,186 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <gui/BLASTBufferQueue.h>
+#include <gui/FrameTimestamps.h>
+#include <gui/Surface.h>
+#include <gui/SurfaceComposerClient.h>
+#include <system/window.h>
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace android {
+namespace {
+
+using Transaction = SurfaceComposerClient::Transaction;
+
+FrameEvents makeFrame(uint64_t frameNumber) {
+    FrameEvents frame;
+    frame.valid = true;
+    frame.frameNumber = frameNumber;
+    frame.requestedPresentTime = static_cast<nsecs_t>(frameNumber) * 1000;
+    frame.latchTime = static_cast<nsecs_t>(frameNumber) * 1000 + 100;
+    frame.acquireFence = std::make_shared<FenceTime>(frame.requestedPresentTime + 50);
+    return frame;
+}
+
+// Baseline: queries copy the frame under the same mutex the producer updates
+// the history with, like the locked getFrameTimestamps path.
+void BM_FrameEventsQuery_Mutex(benchmark::State& state) {
+    static std::mutex sMutex;
+    static FrameEvents sFrame = makeFrame(1);
+
+    if (state.thread_index() == 0) {
+        // Producer thread.
+        uint64_t frameNumber = 1;
+        for (auto _ : state) {
+            std::lock_guard lock{sMutex};
+            sFrame = makeFrame(frameNumber++);
+        }
+    } else {
+        // Render threads.
+        for (auto _ : state) {
+            std::lock_guard lock{sMutex};
+            benchmark::DoNotOptimize(sFrame.latchTime);
+            benchmark::DoNotOptimize(sFrame.acquireFence->getSignalTime());
+        }
+    }
+}
+BENCHMARK(BM_FrameEventsQuery_Mutex)->ThreadRange(2, 8)->UseRealTime();
+
+// Queries read the published snapshot while the producer republishes it.
+void BM_FrameEventsQuery_Snapshot(benchmark::State& state) {
+    static FrameEventsSnapshotRing sRing;
+    static std::atomic<uint64_t> sFrameNumber = 1;
+
+    if (state.thread_index() == 0) {
+        sRing.publish(makeFrame(1));
+        for (auto _ : state) {
+            const uint64_t frameNumber = sFrameNumber.load(std::memory_order_relaxed) + 1;
+            sRing.publish(makeFrame(frameNumber));
+            sFrameNumber.store(frameNumber, std::memory_order_relaxed);
+        }
+    } else {
+        FrameEventsSnapshot snapshot;
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(
+                    sRing.read(sFrameNumber.load(std::memory_order_relaxed), &snapshot));
+            benchmark::DoNotOptimize(snapshot.latchTime);
+        }
+    }
+}
+BENCHMARK(BM_FrameEventsQuery_Snapshot)->ThreadRange(2, 8)->UseRealTime();
+
+// End to end: a frame pacer querying the timestamps of a presented frame on
+// every frame, like eglGetFrameTimestampsANDROID callers do. With an argument
+// of 1, a producer thread keeps queueing into the same Surface meanwhile.
+void BM_Surface_GetFrameTimestamps(benchmark::State& state) {
+    sp<SurfaceComposerClient> client = sp<SurfaceComposerClient>::make();
+    if (client->initCheck() != NO_ERROR) {
+        state.SkipWithError("SurfaceFlinger is not available");
+        return;
+    }
+
+    constexpr int kSize = 64;
+    sp<SurfaceControl> surfaceControl =
+            client->createSurface(String8("FrameTimestampsBenchmark"), kSize, kSize,
+                                  PIXEL_FORMAT_RGBA_8888,
+                                  ISurfaceComposerClient::eFXSurfaceBufferState);
+    if (surfaceControl == nullptr) {
+        state.SkipWithError("Failed to create surface");
+        return;
+    }
+    Transaction()
+            .setLayer(surfaceControl, std::numeric_limits<int32_t>::max())
+            .show(surfaceControl)
+            .apply(true /* synchronous */);
+
+    sp<BLASTBufferQueue> blastBufferQueue =
+            sp<BLASTBufferQueue>::make("FrameTimestampsBenchmark", surfaceControl, kSize, kSize,
+                                       PIXEL_FORMAT_RGBA_8888);
+    sp<Surface> surface = blastBufferQueue->getSurface(false /* includeSurfaceControlHandle */);
+    ANativeWindow* window = surface.get();
+    native_window_api_connect(window, NATIVE_WINDOW_API_CPU);
+    native_window_enable_frame_timestamps(window, true);
+
+    auto queueFrame = [window]() {
+        ANativeWindowBuffer* buffer = nullptr;
+        int fenceFd = -1;
+        if (window->dequeueBuffer(window, &buffer, &fenceFd) != NO_ERROR) {
+            return false;
+        }
+        sp<Fence>::make(fenceFd)->waitForever("FrameTimestampsBenchmark");
+        return window->queueBuffer(window, buffer, -1 /* fenceFd */) == NO_ERROR;
+    };
+
+    uint64_t firstFrameId = 0;
+    native_window_get_next_frame_id(window, &firstFrameId);
+    // The frame being queried; kept a few frames behind the producer so that
+    // it stays in the frame event history.
+    std::atomic<uint64_t> queriedFrameId = firstFrameId;
+    for (int i = 0; i < 3; i++) {
+        if (!queueFrame()) {
+            state.SkipWithError("Failed to queue a frame");
+            return;
+        }
+    }
+    // Give SurfaceFlinger time to present the first frame, so that most of
+    // its timestamps are final.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::atomic<bool> stop = false;
+    std::thread producerThread;
+    if (state.range(0) != 0) {
+        producerThread = std::thread([&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                uint64_t frameId = 0;
+                native_window_get_next_frame_id(window, &frameId);
+                if (!queueFrame()) {
+                    return;
+                }
+                queriedFrameId.store(frameId - 2, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    for (auto _ : state) {
+        nsecs_t requestedPresentTime, acquireTime, latchTime, firstRefreshStartTime;
+        benchmark::DoNotOptimize(
+                native_window_get_frame_timestamps(window,
+                                                   queriedFrameId.load(std::memory_order_relaxed),
+                                                   &requestedPresentTime,
+                                                   &acquireTime, &latchTime,
+                                                   &firstRefreshStartTime, nullptr, nullptr,
+                                                   nullptr, nullptr, nullptr));
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    stop = true;
+    if (producerThread.joinable()) {
+        producerThread.join();
+    }
+    native_window_api_disconnect(window, NATIVE_WINDOW_API_CPU);
+    Transaction().reparent(surfaceControl, nullptr).apply(true /* synchronous */);
+}
+BENCHMARK(BM_Surface_GetFrameTimestamps)->Arg(0)->Arg(1)->UseRealTime();
+
+} // namespace
+} // namespace android
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <gui/BufferItem.h>
+#include <gui/BufferQueue.h>
+#include <gui/IConsumerListener.h>
+#include <gui/IProducerListener.h>
+#include <gui/StreamSplitter.h>
+#include <system/window.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace {
+
+// An output consumer, like a preview, encoder or analysis pipeline, that releases each frame as
+// soon as it arrives. Frames are acquired on a dedicated thread, since releasing from the
+// onFrameAvailable callback would re-enter the splitter.
+class OutputConsumer : public BnConsumerListener {
+public:
+    explicit OutputConsumer(const sp<IGraphicBufferConsumer>& consumer) : mConsumer(consumer) {}
+
+    void start() { mThread = std::thread(&OutputConsumer::loop, this); }
+
+    void stop() {
+        {
+            std::lock_guard lock(mMutex);
+            mStopped = true;
+        }
+        mCondition.notify_one();
+        mThread.join();
+    }
+
+    void onFrameAvailable(const BufferItem&) override {
+        std::lock_guard lock(mMutex);
+        mPendingFrames++;
+        mCondition.notify_one();
+    }
+    void onBuffersReleased() override {}
+    void onSidebandStreamChanged() override {}
+
+private:
+    void loop() {
+        while (true) {
+            {
+                std::unique_lock lock(mMutex);
+                mCondition.wait(lock, [this] { return mPendingFrames > 0 || mStopped; });
+                if (mStopped) {
+                    return;
+                }
+                mPendingFrames--;
+            }
+            BufferItem item;
+            if (mConsumer->acquireBuffer(&item, 0) != NO_ERROR) {
+                continue;
+            }
+            mConsumer->releaseBuffer(item.mSlot, item.mFrameNumber, EGL_NO_DISPLAY,
+                                     EGL_NO_SYNC_KHR, Fence::NO_FENCE);
+        }
+    }
+
+    const sp<IGraphicBufferConsumer> mConsumer;
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    int mPendingFrames = 0;
+    bool mStopped = false;
+};
+
+// Frames per second through a splitter fanning one input out to state.range(0) outputs.
+void BM_StreamSplitterFanOut(benchmark::State& state) {
+    sp<IGraphicBufferProducer> inputProducer;
+    sp<IGraphicBufferConsumer> inputConsumer;
+    BufferQueue::createBufferQueue(&inputProducer, &inputConsumer);
+
+    sp<StreamSplitter> splitter;
+    if (StreamSplitter::createSplitter(inputConsumer, &splitter) != NO_ERROR) {
+        state.SkipWithError("Failed to create splitter");
+        return;
+    }
+
+    std::vector<sp<OutputConsumer>> outputs;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        sp<IGraphicBufferProducer> outputProducer;
+        sp<IGraphicBufferConsumer> outputConsumer;
+        BufferQueue::createBufferQueue(&outputProducer, &outputConsumer);
+        sp<OutputConsumer> output = sp<OutputConsumer>::make(outputConsumer);
+        outputConsumer->consumerConnect(output, false);
+        splitter->addOutput(outputProducer);
+        outputProducer->allowAllocation(false);
+        output->start();
+        outputs.push_back(output);
+    }
+
+    IGraphicBufferProducer::QueueBufferOutput qbOutput;
+    inputProducer->connect(sp<StubProducerListener>::make(), NATIVE_WINDOW_API_CPU, false,
+                           &qbOutput);
+    inputProducer->setMaxDequeuedBufferCount(2);
+
+    const IGraphicBufferProducer::QueueBufferInput qbInput(0, false, HAL_DATASPACE_UNKNOWN,
+                                                           Rect(0, 0, 1920, 1080),
+                                                           NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                           Fence::NO_FENCE);
+    for (auto _ : state) {
+        int slot;
+        sp<Fence> fence;
+        const status_t result =
+                inputProducer->dequeueBuffer(&slot, &fence, 1920, 1080, HAL_PIXEL_FORMAT_RGBA_8888,
+                                             GRALLOC_USAGE_SW_WRITE_OFTEN, nullptr, nullptr);
+        if (result < 0) {
+            state.SkipWithError("dequeueBuffer failed");
+            break;
+        }
+        if (result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+            sp<GraphicBuffer> buffer;
+            inputProducer->requestBuffer(slot, &buffer);
+        }
+        fence->waitForever("StreamSplitterBenchmark");
+        inputProducer->queueBuffer(slot, qbInput, &qbOutput);
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    inputProducer->disconnect(NATIVE_WINDOW_API_CPU);
+    for (const auto& output : outputs) {
+        output->stop();
+    }
+}
+BENCHMARK(BM_StreamSplitterFanOut)->DenseRange(1, 4)->UseRealTime();
+
+} // namespace
+} // namespace android
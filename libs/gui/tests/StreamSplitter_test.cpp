@@ -100,7 +100,9 @@ TEST_F(StreamSplitterTest, OneInputOneOutput) {
 
     // This should succeed even with allocation disabled since it will have
     // received the buffer back from the output BufferQueue
-    ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION,
+    // The buffer never left its input slot, so it does not need to be
+    // requested again either.
+    ASSERT_EQ(OK,
               inputProducer->dequeueBuffer(&slot, &fence, 0, 0, 0, GRALLOC_USAGE_SW_WRITE_OFTEN,
                                            nullptr, nullptr));
 }
@@ -175,7 +177,9 @@ TEST_F(StreamSplitterTest, OneInputMultipleOutputs) {
 
     // This should succeed even with allocation disabled since it will have
     // received the buffer back from the output BufferQueues
-    ASSERT_EQ(IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION,
+    // The buffer never left its input slot, so it does not need to be
+    // requested again either.
+    ASSERT_EQ(OK,
               inputProducer->dequeueBuffer(&slot, &fence, 0, 0, 0, GRALLOC_USAGE_SW_WRITE_OFTEN,
                                            nullptr, nullptr));
 }
@@ -1015,6 +1015,16 @@ public:
         return binder::Status::ok();
     }
 
+    binder::Status openTransactionCompletionChannel(
+            const sp<IBinder>& /*listener*/,
+            gui::TransactionCompletionChannelFds* /*outFds*/) override {
+        return binder::Status::ok();
+    }
+
+    binder::Status closeTransactionCompletionChannel(const sp<IBinder>& /*listener*/) override {
+        return binder::Status::ok();
+    }
+
 protected:
     IBinder* onAsBinder() override { return nullptr; }
 
@@ -1086,6 +1096,8 @@ public:
         mNow = now;
     }
 
+    Mutex& getMutexForTest() { return mMutex; }
+
 public:
     sp<FakeSurfaceComposer> mFakeSurfaceComposer;
     sp<FakeSurfaceComposerAIDL> mFakeSurfaceComposerAIDL;
@@ -2038,6 +2050,55 @@ TEST_F(GetFrameTimestampsTest, NoReleaseNoSync) {
     EXPECT_EQ(NATIVE_WINDOW_TIMESTAMP_PENDING, outReleaseTime);
 }
 
+// This test verifies that once every requested timestamp is known, queries are
+// answered without taking the Surface lock.
+TEST_F(GetFrameTimestampsTest, ResolvedTimestampsNoLock) {
+    enableFrameTimestamps();
+
+    // Dequeue and queue frame 1.
+    const uint64_t fId1 = getNextFrameId();
+    dequeueAndQueue(0);
+    mFrames[0].signalQueueFences();
+
+    // Dequeue and queue frame 2.
+    dequeueAndQueue(1);
+    mFrames[1].signalQueueFences();
+
+    addFrameEvents(true, NO_FRAME_INDEX, 0);
+    addFrameEvents(true, 0, 1);
+    mFrames[0].signalRefreshFences();
+    mFrames[0].signalReleaseFences();
+
+    // The first query syncs with the consumer and resolves the fences.
+    resetTimestamps();
+    ASSERT_EQ(NO_ERROR, getAllFrameTimestamps(fId1));
+
+    // Query again while another thread holds the Surface lock.
+    resetTimestamps();
+    int oldCount = mFakeConsumer->mGetFrameTimestampsCount;
+    std::future<int> result;
+    std::future_status status;
+    {
+        Mutex::Autolock lock(mSurface->getMutexForTest());
+        result = std::async(std::launch::async,
+                            [this, fId1] { return getAllFrameTimestamps(fId1); });
+        status = result.wait_for(std::chrono::seconds(1));
+    }
+    ASSERT_EQ(std::future_status::ready, status);
+    EXPECT_EQ(NO_ERROR, result.get());
+    EXPECT_EQ(oldCount, mFakeConsumer->mGetFrameTimestampsCount);
+    EXPECT_EQ(mFrames[0].kRequestedPresentTime, outRequestedPresentTime);
+    EXPECT_EQ(mFrames[0].kProducerAcquireTime, outAcquireTime);
+    EXPECT_EQ(mFrames[0].kLatchTime, outLatchTime);
+    EXPECT_EQ(mFrames[0].mRefreshes[0].kStartTime, outFirstRefreshStartTime);
+    EXPECT_EQ(mFrames[0].mRefreshes[2].kStartTime, outLastRefreshStartTime);
+    EXPECT_EQ(mFrames[0].mRefreshes[0].kGpuCompositionDoneTime,
+            outGpuCompositionDoneTime);
+    EXPECT_EQ(mFrames[0].mRefreshes[0].kPresentTime, outDisplayPresentTime);
+    EXPECT_EQ(mFrames[0].kDequeueReadyTime, outDequeueReadyTime);
+    EXPECT_EQ(mFrames[0].kReleaseTime, outReleaseTime);
+}
+
 // This test verifies there are no sync calls for present times
 // when they aren't supported and that an error is returned.
 
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <binder/Binder.h>
+#include <binder/Parcel.h>
+#include <gui/SurfaceComposerClient.h>
+#include <gui/TransactionCompletionChannel.h>
+
+#include <sys/mman.h>
+
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace android {
+namespace {
+
+using gui::TransactionCompletionChannel;
+using Transaction = SurfaceComposerClient::Transaction;
+
+constexpr int32_t kLayerId = 1;
+
+ListenerStats makeListenerStats(const sp<IBinder>& surfaceControl, int64_t callbackId) {
+    ListenerStats listenerStats;
+    TransactionStats& stats = listenerStats.transactionStats.emplace_back(
+            std::vector<CallbackId>{CallbackId(callbackId, CallbackId::Type::ON_COMPLETE)});
+    stats.latchTime = callbackId;
+    stats.presentFence = sp<Fence>::make(memfd_create("present-fence", MFD_CLOEXEC));
+
+    SurfaceStats& surfaceStats = stats.surfaceStats.emplace_back();
+    surfaceStats.surfaceControl = surfaceControl;
+    surfaceStats.acquireTimeOrFence = static_cast<nsecs_t>(callbackId);
+    surfaceStats.previousReleaseFence =
+            sp<Fence>::make(memfd_create("release-fence", MFD_CLOEXEC));
+    surfaceStats.eventStats.frameNumber = static_cast<uint64_t>(callbackId);
+    return listenerStats;
+}
+
+// Baseline: the marshalling the binder path does on both sides for every batch,
+// without the transaction itself.
+void BM_ListenerStats_Parcel(benchmark::State& state) {
+    const sp<IBinder> surfaceControl = sp<BBinder>::make();
+    const ListenerStats stats = makeListenerStats(surfaceControl, 1);
+
+    for (auto _ : state) {
+        Parcel parcel;
+        stats.writeToParcel(&parcel);
+        parcel.setDataPosition(0);
+        ListenerStats read;
+        read.readFromParcel(&parcel);
+        benchmark::DoNotOptimize(read.transactionStats.size());
+    }
+}
+BENCHMARK(BM_ListenerStats_Parcel);
+
+// Round trip through the channel between two threads: the producer publishes a
+// batch and waits for the consumer to have read it.
+void BM_CompletionChannel_RoundTrip(benchmark::State& state) {
+    std::unique_ptr<TransactionCompletionChannel::ConsumerEndpoint> consumer;
+    std::shared_ptr<TransactionCompletionChannel::ProducerEndpoint> producer;
+    if (TransactionCompletionChannel::open("benchmark", consumer, producer) != OK) {
+        state.SkipWithError("Failed to open the channel");
+        return;
+    }
+
+    const sp<IBinder> surfaceControl = sp<BBinder>::make();
+    const ListenerStats stats = makeListenerStats(surfaceControl, 1);
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    int64_t batchesRead = 0;
+    bool stop = false;
+
+    std::thread consumerThread([&]() {
+        auto resolveHandle = [&](const std::vector<CallbackId>&, int32_t) {
+            return surfaceControl;
+        };
+        ListenerStats read;
+        while (true) {
+            consumer->waitForBatch();
+            {
+                std::lock_guard lock{mutex};
+                if (stop) {
+                    return;
+                }
+            }
+            while (consumer->read(read, resolveHandle) == OK) {
+                std::lock_guard lock{mutex};
+                batchesRead++;
+                condition.notify_one();
+            }
+        }
+    });
+
+    auto resolveLayerId = [](const sp<IBinder>&) { return kLayerId; };
+    int64_t batchesWritten = 0;
+    for (auto _ : state) {
+        if (producer->write(stats, resolveLayerId) != OK) {
+            state.SkipWithError("Failed to write a batch");
+            break;
+        }
+        batchesWritten++;
+        std::unique_lock lock{mutex};
+        condition.wait(lock, [&]() { return batchesRead == batchesWritten; });
+    }
+
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    consumer->wake();
+    consumerThread.join();
+}
+BENCHMARK(BM_CompletionChannel_RoundTrip)->UseRealTime();
+
+// End to end: the latency from applying a small transaction to its completed
+// callback. With an argument of 1 the callbacks come through the completion
+// channel instead of binder.
+void BM_TransactionCompletedCallback(benchmark::State& state) {
+    sp<SurfaceComposerClient> client = sp<SurfaceComposerClient>::make();
+    if (client->initCheck() != NO_ERROR) {
+        state.SkipWithError("SurfaceFlinger is not available");
+        return;
+    }
+
+    sp<SurfaceControl> surfaceControl =
+            client->createSurface(String8("TransactionCompletionChannelBenchmark"), 0, 0,
+                                  PIXEL_FORMAT_RGBA_8888,
+                                  ISurfaceComposerClient::eFXSurfaceEffect);
+    if (surfaceControl == nullptr) {
+        state.SkipWithError("Failed to create surface");
+        return;
+    }
+
+    const sp<TransactionCompletedListener> listener = TransactionCompletedListener::getInstance();
+    const bool useChannel = state.range(0) != 0;
+    if (useChannel && listener->enableCompletionChannel() != OK) {
+        state.SkipWithError("Completion channel is not available");
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool completed = false;
+    auto callback = [&](void* /*context*/, nsecs_t /*latchTime*/, const sp<Fence>& /*presentFence*/,
+                        const std::vector<SurfaceControlStats>& /*stats*/) {
+        std::lock_guard lock{mutex};
+        completed = true;
+        condition.notify_one();
+    };
+
+    int32_t layer = 0;
+    for (auto _ : state) {
+        {
+            std::lock_guard lock{mutex};
+            completed = false;
+        }
+        // Changing the layer each time keeps the transaction from being a no-op.
+        Transaction()
+                .setLayer(surfaceControl, layer++ % std::numeric_limits<int16_t>::max())
+                .addTransactionCompletedCallback(callback, nullptr)
+                .apply();
+        std::unique_lock lock{mutex};
+        condition.wait(lock, [&]() { return completed; });
+    }
+
+    if (useChannel) {
+        listener->disableCompletionChannel();
+    }
+    Transaction().reparent(surfaceControl, nullptr).apply(true /* synchronous */);
+}
+BENCHMARK(BM_TransactionCompletedCallback)->Arg(0)->Arg(1)->UseRealTime();
+
+} // namespace
+} // namespace android
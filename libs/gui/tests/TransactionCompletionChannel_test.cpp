@@ -0,0 +1,258 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <binder/Binder.h>
+#include <gtest/gtest.h>
+#include <gui/TransactionCompletionChannel.h>
+
+using namespace std::string_literals;
+using android::gui::TransactionCompletionChannel;
+
+namespace android {
+
+namespace {
+
+// Helper function to check if two file descriptors point to the same file.
+bool is_same_file(int fd1, int fd2) {
+    struct stat stat1;
+    if (fstat(fd1, &stat1) != 0) {
+        return false;
+    }
+    struct stat stat2;
+    if (fstat(fd2, &stat2) != 0) {
+        return false;
+    }
+    return (stat1.st_dev == stat2.st_dev) && (stat1.st_ino == stat2.st_ino);
+}
+
+sp<Fence> makeFakeFence() {
+    return sp<Fence>::make(memfd_create("fake-fence-fd", 0));
+}
+
+TransactionStats makeTransactionStats(int64_t callbackId, const sp<IBinder>& surfaceControl) {
+    TransactionStats stats(std::vector<CallbackId>{
+            CallbackId(callbackId, CallbackId::Type::ON_COMPLETE)});
+    stats.latchTime = 1000 + callbackId;
+    stats.presentFence = makeFakeFence();
+
+    SurfaceStats& surfaceStats = stats.surfaceStats.emplace_back();
+    surfaceStats.surfaceControl = surfaceControl;
+    surfaceStats.acquireTimeOrFence = static_cast<nsecs_t>(500);
+    surfaceStats.previousReleaseFence = makeFakeFence();
+    surfaceStats.transformHint = 4;
+    surfaceStats.currentMaxAcquiredBufferCount = 3;
+    surfaceStats.eventStats.frameNumber = 10;
+    surfaceStats.eventStats.previousFrameNumber = 9;
+    surfaceStats.eventStats.compositorTiming.interval = 16'666'666;
+    surfaceStats.previousReleaseCallbackId = ReleaseCallbackId(42, 9);
+    return stats;
+}
+
+class TransactionCompletionChannelTest : public testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(OK, TransactionCompletionChannel::open("test-channel"s, mConsumer, mProducer));
+    }
+
+    status_t write(const ListenerStats& stats) {
+        return mProducer->write(stats, [this](const sp<IBinder>& surfaceControl) {
+            return surfaceControl == mSurfaceControl ? kLayerId : -1;
+        });
+    }
+
+    status_t read(ListenerStats& outStats) {
+        return mConsumer->read(outStats,
+                               [this](const std::vector<CallbackId>&,
+                                      int32_t layerId) -> sp<IBinder> {
+                                   return layerId == kLayerId ? mSurfaceControl : nullptr;
+                               });
+    }
+
+    static constexpr int32_t kLayerId = 7;
+    const sp<IBinder> mSurfaceControl = sp<BBinder>::make();
+    std::unique_ptr<TransactionCompletionChannel::ConsumerEndpoint> mConsumer;
+    std::shared_ptr<TransactionCompletionChannel::ProducerEndpoint> mProducer;
+};
+
+} // namespace
+
+TEST_F(TransactionCompletionChannelTest, ConsumerIsNonBlocking) {
+    ListenerStats stats;
+    EXPECT_EQ(WOULD_BLOCK, read(stats));
+}
+
+TEST_F(TransactionCompletionChannelTest, ProduceAndConsume) {
+    ListenerStats written;
+    written.transactionStats.push_back(makeTransactionStats(1, mSurfaceControl));
+    TransactionStats noFences(std::vector<CallbackId>{CallbackId(2, CallbackId::Type::ON_COMMIT)});
+    noFences.surfaceStats.emplace_back().surfaceControl = mSurfaceControl;
+    noFences.surfaceStats.back().transformHint = std::nullopt;
+    written.transactionStats.push_back(noFences);
+    ASSERT_EQ(OK, write(written));
+
+    ListenerStats read;
+    ASSERT_EQ(OK, this->read(read));
+    ASSERT_EQ(2u, read.transactionStats.size());
+
+    const TransactionStats& first = read.transactionStats[0];
+    ASSERT_EQ(1u, first.callbackIds.size());
+    EXPECT_EQ(CallbackId(1, CallbackId::Type::ON_COMPLETE), first.callbackIds[0]);
+    EXPECT_EQ(1001, first.latchTime);
+    ASSERT_NE(nullptr, first.presentFence);
+    EXPECT_TRUE(is_same_file(written.transactionStats[0].presentFence->get(),
+                             first.presentFence->get()));
+
+    ASSERT_EQ(1u, first.surfaceStats.size());
+    const SurfaceStats& surfaceStats = first.surfaceStats[0];
+    EXPECT_EQ(mSurfaceControl, surfaceStats.surfaceControl);
+    EXPECT_EQ(500, std::get<nsecs_t>(surfaceStats.acquireTimeOrFence));
+    ASSERT_NE(nullptr, surfaceStats.previousReleaseFence);
+    const sp<Fence>& writtenReleaseFence =
+            written.transactionStats[0].surfaceStats[0].previousReleaseFence;
+    EXPECT_TRUE(is_same_file(writtenReleaseFence->get(), surfaceStats.previousReleaseFence->get()));
+    EXPECT_EQ(4u, surfaceStats.transformHint);
+    EXPECT_EQ(3u, surfaceStats.currentMaxAcquiredBufferCount);
+    EXPECT_EQ(10u, surfaceStats.eventStats.frameNumber);
+    EXPECT_EQ(9u, surfaceStats.eventStats.previousFrameNumber);
+    EXPECT_EQ(16'666'666, surfaceStats.eventStats.compositorTiming.interval);
+    EXPECT_EQ(ReleaseCallbackId(42, 9), surfaceStats.previousReleaseCallbackId);
+
+    const TransactionStats& second = read.transactionStats[1];
+    EXPECT_EQ(CallbackId(2, CallbackId::Type::ON_COMMIT), second.callbackIds[0]);
+    EXPECT_EQ(nullptr, second.presentFence);
+    ASSERT_EQ(1u, second.surfaceStats.size());
+    EXPECT_EQ(nullptr, second.surfaceStats[0].previousReleaseFence);
+    EXPECT_FALSE(second.surfaceStats[0].transformHint.has_value());
+
+    EXPECT_EQ(WOULD_BLOCK, this->read(read));
+}
+
+TEST_F(TransactionCompletionChannelTest, FullRingFallsBack) {
+    ListenerStats stats;
+    stats.transactionStats.push_back(makeTransactionStats(1, mSurfaceControl));
+
+    size_t written = 0;
+    status_t status;
+    while ((status = write(stats)) == OK) {
+        written++;
+    }
+    EXPECT_EQ(WOULD_BLOCK, status);
+    EXPECT_GT(written, 0u);
+
+    // Draining one batch makes room for another, and the ring wraps around.
+    ListenerStats read;
+    for (size_t i = 0; i < 2 * TransactionCompletionChannel::kCapacity; i++) {
+        ASSERT_EQ(OK, this->read(read));
+        ASSERT_EQ(OK, write(stats));
+    }
+    for (size_t i = 0; i < written; i++) {
+        ASSERT_EQ(OK, this->read(read));
+        EXPECT_EQ(1001, read.transactionStats[0].latchTime);
+    }
+    EXPECT_EQ(WOULD_BLOCK, this->read(read));
+}
+
+TEST_F(TransactionCompletionChannelTest, WakesUpConsumer) {
+    constexpr int64_t kBatchCount = 1000;
+    std::thread consumerThread([&]() {
+        int64_t expectedCallbackId = 1;
+        ListenerStats stats;
+        while (expectedCallbackId <= kBatchCount) {
+            mConsumer->waitForBatch();
+            while (read(stats) == OK) {
+                ASSERT_EQ(expectedCallbackId++, stats.transactionStats[0].callbackIds[0].id);
+            }
+        }
+    });
+
+    for (int64_t callbackId = 1; callbackId <= kBatchCount;) {
+        ListenerStats stats;
+        stats.transactionStats.push_back(makeTransactionStats(callbackId, mSurfaceControl));
+        if (write(stats) == OK) {
+            callbackId++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    consumerThread.join();
+}
+
+TEST_F(TransactionCompletionChannelTest, ClosedProducerDoesNotWakeConsumer) {
+    // The consumer notices once that the producer is gone, and then only waits for wake().
+    mProducer.reset();
+    mConsumer->waitForBatch();
+
+    std::atomic_bool woken = false;
+    std::thread consumerThread([&]() {
+        mConsumer->waitForBatch();
+        woken = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(woken);
+    mConsumer->wake();
+    consumerThread.join();
+    EXPECT_TRUE(woken);
+}
+
+TEST(TransactionCompletionChannelProducerTest, ConsumerCannotBlockProducer) {
+    std::shared_ptr<TransactionCompletionChannel::ProducerEndpoint> producer;
+    android::base::unique_fd memoryFd;
+    android::base::unique_fd fenceFd;
+    ASSERT_EQ(OK, TransactionCompletionChannel::create("test-channel"s, producer, memoryFd,
+                                                       fenceFd));
+
+    // Everything the client can do to its own ends leaves the producer's alone.
+    ASSERT_EQ(0, fcntl(fenceFd.get(), F_SETFL, fcntl(fenceFd.get(), F_GETFL) & ~O_NONBLOCK));
+    EXPECT_EQ(-1, ftruncate(memoryFd.get(), 0));
+    EXPECT_EQ(EPERM, errno);
+
+    // Without a reader, the producer eventually runs out of room but never blocks.
+    const sp<IBinder> surfaceControl = sp<BBinder>::make();
+    ListenerStats stats;
+    stats.transactionStats.push_back(makeTransactionStats(1, surfaceControl));
+    auto resolveLayerId = [](const sp<IBinder>&) { return 7; };
+    status_t status;
+    size_t written = 0;
+    while ((status = producer->write(stats, resolveLayerId)) == OK) {
+        ASSERT_LE(++written, TransactionCompletionChannel::kCapacity);
+    }
+    EXPECT_EQ(WOULD_BLOCK, status);
+}
+
+TEST(TransactionCompletionChannelConsumerTest, RejectsSmallMemory) {
+    android::base::unique_fd memoryFd(memfd_create("small", MFD_CLOEXEC));
+    ASSERT_EQ(0, ftruncate(memoryFd.get(), 4096));
+    int sockets[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets));
+    close(sockets[1]);
+    EXPECT_EQ(nullptr,
+              TransactionCompletionChannel::ConsumerEndpoint::
+                      create("test-channel"s, std::move(memoryFd),
+                             android::base::unique_fd(sockets[0])));
+}
+
+} // namespace android
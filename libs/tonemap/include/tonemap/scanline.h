@@ -0,0 +1,109 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <aidl/android/hardware/graphics/common/Dataspace.h>
+#include <math/mat3.h>
+#include <tonemap/tonemap.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// CPU kernels over scanlines of pixels, for color conversion and tone mapping without a GPU.
+//
+// Unless noted otherwise, a scanline holds pixelCount pixels of four floats each, in RGBA order.
+// Kernels apply to the RGB channels and leave the alpha channel untouched. They are vectorized,
+// and match the scalar functions in ColorSpace and ToneMapper within float precision.
+namespace android::tonemap {
+
+// Parametric transfer function, with the same parameters as ColorSpace::TransferParameters:
+// linear = x >= d ? (a * x + b)^g + e : c * x + f, mirrored for negative values.
+struct TransferParameters {
+    float g = 1.0f;
+    float a = 1.0f;
+    float b = 0.0f;
+    float c = 0.0f;
+    float d = 0.0f;
+    float e = 0.0f;
+    float f = 0.0f;
+};
+
+// Decodes with the parametric transfer function.
+void applyTransferFunction(const TransferParameters& parameters, float* rgba, size_t pixelCount);
+
+// Encodes with the inverse of the parametric transfer function.
+void applyInverseTransferFunction(const TransferParameters& parameters, float* rgba,
+                                  size_t pixelCount);
+
+// SMPTE ST 2084 (PQ). Linear values are normalized so that 1.0 is 10,000 nits.
+void applySt2084Eotf(float* rgba, size_t pixelCount);
+void applySt2084Oetf(float* rgba, size_t pixelCount);
+
+// Hybrid log-gamma, from BT.2100. Linear values are scene light, normalized to [0, 1].
+void applyHlgInverseOetf(float* rgba, size_t pixelCount);
+void applyHlgOetf(float* rgba, size_t pixelCount);
+
+// Multiplies the RGB channels of each pixel by the matrix, e.g. a gamut conversion.
+void applyMatrix(const mat3& matrix, float* rgba, size_t pixelCount);
+
+// Converts HDR pixels to SDR on the CPU, for instance to turn an HDR screenshot into an image that
+// can leave the device. This follows the same steps as the tone mapping shader from libshaders:
+// decoding, scaling to nits, tone mapping with getToneMapper(), gamut conversion, normalization
+// to the display luminance and encoding.
+//
+// The source may use any transfer function, while the destination must use an SDR one. Scanlines
+// are processed in small chunks so that intermediate results stay in the cache.
+class HdrToSdrConverter {
+public:
+    HdrToSdrConverter(aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
+                      aidl::android::hardware::graphics::common::Dataspace destinationDataspace,
+                      const Metadata& metadata);
+
+    // Converts a scanline of float pixels, which may be converted in place.
+    void convert(const float* source, float* destination, size_t pixelCount) const;
+
+    // Converts a scanline of an RGBA_1010102 buffer into a scanline of an RGBA_8888 buffer.
+    void convert(const uint32_t* source, uint8_t* destination, size_t pixelCount) const;
+
+private:
+    enum class Transfer { LINEAR, PARAMETRIC, ST2084, HLG };
+
+    // Decodes to linear values with the source transfer function.
+    void decode(float* rgba, size_t pixelCount) const;
+    // Tone maps linear values, and encodes them for the destination.
+    void toneMapAndEncode(float* rgba, size_t pixelCount) const;
+
+    aidl::android::hardware::graphics::common::Dataspace mSourceDataspace;
+    aidl::android::hardware::graphics::common::Dataspace mDestinationDataspace;
+    Metadata mMetadata;
+
+    Transfer mSourceTransfer;
+    TransferParameters mSourceParameters;
+    // Scale from decoded values to nits, when tone mapping.
+    float mSourceScale = 1.0f;
+    bool mToneMap = false;
+    mat3 mSourceRgbToXyz;
+    // Converts to the destination gamut, and normalizes to [0, 1].
+    mat3 mOutputMatrix;
+    Transfer mDestinationTransfer;
+    TransferParameters mDestinationParameters;
+    // Decoded values of every 10-bit channel value, so that packed pixels skip decode().
+    std::array<float, 1024> mDecodeTable;
+};
+
+} // namespace android::tonemap
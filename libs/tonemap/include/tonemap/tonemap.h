@@ -19,6 +19,7 @@
 #include <aidl/android/hardware/graphics/common/Dataspace.h>
 #include <aidl/android/hardware/graphics/composer3/RenderIntent.h>
 #include <android/hardware_buffer.h>
+#include <math/mat3.h>
 #include <math/vec3.h>
 
 #include <string>
@@ -148,6 +149,18 @@ public:
             aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
             aidl::android::hardware::graphics::common::Dataspace destinationDataspace,
             const std::vector<Color>& colors, const Metadata& metadata) = 0;
+
+    // Batch version of lookupTonemapGain(), which scales a scanline of pixels by their gains in
+    // place. rgba holds pixelCount pixels of four floats each: RGB colors in linear space, in
+    // absolute nits and in the source gamut, followed by an alpha channel that is left untouched.
+    // rgbToXyz converts from the source gamut to XYZ, for tone mappers that use CIE luminance.
+    //
+    // The default implementation goes through lookupTonemapGain(). Tone mappers may override it
+    // with a vectorized implementation matching lookupTonemapGain() within float precision.
+    virtual void applyTonemapGain(
+            aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
+            aidl::android::hardware::graphics::common::Dataspace destinationDataspace,
+            const mat3& rgbToXyz, float* rgba, size_t pixelCount, const Metadata& metadata);
 };
 
 // Retrieves a tonemapper instance.
@@ -0,0 +1,309 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libtonemap"
+
+#include <tonemap/scanline.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include <log/log.h>
+#include <math/vec2.h>
+
+#include "simd.h"
+
+namespace android::tonemap {
+
+using aidl::android::hardware::graphics::common::Dataspace;
+using namespace simd;
+
+namespace {
+
+static const constexpr auto kStandardMask = static_cast<int32_t>(Dataspace::STANDARD_MASK);
+static const constexpr auto kStandardBT2020 = static_cast<int32_t>(Dataspace::STANDARD_BT2020);
+static const constexpr auto kStandardBT2020ConstantLuminance =
+        static_cast<int32_t>(Dataspace::STANDARD_BT2020_CONSTANT_LUMINANCE);
+static const constexpr auto kStandardDciP3 = static_cast<int32_t>(Dataspace::STANDARD_DCI_P3);
+
+static const constexpr auto kTransferMask = static_cast<int32_t>(Dataspace::TRANSFER_MASK);
+static const constexpr auto kTransferLinear = static_cast<int32_t>(Dataspace::TRANSFER_LINEAR);
+static const constexpr auto kTransferSmpte170M =
+        static_cast<int32_t>(Dataspace::TRANSFER_SMPTE_170M);
+static const constexpr auto kTransferGamma22 = static_cast<int32_t>(Dataspace::TRANSFER_GAMMA2_2);
+static const constexpr auto kTransferGamma26 = static_cast<int32_t>(Dataspace::TRANSFER_GAMMA2_6);
+static const constexpr auto kTransferGamma28 = static_cast<int32_t>(Dataspace::TRANSFER_GAMMA2_8);
+static const constexpr auto kTransferST2084 = static_cast<int32_t>(Dataspace::TRANSFER_ST2084);
+static const constexpr auto kTransferHLG = static_cast<int32_t>(Dataspace::TRANSFER_HLG);
+
+// Luminance of normalized linear light at 1.0, as in ToneMapper.
+constexpr float kHlgPeakNits = 1000.0f;
+constexpr float kSt2084PeakNits = 10000.0f;
+
+// Number of pixels converted through all the steps at once.
+constexpr size_t kChunkSize = 256;
+
+const I4 kAlphaLane = {0, 0, 0, -1};
+
+// Applies a function to the color channels of every pixel.
+template <typename Function>
+void forEachPixel(float* rgba, size_t pixelCount, Function function) {
+    for (size_t i = 0; i < pixelCount; i++) {
+        const F4 pixel = load(rgba + 4 * i);
+        store(rgba + 4 * i, select(kAlphaLane, pixel, function(pixel)));
+    }
+}
+
+F4 abs(F4 value) {
+    return std::bit_cast<F4>(std::bit_cast<I4>(value) & 0x7fffffff);
+}
+
+F4 copySign(F4 magnitude, F4 sign) {
+    return std::bit_cast<F4>(std::bit_cast<I4>(magnitude) |
+                             (std::bit_cast<I4>(sign) & static_cast<int32_t>(0x80000000)));
+}
+
+mat3 computeRgbToXyz(const std::array<float2, 3>& primaries) {
+    // All the standards supported here use a D65 white point.
+    constexpr float2 kWhitePoint = {0.3127f, 0.3290f};
+    auto toXyz = [](float2 xy) { return float3(xy.x / xy.y, 1.0f, (1 - xy.x - xy.y) / xy.y); };
+
+    const mat3 primariesXyz(toXyz(primaries[0]), toXyz(primaries[1]), toXyz(primaries[2]));
+    const float3 scale = inverse(primariesXyz) * toXyz(kWhitePoint);
+    return primariesXyz * mat3(scale);
+}
+
+mat3 getRgbToXyz(Dataspace dataspace) {
+    switch (static_cast<int32_t>(dataspace) & kStandardMask) {
+        case kStandardDciP3:
+            return computeRgbToXyz({{{0.680f, 0.320f}, {0.265f, 0.690f}, {0.150f, 0.060f}}});
+        case kStandardBT2020:
+        case kStandardBT2020ConstantLuminance:
+            return computeRgbToXyz({{{0.708f, 0.292f}, {0.170f, 0.797f}, {0.131f, 0.046f}}});
+        default:
+            // Like libshaders, treat other standards as BT.709.
+            return computeRgbToXyz({{{0.640f, 0.330f}, {0.300f, 0.600f}, {0.150f, 0.060f}}});
+    }
+}
+
+bool isHdrTransfer(int32_t transfer) {
+    return transfer == kTransferST2084 || transfer == kTransferHLG;
+}
+
+void applyScale(float scale, float* rgba, size_t pixelCount) {
+    const F4 scales = {scale, scale, scale, 1.0f};
+    for (size_t i = 0; i < pixelCount; i++) {
+        store(rgba + 4 * i, load(rgba + 4 * i) * scales);
+    }
+}
+
+void applyClamp(float* rgba, size_t pixelCount) {
+    forEachPixel(rgba, pixelCount, [](F4 pixel) { return clamp(pixel, 0.0f, 1.0f); });
+}
+
+} // namespace
+
+void applyTransferFunction(const TransferParameters& p, float* rgba, size_t pixelCount) {
+    forEachPixel(rgba, pixelCount, [&p](F4 pixel) {
+        const F4 x = abs(pixel);
+        const F4 linear = select(x >= splat(p.d), pow(x * p.a + p.b, p.g) + p.e, x * p.c + p.f);
+        return copySign(linear, pixel);
+    });
+}
+
+void applyInverseTransferFunction(const TransferParameters& p, float* rgba, size_t pixelCount) {
+    forEachPixel(rgba, pixelCount, [&p](F4 pixel) {
+        const F4 x = abs(pixel);
+        // Matches ColorSpace, which is only defined when c is not 0 or d is 0.
+        const F4 encoded = select(x >= splat(p.d * p.c), (pow(x - p.e, 1.0f / p.g) - p.b) / p.a,
+                                  (x - p.f) / p.c);
+        return copySign(encoded, pixel);
+    });
+}
+
+void applySt2084Eotf(float* rgba, size_t pixelCount) {
+    forEachPixel(rgba, pixelCount, st2084Eotf);
+}
+
+void applySt2084Oetf(float* rgba, size_t pixelCount) {
+    forEachPixel(rgba, pixelCount, st2084Oetf);
+}
+
+void applyHlgInverseOetf(float* rgba, size_t pixelCount) {
+    forEachPixel(rgba, pixelCount, hlgInverseOetf);
+}
+
+void applyHlgOetf(float* rgba, size_t pixelCount) {
+    forEachPixel(rgba, pixelCount, hlgOetf);
+}
+
+void applyMatrix(const mat3& matrix, float* rgba, size_t pixelCount) {
+    // Columns of the matrix, extended with a column that copies alpha.
+    const F4 r = {matrix[0][0], matrix[0][1], matrix[0][2], 0.0f};
+    const F4 g = {matrix[1][0], matrix[1][1], matrix[1][2], 0.0f};
+    const F4 b = {matrix[2][0], matrix[2][1], matrix[2][2], 0.0f};
+    const F4 a = {0.0f, 0.0f, 0.0f, 1.0f};
+    for (size_t i = 0; i < pixelCount; i++) {
+        const F4 pixel = load(rgba + 4 * i);
+        store(rgba + 4 * i, r * pixel[0] + g * pixel[1] + b * pixel[2] + a * pixel[3]);
+    }
+}
+
+HdrToSdrConverter::HdrToSdrConverter(Dataspace sourceDataspace, Dataspace destinationDataspace,
+                                     const Metadata& metadata)
+      : mSourceDataspace(sourceDataspace),
+        mDestinationDataspace(destinationDataspace),
+        mMetadata(metadata),
+        mSourceRgbToXyz(getRgbToXyz(sourceDataspace)) {
+    const int32_t sourceTransfer = static_cast<int32_t>(sourceDataspace) & kTransferMask;
+    const int32_t destinationTransfer = static_cast<int32_t>(destinationDataspace) & kTransferMask;
+    LOG_ALWAYS_FATAL_IF(isHdrTransfer(destinationTransfer),
+                        "Cannot convert to HDR dataspace %d",
+                        static_cast<int32_t>(destinationDataspace));
+
+    auto selectTransfer = [](int32_t transfer, TransferParameters& outParameters) {
+        switch (transfer) {
+            case kTransferLinear:
+                return Transfer::LINEAR;
+            case kTransferST2084:
+                return Transfer::ST2084;
+            case kTransferHLG:
+                return Transfer::HLG;
+            case kTransferSmpte170M:
+                outParameters = {.g = 1 / 0.45f,
+                                 .a = 1 / 1.099f,
+                                 .b = 0.099f / 1.099f,
+                                 .c = 1 / 4.5f,
+                                 .d = 0.081f};
+                return Transfer::PARAMETRIC;
+            case kTransferGamma22:
+                outParameters = {.g = 2.2f};
+                return Transfer::PARAMETRIC;
+            case kTransferGamma26:
+                outParameters = {.g = 2.6f};
+                return Transfer::PARAMETRIC;
+            case kTransferGamma28:
+                outParameters = {.g = 2.8f};
+                return Transfer::PARAMETRIC;
+            default:
+                outParameters = {.g = 2.4f,
+                                 .a = 1 / 1.055f,
+                                 .b = 0.055f / 1.055f,
+                                 .c = 1 / 12.92f,
+                                 .d = 0.04045f};
+                return Transfer::PARAMETRIC;
+        }
+    };
+    mSourceTransfer = selectTransfer(sourceTransfer, mSourceParameters);
+    mDestinationTransfer = selectTransfer(destinationTransfer, mDestinationParameters);
+
+    float normalization = 1.0f;
+    if (isHdrTransfer(sourceTransfer)) {
+        // The tone mapper outputs nits in [0, displayMaxLuminance].
+        mToneMap = true;
+        mSourceScale = sourceTransfer == kTransferST2084 ? kSt2084PeakNits : kHlgPeakNits;
+        normalization = 1.0f / std::max(metadata.displayMaxLuminance, 1.0f);
+    }
+    mOutputMatrix = inverse(getRgbToXyz(destinationDataspace)) * mSourceRgbToXyz * normalization;
+
+    std::array<float, 4 * 1024> ramp;
+    for (size_t i = 0; i < mDecodeTable.size(); i++) {
+        std::fill_n(&ramp[4 * i], 4, static_cast<float>(i) / 1023.0f);
+    }
+    decode(ramp.data(), mDecodeTable.size());
+    for (size_t i = 0; i < mDecodeTable.size(); i++) {
+        mDecodeTable[i] = ramp[4 * i];
+    }
+}
+
+void HdrToSdrConverter::decode(float* rgba, size_t pixelCount) const {
+    switch (mSourceTransfer) {
+        case Transfer::LINEAR:
+            break;
+        case Transfer::PARAMETRIC:
+            applyTransferFunction(mSourceParameters, rgba, pixelCount);
+            break;
+        case Transfer::ST2084:
+            applySt2084Eotf(rgba, pixelCount);
+            break;
+        case Transfer::HLG:
+            applyHlgInverseOetf(rgba, pixelCount);
+            break;
+    }
+}
+
+void HdrToSdrConverter::toneMapAndEncode(float* rgba, size_t pixelCount) const {
+    if (mToneMap) {
+        applyScale(mSourceScale, rgba, pixelCount);
+        getToneMapper()->applyTonemapGain(mSourceDataspace, mDestinationDataspace, mSourceRgbToXyz,
+                                          rgba, pixelCount, mMetadata);
+    }
+
+    applyMatrix(mOutputMatrix, rgba, pixelCount);
+    applyClamp(rgba, pixelCount);
+
+    switch (mDestinationTransfer) {
+        case Transfer::PARAMETRIC:
+            applyInverseTransferFunction(mDestinationParameters, rgba, pixelCount);
+            break;
+        case Transfer::LINEAR:
+        case Transfer::ST2084:
+        case Transfer::HLG:
+            break;
+    }
+}
+
+void HdrToSdrConverter::convert(const float* source, float* destination,
+                                size_t pixelCount) const {
+    for (size_t offset = 0; offset < pixelCount; offset += kChunkSize) {
+        const size_t count = std::min(kChunkSize, pixelCount - offset);
+        float* chunk = destination + 4 * offset;
+        if (source != destination) {
+            std::memcpy(chunk, source + 4 * offset, count * 4 * sizeof(float));
+        }
+        decode(chunk, count);
+        toneMapAndEncode(chunk, count);
+    }
+}
+
+void HdrToSdrConverter::convert(const uint32_t* source, uint8_t* destination,
+                                size_t pixelCount) const {
+    float chunk[4 * kChunkSize];
+    for (size_t offset = 0; offset < pixelCount; offset += kChunkSize) {
+        const size_t count = std::min(kChunkSize, pixelCount - offset);
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t pixel = source[offset + i];
+            store(chunk + 4 * i,
+                  F4{mDecodeTable[pixel & 0x3ff], mDecodeTable[(pixel >> 10) & 0x3ff],
+                     mDecodeTable[(pixel >> 20) & 0x3ff], static_cast<float>(pixel >> 30) / 3.0f});
+        }
+
+        toneMapAndEncode(chunk, count);
+
+        uint8_t* pixels = destination + 4 * offset;
+        for (size_t i = 0; i < count; i++) {
+            const I4 channels =
+                    __builtin_convertvector(clamp(load(chunk + 4 * i), 0.0f, 1.0f) * 255.0f + 0.5f,
+                                            I4);
+            for (size_t channel = 0; channel < 4; channel++) {
+                pixels[4 * i + channel] = static_cast<uint8_t>(channels[channel]);
+            }
+        }
+    }
+}
+
+} // namespace android::tonemap
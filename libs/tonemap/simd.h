@@ -0,0 +1,171 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+// Four-lane float math for the CPU kernels of libtonemap.
+//
+// This uses the compiler's generic vector extension rather than intrinsics, so that the same code
+// lowers to NEON on ARM and SSE on x86. Transcendental functions are polynomial approximations
+// from Cephes, accurate to a few ulp over the ranges the tone mapping curves use.
+//
+// The transfer functions at the end work on normalized values: 1.0 is 10,000 nits for ST 2084,
+// and the peak scene light for HLG.
+namespace android::tonemap::simd {
+
+typedef float F4 __attribute__((vector_size(16)));
+typedef int32_t I4 __attribute__((vector_size(16)));
+
+inline F4 splat(float value) {
+    return F4{value, value, value, value};
+}
+
+inline F4 load(const float* source) {
+    F4 value;
+    std::memcpy(&value, source, sizeof(value));
+    return value;
+}
+
+inline void store(float* destination, F4 value) {
+    std::memcpy(destination, &value, sizeof(value));
+}
+
+// Picks a where mask is set, and b elsewhere. Comparisons return such masks.
+inline F4 select(I4 mask, F4 a, F4 b) {
+    return std::bit_cast<F4>((mask & std::bit_cast<I4>(a)) | (~mask & std::bit_cast<I4>(b)));
+}
+
+inline F4 min(F4 a, F4 b) {
+    return select(a < b, a, b);
+}
+
+inline F4 max(F4 a, F4 b) {
+    return select(a > b, a, b);
+}
+
+inline F4 clamp(F4 value, float low, float high) {
+    return min(max(value, splat(low)), splat(high));
+}
+
+inline F4 floor(F4 value) {
+    const F4 truncated = __builtin_convertvector(__builtin_convertvector(value, I4), F4);
+    return truncated - select(truncated > value, splat(1.f), splat(0.f));
+}
+
+// Natural logarithm. The input must be positive; zero yields a large negative number rather than
+// -inf, which exp() turns back into zero.
+inline F4 log(F4 x) {
+    const I4 bits = std::bit_cast<I4>(x);
+    // x = m * 2^e, with m in [0.5, 1).
+    I4 exponent = ((bits >> 23) & 0xff) - 126;
+    F4 m = std::bit_cast<F4>((bits & 0x007fffff) | 0x3f000000);
+
+    // Keep m in [sqrt(0.5), sqrt(2)) so that the polynomial is evaluated around 1.
+    const I4 small = m < splat(0.707106781186547524f);
+    exponent += small;
+    m = m - 1.f + select(small, m, splat(0.f));
+    const F4 e = __builtin_convertvector(exponent, F4);
+
+    const F4 z = m * m;
+    F4 y = splat(7.0376836292e-2f);
+    y = y * m - 1.1514610310e-1f;
+    y = y * m + 1.1676998740e-1f;
+    y = y * m - 1.2420140846e-1f;
+    y = y * m + 1.4249322787e-1f;
+    y = y * m - 1.6668057665e-1f;
+    y = y * m + 2.0000714765e-1f;
+    y = y * m - 2.4999993993e-1f;
+    y = y * m + 3.3333331174e-1f;
+    y = y * m * z;
+
+    y += e * -2.12194440e-4f;
+    y -= z * 0.5f;
+    return m + y + e * 0.693359375f;
+}
+
+inline F4 exp(F4 x) {
+    x = clamp(x, -87.3f, 88.3f);
+
+    // x = n * ln(2) + r, with r in [-ln(2) / 2, ln(2) / 2].
+    const F4 n = floor(x * 1.44269504088896341f + 0.5f);
+    x = x - n * 0.693359375f + n * 2.12194440e-4f;
+
+    const F4 z = x * x;
+    F4 y = splat(1.9875691500e-4f);
+    y = y * x + 1.3981999507e-3f;
+    y = y * x + 8.3334519073e-3f;
+    y = y * x + 4.1665795894e-2f;
+    y = y * x + 1.6666665459e-1f;
+    y = y * x + 5.0000001201e-1f;
+    y = y * z + x + 1.f;
+
+    return y * std::bit_cast<F4>((__builtin_convertvector(n, I4) + 127) << 23);
+}
+
+// base^exponent, which is zero for non-positive bases.
+inline F4 pow(F4 base, F4 exponent) {
+    return select(base > splat(0.f), exp(exponent * log(base)), splat(0.f));
+}
+
+inline F4 pow(F4 base, float exponent) {
+    return pow(base, splat(exponent));
+}
+
+namespace st2084 {
+constexpr float m1 = (2610.0 / 4096.0) / 4.0;
+constexpr float m2 = (2523.0 / 4096.0) * 128.0;
+constexpr float c1 = (3424.0 / 4096.0);
+constexpr float c2 = (2413.0 / 4096.0) * 32.0;
+constexpr float c3 = (2392.0 / 4096.0) * 32.0;
+} // namespace st2084
+
+inline F4 st2084Eotf(F4 encoded) {
+    using namespace st2084;
+    const F4 tmp = pow(clamp(encoded, 0.f, 1.f), 1.f / m2);
+    return pow(max(tmp - c1, splat(0.f)) / (c2 - c3 * tmp), 1.f / m1);
+}
+
+inline F4 st2084Oetf(F4 linear) {
+    using namespace st2084;
+    const F4 tmp = pow(clamp(linear, 0.f, 1.f), m1);
+    return pow((c1 + c2 * tmp) / (1.f + c3 * tmp), m2);
+}
+
+namespace hlg {
+constexpr float a = 0.17883277;
+constexpr float b = 0.28466892;
+constexpr float c = 0.55991073;
+} // namespace hlg
+
+inline F4 hlgInverseOetf(F4 encoded) {
+    using namespace hlg;
+    encoded = clamp(encoded, 0.f, 1.f);
+    return select(encoded <= splat(0.5f), encoded * encoded / 3.f,
+                  (exp((encoded - c) / a) + b) / 12.f);
+}
+
+inline F4 hlgOetf(F4 linear) {
+    using namespace hlg;
+    linear = clamp(linear, 0.f, 1.f);
+    return select(linear <= splat(1.f / 12.f), pow(linear * 3.f, 0.5f),
+                  a * log(linear * 12.f - b) + c);
+}
+
+} // namespace android::tonemap::simd
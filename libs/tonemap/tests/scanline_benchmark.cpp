@@ -0,0 +1,174 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <tonemap/scanline.h>
+#include <tonemap/tonemap.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace android {
+namespace {
+
+using aidl::android::hardware::graphics::common::Dataspace;
+
+constexpr size_t kWidth = 3840;
+constexpr size_t kHeight = 2160;
+
+const tonemap::Metadata kMetadata{.displayMaxLuminance = 500.f, .currentDisplayLuminance = 500.f};
+
+Dataspace sourceDataspace(const benchmark::State& state) {
+    return state.range(0) == 0 ? Dataspace::BT2020_ITU_PQ : Dataspace::BT2020_ITU_HLG;
+}
+
+// A 4K frame of RGBA_1010102 pixels covering the whole signal range.
+std::vector<uint32_t> makeFrame() {
+    std::vector<uint32_t> frame(kWidth * kHeight);
+    for (size_t y = 0; y < kHeight; y++) {
+        for (size_t x = 0; x < kWidth; x++) {
+            const uint32_t r = x * 1023 / (kWidth - 1);
+            const uint32_t g = y * 1023 / (kHeight - 1);
+            const uint32_t b = (x + y) % 1024;
+            frame[y * kWidth + x] = r | (g << 10) | (b << 20) | (3u << 30);
+        }
+    }
+    return frame;
+}
+
+double st2084Eotf(double encoded) {
+    const double m1 = (2610.0 / 4096.0) / 4.0;
+    const double m2 = (2523.0 / 4096.0) * 128.0;
+    const double c1 = (3424.0 / 4096.0);
+    const double c2 = (2413.0 / 4096.0) * 32.0;
+    const double c3 = (2392.0 / 4096.0) * 32.0;
+    const double tmp = std::pow(encoded, 1.0 / m2);
+    return std::pow(std::max(tmp - c1, 0.0) / (c2 - c3 * tmp), 1.0 / m1);
+}
+
+double hlgInverseOetf(double encoded) {
+    const double a = 0.17883277;
+    const double b = 0.28466892;
+    const double c = 0.55991073;
+    return encoded <= 0.5 ? encoded * encoded / 3.0 : (std::exp((encoded - c) / a) + b) / 12.0;
+}
+
+double srgbOetf(double linear) {
+    return linear >= 0.0031308 ? 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055 : 12.92 * linear;
+}
+
+// Baseline: the same conversion one pixel at a time with scalar math, with the gains of each
+// scanline computed through ToneMapper::lookupTonemapGain().
+void BM_HdrToSdr_Scalar(benchmark::State& state) {
+    const std::vector<uint32_t> frame = makeFrame();
+    std::vector<uint8_t> output(frame.size() * 4);
+    const Dataspace source = sourceDataspace(state);
+    const bool isPq = source == Dataspace::BT2020_ITU_PQ;
+    // BT.2020 to BT.709 primaries.
+    const mat3 gamut(vec3(1.6605f, -0.1246f, -0.0182f), vec3(-0.5876f, 1.1329f, -0.1006f),
+                     vec3(-0.0728f, -0.0083f, 1.1187f));
+
+    std::vector<tonemap::Color> colors(kWidth);
+    for (auto _ : state) {
+        for (size_t y = 0; y < kHeight; y++) {
+            const uint32_t* row = &frame[y * kWidth];
+            for (size_t x = 0; x < kWidth; x++) {
+                vec3 rgb;
+                for (size_t channel = 0; channel < 3; channel++) {
+                    const double encoded = ((row[x] >> (10 * channel)) & 0x3ff) / 1023.0;
+                    rgb[channel] = isPq ? st2084Eotf(encoded) * 10000.0
+                                        : hlgInverseOetf(encoded) * 1000.0;
+                }
+                colors[x].linearRGB = rgb;
+            }
+            const auto gains = tonemap::getToneMapper()->lookupTonemapGain(source, Dataspace::SRGB,
+                                                                           colors, kMetadata);
+            uint8_t* pixels = &output[y * kWidth * 4];
+            for (size_t x = 0; x < kWidth; x++) {
+                const vec3 rgb =
+                        gamut * colors[x].linearRGB * (gains[x] / kMetadata.displayMaxLuminance);
+                for (size_t channel = 0; channel < 3; channel++) {
+                    const double linear = std::clamp(static_cast<double>(rgb[channel]), 0.0, 1.0);
+                    pixels[4 * x + channel] = static_cast<uint8_t>(srgbOetf(linear) * 255 + 0.5);
+                }
+                pixels[4 * x + 3] = 255;
+            }
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_HdrToSdr_Scalar)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+void BM_HdrToSdr_Scanline(benchmark::State& state) {
+    const std::vector<uint32_t> frame = makeFrame();
+    std::vector<uint8_t> output(frame.size() * 4);
+    const tonemap::HdrToSdrConverter converter(sourceDataspace(state), Dataspace::SRGB,
+                                               kMetadata);
+
+    for (auto _ : state) {
+        for (size_t y = 0; y < kHeight; y++) {
+            converter.convert(&frame[y * kWidth], &output[y * kWidth * 4], kWidth);
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_HdrToSdr_Scanline)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// The tone mapping curve alone, over linear pixels in nits.
+void BM_TonemapGain_Lookup(benchmark::State& state) {
+    std::vector<tonemap::Color> colors(kWidth);
+    for (size_t x = 0; x < kWidth; x++) {
+        colors[x].linearRGB = vec3(x * 4000.f / kWidth);
+    }
+    const Dataspace source = sourceDataspace(state);
+
+    for (auto _ : state) {
+        for (size_t y = 0; y < kHeight; y++) {
+            benchmark::DoNotOptimize(
+                    tonemap::getToneMapper()->lookupTonemapGain(source, Dataspace::SRGB, colors,
+                                                                kMetadata));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+}
+BENCHMARK(BM_TonemapGain_Lookup)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+void BM_TonemapGain_Scanline(benchmark::State& state) {
+    std::vector<float> row(kWidth * 4);
+    for (size_t x = 0; x < kWidth; x++) {
+        std::fill_n(&row[4 * x], 3, x * 4000.f / kWidth);
+        row[4 * x + 3] = 1.f;
+    }
+    std::vector<float> scratch(row.size());
+    const Dataspace source = sourceDataspace(state);
+
+    for (auto _ : state) {
+        for (size_t y = 0; y < kHeight; y++) {
+            std::copy(row.begin(), row.end(), scratch.begin());
+            tonemap::getToneMapper()->applyTonemapGain(source, Dataspace::SRGB, mat3(),
+                                                       scratch.data(), kWidth, kMetadata);
+        }
+        benchmark::DoNotOptimize(scratch.data());
+    }
+    state.SetItemsProcessed(state.iterations() * kWidth * kHeight);
+}
+BENCHMARK(BM_TonemapGain_Scanline)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+} // namespace
+} // namespace android
@@ -0,0 +1,252 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tonemap/scanline.h>
+#include <tonemap/tonemap.h>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace android {
+
+using aidl::android::hardware::graphics::common::Dataspace;
+
+namespace {
+
+// Fills a scanline with a ramp over [low, high] in the color channels, and a distinct alpha.
+std::vector<float> makeRamp(size_t pixelCount, float low, float high) {
+    std::vector<float> rgba(pixelCount * 4);
+    for (size_t i = 0; i < pixelCount; i++) {
+        const float t = pixelCount > 1 ? static_cast<float>(i) / (pixelCount - 1) : 0.f;
+        rgba[4 * i] = low + (high - low) * t;
+        rgba[4 * i + 1] = low + (high - low) * t * t;
+        rgba[4 * i + 2] = low + (high - low) * (1 - t);
+        rgba[4 * i + 3] = t;
+    }
+    return rgba;
+}
+
+double st2084Eotf(double encoded) {
+    const double m1 = (2610.0 / 4096.0) / 4.0;
+    const double m2 = (2523.0 / 4096.0) * 128.0;
+    const double c1 = (3424.0 / 4096.0);
+    const double c2 = (2413.0 / 4096.0) * 32.0;
+    const double c3 = (2392.0 / 4096.0) * 32.0;
+    const double tmp = std::pow(encoded, 1.0 / m2);
+    return std::pow(std::max(tmp - c1, 0.0) / (c2 - c3 * tmp), 1.0 / m1);
+}
+
+double srgbEotf(double encoded) {
+    return encoded >= 0.04045 ? std::pow((encoded + 0.055) / 1.055, 2.4) : encoded / 12.92;
+}
+
+const tonemap::TransferParameters kSrgb = {.g = 2.4f,
+                                           .a = 1 / 1.055f,
+                                           .b = 0.055f / 1.055f,
+                                           .c = 1 / 12.92f,
+                                           .d = 0.04045f};
+
+} // namespace
+
+TEST(ScanlineTest, transferFunctionMatchesScalar) {
+    std::vector<float> rgba = makeRamp(67, -1.f, 1.f);
+    const std::vector<float> original = rgba;
+    tonemap::applyTransferFunction(kSrgb, rgba.data(), rgba.size() / 4);
+
+    for (size_t i = 0; i < rgba.size(); i++) {
+        if (i % 4 == 3) {
+            EXPECT_EQ(original[i], rgba[i]);
+            continue;
+        }
+        const double expected = std::copysign(srgbEotf(std::abs(original[i])), original[i]);
+        EXPECT_NEAR(expected, rgba[i], 1e-5) << "at " << original[i];
+    }
+}
+
+TEST(ScanlineTest, inverseTransferFunctionRoundTrips) {
+    std::vector<float> rgba = makeRamp(64, 0.f, 1.f);
+    const std::vector<float> original = rgba;
+    tonemap::applyTransferFunction(kSrgb, rgba.data(), rgba.size() / 4);
+    tonemap::applyInverseTransferFunction(kSrgb, rgba.data(), rgba.size() / 4);
+
+    for (size_t i = 0; i < rgba.size(); i++) {
+        EXPECT_NEAR(original[i], rgba[i], 1e-4);
+    }
+}
+
+TEST(ScanlineTest, st2084MatchesScalarAndRoundTrips) {
+    std::vector<float> rgba = makeRamp(101, 0.f, 1.f);
+    const std::vector<float> original = rgba;
+    tonemap::applySt2084Eotf(rgba.data(), rgba.size() / 4);
+    for (size_t i = 0; i < rgba.size(); i++) {
+        if (i % 4 != 3) {
+            const double expected = st2084Eotf(original[i]);
+            EXPECT_NEAR(expected, rgba[i], 1e-5 + expected * 1e-4) << "at " << original[i];
+        }
+    }
+
+    tonemap::applySt2084Oetf(rgba.data(), rgba.size() / 4);
+    for (size_t i = 0; i < rgba.size(); i++) {
+        EXPECT_NEAR(original[i], rgba[i], 1e-4);
+    }
+}
+
+TEST(ScanlineTest, hlgRoundTrips) {
+    // BT.2408 puts reference white at a signal of 0.75, which is 264.96 nits of scene light.
+    float reference[4] = {0.75f, 0.75f, 0.75f, 1.f};
+    tonemap::applyHlgInverseOetf(reference, 1);
+    EXPECT_NEAR(0.26496f, reference[0], 1e-4);
+
+    std::vector<float> rgba = makeRamp(101, 0.f, 1.f);
+    const std::vector<float> original = rgba;
+    tonemap::applyHlgInverseOetf(rgba.data(), rgba.size() / 4);
+    tonemap::applyHlgOetf(rgba.data(), rgba.size() / 4);
+    for (size_t i = 0; i < rgba.size(); i++) {
+        EXPECT_NEAR(original[i], rgba[i], 1e-4);
+    }
+}
+
+TEST(ScanlineTest, applyMatrixKeepsAlpha) {
+    float rgba[8] = {1.f, 2.f, 3.f, 0.5f, -1.f, 0.f, 1.f, 0.25f};
+    const mat3 matrix(vec3(1.f, 0.f, 2.f), vec3(0.f, 1.f, 0.f), vec3(0.f, 3.f, 1.f));
+    tonemap::applyMatrix(matrix, rgba, 2);
+
+    const vec3 first = matrix * vec3(1.f, 2.f, 3.f);
+    const vec3 second = matrix * vec3(-1.f, 0.f, 1.f);
+    EXPECT_FLOAT_EQ(first.r, rgba[0]);
+    EXPECT_FLOAT_EQ(first.g, rgba[1]);
+    EXPECT_FLOAT_EQ(first.b, rgba[2]);
+    EXPECT_FLOAT_EQ(0.5f, rgba[3]);
+    EXPECT_FLOAT_EQ(second.r, rgba[4]);
+    EXPECT_FLOAT_EQ(second.g, rgba[5]);
+    EXPECT_FLOAT_EQ(second.b, rgba[6]);
+    EXPECT_FLOAT_EQ(0.25f, rgba[7]);
+}
+
+TEST(ScanlineTest, applyTonemapGainMatchesLookup) {
+    const tonemap::Metadata metadata{.displayMaxLuminance = 500.f,
+                                     .currentDisplayLuminance = 300.f};
+    const std::pair<Dataspace, Dataspace> conversions[] = {
+            {Dataspace::BT2020_ITU_PQ, Dataspace::DISPLAY_P3},
+            {Dataspace::BT2020_ITU_HLG, Dataspace::DISPLAY_P3},
+            {Dataspace::BT2020_ITU_PQ, Dataspace::BT2020_ITU_HLG},
+            {Dataspace::BT2020_ITU_HLG, Dataspace::BT2020_ITU_PQ},
+            {Dataspace::BT2020_ITU_PQ, Dataspace::BT2020_ITU_PQ},
+    };
+
+    for (const auto& [source, destination] : conversions) {
+        // Not a multiple of four, to cover the last partial batch of pixels.
+        std::vector<float> rgba = makeRamp(999, 0.f, 6000.f);
+        std::vector<tonemap::Color> colors;
+        for (size_t i = 0; i < rgba.size() / 4; i++) {
+            colors.push_back({.linearRGB = vec3(rgba[4 * i], rgba[4 * i + 1], rgba[4 * i + 2])});
+        }
+        const std::vector<float> original = rgba;
+
+        const auto gains =
+                tonemap::getToneMapper()->lookupTonemapGain(source, destination, colors, metadata);
+        tonemap::getToneMapper()->applyTonemapGain(source, destination, mat3(), rgba.data(),
+                                                   colors.size(), metadata);
+
+        for (size_t i = 0; i < colors.size(); i++) {
+            for (size_t channel = 0; channel < 3; channel++) {
+                const double expected = original[4 * i + channel] * gains[i];
+                EXPECT_NEAR(expected, rgba[4 * i + channel], 1e-2 + expected * 1e-4)
+                        << "pixel " << i << " of " << static_cast<int32_t>(source) << " to "
+                        << static_cast<int32_t>(destination);
+            }
+            EXPECT_EQ(original[4 * i + 3], rgba[4 * i + 3]);
+        }
+    }
+}
+
+TEST(ScanlineTest, sdrConversionIsIdentity) {
+    const tonemap::HdrToSdrConverter converter(Dataspace::SRGB, Dataspace::SRGB,
+                                               {.displayMaxLuminance = 500.f});
+    const std::vector<float> source = makeRamp(300, 0.f, 1.f);
+    std::vector<float> destination(source.size());
+    converter.convert(source.data(), destination.data(), source.size() / 4);
+
+    for (size_t i = 0; i < source.size(); i++) {
+        EXPECT_NEAR(source[i], destination[i], 1e-4);
+    }
+}
+
+TEST(ScanlineTest, hdrConversionMatchesToneMapper) {
+    const tonemap::Metadata metadata{.displayMaxLuminance = 500.f,
+                                     .currentDisplayLuminance = 500.f};
+    const tonemap::HdrToSdrConverter converter(Dataspace::BT2020_ITU_PQ, Dataspace::SRGB_LINEAR,
+                                               metadata);
+
+    // Gray stays gray through the gamut conversion, so only the luminance changes.
+    const float signals[] = {0.f, 0.3f, 0.5f, 0.58f, 0.65f, 0.75f, 1.f};
+    for (const float signal : signals) {
+        float rgba[4] = {signal, signal, signal, 1.f};
+        converter.convert(rgba, rgba, 1);
+
+        const double nits = st2084Eotf(signal) * 10000.0;
+        const tonemap::Color color{.linearRGB = vec3(nits)};
+        const double gain = tonemap::getToneMapper()
+                                    ->lookupTonemapGain(Dataspace::BT2020_ITU_PQ,
+                                                        Dataspace::SRGB_LINEAR, {color}, metadata)
+                                    .front();
+        const double expected = std::min(nits * gain / metadata.displayMaxLuminance, 1.0);
+        EXPECT_NEAR(expected, rgba[0], 1e-3) << "at " << signal;
+        EXPECT_NEAR(rgba[0], rgba[1], 1e-4);
+        EXPECT_NEAR(rgba[0], rgba[2], 1e-4);
+        EXPECT_EQ(1.f, rgba[3]);
+    }
+}
+
+TEST(ScanlineTest, convertsRgba1010102ToRgba8888) {
+    const tonemap::HdrToSdrConverter converter(Dataspace::BT2020_ITU_HLG, Dataspace::SRGB,
+                                               {.displayMaxLuminance = 500.f,
+                                                .currentDisplayLuminance = 500.f});
+    auto pack = [](uint32_t r, uint32_t g, uint32_t b, uint32_t a) {
+        return r | (g << 10) | (b << 20) | (a << 30);
+    };
+    const std::vector<uint32_t> source = {pack(0, 0, 0, 3), pack(1023, 1023, 1023, 0),
+                                          pack(512, 512, 512, 1), pack(1023, 0, 0, 2),
+                                          pack(768, 768, 768, 3)};
+    std::vector<uint8_t> destination(source.size() * 4);
+    converter.convert(source.data(), destination.data(), source.size());
+
+    // Black and white.
+    EXPECT_EQ(0, destination[0]);
+    EXPECT_EQ(255, destination[3]);
+    EXPECT_EQ(255, destination[4]);
+    EXPECT_EQ(0, destination[7]);
+    // Grays stay gray, between black and white.
+    EXPECT_GT(destination[8], 0);
+    EXPECT_LT(destination[8], 255);
+    EXPECT_EQ(destination[8], destination[9]);
+    EXPECT_EQ(destination[8], destination[10]);
+    EXPECT_EQ(85, destination[11]);
+    EXPECT_GT(destination[16], destination[8]);
+    // Saturated BT.2020 red is clipped to the sRGB gamut.
+    EXPECT_EQ(255, destination[12]);
+    EXPECT_EQ(0, destination[13]);
+    EXPECT_EQ(170, destination[15]);
+
+    // Converting a single pixel gives the same result as a whole scanline.
+    uint8_t single[4];
+    converter.convert(&source[4], single, 1);
+    EXPECT_EQ(0, std::memcmp(single, &destination[16], sizeof(single)));
+}
+
+} // namespace android
@@ -18,9 +18,12 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <mutex>
 #include <type_traits>
 
+#include "simd.h"
+
 namespace android::tonemap {
 
 namespace {
@@ -726,10 +729,115 @@ public:
         }
         return gains;
     }
+
+    void applyTonemapGain(aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
+                          aidl::android::hardware::graphics::common::Dataspace destinationDataspace,
+                          const mat3& /*rgbToXyz*/, float* rgba, size_t pixelCount,
+                          const Metadata& metadata) override {
+        using namespace simd;
+
+        const int32_t sourceTransfer = static_cast<int32_t>(sourceDataspace) & kTransferMask;
+        const int32_t destinationTransfer =
+                static_cast<int32_t>(destinationDataspace) & kTransferMask;
+        if ((sourceTransfer != kTransferST2084 && sourceTransfer != kTransferHLG) ||
+            sourceTransfer == destinationTransfer) {
+            // The gain is always 1.
+            return;
+        }
+
+        // Same constants as lookupTonemapGain().
+        constexpr float maxInLumi = 4000;
+        const float maxOutLumi = metadata.displayMaxLuminance;
+
+        const float x1 = maxOutLumi * 0.65;
+        const float y1 = x1;
+        const float x3 = maxInLumi;
+        const float y3 = maxOutLumi;
+        const float x2 = x1 + (x3 - x1) * 4.0 / 17.0;
+        const float y2 = maxOutLumi * 0.9;
+
+        const float greyNorm1 = OETF_ST2084(x1);
+        const float greyNorm2 = OETF_ST2084(x2);
+        const float greyNorm3 = OETF_ST2084(x3);
+
+        const float slope2 = (y2 - y1) / (greyNorm2 - greyNorm1);
+        const float slope3 = (y3 - y2) / (greyNorm3 - greyNorm2);
+
+        const float hlgGamma = computeHlgGamma(metadata.currentDisplayLuminance);
+
+        auto targetNits = [&](F4 maxRGB) -> F4 {
+            if (sourceTransfer == kTransferST2084) {
+                if (destinationTransfer == kTransferHLG) {
+                    const F4 nits = clamp(maxRGB, 0.f, 1000.f);
+                    return nits * pow(nits / 1000.f, (1 - hlgGamma) / hlgGamma);
+                }
+                const F4 greyNits = st2084Oetf(maxRGB / 10000.f);
+                const F4 curve = select(greyNits <= splat(greyNorm2),
+                                        (greyNits - greyNorm2) * slope2 + y2,
+                                        select(greyNits <= splat(greyNorm3),
+                                               (greyNits - greyNorm3) * slope3 + y3,
+                                               splat(maxOutLumi)));
+                return select(maxRGB < splat(x1), maxRGB,
+                              select(maxRGB > splat(maxInLumi), splat(maxOutLumi), curve));
+            }
+            const F4 nits = maxRGB * pow(maxRGB / 1000.f, hlgGamma - 1);
+            return destinationTransfer == kTransferST2084 ? nits
+                                                          : nits * maxOutLumi / 1000.f;
+        };
+
+        // The gain only depends on the largest channel of each pixel, so compute it for four
+        // pixels at a time.
+        auto applyToFourPixels = [&](float* pixels) {
+            F4 colors[4];
+            float maxRGB[4];
+            for (size_t i = 0; i < 4; i++) {
+                colors[i] = load(pixels + 4 * i);
+                maxRGB[i] = std::max({colors[i][0], colors[i][1], colors[i][2]});
+            }
+            const F4 largest = load(maxRGB);
+            const F4 gain =
+                    select(largest > splat(0.f), targetNits(largest) / largest, splat(1.f));
+            for (size_t i = 0; i < 4; i++) {
+                store(pixels + 4 * i, colors[i] * F4{gain[i], gain[i], gain[i], 1.f});
+            }
+        };
+
+        size_t i = 0;
+        for (; i + 4 <= pixelCount; i += 4) {
+            applyToFourPixels(rgba + 4 * i);
+        }
+        if (i < pixelCount) {
+            float tail[16] = {};
+            const size_t tailSize = (pixelCount - i) * 4 * sizeof(float);
+            std::memcpy(tail, rgba + 4 * i, tailSize);
+            applyToFourPixels(tail);
+            std::memcpy(rgba + 4 * i, tail, tailSize);
+        }
+    }
 };
 
 } // namespace
 
+void ToneMapper::applyTonemapGain(
+        aidl::android::hardware::graphics::common::Dataspace sourceDataspace,
+        aidl::android::hardware::graphics::common::Dataspace destinationDataspace,
+        const mat3& rgbToXyz, float* rgba, size_t pixelCount, const Metadata& metadata) {
+    std::vector<Color> colors;
+    colors.reserve(pixelCount);
+    for (size_t i = 0; i < pixelCount; i++) {
+        const vec3 linearRGB(rgba[4 * i], rgba[4 * i + 1], rgba[4 * i + 2]);
+        colors.push_back({.linearRGB = linearRGB, .xyz = rgbToXyz * linearRGB});
+    }
+
+    const std::vector<Gain> gains =
+            lookupTonemapGain(sourceDataspace, destinationDataspace, colors, metadata);
+    for (size_t i = 0; i < pixelCount; i++) {
+        for (size_t channel = 0; channel < 3; channel++) {
+            rgba[4 * i + channel] *= gains[i];
+        }
+    }
+}
+
 ToneMapper* getToneMapper() {
     static std::once_flag sOnce;
     static std::unique_ptr<ToneMapper> sToneMapper;
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RING_BUFFER_FORMAT_H
+#define RING_BUFFER_FORMAT_H
+
+#include <stdint.h>
+
+namespace tracing_perfetto {
+
+/**
+ * Binary format of the events written by flushRingBuffers().
+ *
+ * The output is a sequence of chunks, one per thread that recorded events since the previous
+ * flush: a RingBufferChunkHeader followed by |size| bytes of records. Each record is a
+ * RingBufferRecord followed by its name and then its track name, without terminating nul, and
+ * padded with zeros to a multiple of 8 bytes. Everything is in host byte order.
+ */
+
+enum class RingBufferEventType : uint8_t {
+  BEGIN = 1,
+  END = 2,
+  // Async events of traceAsyncEndForTrack() only have a track name.
+  ASYNC_BEGIN = 3,
+  ASYNC_END = 4,
+  INSTANT = 5,
+  COUNTER = 6,
+};
+
+// "TRBC", little endian.
+constexpr uint32_t kRingBufferChunkMagic = 0x43425254;
+
+struct RingBufferChunkHeader {
+  uint32_t magic;
+  int32_t tid;
+  // Bytes of records following this header.
+  uint64_t size;
+  // Events of this thread that were dropped since the previous flush because its buffer was
+  // full.
+  uint64_t dropped;
+};
+
+struct RingBufferRecord {
+  // CLOCK_BOOTTIME, the default clock of perfetto traces.
+  uint64_t timestampNs;
+  // Cookie of async events, value of counters, 0 otherwise.
+  int64_t value;
+  // One of TRACE_CATEGORY_*.
+  uint32_t category;
+  // Size of the record, including the strings and the padding.
+  uint16_t size;
+  RingBufferEventType type;
+  uint8_t nameLength;
+  uint8_t trackNameLength;
+  uint8_t reserved[7];
+};
+
+static_assert(sizeof(RingBufferChunkHeader) == 24);
+static_assert(sizeof(RingBufferRecord) == 32);
+
+}  // namespace tracing_perfetto
+
+#endif  // RING_BUFFER_FORMAT_H
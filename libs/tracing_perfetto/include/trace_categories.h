@@ -62,4 +62,12 @@
       TRACE_CATEGORY_DATABASE | TRACE_CATEGORY_NETWORK | TRACE_CATEGORY_ADB | \
       TRACE_CATEGORY_VIBRATOR | TRACE_CATEGORY_AIDL | TRACE_CATEGORY_NNAPI |  \
       TRACE_CATEGORY_RRO | TRACE_CATEGORY_THERMAL
+
+// Categories that tracing_perfetto::enableRingBuffer() may divert to the ring buffers. Events of
+// other categories never reach them, the check is folded away when the library is built. Build
+// with -DTRACE_RING_BUFFER_CATEGORIES=... to record other categories. Only graphics by default,
+// since SurfaceFlinger is the only process tracing through this library.
+#ifndef TRACE_RING_BUFFER_CATEGORIES
+#define TRACE_RING_BUFFER_CATEGORIES (TRACE_CATEGORY_GRAPHICS)
+#endif
 #endif  // TRACE_CATEGORIES_H
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace tracing_perfetto {
@@ -50,4 +51,24 @@ void traceCounter(uint64_t category, const char* name, int64_t value);
 void traceCounter32(uint64_t category, const char* name, int32_t value);
 
 bool isTagEnabled(uint64_t category);
+
+/**
+ * Records the events of TRACE_RING_BUFFER_CATEGORIES into per-thread ring buffers of this
+ * process instead of sending them to atrace or perfetto, which costs a syscall per event.
+ * Each buffer holds |bufferSize| bytes, rounded up to a power of two. Events are dropped while
+ * a buffer is full, so flushRingBuffers() must be called often enough. SurfaceFlinger exposes
+ * this as `dumpsys SurfaceFlinger --ring-buffer-trace enable|disable|flush`.
+ */
+void enableRingBuffer(size_t bufferSize = 64 * 1024);
+
+/**
+ * Stops recording into the ring buffers. Events recorded so far are kept until flushed.
+ */
+void disableRingBuffer();
+
+/**
+ * Moves the events recorded so far to |fd| in a single write, in the format described in
+ * ring_buffer_format.h. Returns false if the write failed, in which case the events are lost.
+ */
+bool flushRingBuffers(int fd);
 }  // namespace tracing_perfetto
@@ -0,0 +1,245 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <android-base/file.h>
+
+#include "gtest/gtest.h"
+#include "ring_buffer_format.h"
+#include "trace_categories.h"
+#include "tracing_perfetto.h"
+
+namespace tracing_perfetto {
+
+namespace {
+
+struct Event {
+  int32_t tid;
+  RingBufferEventType type;
+  uint32_t category;
+  std::string name;
+  std::string trackName;
+  int64_t value;
+};
+
+struct Flushed {
+  std::vector<Event> events;
+  std::map<int32_t, uint64_t> dropped;
+};
+
+Flushed flush() {
+  TemporaryFile file;
+  EXPECT_TRUE(flushRingBuffers(file.fd));
+  std::string data;
+  EXPECT_TRUE(android::base::ReadFileToString(file.path, &data));
+
+  Flushed flushed;
+  size_t offset = 0;
+  while (offset + sizeof(RingBufferChunkHeader) <= data.size()) {
+    RingBufferChunkHeader header;
+    memcpy(&header, data.data() + offset, sizeof(header));
+    offset += sizeof(header);
+    EXPECT_EQ(kRingBufferChunkMagic, header.magic);
+    flushed.dropped[header.tid] += header.dropped;
+
+    const size_t end = offset + header.size;
+    EXPECT_LE(end, data.size());
+    while (offset + sizeof(RingBufferRecord) <= end) {
+      RingBufferRecord record;
+      memcpy(&record, data.data() + offset, sizeof(record));
+      EXPECT_EQ(0u, record.size % 8);
+      const char* strings = data.data() + offset + sizeof(record);
+      flushed.events.push_back(Event{
+          .tid = header.tid,
+          .type = record.type,
+          .category = record.category,
+          .name = std::string(strings, record.nameLength),
+          .trackName = std::string(strings + record.nameLength, record.trackNameLength),
+          .value = record.value,
+      });
+      offset += record.size;
+    }
+    EXPECT_EQ(end, offset);
+  }
+  EXPECT_EQ(data.size(), offset);
+  return flushed;
+}
+
+}  // namespace
+
+class TracingRingBufferTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    // Drop whatever earlier tests left behind.
+    flush();
+  }
+
+  void TearDown() override {
+    disableRingBuffer();
+    flush();
+  }
+};
+
+TEST_F(TracingRingBufferTest, recordsEvents) {
+  enableRingBuffer();
+  traceBegin(TRACE_CATEGORY_GRAPHICS, "composite");
+  traceCounter(TRACE_CATEGORY_GRAPHICS, "fps", 120);
+  traceAsyncBeginForTrack(TRACE_CATEGORY_GRAPHICS, "dispatch", "dispatchTrack", 42);
+  traceAsyncEndForTrack(TRACE_CATEGORY_GRAPHICS, "dispatchTrack", 42);
+  traceFormatInstant(TRACE_CATEGORY_GRAPHICS, "event %d", 7);
+  traceEnd(TRACE_CATEGORY_GRAPHICS);
+  EXPECT_TRUE(isTagEnabled(TRACE_CATEGORY_GRAPHICS));
+
+  Flushed flushed = flush();
+  ASSERT_EQ(6u, flushed.events.size());
+  const int32_t tid = gettid();
+  const Event& begin = flushed.events[0];
+  EXPECT_EQ(tid, begin.tid);
+  EXPECT_EQ(RingBufferEventType::BEGIN, begin.type);
+  EXPECT_EQ(static_cast<uint32_t>(TRACE_CATEGORY_GRAPHICS), begin.category);
+  EXPECT_EQ("composite", begin.name);
+  EXPECT_EQ(RingBufferEventType::COUNTER, flushed.events[1].type);
+  EXPECT_EQ(120, flushed.events[1].value);
+  EXPECT_EQ(RingBufferEventType::ASYNC_BEGIN, flushed.events[2].type);
+  EXPECT_EQ("dispatch", flushed.events[2].name);
+  EXPECT_EQ("dispatchTrack", flushed.events[2].trackName);
+  EXPECT_EQ(42, flushed.events[2].value);
+  EXPECT_EQ(RingBufferEventType::ASYNC_END, flushed.events[3].type);
+  EXPECT_EQ("", flushed.events[3].name);
+  EXPECT_EQ("dispatchTrack", flushed.events[3].trackName);
+  EXPECT_EQ(RingBufferEventType::INSTANT, flushed.events[4].type);
+  EXPECT_EQ("event 7", flushed.events[4].name);
+  EXPECT_EQ(RingBufferEventType::END, flushed.events[5].type);
+  EXPECT_EQ("", flushed.events[5].name);
+
+  EXPECT_TRUE(flush().events.empty()) << "Events should only be flushed once";
+}
+
+TEST_F(TracingRingBufferTest, filtersCategories) {
+  enableRingBuffer();
+  static_assert((TRACE_RING_BUFFER_CATEGORIES & TRACE_CATEGORY_APP) == 0);
+  traceBegin(TRACE_CATEGORY_APP, "notRecorded");
+  traceEnd(TRACE_CATEGORY_APP);
+  disableRingBuffer();
+  traceBegin(TRACE_CATEGORY_GRAPHICS, "disabled");
+  traceEnd(TRACE_CATEGORY_GRAPHICS);
+
+  EXPECT_TRUE(flush().events.empty());
+}
+
+TEST_F(TracingRingBufferTest, truncatesLongNames) {
+  enableRingBuffer();
+  const std::string name(300, 'x');
+  traceInstant(TRACE_CATEGORY_GRAPHICS, name.c_str());
+
+  Flushed flushed = flush();
+  ASSERT_EQ(1u, flushed.events.size());
+  EXPECT_EQ(name.substr(0, 255), flushed.events[0].name);
+}
+
+TEST_F(TracingRingBufferTest, dropsEventsWhenFull) {
+  enableRingBuffer(4096);
+  // 32 bytes of header and 32 of name: 64 events fit.
+  const std::string name(32, 'x');
+  for (int i = 0; i < 100; i++) {
+    traceInstant(TRACE_CATEGORY_GRAPHICS, name.c_str());
+  }
+
+  Flushed flushed = flush();
+  EXPECT_EQ(64u, flushed.events.size());
+  EXPECT_EQ(36u, flushed.dropped[gettid()]);
+
+  // The buffer is usable again once flushed, across its end.
+  for (int i = 0; i < 100; i++) {
+    traceInstant(TRACE_CATEGORY_GRAPHICS, name.c_str());
+    if (i % 10 == 9) {
+      flushed = flush();
+      EXPECT_EQ(10u, flushed.events.size());
+      EXPECT_EQ(0u, flushed.dropped[gettid()]);
+    }
+  }
+}
+
+TEST_F(TracingRingBufferTest, recordsPerThread) {
+  enableRingBuffer();
+  static constexpr int kThreads = 4;
+  static constexpr int kEvents = 100;
+  std::vector<std::thread> threads;
+  std::vector<int32_t> tids(kThreads);
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&, t] {
+      tids[t] = gettid();
+      for (int i = 0; i < kEvents; i++) {
+        traceBegin(TRACE_CATEGORY_GRAPHICS, "work");
+        traceCounter(TRACE_CATEGORY_GRAPHICS, "iteration", i);
+        traceEnd(TRACE_CATEGORY_GRAPHICS);
+      }
+    });
+  }
+  // Collect while the threads are recording.
+  std::vector<Event> events;
+  for (int i = 0; i < 10; i++) {
+    Flushed flushed = flush();
+    events.insert(events.end(), flushed.events.begin(), flushed.events.end());
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  Flushed flushed = flush();
+  events.insert(events.end(), flushed.events.begin(), flushed.events.end());
+
+  std::map<int32_t, int64_t> nextIteration;
+  for (const Event& event : events) {
+    if (event.type == RingBufferEventType::COUNTER) {
+      EXPECT_EQ(nextIteration[event.tid]++, event.value) << "Events out of order";
+    }
+  }
+  for (int32_t tid : tids) {
+    EXPECT_EQ(kEvents, nextIteration[tid]);
+  }
+  EXPECT_EQ(static_cast<size_t>(kThreads * kEvents * 3), events.size());
+}
+
+TEST_F(TracingRingBufferTest, keepsEventsAcrossEnable) {
+  enableRingBuffer(1024 * 1024);
+  static constexpr int kEvents = 10000;
+  std::thread thread([] {
+    for (int i = 0; i < kEvents; i++) {
+      traceCounter(TRACE_CATEGORY_GRAPHICS, "iteration", i);
+    }
+  });
+  // Switches the thread to a new buffer while it may be appending to its old one.
+  std::vector<Event> events;
+  for (int i = 0; i < 20; i++) {
+    enableRingBuffer(1024 * 1024);
+    Flushed flushed = flush();
+    events.insert(events.end(), flushed.events.begin(), flushed.events.end());
+  }
+  thread.join();
+  Flushed flushed = flush();
+  events.insert(events.end(), flushed.events.begin(), flushed.events.end());
+
+  EXPECT_EQ(static_cast<size_t>(kEvents), events.size());
+}
+
+}  // namespace tracing_perfetto
@@ -22,6 +22,7 @@
 #include "perfetto/public/te_category_macros.h"
 #include "trace_categories.h"
 #include "tracing_perfetto_internal.h"
+#include "tracing_ring_buffer.h"
 
 namespace tracing_perfetto {
 
@@ -33,7 +34,9 @@ void traceBegin(uint64_t category, const char* name) {
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
 
-  if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
+  if (internal::shouldUseRingBuffer(category)) {
+    internal::ringBufferTrace(RingBufferEventType::BEGIN, category, name, nullptr, 0);
+  } else if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
     atrace_begin(category, name);
   } else if (internal::isPerfettoCategoryEnabled(perfettoTeCategory)) {
     internal::perfettoTraceBegin(*perfettoTeCategory, name);
@@ -43,9 +46,10 @@ void traceBegin(uint64_t category, const char* name) {
 void traceFormatBegin(uint64_t category, const char* fmt, ...) {
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
+  const bool useRingBuffer = internal::shouldUseRingBuffer(category);
   const bool preferAtrace = internal::shouldPreferAtrace(perfettoTeCategory, category);
   const bool preferPerfetto = internal::isPerfettoCategoryEnabled(perfettoTeCategory);
-  if (CC_LIKELY(!(preferAtrace || preferPerfetto))) {
+  if (CC_LIKELY(!(useRingBuffer || preferAtrace || preferPerfetto))) {
     return;
   }
 
@@ -58,7 +62,9 @@ void traceFormatBegin(uint64_t category, const char* fmt, ...) {
   va_end(ap);
 
 
-  if (preferAtrace) {
+  if (useRingBuffer) {
+    internal::ringBufferTrace(RingBufferEventType::BEGIN, category, buf, nullptr, 0);
+  } else if (preferAtrace) {
     atrace_begin(category, buf);
   } else if (preferPerfetto) {
     internal::perfettoTraceBegin(*perfettoTeCategory, buf);
@@ -69,7 +75,9 @@ void traceEnd(uint64_t category) {
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
 
-  if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
+  if (internal::shouldUseRingBuffer(category)) {
+    internal::ringBufferTrace(RingBufferEventType::END, category, nullptr, nullptr, 0);
+  } else if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
     atrace_end(category);
   } else if (internal::isPerfettoCategoryEnabled(perfettoTeCategory)) {
     internal::perfettoTraceEnd(*perfettoTeCategory);
@@ -80,7 +88,9 @@ void traceAsyncBegin(uint64_t category, const char* name, int32_t cookie) {
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
 
-  if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
+  if (internal::shouldUseRingBuffer(category)) {
+    internal::ringBufferTrace(RingBufferEventType::ASYNC_BEGIN, category, name, nullptr, cookie);
+  } else if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
     atrace_async_begin(category, name, cookie);
   } else if (internal::isPerfettoCategoryEnabled(perfettoTeCategory)) {
     internal::perfettoTraceAsyncBegin(*perfettoTeCategory, name, cookie);
@@ -91,7 +101,9 @@ void traceAsyncEnd(uint64_t category, const char* name, int32_t cookie) {
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
 
-  if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
+  if (internal::shouldUseRingBuffer(category)) {
+    internal::ringBufferTrace(RingBufferEventType::ASYNC_END, category, name, nullptr, cookie);
+  } else if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
     atrace_async_end(category, name, cookie);
   } else if (internal::isPerfettoCategoryEnabled(perfettoTeCategory)) {
     internal::perfettoTraceAsyncEnd(*perfettoTeCategory, name, cookie);
@@ -103,7 +115,10 @@ void traceAsyncBeginForTrack(uint64_t category, const char* name,
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
 
-  if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
+  if (internal::shouldUseRingBuffer(category)) {
+    internal::ringBufferTrace(RingBufferEventType::ASYNC_BEGIN, category, name, trackName,
+                              cookie);
+  } else if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
     atrace_async_for_track_begin(category, trackName, name, cookie);
   } else if (internal::isPerfettoCategoryEnabled(perfettoTeCategory)) {
     internal::perfettoTraceAsyncBeginForTrack(*perfettoTeCategory, name, trackName, cookie);
@@ -115,7 +130,10 @@ void traceAsyncEndForTrack(uint64_t category, const char* trackName,
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
 
-  if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
+  if (internal::shouldUseRingBuffer(category)) {
+    internal::ringBufferTrace(RingBufferEventType::ASYNC_END, category, nullptr, trackName,
+                              cookie);
+  } else if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
     atrace_async_for_track_end(category, trackName, cookie);
   } else if (internal::isPerfettoCategoryEnabled(perfettoTeCategory)) {
     internal::perfettoTraceAsyncEndForTrack(*perfettoTeCategory, trackName, cookie);
@@ -126,7 +144,9 @@ void traceInstant(uint64_t category, const char* name) {
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
 
-  if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
+  if (internal::shouldUseRingBuffer(category)) {
+    internal::ringBufferTrace(RingBufferEventType::INSTANT, category, name, nullptr, 0);
+  } else if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
     atrace_instant(category, name);
   } else if (internal::isPerfettoCategoryEnabled(perfettoTeCategory)) {
     internal::perfettoTraceInstant(*perfettoTeCategory, name);
@@ -136,9 +156,10 @@ void traceInstant(uint64_t category, const char* name) {
 void traceFormatInstant(uint64_t category, const char* fmt, ...) {
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
+  const bool useRingBuffer = internal::shouldUseRingBuffer(category);
   const bool preferAtrace = internal::shouldPreferAtrace(perfettoTeCategory, category);
   const bool preferPerfetto = internal::isPerfettoCategoryEnabled(perfettoTeCategory);
-  if (CC_LIKELY(!(preferAtrace || preferPerfetto))) {
+  if (CC_LIKELY(!(useRingBuffer || preferAtrace || preferPerfetto))) {
     return;
   }
 
@@ -150,7 +171,9 @@ void traceFormatInstant(uint64_t category, const char* fmt, ...) {
   vsnprintf(buf, BUFFER_SIZE, fmt, ap);
   va_end(ap);
 
-  if (preferAtrace) {
+  if (useRingBuffer) {
+    internal::ringBufferTrace(RingBufferEventType::INSTANT, category, buf, nullptr, 0);
+  } else if (preferAtrace) {
     atrace_instant(category, buf);
   } else if (preferPerfetto) {
     internal::perfettoTraceInstant(*perfettoTeCategory, buf);
@@ -162,7 +185,9 @@ void traceInstantForTrack(uint64_t category, const char* trackName,
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
 
-  if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
+  if (internal::shouldUseRingBuffer(category)) {
+    internal::ringBufferTrace(RingBufferEventType::INSTANT, category, name, trackName, 0);
+  } else if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
     atrace_instant_for_track(category, trackName, name);
   } else if (internal::isPerfettoCategoryEnabled(perfettoTeCategory)) {
     internal::perfettoTraceInstantForTrack(*perfettoTeCategory, trackName, name);
@@ -173,7 +198,9 @@ void traceCounter(uint64_t category, const char* name, int64_t value) {
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
 
-  if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
+  if (internal::shouldUseRingBuffer(category)) {
+    internal::ringBufferTrace(RingBufferEventType::COUNTER, category, name, nullptr, value);
+  } else if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
     atrace_int64(category, name, value);
   } else if (internal::isPerfettoCategoryEnabled(perfettoTeCategory)) {
     internal::perfettoTraceCounter(*perfettoTeCategory, name, value);
@@ -182,7 +209,9 @@ void traceCounter(uint64_t category, const char* name, int64_t value) {
 
 void traceCounter32(uint64_t category, const char* name, int32_t value) {
   struct PerfettoTeCategory* perfettoTeCategory = internal::toPerfettoCategory(category);
-  if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
+  if (internal::shouldUseRingBuffer(category)) {
+    internal::ringBufferTrace(RingBufferEventType::COUNTER, category, name, nullptr, value);
+  } else if (internal::shouldPreferAtrace(perfettoTeCategory, category)) {
     atrace_int(category, name, value);
   } else if (internal::isPerfettoCategoryEnabled(perfettoTeCategory)) {
     internal::perfettoTraceCounter(*perfettoTeCategory, name,
@@ -193,8 +222,21 @@ void traceCounter32(uint64_t category, const char* name, int32_t value) {
 bool isTagEnabled(uint64_t category) {
   struct PerfettoTeCategory* perfettoTeCategory =
       internal::toPerfettoCategory(category);
-  return internal::isPerfettoCategoryEnabled(perfettoTeCategory)
+  return internal::shouldUseRingBuffer(category)
+      || internal::isPerfettoCategoryEnabled(perfettoTeCategory)
       || atrace_is_tag_enabled(category);
 }
 
+void enableRingBuffer(size_t bufferSize) {
+  internal::enableRingBuffer(bufferSize);
+}
+
+void disableRingBuffer() {
+  internal::disableRingBuffer();
+}
+
+bool flushRingBuffers(int fd) {
+  return internal::flushRingBuffers(fd);
+}
+
 }  // namespace tracing_perfetto
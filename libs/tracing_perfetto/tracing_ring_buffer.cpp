@@ -0,0 +1,266 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tracing_ring_buffer.h"
+
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/threads.h>
+#include <cutils/compiler.h>
+
+namespace tracing_perfetto {
+
+namespace internal {
+
+std::atomic_bool ring_buffer_enabled = false;
+
+namespace {
+
+static constexpr size_t kMinBufferSize = 4096;
+static constexpr size_t kMaxStringLength = UINT8_MAX;
+static constexpr size_t kRecordAlignment = 8;
+
+/**
+ * A ring buffer with a single producer, the thread owning it, and a single consumer,
+ * flushRingBuffers() holding |buffers_lock|. The positions only ever grow and are masked on
+ * access, so a full buffer is told apart from an empty one without wasting a slot. Events that
+ * don't fit are dropped rather than overwriting ones the consumer may be reading.
+ */
+class ThreadBuffer {
+ public:
+  ThreadBuffer(int32_t tid, size_t capacity, uint64_t generation)
+      : tid_(tid), capacity_(capacity), generation_(generation) {
+    void* data = mmap(nullptr, capacity_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1, 0);
+    if (data == MAP_FAILED) {
+      PLOG(ERROR) << "Failed to allocate a trace ring buffer of " << capacity_ << " bytes";
+      return;
+    }
+    data_ = static_cast<uint8_t*>(data);
+  }
+
+  ~ThreadBuffer() {
+    if (data_ != nullptr) {
+      munmap(data_, capacity_);
+    }
+  }
+
+  ThreadBuffer(const ThreadBuffer&) = delete;
+  ThreadBuffer& operator=(const ThreadBuffer&) = delete;
+
+  bool valid() const { return data_ != nullptr; }
+  int32_t tid() const { return tid_; }
+  uint64_t generation() const { return generation_; }
+
+  // Called by the producer once it won't append anymore.
+  void markExited() { exited_.store(true, std::memory_order_release); }
+  bool exited() const { return exited_.load(std::memory_order_acquire); }
+
+  // Producer only.
+  void append(const RingBufferRecord& record, const char* name, const char* trackName) {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    const uint64_t tail = tail_.load(std::memory_order_acquire);
+    if (capacity_ - (head - tail) < record.size) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    static constexpr uint8_t kPadding[kRecordAlignment] = {};
+    uint64_t position = head;
+    position = copyIn(position, &record, sizeof(record));
+    position = copyIn(position, name, record.nameLength);
+    position = copyIn(position, trackName, record.trackNameLength);
+    copyIn(position, kPadding, head + record.size - position);
+    head_.store(head + record.size, std::memory_order_release);
+  }
+
+  // Consumer only. Appends the pending records to |out| and returns the number of events
+  // dropped since the previous call.
+  uint64_t drain(std::vector<uint8_t>* out) {
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    const size_t offset = tail & (capacity_ - 1);
+    const size_t size = head - tail;
+    const size_t first = std::min(size, capacity_ - offset);
+    out->insert(out->end(), data_ + offset, data_ + offset + first);
+    out->insert(out->end(), data_, data_ + size - first);
+    tail_.store(head, std::memory_order_release);
+    return dropped_.exchange(0, std::memory_order_relaxed);
+  }
+
+ private:
+  uint64_t copyIn(uint64_t position, const void* source, size_t size) {
+    if (size == 0) {
+      return position;
+    }
+    const size_t offset = position & (capacity_ - 1);
+    const size_t first = std::min(size, capacity_ - offset);
+    memcpy(data_ + offset, source, first);
+    memcpy(data_, static_cast<const uint8_t*>(source) + first, size - first);
+    return position + size;
+  }
+
+  const int32_t tid_;
+  const size_t capacity_;
+  const uint64_t generation_;
+  uint8_t* data_ = nullptr;
+  // Written by the producer.
+  std::atomic_uint64_t head_ = 0;
+  // Written by the consumer.
+  std::atomic_uint64_t tail_ = 0;
+  std::atomic_uint64_t dropped_ = 0;
+  std::atomic_bool exited_ = false;
+};
+
+static std::atomic_size_t buffer_size = 0;
+// Bumped by enableRingBuffer() so that threads pick up the new buffer size.
+static std::atomic_uint64_t buffer_generation = 0;
+
+static std::mutex buffers_lock;
+// Buffers that may still hold events, including those of exited threads and those replaced
+// after enableRingBuffer().
+static std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+struct ThreadBufferHolder {
+  ~ThreadBufferHolder() {
+    if (buffer != nullptr) {
+      buffer->markExited();
+    }
+  }
+
+  std::shared_ptr<ThreadBuffer> buffer;
+};
+
+static thread_local ThreadBufferHolder thread_buffer;
+
+ThreadBuffer* getThreadBuffer() {
+  const uint64_t generation = buffer_generation.load(std::memory_order_acquire);
+  std::shared_ptr<ThreadBuffer>& buffer = thread_buffer.buffer;
+  if (CC_LIKELY(buffer != nullptr && buffer->generation() == generation)) {
+    return buffer->valid() ? buffer.get() : nullptr;
+  }
+
+  if (buffer != nullptr) {
+    // The collector releases it once its last events are flushed.
+    buffer->markExited();
+  }
+  buffer = std::make_shared<ThreadBuffer>(android::base::GetThreadId(),
+                                          buffer_size.load(std::memory_order_relaxed),
+                                          generation);
+  if (!buffer->valid()) {
+    // Keep it anyway so that allocating isn't retried on every event.
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(buffers_lock);
+  buffers.push_back(buffer);
+  return buffer.get();
+}
+
+uint64_t now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_BOOTTIME, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+}  // namespace
+
+void enableRingBuffer(size_t bufferSize) {
+  size_t capacity = kMinBufferSize;
+  while (capacity < bufferSize) {
+    capacity <<= 1;
+  }
+  buffer_size.store(capacity, std::memory_order_relaxed);
+  buffer_generation.fetch_add(1, std::memory_order_release);
+  ring_buffer_enabled.store(true, std::memory_order_relaxed);
+}
+
+void disableRingBuffer() {
+  ring_buffer_enabled.store(false, std::memory_order_relaxed);
+}
+
+bool flushRingBuffers(int fd) {
+  std::vector<uint8_t> out;
+  {
+    std::lock_guard<std::mutex> lock(buffers_lock);
+    for (auto it = buffers.begin(); it != buffers.end();) {
+      ThreadBuffer& buffer = **it;
+      // Read before draining so that no event appended before exiting is missed. A buffer of an
+      // older generation is only released once its thread switched to a new one, since the
+      // thread may be appending to it until then.
+      const bool exited = buffer.exited();
+
+      const size_t headerOffset = out.size();
+      out.resize(out.size() + sizeof(RingBufferChunkHeader));
+      const uint64_t dropped = buffer.drain(&out);
+      const uint64_t size = out.size() - headerOffset - sizeof(RingBufferChunkHeader);
+      if (size == 0 && dropped == 0) {
+        out.resize(headerOffset);
+      } else {
+        RingBufferChunkHeader header = {
+            .magic = kRingBufferChunkMagic,
+            .tid = buffer.tid(),
+            .size = size,
+            .dropped = dropped,
+        };
+        memcpy(out.data() + headerOffset, &header, sizeof(header));
+      }
+
+      it = exited ? buffers.erase(it) : it + 1;
+    }
+  }
+
+  if (out.empty()) {
+    return true;
+  }
+  if (!android::base::WriteFully(fd, out.data(), out.size())) {
+    PLOG(ERROR) << "Failed to write " << out.size() << " bytes of ring buffer events";
+    return false;
+  }
+  return true;
+}
+
+void ringBufferTrace(RingBufferEventType type, uint64_t category, const char* name,
+                     const char* trackName, int64_t value) {
+  ThreadBuffer* buffer = getThreadBuffer();
+  if (buffer == nullptr) {
+    return;
+  }
+
+  RingBufferRecord record = {
+      .timestampNs = now(),
+      .value = value,
+      .category = static_cast<uint32_t>(category),
+      .type = type,
+      .nameLength = static_cast<uint8_t>(name ? strnlen(name, kMaxStringLength) : 0),
+      .trackNameLength =
+          static_cast<uint8_t>(trackName ? strnlen(trackName, kMaxStringLength) : 0),
+  };
+  const size_t size = sizeof(record) + record.nameLength + record.trackNameLength;
+  record.size = static_cast<uint16_t>((size + kRecordAlignment - 1) & ~(kRecordAlignment - 1));
+  buffer->append(record, name, trackName);
+}
+
+}  // namespace internal
+
+}  // namespace tracing_perfetto
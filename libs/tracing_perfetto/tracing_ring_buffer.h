@@ -0,0 +1,60 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACING_RING_BUFFER_H
+#define TRACING_RING_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "ring_buffer_format.h"
+#include "trace_categories.h"
+
+namespace tracing_perfetto {
+
+namespace internal {
+
+extern std::atomic_bool ring_buffer_enabled;
+
+/**
+ * Whether events of |category| go to the ring buffers. For categories outside of
+ * TRACE_RING_BUFFER_CATEGORIES this is false without loading anything.
+ */
+inline bool shouldUseRingBuffer(uint64_t category) {
+  return (category & (TRACE_RING_BUFFER_CATEGORIES)) != 0 &&
+      ring_buffer_enabled.load(std::memory_order_relaxed);
+}
+
+void enableRingBuffer(size_t bufferSize);
+
+void disableRingBuffer();
+
+bool flushRingBuffers(int fd);
+
+/**
+ * Appends an event to the ring buffer of the calling thread. |name| and |trackName| may be
+ * null, and are truncated to 255 bytes.
+ */
+void ringBufferTrace(RingBufferEventType type, uint64_t category, const char* name,
+                     const char* trackName, int64_t value);
+
+}  // namespace internal
+
+}  // namespace tracing_perfetto
+
+#endif  // TRACING_RING_BUFFER_H
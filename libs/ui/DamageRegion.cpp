@@ -0,0 +1,207 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ui/DamageRegion.h>
+
+#include <algorithm>
+#include <inttypes.h>
+#include <limits>
+
+#include <android-base/stringprintf.h>
+
+namespace android::ui {
+
+namespace {
+
+int64_t area(const Rect& rect) {
+    return static_cast<int64_t>(rect.getWidth()) * rect.getHeight();
+}
+
+Rect boundingBox(const Rect& a, const Rect& b) {
+    return Rect(std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right),
+                std::max(a.bottom, b.bottom));
+}
+
+// Area of the bounding box of a and b that neither covers. Negative when they
+// overlap, since the overlap is counted twice.
+int64_t mergeWaste(const Rect& a, const Rect& b) {
+    return area(boundingBox(a, b)) - area(a) - area(b);
+}
+
+bool shouldMerge(const Rect& a, const Rect& b) {
+    Rect overlap;
+    if (a.intersect(b, &overlap)) {
+        return true;
+    }
+    return mergeWaste(a, b) * DamageRegion::MERGE_WASTE_DIVISOR <= area(boundingBox(a, b));
+}
+
+} // namespace
+
+DamageRegion DamageRegion::full() {
+    DamageRegion region;
+    region.setFull();
+    return region;
+}
+
+DamageRegion DamageRegion::fromRegion(const Region& region) {
+    DamageRegion damage;
+    for (const Rect& rect : region) {
+        damage.add(rect);
+    }
+    return damage;
+}
+
+void DamageRegion::clear() {
+    mCount = 0;
+    mFull = false;
+}
+
+void DamageRegion::setFull() {
+    mCount = 0;
+    mFull = true;
+}
+
+void DamageRegion::add(const Rect& rect) {
+    if (mFull) {
+        return;
+    }
+    if (!rect.isValid()) {
+        setFull();
+        return;
+    }
+    if (rect.isEmpty()) {
+        return;
+    }
+
+    // Fold every rectangle the new one should merge with into it. Merging
+    // grows the rectangle, so start over after each merge.
+    Rect pending = rect;
+    for (size_t i = 0; i < mCount;) {
+        if (shouldMerge(mRects[i], pending)) {
+            pending = boundingBox(mRects[i], pending);
+            removeAt(i);
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+
+    if (mCount < MAX_RECTS) {
+        append(pending);
+        return;
+    }
+
+    // The list is full, so merge the pair wasting the least area, counting
+    // the pending rectangle as index MAX_RECTS.
+    auto candidate = [&](size_t index) -> const Rect& {
+        return index == mCount ? pending : mRects[index];
+    };
+    size_t bestFirst = 0;
+    size_t bestSecond = 1;
+    int64_t bestWaste = std::numeric_limits<int64_t>::max();
+    for (size_t i = 0; i <= mCount; i++) {
+        for (size_t j = i + 1; j <= mCount; j++) {
+            const int64_t waste = mergeWaste(candidate(i), candidate(j));
+            if (waste < bestWaste) {
+                bestWaste = waste;
+                bestFirst = i;
+                bestSecond = j;
+            }
+        }
+    }
+
+    const Rect merged = boundingBox(candidate(bestFirst), candidate(bestSecond));
+    if (bestSecond != mCount) {
+        // Neither is the pending rectangle, which takes their place.
+        removeAt(bestSecond);
+        removeAt(bestFirst);
+        append(pending);
+    } else {
+        removeAt(bestFirst);
+    }
+    // The merged rectangle may now overlap others.
+    add(merged);
+}
+
+void DamageRegion::add(const DamageRegion& other) {
+    if (other.mFull) {
+        setFull();
+        return;
+    }
+    for (const Rect& rect : other) {
+        add(rect);
+    }
+}
+
+Rect DamageRegion::getBounds() const {
+    if (mFull) {
+        return Rect::INVALID_RECT;
+    }
+    if (mCount == 0) {
+        return Rect::EMPTY_RECT;
+    }
+    Rect bounds = mRects[0];
+    for (size_t i = 1; i < mCount; i++) {
+        bounds = boundingBox(bounds, mRects[i]);
+    }
+    return bounds;
+}
+
+int64_t DamageRegion::getArea() const {
+    int64_t total = 0;
+    for (const Rect& rect : *this) {
+        total += area(rect);
+    }
+    return total;
+}
+
+Region DamageRegion::toRegion() const {
+    if (mFull) {
+        return Region::INVALID_REGION;
+    }
+    Region region;
+    for (const Rect& rect : *this) {
+        region.orSelf(rect);
+    }
+    return region;
+}
+
+void DamageRegion::dump(std::string& out) const {
+    if (mFull) {
+        out.append("full");
+        return;
+    }
+    base::StringAppendF(&out, "%zu rects, %" PRId64 " px", mCount, getArea());
+    for (const Rect& rect : *this) {
+        base::StringAppendF(&out, " [%d, %d, %d, %d]", rect.left, rect.top, rect.right,
+                            rect.bottom);
+    }
+}
+
+bool DamageRegion::operator==(const DamageRegion& other) const {
+    return mFull == other.mFull && std::equal(begin(), end(), other.begin(), other.end());
+}
+
+void DamageRegion::append(const Rect& rect) {
+    mRects[mCount++] = rect;
+}
+
+void DamageRegion::removeAt(size_t index) {
+    mRects[index] = mRects[--mCount];
+}
+
+} // namespace android::ui
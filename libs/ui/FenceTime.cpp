@@ -19,6 +19,7 @@
 #define LOG_TAG "FenceTime"
 
 #include <cutils/compiler.h>  // For CC_[UN]LIKELY
+#include <ui/FenceWatcher.h>
 #include <utils/Log.h>
 #include <inttypes.h>
 #include <stdlib.h>
@@ -127,6 +128,18 @@ status_t FenceTime::wait(int timeout) {
 
 nsecs_t FenceTime::getSignalTime() {
     // See if we already have a cached value we can return.
+    nsecs_t signalTime = mSignalTime.load(std::memory_order_acquire);
+    if (signalTime != Fence::SIGNAL_TIME_PENDING) {
+        return signalTime;
+    }
+
+    // Even if the fence is watched, it may have signaled before the
+    // FenceWatcher got to record it, e.g. right after a wait(). Callers
+    // expect a signaled fence to report its time, so query it.
+    return querySignalTime();
+}
+
+nsecs_t FenceTime::querySignalTime() {
     nsecs_t signalTime = mSignalTime.load(std::memory_order_relaxed);
     if (signalTime != Fence::SIGNAL_TIME_PENDING) {
         return signalTime;
@@ -165,7 +178,7 @@ nsecs_t FenceTime::getSignalTime() {
     if (signalTime != Fence::SIGNAL_TIME_PENDING) {
         std::lock_guard<std::mutex> lock(mMutex);
         mFence.clear();
-        mSignalTime.store(signalTime, std::memory_order_relaxed);
+        mSignalTime.store(signalTime, std::memory_order_release);
     }
 
     return signalTime;
@@ -304,6 +317,7 @@ void FenceTimeline::push(const std::shared_ptr<FenceTime>& fence) {
         mQueue.pop();
     }
     mQueue.push(fence);
+    FenceWatcher::getInstance().watch(fence);
 }
 
 void FenceTimeline::updateSignalTimes() {
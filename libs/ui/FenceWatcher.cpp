@@ -0,0 +1,179 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "FenceWatcher"
+
+#include <ui/FenceWatcher.h>
+
+#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <ui/FenceTime.h>
+#include <utils/Log.h>
+
+#include <cinttypes>
+#include <cstring>
+#include <thread>
+
+namespace android {
+
+namespace {
+
+constexpr int kMaxEventsPerWake = 32;
+
+// -1 if not overridden, otherwise 0 or 1.
+std::atomic<int> sEnabledOverride{-1};
+
+} // namespace
+
+FenceWatcher& FenceWatcher::getInstance() {
+    // Intentionally leaked: the epoll thread outlives static destruction.
+    static FenceWatcher* const sInstance = new FenceWatcher();
+    return *sInstance;
+}
+
+bool FenceWatcher::isEnabled() {
+    const int override = sEnabledOverride.load(std::memory_order_relaxed);
+    if (override >= 0) {
+        return override != 0;
+    }
+    static const bool sEnabledByProperty =
+            base::GetBoolProperty("debug.ui.fence_watcher", false);
+    return sEnabledByProperty;
+}
+
+void FenceWatcher::setEnabled(bool enabled) {
+    sEnabledOverride.store(enabled ? 1 : 0, std::memory_order_relaxed);
+}
+
+FenceWatcher::FenceWatcher() : mEpollFd(epoll_create1(EPOLL_CLOEXEC)) {
+    if (!mEpollFd.ok()) {
+        ALOGE("Failed to create epoll fd: %s", strerror(errno));
+        return;
+    }
+    std::thread(&FenceWatcher::threadMain, this).detach();
+}
+
+bool FenceWatcher::watch(const std::shared_ptr<FenceTime>& fenceTime) {
+    if (!isEnabled() || !mEpollFd.ok() || !fenceTime) {
+        return false;
+    }
+
+    // Claim the FenceTime first so that concurrent watchers of the same
+    // FenceTime don't register it twice.
+    if (fenceTime->mWatched.exchange(true, std::memory_order_acq_rel)) {
+        return true;
+    }
+
+    const FenceTime::Snapshot snapshot = fenceTime->getSnapshot();
+    if (snapshot.state != FenceTime::Snapshot::State::FENCE || !snapshot.fence->isValid()) {
+        // Already signaled, or nothing to wait on.
+        fenceTime->mWatched.store(false, std::memory_order_release);
+        return false;
+    }
+
+    base::unique_fd fd(snapshot.fence->dup());
+    if (!fd.ok()) {
+        fenceTime->mWatched.store(false, std::memory_order_release);
+        mFailedCount++;
+        return false;
+    }
+
+    std::lock_guard lock(mMutex);
+    const uint64_t key = mNextKey++;
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = key;
+    if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, fd.get(), &event) != 0) {
+        ALOGE("Failed to watch fence: %s", strerror(errno));
+        fenceTime->mWatched.store(false, std::memory_order_release);
+        mFailedCount++;
+        return false;
+    }
+
+    mEntries.emplace(key, Entry{std::move(fd), fenceTime});
+    mWatchedCount++;
+    return true;
+}
+
+size_t FenceWatcher::getPendingCount() const {
+    std::lock_guard lock(mMutex);
+    return mEntries.size();
+}
+
+void FenceWatcher::dump(std::string& result) const {
+    base::StringAppendF(&result,
+                        "FenceWatcher: enabled=%d pending=%zu watched=%" PRIu64
+                        " signaled=%" PRIu64 " expired=%" PRIu64 " failed=%" PRIu64 "\n",
+                        isEnabled(), getPendingCount(), mWatchedCount.load(),
+                        mSignaledCount.load(), mExpiredCount.load(), mFailedCount.load());
+}
+
+void FenceWatcher::threadMain() {
+    pthread_setname_np(pthread_self(), "FenceWatcher");
+
+    epoll_event events[kMaxEventsPerWake];
+    while (true) {
+        const int count = epoll_wait(mEpollFd.get(), events, kMaxEventsPerWake, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ALOGE("epoll_wait failed: %s", strerror(errno));
+            return;
+        }
+
+        for (int i = 0; i < count; i++) {
+            onFenceReadable(events[i].data.u64);
+        }
+    }
+}
+
+void FenceWatcher::onFenceReadable(uint64_t key) {
+    Entry entry;
+    {
+        std::lock_guard lock(mMutex);
+        const auto it = mEntries.find(key);
+        if (it == mEntries.end()) {
+            return;
+        }
+        entry = std::move(it->second);
+        mEntries.erase(it);
+    }
+
+    epoll_ctl(mEpollFd.get(), EPOLL_CTL_DEL, entry.fd.get(), nullptr);
+
+    const std::shared_ptr<FenceTime> fenceTime = entry.fenceTime.lock();
+    if (!fenceTime) {
+        // Nobody cares about the timestamp anymore.
+        mExpiredCount++;
+        return;
+    }
+
+    if (fenceTime->querySignalTime() == Fence::SIGNAL_TIME_PENDING) {
+        // Should not happen for a readable sync file, but don't leave the
+        // FenceTime stuck: hand querying back to its callers.
+        ALOGW("Fence reported readable but is still pending");
+        fenceTime->mWatched.store(false, std::memory_order_release);
+        mFailedCount++;
+        return;
+    }
+    mSignaledCount++;
+}
+
+} // namespace android
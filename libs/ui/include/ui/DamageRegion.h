@@ -0,0 +1,95 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <ui/Rect.h>
+#include <ui/Region.h>
+
+namespace android::ui {
+
+// The part of a buffer that changed since the previous frame, as a short list
+// of non-overlapping rectangles.
+//
+// Region splits any union of rectangles into horizontal bands, so a couple of
+// overlapping or diagonal damage rectangles turn into many thin ones. Panels
+// with partial update support only a few update windows per frame, and HWCs
+// fall back to a full update when given more rectangles than that.
+// DamageRegion instead keeps at most MAX_RECTS rectangles: a rectangle is
+// merged into another one when they overlap or when their bounding box wastes
+// little area, and when the list is full the pair whose bounding box wastes the
+// least area is merged.
+//
+// A DamageRegion is either empty, full (the whole buffer is damaged, which
+// Region encodes as INVALID_REGION), or a list of rectangles.
+class DamageRegion {
+public:
+    static constexpr size_t MAX_RECTS = 4;
+
+    // Two rectangles are merged when the area of their bounding box not
+    // covered by either is at most 1/MERGE_WASTE_DIVISOR of the bounding box.
+    static constexpr int64_t MERGE_WASTE_DIVISOR = 4;
+
+    DamageRegion() = default;
+    explicit DamageRegion(const Rect& rect) { add(rect); }
+
+    static DamageRegion full();
+    static DamageRegion fromRegion(const Region& region);
+
+    bool isEmpty() const { return !mFull && mCount == 0; }
+    bool isFull() const { return mFull; }
+
+    void clear();
+    void setFull();
+
+    // An invalid rectangle, such as Rect::INVALID_RECT, marks the whole buffer
+    // as damaged.
+    void add(const Rect& rect);
+    void add(const DamageRegion& other);
+
+    const Rect* begin() const { return mRects.data(); }
+    const Rect* end() const { return mRects.data() + mCount; }
+    size_t size() const { return mCount; }
+
+    // Rect::INVALID_RECT when full, Rect::EMPTY_RECT when empty.
+    Rect getBounds() const;
+
+    // Number of damaged pixels. Undefined when full.
+    int64_t getArea() const;
+
+    // Region::INVALID_REGION when full.
+    Region toRegion() const;
+
+    void dump(std::string& out) const;
+
+    bool operator==(const DamageRegion& other) const;
+    bool operator!=(const DamageRegion& other) const { return !(*this == other); }
+
+private:
+    void append(const Rect& rect);
+    void removeAt(size_t index);
+
+    std::array<Rect, MAX_RECTS> mRects;
+    size_t mCount = 0;
+    bool mFull = false;
+};
+
+} // namespace android::ui
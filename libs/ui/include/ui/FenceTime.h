@@ -30,12 +30,14 @@
 namespace android {
 
 class FenceToFenceTimeMap;
+class FenceWatcher;
 
 // A wrapper around fence that only implements isValid and getSignalTime.
 // It automatically closes the fence in a thread-safe manner once the signal
 // time is known.
 class FenceTime {
 friend class FenceToFenceTimeMap;
+friend class FenceWatcher;
 public:
     // An atomic snapshot of the FenceTime that is flattenable.
     //
@@ -104,6 +106,8 @@ public:
 
     // Attempts to get the timestamp from the Fence if the timestamp isn't
     // already cached. Otherwise, it returns the cached value.
+    // The FenceWatcher caches the timestamp of the fences it watches as soon
+    // as they signal, which usually saves the query.
     nsecs_t getSignalTime();
 
     // Gets the cached timestamp without attempting to query the Fence.
@@ -126,6 +130,10 @@ private:
     // never return SIGNAL_TIME_INVALID and isValid will always return true.
     FenceTime(const sp<Fence>& fence, bool forceValidForTest);
 
+    // Queries the underlying Fence and caches the result once it has
+    // signaled, regardless of whether the fence is being watched.
+    nsecs_t querySignalTime();
+
     enum class State {
         VALID,
         INVALID,
@@ -140,6 +148,9 @@ private:
     mutable std::mutex mMutex;
     sp<Fence> mFence{Fence::NO_FENCE};
     std::atomic<nsecs_t> mSignalTime{Fence::SIGNAL_TIME_INVALID};
+
+    // Set while the FenceWatcher is responsible for recording mSignalTime.
+    std::atomic<bool> mWatched{false};
 };
 
 using FenceTimePtr = std::shared_ptr<FenceTime>;
@@ -158,6 +169,9 @@ using FenceTimePtr = std::shared_ptr<FenceTime>;
 // if FenceTimeline did nothing. i.e. they should eventually call
 // Fence::getSignalTime(), not only Fence::getCachedSignalTime().
 //
+// If the FenceWatcher is enabled, pushed fences are handed to it and
+// updateSignalTimes() only consumes the cached timestamps.
+//
 // push() and updateSignalTimes() are safe to call simultaneously from
 // different threads.
 class FenceTimeline {
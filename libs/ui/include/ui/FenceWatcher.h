@@ -0,0 +1,88 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <android-base/unique_fd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace android {
+
+class FenceTime;
+
+// Process-wide service that records the signal time of FenceTimes as soon as
+// their underlying sync files signal.
+//
+// Watched fences are registered with a single epoll loop running on a
+// dedicated thread. When a sync file becomes readable the watcher queries its
+// signal time once and caches it in the FenceTime, so that later calls to
+// FenceTime::getSignalTime() on other threads are plain atomic loads instead
+// of a sync-file info ioctl per query.
+//
+// The watcher is disabled by default and is enabled through the
+// debug.ui.fence_watcher system property, or through setEnabled(). When it is
+// disabled, watch() is a no-op and FenceTime falls back to on-demand queries.
+class FenceWatcher {
+public:
+    static FenceWatcher& getInstance();
+
+    static bool isEnabled();
+
+    // Overrides the debug.ui.fence_watcher system property. Only affects
+    // fences that are watched afterwards.
+    static void setEnabled(bool enabled);
+
+    // Starts watching |fenceTime| if the watcher is enabled and the fence is
+    // still pending. Watching the same FenceTime more than once is harmless.
+    // Returns true if the signal time will be recorded by the watcher.
+    bool watch(const std::shared_ptr<FenceTime>& fenceTime);
+
+    // Number of fences currently registered with the epoll loop.
+    size_t getPendingCount() const;
+
+    void dump(std::string& result) const;
+
+private:
+    struct Entry {
+        base::unique_fd fd;
+        std::weak_ptr<FenceTime> fenceTime;
+    };
+
+    FenceWatcher();
+
+    void threadMain();
+    void onFenceReadable(uint64_t key);
+
+    base::unique_fd mEpollFd;
+
+    mutable std::mutex mMutex;
+    uint64_t mNextKey GUARDED_BY(mMutex) = 0;
+    std::unordered_map<uint64_t, Entry> mEntries GUARDED_BY(mMutex);
+
+    std::atomic<uint64_t> mWatchedCount{0};
+    std::atomic<uint64_t> mSignaledCount{0};
+    std::atomic<uint64_t> mExpiredCount{0};
+    std::atomic<uint64_t> mFailedCount{0};
+};
+
+} // namespace android
@@ -0,0 +1 @@
+../../include/ui/FenceWatcher.h
\ No newline at end of file
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "DamageRegionTest"
+
+#include <gtest/gtest.h>
+#include <ui/DamageRegion.h>
+
+namespace android::ui {
+
+TEST(DamageRegionTest, DefaultIsEmpty) {
+    DamageRegion damage;
+    EXPECT_TRUE(damage.isEmpty());
+    EXPECT_FALSE(damage.isFull());
+    EXPECT_EQ(Rect::EMPTY_RECT, damage.getBounds());
+    EXPECT_EQ(0, damage.getArea());
+    EXPECT_TRUE(damage.toRegion().isEmpty());
+}
+
+TEST(DamageRegionTest, InvalidRectIsFull) {
+    DamageRegion damage(Rect(10, 10, 20, 20));
+    damage.add(Rect::INVALID_RECT);
+    EXPECT_TRUE(damage.isFull());
+    EXPECT_EQ(0u, damage.size());
+    EXPECT_EQ(Rect::INVALID_RECT, damage.getBounds());
+
+    // Nothing can be added to full damage.
+    damage.add(Rect(0, 0, 5, 5));
+    EXPECT_TRUE(damage.isFull());
+}
+
+TEST(DamageRegionTest, FromInvalidRegionIsFull) {
+    EXPECT_TRUE(DamageRegion::fromRegion(Region::INVALID_REGION).isFull());
+    EXPECT_TRUE(DamageRegion::fromRegion(Region()).isEmpty());
+
+    const Region region = DamageRegion::full().toRegion();
+    EXPECT_TRUE(region.isRect());
+    EXPECT_EQ(Rect::INVALID_RECT, region.getBounds());
+}
+
+TEST(DamageRegionTest, EmptyRectIsIgnored) {
+    DamageRegion damage;
+    damage.add(Rect(5, 5, 5, 10));
+    EXPECT_TRUE(damage.isEmpty());
+}
+
+TEST(DamageRegionTest, DistantRectsStaySeparate) {
+    DamageRegion damage;
+    damage.add(Rect(0, 0, 10, 10));
+    damage.add(Rect(100, 100, 110, 110));
+    EXPECT_EQ(2u, damage.size());
+    EXPECT_EQ(200, damage.getArea());
+    EXPECT_EQ(Rect(0, 0, 110, 110), damage.getBounds());
+}
+
+TEST(DamageRegionTest, OverlappingRectsMerge) {
+    DamageRegion damage;
+    damage.add(Rect(0, 0, 100, 100));
+    damage.add(Rect(50, 50, 150, 150));
+    ASSERT_EQ(1u, damage.size());
+    EXPECT_EQ(Rect(0, 0, 150, 150), *damage.begin());
+}
+
+TEST(DamageRegionTest, AdjacentRectsMerge) {
+    DamageRegion damage;
+    damage.add(Rect(0, 0, 100, 10));
+    damage.add(Rect(0, 10, 100, 20));
+    ASSERT_EQ(1u, damage.size());
+    EXPECT_EQ(Rect(0, 0, 100, 20), *damage.begin());
+    EXPECT_EQ(2000, damage.getArea());
+}
+
+TEST(DamageRegionTest, RegionBandsAreMergedBack) {
+    // Region splits two overlapping rectangles into three bands.
+    Region region(Rect(0, 0, 100, 100));
+    region.orSelf(Rect(20, 50, 120, 150));
+    ASSERT_GT(region.end() - region.begin(), 1);
+
+    DamageRegion damage = DamageRegion::fromRegion(region);
+    ASSERT_EQ(1u, damage.size());
+    EXPECT_EQ(Rect(0, 0, 120, 150), *damage.begin());
+}
+
+TEST(DamageRegionTest, RectCountIsBounded) {
+    DamageRegion damage;
+    for (int32_t i = 0; i < 10; i++) {
+        const int32_t offset = i * 100;
+        damage.add(Rect(offset, offset, offset + 10, offset + 10));
+    }
+    EXPECT_LE(damage.size(), DamageRegion::MAX_RECTS);
+
+    // Every added rectangle is still covered.
+    const Region covered = damage.toRegion();
+    for (int32_t i = 0; i < 10; i++) {
+        const int32_t offset = i * 100;
+        EXPECT_TRUE(Region(Rect(offset, offset, offset + 10, offset + 10))
+                            .subtract(covered)
+                            .isEmpty());
+    }
+}
+
+TEST(DamageRegionTest, FullListMergesCheapestPair) {
+    DamageRegion damage;
+    damage.add(Rect(0, 0, 10, 10));
+    damage.add(Rect(1000, 0, 1010, 10));
+    damage.add(Rect(0, 1000, 10, 1010));
+    damage.add(Rect(1000, 1000, 1010, 1010));
+    ASSERT_EQ(DamageRegion::MAX_RECTS, damage.size());
+
+    // Close to the first rectangle, but not close enough to merge right away.
+    damage.add(Rect(0, 20, 10, 30));
+    EXPECT_EQ(DamageRegion::MAX_RECTS, damage.size());
+    EXPECT_EQ(300 + 3 * 100, damage.getArea());
+}
+
+TEST(DamageRegionTest, AddDamageRegion) {
+    DamageRegion a(Rect(0, 0, 10, 10));
+    DamageRegion b(Rect(100, 100, 110, 110));
+    a.add(b);
+    EXPECT_EQ(2u, a.size());
+
+    a.add(DamageRegion::full());
+    EXPECT_TRUE(a.isFull());
+}
+
+TEST(DamageRegionTest, Equality) {
+    EXPECT_EQ(DamageRegion(Rect(0, 0, 10, 10)), DamageRegion(Rect(0, 0, 10, 10)));
+    EXPECT_NE(DamageRegion(Rect(0, 0, 10, 10)), DamageRegion(Rect(0, 0, 10, 11)));
+    EXPECT_NE(DamageRegion(), DamageRegion::full());
+    EXPECT_EQ(DamageRegion::full(), DamageRegion::full());
+}
+
+} // namespace android::ui
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <linux/types.h>
+#include <sys/ioctl.h>
+#include <ui/Fence.h>
+#include <ui/FenceTime.h>
+#include <ui/FenceWatcher.h>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+namespace android {
+namespace {
+
+using namespace std::chrono_literals;
+
+// The sw_sync uapi is not exported by libsync, so mirror the two ioctls needed to create
+// pending sync files from userspace.
+struct sw_sync_create_fence_data {
+    __u32 value;
+    char name[32];
+    __s32 fence;
+};
+
+#define SW_SYNC_IOC_MAGIC 'W'
+#define SW_SYNC_IOC_CREATE_FENCE _IOWR(SW_SYNC_IOC_MAGIC, 0, struct sw_sync_create_fence_data)
+#define SW_SYNC_IOC_INC _IOW(SW_SYNC_IOC_MAGIC, 1, __u32)
+
+class SwSyncTimeline {
+public:
+    SwSyncTimeline() {
+        mFd.reset(open("/dev/sw_sync", O_RDWR | O_CLOEXEC));
+        if (!mFd.ok()) {
+            mFd.reset(open("/sys/kernel/debug/sync/sw_sync", O_RDWR | O_CLOEXEC));
+        }
+    }
+
+    bool isValid() const { return mFd.ok(); }
+
+    sp<Fence> createFence(uint32_t value) {
+        sw_sync_create_fence_data data = {};
+        data.value = value;
+        strlcpy(data.name, "FenceWatcherTest", sizeof(data.name));
+        if (ioctl(mFd.get(), SW_SYNC_IOC_CREATE_FENCE, &data) != 0) {
+            return Fence::NO_FENCE;
+        }
+        return sp<Fence>::make(data.fence);
+    }
+
+    void inc(uint32_t count) { ioctl(mFd.get(), SW_SYNC_IOC_INC, &count); }
+
+private:
+    base::unique_fd mFd;
+};
+
+// The watcher records signal times on its own thread, so poll for the outcome.
+template <typename Predicate>
+bool waitFor(Predicate predicate) {
+    const auto deadline = std::chrono::steady_clock::now() + 1s;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+class FenceWatcherTest : public testing::Test {
+protected:
+    void SetUp() override {
+        if (!mTimeline.isValid()) {
+            GTEST_SKIP() << "sw_sync is not available";
+        }
+        FenceWatcher::setEnabled(true);
+        // Fences of earlier tests may still be in flight.
+        ASSERT_TRUE(waitFor([] { return FenceWatcher::getInstance().getPendingCount() == 0; }));
+    }
+
+    void TearDown() override { FenceWatcher::setEnabled(false); }
+
+    FenceWatcher& watcher() { return FenceWatcher::getInstance(); }
+
+    SwSyncTimeline mTimeline;
+};
+
+TEST_F(FenceWatcherTest, doesNotWatchWhenDisabled) {
+    FenceWatcher::setEnabled(false);
+    auto fenceTime = std::make_shared<FenceTime>(mTimeline.createFence(1));
+
+    EXPECT_FALSE(watcher().watch(fenceTime));
+    EXPECT_EQ(0u, watcher().getPendingCount());
+    EXPECT_EQ(Fence::SIGNAL_TIME_PENDING, fenceTime->getSignalTime());
+
+    mTimeline.inc(1);
+    EXPECT_NE(Fence::SIGNAL_TIME_PENDING, fenceTime->getSignalTime());
+}
+
+TEST_F(FenceWatcherTest, doesNotWatchSignaledOrInvalidFences) {
+    EXPECT_FALSE(watcher().watch(std::make_shared<FenceTime>(nsecs_t(1234))));
+    EXPECT_FALSE(watcher().watch(FenceTime::NO_FENCE));
+    EXPECT_FALSE(watcher().watch(nullptr));
+    EXPECT_EQ(0u, watcher().getPendingCount());
+}
+
+TEST_F(FenceWatcherTest, recordsSignalTime) {
+    auto fenceTime = std::make_shared<FenceTime>(mTimeline.createFence(1));
+
+    ASSERT_TRUE(watcher().watch(fenceTime));
+    EXPECT_EQ(1u, watcher().getPendingCount());
+    EXPECT_EQ(Fence::SIGNAL_TIME_PENDING, fenceTime->getSignalTime());
+
+    mTimeline.inc(1);
+    EXPECT_TRUE(waitFor(
+            [&] { return fenceTime->getCachedSignalTime() != Fence::SIGNAL_TIME_PENDING; }));
+    EXPECT_EQ(0u, watcher().getPendingCount());
+
+    const nsecs_t signalTime = fenceTime->getSignalTime();
+    EXPECT_GT(signalTime, 0);
+    EXPECT_EQ(signalTime, fenceTime->getCachedSignalTime());
+}
+
+TEST_F(FenceWatcherTest, signalTimeIsAvailableRightAfterWait) {
+    auto fenceTime = std::make_shared<FenceTime>(mTimeline.createFence(1));
+    ASSERT_TRUE(watcher().watch(fenceTime));
+
+    // The watcher may not have recorded the signal time yet, but a signaled
+    // fence must not be reported as pending.
+    mTimeline.inc(1);
+    ASSERT_EQ(NO_ERROR, fenceTime->wait(1000));
+    const nsecs_t signalTime = fenceTime->getSignalTime();
+    EXPECT_NE(Fence::SIGNAL_TIME_PENDING, signalTime);
+    EXPECT_GT(signalTime, 0);
+}
+
+TEST_F(FenceWatcherTest, watchingTwiceRegistersOnce) {
+    auto fenceTime = std::make_shared<FenceTime>(mTimeline.createFence(1));
+
+    EXPECT_TRUE(watcher().watch(fenceTime));
+    EXPECT_TRUE(watcher().watch(fenceTime));
+    EXPECT_EQ(1u, watcher().getPendingCount());
+
+    mTimeline.inc(1);
+    EXPECT_TRUE(waitFor([&] { return watcher().getPendingCount() == 0; }));
+    EXPECT_GT(fenceTime->getSignalTime(), 0);
+}
+
+TEST_F(FenceWatcherTest, dropsExpiredFenceTimes) {
+    auto fenceTime = std::make_shared<FenceTime>(mTimeline.createFence(1));
+    ASSERT_TRUE(watcher().watch(fenceTime));
+
+    // The watcher only holds a weak reference.
+    std::weak_ptr<FenceTime> weak = fenceTime;
+    fenceTime.reset();
+    EXPECT_TRUE(weak.expired());
+
+    mTimeline.inc(1);
+    EXPECT_TRUE(waitFor([&] { return watcher().getPendingCount() == 0; }));
+}
+
+TEST_F(FenceWatcherTest, fenceTimelineWatchesPushedFences) {
+    FenceTimeline timeline;
+    auto first = std::make_shared<FenceTime>(mTimeline.createFence(1));
+    auto second = std::make_shared<FenceTime>(mTimeline.createFence(2));
+    timeline.push(first);
+    timeline.push(second);
+    EXPECT_EQ(2u, watcher().getPendingCount());
+
+    mTimeline.inc(1);
+    EXPECT_TRUE(waitFor([&] { return watcher().getPendingCount() == 1; }));
+    timeline.updateSignalTimes();
+    EXPECT_GT(first->getCachedSignalTime(), 0);
+    EXPECT_EQ(Fence::SIGNAL_TIME_PENDING, second->getSignalTime());
+
+    mTimeline.inc(1);
+    EXPECT_TRUE(waitFor([&] { return watcher().getPendingCount() == 0; }));
+    timeline.updateSignalTimes();
+    EXPECT_GE(second->getCachedSignalTime(), first->getCachedSignalTime());
+}
+
+} // namespace
+} // namespace android
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/unique_fd.h>
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <linux/types.h>
+#include <sys/ioctl.h>
+#include <ui/Fence.h>
+#include <ui/FenceTime.h>
+#include <ui/FenceWatcher.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace {
+
+// The sw_sync uapi is not exported by libsync, so mirror the two ioctls needed to create
+// pending sync files from userspace.
+struct sw_sync_create_fence_data {
+    __u32 value;
+    char name[32];
+    __s32 fence;
+};
+
+#define SW_SYNC_IOC_MAGIC 'W'
+#define SW_SYNC_IOC_CREATE_FENCE _IOWR(SW_SYNC_IOC_MAGIC, 0, struct sw_sync_create_fence_data)
+#define SW_SYNC_IOC_INC _IOW(SW_SYNC_IOC_MAGIC, 1, __u32)
+
+class SwSyncTimeline {
+public:
+    SwSyncTimeline() {
+        mFd.reset(open("/dev/sw_sync", O_RDWR | O_CLOEXEC));
+        if (!mFd.ok()) {
+            mFd.reset(open("/sys/kernel/debug/sync/sw_sync", O_RDWR | O_CLOEXEC));
+        }
+    }
+
+    bool isValid() const { return mFd.ok(); }
+
+    sp<Fence> createFence(uint32_t value) {
+        sw_sync_create_fence_data data = {};
+        data.value = value;
+        strlcpy(data.name, "FenceTimeBenchmark", sizeof(data.name));
+        if (ioctl(mFd.get(), SW_SYNC_IOC_CREATE_FENCE, &data) != 0) {
+            return Fence::NO_FENCE;
+        }
+        return sp<Fence>::make(data.fence);
+    }
+
+    void inc(uint32_t count) { ioctl(mFd.get(), SW_SYNC_IOC_INC, &count); }
+
+private:
+    base::unique_fd mFd;
+};
+
+std::vector<FenceTimePtr> makePendingFences(SwSyncTimeline& timeline, int64_t count,
+                                            bool watched) {
+    std::vector<FenceTimePtr> fences;
+    fences.reserve(count);
+    for (int64_t i = 0; i < count; i++) {
+        // Values past the current timeline point keep the fences pending.
+        auto fenceTime = std::make_shared<FenceTime>(timeline.createFence(i + 1));
+        if (watched) {
+            FenceWatcher::getInstance().watch(fenceTime);
+        }
+        fences.push_back(std::move(fenceTime));
+    }
+    return fences;
+}
+
+// Queries every pending fence, like FrameTimeline and TimeStats do each frame.
+void runPendingQueries(benchmark::State& state, bool watched) {
+    SwSyncTimeline timeline;
+    if (!timeline.isValid()) {
+        state.SkipWithError("sw_sync is not available");
+        return;
+    }
+
+    FenceWatcher::setEnabled(watched);
+    const auto fences = makePendingFences(timeline, state.range(0), watched);
+
+    for (auto _ : state) {
+        for (const auto& fence : fences) {
+            benchmark::DoNotOptimize(fence->getSignalTime());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+
+    // Release the fences so the watcher drops them.
+    timeline.inc(static_cast<uint32_t>(state.range(0)));
+    FenceWatcher::setEnabled(false);
+}
+
+void BM_PendingFenceQueries_Polling(benchmark::State& state) {
+    runPendingQueries(state, false /* watched */);
+}
+BENCHMARK(BM_PendingFenceQueries_Polling)->Arg(64)->Arg(256)->Arg(512);
+
+void BM_PendingFenceQueries_Watched(benchmark::State& state) {
+    runPendingQueries(state, true /* watched */);
+}
+BENCHMARK(BM_PendingFenceQueries_Watched)->Arg(64)->Arg(256)->Arg(512);
+
+// A FenceTimeline where half of the fences have signaled, so each update has to
+// retire them one by one.
+void runTimelineUpdate(benchmark::State& state, bool watched) {
+    SwSyncTimeline timeline;
+    if (!timeline.isValid()) {
+        state.SkipWithError("sw_sync is not available");
+        return;
+    }
+
+    FenceWatcher::setEnabled(watched);
+    const int64_t count = std::min<int64_t>(state.range(0), FenceTimeline::MAX_ENTRIES);
+    uint32_t base = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        FenceTimeline fenceTimeline;
+        std::vector<FenceTimePtr> fences;
+        for (int64_t i = 0; i < count; i++) {
+            fences.push_back(std::make_shared<FenceTime>(timeline.createFence(base + i + 1)));
+            fenceTimeline.push(fences.back());
+        }
+        timeline.inc(static_cast<uint32_t>(count / 2));
+        if (watched) {
+            while (FenceWatcher::getInstance().getPendingCount() > static_cast<size_t>(count / 2)) {
+                std::this_thread::yield();
+            }
+        }
+        state.ResumeTiming();
+
+        fenceTimeline.updateSignalTimes();
+
+        state.PauseTiming();
+        timeline.inc(static_cast<uint32_t>(count - count / 2));
+        base += static_cast<uint32_t>(count);
+        state.ResumeTiming();
+    }
+
+    FenceWatcher::setEnabled(false);
+}
+
+void BM_FenceTimelineUpdate_Polling(benchmark::State& state) {
+    runTimelineUpdate(state, false /* watched */);
+}
+BENCHMARK(BM_FenceTimelineUpdate_Polling)->Arg(FenceTimeline::MAX_ENTRIES);
+
+void BM_FenceTimelineUpdate_Watched(benchmark::State& state) {
+    runTimelineUpdate(state, true /* watched */);
+}
+BENCHMARK(BM_FenceTimelineUpdate_Watched)->Arg(FenceTimeline::MAX_ENTRIES);
+
+} // namespace
+} // namespace android
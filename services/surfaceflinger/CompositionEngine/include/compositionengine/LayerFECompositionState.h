@@ -22,6 +22,7 @@
 #include <gui/HdrMetadata.h>
 #include <math/mat4.h>
 #include <ui/BlurRegion.h>
+#include <ui/DamageRegion.h>
 #include <ui/FloatRect.h>
 #include <ui/LayerStack.h>
 #include <ui/Rect.h>
@@ -170,7 +171,7 @@ struct LayerFECompositionState {
     // The buffer and related state
     sp<GraphicBuffer> buffer;
     sp<Fence> acquireFence = Fence::NO_FENCE;
-    Region surfaceDamage;
+    ui::DamageRegion surfaceDamage;
     uint64_t frameNumber = 0;
 
     // The handle to use for a sideband stream for this layer
@@ -36,6 +36,7 @@ void dumpVal(std::string& out, const char* name, const void*);
 void dumpVal(std::string& out, const char* name, int);
 void dumpVal(std::string& out, const char* name, float);
 void dumpVal(std::string& out, const char* name, uint32_t);
+void dumpVal(std::string& out, const char* name, int64_t);
 void dumpHex(std::string& out, const char* name, uint64_t);
 void dumpVal(std::string& out, const char* name, const char* value);
 void dumpVal(std::string& out, const char* name, const std::string& value);
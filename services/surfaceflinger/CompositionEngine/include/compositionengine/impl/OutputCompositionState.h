@@ -168,6 +168,18 @@ struct OutputCompositionState {
     uint64_t lastOutputLayerHash = 0;
     uint64_t outputLayerHash = 0;
 
+    // Surface damage sent to HWC for the most recent frame, summed over layers
+    // with a buffer.
+    struct DamageStats {
+        // Layers with damage covering part of the buffer, or all of it.
+        uint32_t partialUpdateLayers = 0;
+        uint32_t fullUpdateLayers = 0;
+        // Buffer pixels inside and outside of the damage of updated layers.
+        int64_t damagedPixels = 0;
+        int64_t savedPixels = 0;
+    };
+    DamageStats damageStats;
+
     ICEPowerCallback* powerCallback = nullptr;
 
     // Debugging
@@ -151,6 +151,11 @@ struct OutputLayerCompositionState {
 
         // True when this layer was skipped as part of SF-side layer caching.
         bool layerSkipped = false;
+
+        // The number of buffer pixels covered by the most recently set surface
+        // damage, and the number of pixels outside of it.
+        int64_t damagedPixels = 0;
+        int64_t damageSavedPixels = 0;
     };
 
     // The HWC state is optional, and is only set up if there is any potential
@@ -862,6 +862,20 @@ void Output::writeCompositionState(const compositionengine::CompositionRefreshAr
     uint32_t z = 0;
     bool overrideZ = false;
     uint64_t outputLayerHash = 0;
+    OutputCompositionState::DamageStats damageStats;
+    auto accumulateDamageStats = [&damageStats](const compositionengine::OutputLayer* layer) {
+        const auto& hwcState = layer->getState().hwc;
+        if (!hwcState || hwcState->damagedPixels == 0) {
+            return;
+        }
+        if (hwcState->damageSavedPixels > 0) {
+            damageStats.partialUpdateLayers++;
+        } else {
+            damageStats.fullUpdateLayers++;
+        }
+        damageStats.damagedPixels += hwcState->damagedPixels;
+        damageStats.savedPixels += hwcState->damageSavedPixels;
+    };
     for (auto* layer : getOutputLayersOrderedByZ()) {
         if (layer == peekThroughLayer) {
             // No longer needed, although it should not show up again, so
@@ -888,6 +902,7 @@ void Output::writeCompositionState(const compositionengine::CompositionRefreshAr
                     constexpr bool isPeekingThrough = true;
                     peekThroughLayer->writeStateToHWC(includeGeometry, false, z++, overrideZ,
                                                       isPeekingThrough);
+                    accumulateDamageStats(peekThroughLayer);
                     outputLayerHash ^= android::hashCombine(
                             reinterpret_cast<uint64_t>(&peekThroughLayer->getLayerFE()),
                             z, includeGeometry, overrideZ, isPeekingThrough,
@@ -905,9 +920,11 @@ void Output::writeCompositionState(const compositionengine::CompositionRefreshAr
                     reinterpret_cast<uint64_t>(&layer->getLayerFE()),
                     z, includeGeometry, overrideZ, isPeekingThrough,
                     layer->requiresClientComposition());
+            accumulateDamageStats(layer);
         }
     }
     editState().outputLayerHash = outputLayerHash;
+    editState().damageStats = damageStats;
 }
 
 compositionengine::OutputLayer* Output::findLayerRequestingBackgroundComposition() const {
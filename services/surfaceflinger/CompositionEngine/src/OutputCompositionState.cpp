@@ -67,6 +67,12 @@ void OutputCompositionState::dump(std::string& out) const {
 
     out.append("\n   ");
     dumpVal(out, "treat170mAsSrgb", treat170mAsSrgb);
+
+    out.append("\n   ");
+    dumpVal(out, "partialUpdateLayers", damageStats.partialUpdateLayers);
+    dumpVal(out, "fullUpdateLayers", damageStats.fullUpdateLayers);
+    dumpVal(out, "damagedPixels", damageStats.damagedPixels);
+    dumpVal(out, "damageSavedPixels", damageStats.savedPixels);
     out.append("\n");
 }
 
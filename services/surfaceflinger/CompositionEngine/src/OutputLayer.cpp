@@ -586,15 +586,32 @@ void OutputLayer::writeOutputIndependentPerFrameStateToHWC(
                   to_string(error).c_str(), static_cast<int32_t>(error));
     }
 
-    const Region& surfaceDamage = getState().overrideInfo.buffer
-            ? getState().overrideInfo.damageRegion
-            : (getState().hwc->stateOverridden ? Region::INVALID_REGION
+    const ui::DamageRegion surfaceDamage = getState().overrideInfo.buffer
+            ? ui::DamageRegion::fromRegion(getState().overrideInfo.damageRegion)
+            : (getState().hwc->stateOverridden ? ui::DamageRegion::full()
                                                : outputIndependentState.surfaceDamage);
 
     if (auto error = hwcLayer->setSurfaceDamage(surfaceDamage); error != hal::Error::NONE) {
-        ALOGE("[%s] Failed to set surface damage: %s (%d)", getLayerFE().getDebugName(),
-              to_string(error).c_str(), static_cast<int32_t>(error));
-        outputIndependentState.surfaceDamage.dump(LOG_TAG);
+        std::string damageString;
+        surfaceDamage.dump(damageString);
+        ALOGE("[%s] Failed to set surface damage %s: %s (%d)", getLayerFE().getDebugName(),
+              damageString.c_str(), to_string(error).c_str(), static_cast<int32_t>(error));
+    }
+
+    // Pixels the HWC can skip updating on panels with partial update support.
+    auto& hwcState = *editState().hwc;
+    hwcState.damagedPixels = 0;
+    hwcState.damageSavedPixels = 0;
+    const auto& buffer = getState().overrideInfo.buffer
+            ? getState().overrideInfo.buffer->getBuffer()
+            : outputIndependentState.buffer;
+    if (buffer && !surfaceDamage.isEmpty()) {
+        const int64_t bufferPixels =
+                static_cast<int64_t>(buffer->getWidth()) * buffer->getHeight();
+        hwcState.damagedPixels = surfaceDamage.isFull()
+                ? bufferPixels
+                : std::min(surfaceDamage.getArea(), bufferPixels);
+        hwcState.damageSavedPixels = bufferPixels - hwcState.damagedPixels;
     }
 
     // Content-specific per-frame state
@@ -40,6 +40,8 @@ void dumpHwc(const OutputLayerCompositionState::Hwc& hwc, std::string& out) {
     }
 
     dumpVal(out, "composition", toString(hwc.hwcCompositionType), hwc.hwcCompositionType);
+    dumpVal(out, "damagedPixels", hwc.damagedPixels);
+    dumpVal(out, "damageSavedPixels", hwc.damageSavedPixels);
 }
 
 } // namespace
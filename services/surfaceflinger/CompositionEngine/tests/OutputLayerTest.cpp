@@ -829,7 +829,7 @@ struct OutputLayerWriteStateToHWCTest : public OutputLayerTest {
         mLayerFEState.alpha = kAlpha;
         mLayerFEState.colorTransform = kColorTransform;
         mLayerFEState.color = kColor;
-        mLayerFEState.surfaceDamage = kSurfaceDamage;
+        mLayerFEState.surfaceDamage = ui::DamageRegion::fromRegion(kSurfaceDamage);
         mLayerFEState.hdrMetadata = kHdrMetadata;
         mLayerFEState.sidebandStream = NativeHandle::create(kSidebandStreamHandle, false);
         mLayerFEState.buffer = kBuffer;
@@ -896,7 +896,8 @@ struct OutputLayerWriteStateToHWCTest : public OutputLayerTest {
                 .WillOnce(Return(unsupported == SimulateUnsupported::ColorTransform
                                          ? hal::Error::UNSUPPORTED
                                          : hal::Error::NONE));
-        EXPECT_CALL(*mHwcLayer, setSurfaceDamage(RegionEq(surfaceDamage))).WillOnce(Return(kError));
+        EXPECT_CALL(*mHwcLayer, setSurfaceDamage(ui::DamageRegion::fromRegion(surfaceDamage)))
+                .WillOnce(Return(kError));
         EXPECT_CALL(*mHwcLayer, setBlockingRegion(RegionEq(blockingRegion)))
                 .WillOnce(Return(kError));
     }
@@ -1212,6 +1213,24 @@ TEST_F(OutputLayerWriteStateToHWCTest, previousOverriddenLayerSendsSurfaceDamage
                                  /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
 }
 
+TEST_F(OutputLayerWriteStateToHWCTest, partialSurfaceDamageRecordsSavedPixels) {
+    mLayerFEState.compositionType = Composition::DEVICE;
+    const Region damage{Rect{0, 0, 1, 1}};
+    mLayerFEState.surfaceDamage = ui::DamageRegion::fromRegion(damage);
+
+    expectPerFrameCommonCalls(SimulateUnsupported::None, kDataspace, kOutputSpaceVisibleRegion,
+                              damage);
+    expectSetHdrMetadataAndBufferCalls();
+    expectSetCompositionTypeCall(Composition::DEVICE);
+
+    mOutputLayer.writeStateToHWC(/*includeGeometry*/ false, /*skipLayer*/ false, 0,
+                                 /*zIsOverridden*/ false, /*isPeekingThrough*/ false);
+
+    // kBuffer is 1x2, and only one of its pixels is damaged.
+    EXPECT_EQ(1, mOutputLayer.getState().hwc->damagedPixels);
+    EXPECT_EQ(1, mOutputLayer.getState().hwc->damageSavedPixels);
+}
+
 TEST_F(OutputLayerWriteStateToHWCTest, previousSkipLayerSendsUpdatedDeviceCompositionInfo) {
     mLayerFEState.compositionType = Composition::DEVICE;
     mOutputLayer.editState().hwc->stateOverridden = true;
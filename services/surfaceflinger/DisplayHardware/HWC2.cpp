@@ -781,29 +781,31 @@ Error Layer::setBufferSlotsToClear(const std::vector<uint32_t>& slotsToClear,
     return static_cast<Error>(intError);
 }
 
-Error Layer::setSurfaceDamage(const Region& damage)
+Error Layer::setSurfaceDamage(const ui::DamageRegion& damage)
 {
     if (CC_UNLIKELY(!mDisplay)) {
         return Error::BAD_DISPLAY;
     }
 
-    if (damage.isRect() && mDamageRegion.isRect() &&
-        (damage.getBounds() == mDamageRegion.getBounds())) {
+    if (damage == mDamageRegion) {
         return Error::NONE;
     }
     mDamageRegion = damage;
 
     // We encode default full-screen damage as INVALID_RECT upstream, but as 0
-    // rects for HWC
-    Hwc2::Error intError = Hwc2::Error::NONE;
-    if (damage.isRect() && damage.getBounds() == Rect::INVALID_RECT) {
-        intError = mComposer.setLayerSurfaceDamage(mDisplay->getId(), mId,
-                                                   std::vector<Hwc2::IComposerClient::Rect>());
-    } else {
-        const auto hwcRects = convertRegionToHwcRects(damage);
-        intError = mComposer.setLayerSurfaceDamage(mDisplay->getId(), mId, hwcRects);
+    // rects for HWC. No damage is a single empty rect, as HWC would read 0
+    // rects as full-screen damage. The damage rects are already merged and
+    // bounded for partial update, so they are passed through as is.
+    std::vector<Hwc2::IComposerClient::Rect> hwcRects;
+    if (damage.isEmpty()) {
+        hwcRects.push_back({0, 0, 0, 0});
+    } else if (!damage.isFull()) {
+        hwcRects.reserve(damage.size());
+        for (const Rect& rect : damage) {
+            hwcRects.push_back({rect.left, rect.top, rect.right, rect.bottom});
+        }
     }
-
+    auto intError = mComposer.setLayerSurfaceDamage(mDisplay->getId(), mId, hwcRects);
     return static_cast<Error>(intError);
 }
 
@@ -22,6 +22,7 @@
 #include <ftl/future.h>
 #include <gui/HdrMetadata.h>
 #include <math/mat4.h>
+#include <ui/DamageRegion.h>
 #include <ui/HdrCapabilities.h>
 #include <ui/Region.h>
 #include <ui/StaticDisplayInfo.h>
@@ -339,7 +340,7 @@ public:
                                                const android::sp<android::Fence>& acquireFence) = 0;
     [[nodiscard]] virtual hal::Error setBufferSlotsToClear(
             const std::vector<uint32_t>& slotsToClear, uint32_t activeBufferSlot) = 0;
-    [[nodiscard]] virtual hal::Error setSurfaceDamage(const android::Region& damage) = 0;
+    [[nodiscard]] virtual hal::Error setSurfaceDamage(const android::ui::DamageRegion& damage) = 0;
 
     [[nodiscard]] virtual hal::Error setBlendMode(hal::BlendMode mode) = 0;
     [[nodiscard]] virtual hal::Error setColor(
@@ -393,7 +394,7 @@ public:
                          const android::sp<android::Fence>& acquireFence) override;
     hal::Error setBufferSlotsToClear(const std::vector<uint32_t>& slotsToClear,
                                      uint32_t activeBufferSlot) override;
-    hal::Error setSurfaceDamage(const android::Region& damage) override;
+    hal::Error setSurfaceDamage(const android::ui::DamageRegion& damage) override;
 
     hal::Error setBlendMode(hal::BlendMode mode) override;
     hal::Error setColor(aidl::android::hardware::graphics::composer3::Color color) override;
@@ -437,7 +438,7 @@ private:
     // Cached HWC2 data, to ensure the same commands aren't sent to the HWC
     // multiple times.
     android::Region mVisibleRegion = android::Region::INVALID_REGION;
-    android::Region mDamageRegion = android::Region::INVALID_REGION;
+    android::ui::DamageRegion mDamageRegion = android::ui::DamageRegion::full();
     android::Region mBlockingRegion = android::Region::INVALID_REGION;
     hal::Dataspace mDataSpace = hal::Dataspace::UNKNOWN;
     android::HdrMetadata mHdrMetadata;
@@ -28,15 +28,15 @@ using namespace ftl::flag_operators;
 namespace {
 
 void updateSurfaceDamage(const RequestedLayerState& requested, bool hasReadyFrame,
-                         bool forceFullDamage, Region& outSurfaceDamageRegion) {
+                         bool forceFullDamage, ui::DamageRegion& outSurfaceDamageRegion) {
     if (!hasReadyFrame) {
         outSurfaceDamageRegion.clear();
         return;
     }
     if (forceFullDamage) {
-        outSurfaceDamageRegion = Region::INVALID_REGION;
+        outSurfaceDamageRegion.setFull();
     } else {
-        outSurfaceDamageRegion = requested.surfaceDamageRegion;
+        outSurfaceDamageRegion = ui::DamageRegion::fromRegion(requested.surfaceDamageRegion);
     }
 }
 
@@ -419,7 +419,7 @@ void LayerProtoHelper::writeSnapshotToProto(perfetto::protos::LayerProto* layerI
                                            [&]() { return layerInfo->mutable_position(); });
     LayerProtoHelper::writeToProto(snapshot.geomLayerBounds,
                                    [&]() { return layerInfo->mutable_bounds(); });
-    LayerProtoHelper::writeToProto(snapshot.surfaceDamage,
+    LayerProtoHelper::writeToProto(snapshot.surfaceDamage.toRegion(),
                                    [&]() { return layerInfo->mutable_damage_region(); });
 
     if (requestedState.hasColorTransform) {
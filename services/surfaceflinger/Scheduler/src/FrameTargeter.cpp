@@ -18,6 +18,7 @@
 #include <common/trace.h>
 #include <scheduler/FrameTargeter.h>
 #include <scheduler/IVsyncSource.h>
+#include <ui/FenceWatcher.h>
 #include <utils/Log.h>
 
 namespace android::scheduler {
@@ -186,6 +187,9 @@ FenceTimePtr FrameTargeter::setPresentFence(sp<Fence> presentFence) {
 }
 
 FenceTimePtr FrameTargeter::setPresentFence(sp<Fence> presentFence, FenceTimePtr presentFenceTime) {
+    // FrameTimeline and TimeStats poll the present fence from the main thread every frame.
+    FenceWatcher::getInstance().watch(presentFenceTime);
+
     if (FlagManager::getInstance().allow_n_vsyncs_in_targeter()) {
         addFence(std::move(presentFence), presentFenceTime, mExpectedPresentTime);
     } else {
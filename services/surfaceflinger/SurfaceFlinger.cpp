@@ -59,6 +59,7 @@
 #include <configstore/Utils.h>
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
+#include <fcntl.h>
 #include <fmt/format.h>
 #include <ftl/algorithm.h>
 #include <ftl/concat.h>
@@ -91,6 +92,7 @@
 #include <ui/DisplayStatInfo.h>
 #include <ui/DisplayState.h>
 #include <ui/DynamicDisplayInfo.h>
+#include <ui/FenceWatcher.h>
 #include <ui/GraphicBufferAllocator.h>
 #include <ui/HdrRenderTypeUtils.h>
 #include <ui/LayerStack.h>
@@ -5550,6 +5552,9 @@ status_t SurfaceFlinger::doDump(int fd, const DumpArgs& args, bool asProto) {
     };
 
     const auto flag = args.empty() ? ""s : std::string(String8(args[0]));
+    if (flag == "--ring-buffer-trace"s) {
+        return dumpRingBufferTrace(fd, args);
+    }
     if (const auto it = dumpers.find(flag); it != dumpers.end()) {
         (it->second)(args, asProto, result);
         write(fd, result.c_str(), result.size());
@@ -5578,6 +5583,32 @@ status_t SurfaceFlinger::doDump(int fd, const DumpArgs& args, bool asProto) {
     return NO_ERROR;
 }
 
+status_t SurfaceFlinger::dumpRingBufferTrace(int fd, const DumpArgs& args) {
+    const auto command = args.size() < 2 ? "flush"s : std::string(String8(args[1]));
+    std::string result;
+    if (command == "enable") {
+        size_t bufferSize = 64 * 1024;
+        if (args.size() > 2 && !base::ParseUint(String8(args[2]).c_str(), &bufferSize)) {
+            StringAppendF(&result, "Invalid ring buffer size: %s\n", String8(args[2]).c_str());
+        } else {
+            ::tracing_perfetto::enableRingBuffer(bufferSize);
+            StringAppendF(&result, "Recording trace events into %zu byte ring buffers\n",
+                          bufferSize);
+        }
+    } else if (command == "disable") {
+        ::tracing_perfetto::disableRingBuffer();
+        result.append("Stopped recording trace events into ring buffers\n");
+    } else if (command == "flush") {
+        // Binary, in the format of ring_buffer_format.h.
+        ::tracing_perfetto::flushRingBuffers(fd);
+        return NO_ERROR;
+    } else {
+        result.append("Usage: --ring-buffer-trace [enable [bytes] | disable | flush]\n");
+    }
+    write(fd, result.c_str(), result.size());
+    return NO_ERROR;
+}
+
 status_t SurfaceFlinger::dumpCritical(int fd, const DumpArgs&, bool asProto) {
     return doDump(fd, DumpArgs(), asProto);
 }
@@ -5971,7 +6002,9 @@ void SurfaceFlinger::dumpAll(const DumpArgs& args, const std::string& compositio
     result.append("Sync configuration: ");
     colorizer.reset(result);
     result.append(SyncFeatures::getInstance().toString());
-    result.append("\n\n");
+    result.append("\n");
+    FenceWatcher::getInstance().dump(result);
+    result.append("\n");
 
     colorizer.bold(result);
     result.append("Scheduler:\n");
@@ -9351,6 +9384,47 @@ binder::Status SurfaceComposerAIDL::removeJankListener(int32_t layerId,
     return binder::Status::ok();
 }
 
+binder::Status SurfaceComposerAIDL::openTransactionCompletionChannel(
+        const sp<IBinder>& listener, gui::TransactionCompletionChannelFds* outFds) {
+    if (listener == nullptr) {
+        return binder::Status::fromExceptionCode(binder::Status::EX_NULL_POINTER);
+    }
+    if (status_t status = checkAccessPermission(); status != OK) {
+        return binderStatusFromStatusT(status);
+    }
+
+    // SurfaceFlinger creates the channel, so that the client never gets hold of the producer's
+    // file descriptors and can't make writes to them block the main thread.
+    const int pid = IPCThreadState::self()->getCallingPid();
+    std::shared_ptr<gui::TransactionCompletionChannel::ProducerEndpoint> channel;
+    base::unique_fd memoryFd;
+    base::unique_fd fenceFd;
+    if (status_t status =
+                gui::TransactionCompletionChannel::create("TransactionCompletion pid=" +
+                                                                  std::to_string(pid),
+                                                          channel, memoryFd, fenceFd);
+        status != OK) {
+        return binderStatusFromStatusT(status);
+    }
+    if (status_t status =
+                mFlinger->mTransactionCallbackInvoker.addCompletionChannel(listener, pid,
+                                                                           std::move(channel));
+        status != OK) {
+        return binderStatusFromStatusT(status);
+    }
+    outFds->sharedMemory.reset(std::move(memoryFd));
+    outFds->fenceSocket.reset(std::move(fenceFd));
+    return binder::Status::ok();
+}
+
+binder::Status SurfaceComposerAIDL::closeTransactionCompletionChannel(const sp<IBinder>& listener) {
+    if (listener == nullptr) {
+        return binder::Status::fromExceptionCode(binder::Status::EX_NULL_POINTER);
+    }
+    mFlinger->mTransactionCallbackInvoker.removeCompletionChannel(listener);
+    return binder::Status::ok();
+}
+
 status_t SurfaceComposerAIDL::checkAccessPermission(bool usePermissionCache) {
     if (!mFlinger->callingThreadHasUnscopedSurfaceFlingerAccess(usePermissionCache)) {
         IPCThreadState* ipc = IPCThreadState::self();
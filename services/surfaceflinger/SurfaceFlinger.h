@@ -1139,6 +1139,10 @@ private:
 
     status_t doDump(int fd, const DumpArgs& args, bool asProto);
 
+    // Controls the in-process trace ring buffers of libtracing_perfetto, and writes out what they
+    // recorded.
+    status_t dumpRingBufferTrace(int fd, const DumpArgs& args);
+
     status_t dumpCritical(int fd, const DumpArgs&, bool asProto);
 
     status_t dumpAll(int fd, const DumpArgs& args, bool asProto) override {
@@ -1615,6 +1619,9 @@ public:
     binder::Status flushJankData(int32_t layerId) override;
     binder::Status removeJankListener(int32_t layerId, const sp<gui::IJankListener>& listener,
                                       int64_t afterVsync) override;
+    binder::Status openTransactionCompletionChannel(
+            const sp<IBinder>& listener, gui::TransactionCompletionChannelFds* outFds) override;
+    binder::Status closeTransactionCompletionChannel(const sp<IBinder>& listener) override;
 
 private:
     static const constexpr bool kUsePermissionCache = true;
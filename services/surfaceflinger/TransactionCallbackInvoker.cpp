@@ -25,8 +25,11 @@
 
 #include "TransactionCallbackInvoker.h"
 #include "BackgroundExecutor.h"
+#include "FrontEnd/LayerHandle.h"
 #include "Utils/FenceUtils.h"
 
+#include <algorithm>
+
 #include <binder/IInterface.h>
 #include <common/FlagManager.h>
 #include <common/trace.h>
@@ -51,6 +54,9 @@ static bool containsOnCommitCallbacks(const std::vector<CallbackId>& callbacks)
     return !callbacks.empty() && callbacks.front().type == CallbackId::Type::ON_COMMIT;
 }
 
+TransactionCallbackInvoker::TransactionCallbackInvoker()
+      : mCompletionChannelDeathRecipient(sp<CompletionChannelDeathRecipient>::make(*this)) {}
+
 void TransactionCallbackInvoker::addEmptyTransaction(const ListenerCallbacks& listenerCallbacks) {
     auto& [listener, callbackIds] = listenerCallbacks;
     auto& transactionStatsDeque = mCompletedTransactions[listener];
@@ -208,7 +214,11 @@ void TransactionCallbackInvoker::sendCallbacks(bool onCommitOnly) {
                 // keep it as an IBinder due to consistency reasons: if we
                 // interface_cast at the IPC boundary when reading a Parcel,
                 // we get pointers that compare unequal in the SF process.
-                listenerStatsToSend.emplace_back(std::move(listenerStats));
+                if (!sendThroughCompletionChannel(listenerStats)) {
+                    listenerStatsToSend.emplace_back(std::move(listenerStats));
+                }
+            } else {
+                removeCompletionChannel(listener);
             }
         }
         completedTransactionsItr++;
@@ -228,6 +238,72 @@ void TransactionCallbackInvoker::sendCallbacks(bool onCommitOnly) {
             }});
 }
 
+status_t TransactionCallbackInvoker::addCompletionChannel(
+        const sp<IBinder>& listener, pid_t pid,
+        std::shared_ptr<gui::TransactionCompletionChannel::ProducerEndpoint> channel) {
+    std::scoped_lock lock(mCompletionChannelsMutex);
+    if (auto it = mCompletionChannels.find(listener); it != mCompletionChannels.end()) {
+        it->second = {std::move(channel), pid};
+        return NO_ERROR;
+    }
+    const auto channelCount =
+            std::count_if(mCompletionChannels.begin(), mCompletionChannels.end(),
+                          [pid](const auto& entry) { return entry.second.pid == pid; });
+    if (static_cast<size_t>(channelCount) >= kMaxCompletionChannelsPerProcess) {
+        ALOGW("Too many transaction completion channels for pid %d", pid);
+        return NO_MEMORY;
+    }
+    if (status_t err = listener->linkToDeath(mCompletionChannelDeathRecipient); err != OK) {
+        ALOGW("Could not watch transaction completion channel listener: %s (%d)",
+              statusToString(err).c_str(), err);
+        return err;
+    }
+    mCompletionChannels.emplace(listener, CompletionChannel{std::move(channel), pid});
+    return NO_ERROR;
+}
+
+void TransactionCallbackInvoker::removeCompletionChannel(const sp<IBinder>& listener) {
+    std::scoped_lock lock(mCompletionChannelsMutex);
+    if (auto it = mCompletionChannels.find(listener); it != mCompletionChannels.end()) {
+        // Fails if the listener died, which is fine.
+        (void)listener->unlinkToDeath(mCompletionChannelDeathRecipient);
+        mCompletionChannels.erase(it);
+    }
+}
+
+void TransactionCallbackInvoker::CompletionChannelDeathRecipient::binderDied(
+        const wp<IBinder>& who) {
+    if (sp<IBinder> listener = who.promote()) {
+        mInvoker.removeCompletionChannel(listener);
+    }
+}
+
+bool TransactionCallbackInvoker::sendThroughCompletionChannel(const ListenerStats& listenerStats) {
+    std::scoped_lock lock(mCompletionChannelsMutex);
+    auto it = mCompletionChannels.find(listenerStats.listener);
+    if (it == mCompletionChannels.end()) {
+        return false;
+    }
+
+    SFTRACE_CALL();
+    auto resolveLayerId = [](const sp<IBinder>& surfaceControl) {
+        return static_cast<int32_t>(surfaceflinger::LayerHandle::getLayerId(surfaceControl));
+    };
+    const status_t status = it->second.producer->write(listenerStats, resolveLayerId);
+    if (status == OK) {
+        return true;
+    }
+    // Fall back to binder for good, whether the batch did not fit or the client broke the
+    // channel. Switching back and forth could deliver a later batch through the ring before an
+    // earlier one that went through binder. The client drains the ring before handling stats
+    // from binder, so the batches already in the ring stay in order.
+    ALOGW("Transaction completion channel failed, falling back to binder: %s (%d)",
+          statusToString(status).c_str(), status);
+    (void)listenerStats.listener->unlinkToDeath(mCompletionChannelDeathRecipient);
+    mCompletionChannels.erase(it);
+    return false;
+}
+
 // -----------------------------------------------------------------------
 
 CallbackHandle::CallbackHandle(const sp<IBinder>& transactionListener,
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <deque>
+#include <mutex>
 #include <optional>
 #include <unordered_map>
 
@@ -25,6 +26,7 @@
 #include <ftl/future.h>
 #include <gui/BufferReleaseChannel.h>
 #include <gui/ITransactionCompletedListener.h>
+#include <gui/TransactionCompletionChannel.h>
 #include <ui/Fence.h>
 #include <ui/FenceResult.h>
 
@@ -60,6 +62,8 @@ public:
 
 class TransactionCallbackInvoker {
 public:
+    TransactionCallbackInvoker();
+
     status_t addCallbackHandles(const std::deque<sp<CallbackHandle>>& handles);
     status_t addOnCommitCallbackHandles(const std::deque<sp<CallbackHandle>>& handles,
                                              std::deque<sp<CallbackHandle>>& outRemainingHandles);
@@ -75,7 +79,24 @@ public:
 
     status_t addCallbackHandle(const sp<CallbackHandle>& handle);
 
+    // A process normally has a single listener, so this only guards against misbehaving clients.
+    static constexpr size_t kMaxCompletionChannelsPerProcess = 4;
+
+    // Routes the callbacks of the given listener, owned by the given process, through a
+    // shared-memory channel instead of binder. Returns NO_MEMORY if the process already has
+    // kMaxCompletionChannelsPerProcess channels. May be called from any thread.
+    status_t addCompletionChannel(
+            const sp<IBinder>& listener, pid_t pid,
+            std::shared_ptr<gui::TransactionCompletionChannel::ProducerEndpoint> channel);
+
+    // Routes the callbacks of the given listener back through binder. May be called from any
+    // thread.
+    void removeCompletionChannel(const sp<IBinder>& listener);
+
 private:
+    // Returns false if the stats must be sent through binder instead.
+    bool sendThroughCompletionChannel(const ListenerStats& listenerStats);
+
     status_t findOrCreateTransactionStats(const sp<IBinder>& listener,
                                           const std::vector<CallbackId>& callbackIds,
                                           TransactionStats** outTransactionStats);
@@ -92,6 +113,27 @@ private:
     std::vector<BufferRelease> mBufferReleases;
 
     sp<Fence> mPresentFence;
+
+    struct CompletionChannel {
+        std::shared_ptr<gui::TransactionCompletionChannel::ProducerEndpoint> producer;
+        pid_t pid;
+    };
+    std::mutex mCompletionChannelsMutex;
+    std::unordered_map<sp<IBinder>, CompletionChannel, IListenerHash> mCompletionChannels
+            GUARDED_BY(mCompletionChannelsMutex);
+
+    // Drops the channel of a listener whose process died without unregistering it.
+    class CompletionChannelDeathRecipient : public IBinder::DeathRecipient {
+    public:
+        explicit CompletionChannelDeathRecipient(TransactionCallbackInvoker& invoker)
+              : mInvoker(invoker) {}
+        void binderDied(const wp<IBinder>& who) override;
+
+    private:
+        TransactionCallbackInvoker& mInvoker;
+    };
+
+    sp<CompletionChannelDeathRecipient> mCompletionChannelDeathRecipient;
 };
 
 } // namespace android
@@ -598,4 +598,38 @@ TEST_F(HWComposerLayerGenericMetadataTest, forwardsSupportedMetadata) {
     EXPECT_EQ(hal::Error::UNSUPPORTED, result);
 }
 
+struct HWComposerLayerSurfaceDamageTest : public HWComposerLayerTest {
+    HWComposerLayerSurfaceDamageTest() : HWComposerLayerTest({}) {}
+};
+
+TEST_F(HWComposerLayerSurfaceDamageTest, emptyDamageSendsSingleEmptyRect) {
+    // HWC reads 0 rects as full-screen damage.
+    const std::vector<IComposerClient::Rect> expected{IComposerClient::Rect{0, 0, 0, 0}};
+    EXPECT_CALL(*mHal, setLayerSurfaceDamage(kDisplayId, kLayerId, expected))
+            .WillOnce(Return(V2_4::Error::NONE));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setSurfaceDamage(ui::DamageRegion()));
+
+    // Unchanged damage is not sent again.
+    EXPECT_EQ(hal::Error::NONE, mLayer.setSurfaceDamage(ui::DamageRegion()));
+}
+
+TEST_F(HWComposerLayerSurfaceDamageTest, forwardsDamageRects) {
+    const std::vector<IComposerClient::Rect> expected{IComposerClient::Rect{1, 2, 3, 4}};
+    EXPECT_CALL(*mHal, setLayerSurfaceDamage(kDisplayId, kLayerId, expected))
+            .WillOnce(Return(V2_4::Error::NONE));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setSurfaceDamage(ui::DamageRegion(Rect(1, 2, 3, 4))));
+}
+
+TEST_F(HWComposerLayerSurfaceDamageTest, fullDamageSendsNoRects) {
+    // Full damage is the initial state, so damage something else first.
+    EXPECT_CALL(*mHal, setLayerSurfaceDamage(kDisplayId, kLayerId, _))
+            .WillOnce(Return(V2_4::Error::NONE));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setSurfaceDamage(ui::DamageRegion()));
+
+    EXPECT_CALL(*mHal,
+                setLayerSurfaceDamage(kDisplayId, kLayerId, std::vector<IComposerClient::Rect>()))
+            .WillOnce(Return(V2_4::Error::NONE));
+    EXPECT_EQ(hal::Error::NONE, mLayer.setSurfaceDamage(ui::DamageRegion::full()));
+}
+
 } // namespace android